@@ -11,6 +11,7 @@
 #include "base/deps/abseil/flags/flag.h"
 #include "base/deps/abseil/flags/parse.h"
 #include "base/deps/abseil/strings/str_cat.h"
+#include "base/deps/abseil/strings/str_split.h"
 #include "ui/static_settings_config.h"
 
 #ifdef WB_OS_WIN
@@ -130,6 +131,52 @@ bool AbslParseFlag(std::string_view text, WindowHeight* h, std::string* error) {
   return true;
 }
 
+std::string AbslUnparseFlag(FramePipelineDepth d) {
+  // Delegate to the usual unparsing for int.
+  return absl::UnparseFlag(std::uint32_t{d.depth});
+}
+
+bool AbslParseFlag(std::string_view text, FramePipelineDepth* d,
+                   std::string* error) {
+  // Convert from text to uint32_t using the uint32_t-flag parser.
+  std::uint32_t depth;
+  if (!absl::ParseFlag(text, &depth, error)) {
+    return false;
+  }
+
+  constexpr std::uint32_t minimum_depth{1}, maximum_depth{2};
+
+  if (depth < minimum_depth || depth > maximum_depth) [[unlikely]] {
+    *error =
+        absl::StrCat("not in range [", minimum_depth, ",", maximum_depth, "]");
+    return false;
+  }
+
+  d->depth = static_cast<std::uint8_t>(depth);
+  return true;
+}
+
+std::string AbslUnparseFlag(WorkerPinning p) {
+  return std::string{base::GetWorkerPinningName(p.pinning)};
+}
+
+bool AbslParseFlag(std::string_view text, WorkerPinning* p,
+                   std::string* error) {
+  using base::WorkerPinning;
+
+  for (const WorkerPinning pinning :
+       {WorkerPinning::kNone, WorkerPinning::kCores,
+        WorkerPinning::kCacheGroups}) {
+    if (text == base::GetWorkerPinningName(pinning)) {
+      p->pinning = pinning;
+      return true;
+    }
+  }
+
+  *error = absl::StrCat("'", text, "' is not one of none, cores, ccx");
+  return false;
+}
+
 std::string AbslUnparseFlag(AssetsPath p) {
   // Delegate to the usual unparsing for string.
   return absl::UnparseFlag(p.value);
@@ -158,6 +205,77 @@ bool AbslParseFlag(std::string_view text, AssetsPath* p, std::string* error) {
   return true;
 }
 
+std::string AbslUnparseFlag(const MemoryBudgets& b) {
+  using namespace wb::base::memory;
+
+  constexpr std::size_t kMiB{1024U * 1024U};
+
+  std::string text;
+  for (std::size_t i{0}; i < b.budgets.size(); ++i) {
+    const MemoryBudget& budget{b.budgets[i]};
+    if (budget.soft_limit == 0 && budget.hard_limit == 0) continue;
+
+    absl::StrAppend(&text, text.empty() ? "" : ",",
+                    GetMemoryCategoryName(static_cast<MemoryCategory>(i)), "=",
+                    budget.soft_limit / kMiB, ":", budget.hard_limit / kMiB);
+  }
+  return text;
+}
+
+bool AbslParseFlag(std::string_view text, MemoryBudgets* b,
+                   std::string* error) {
+  using namespace wb::base::memory;
+
+  constexpr std::size_t kMiB{1024U * 1024U};
+
+  MemoryBudgets budgets{};
+  for (std::string_view item : absl::StrSplit(text, ',', absl::SkipEmpty())) {
+    const std::size_t equal_index{item.find('=')};
+    const std::size_t colon_index{item.find(':')};
+    if (equal_index == std::string_view::npos ||
+        colon_index == std::string_view::npos || colon_index < equal_index)
+        [[unlikely]] {
+      *error = absl::StrCat("'", item, "' is not category=soft:hard");
+      return false;
+    }
+
+    const std::string_view name{item.substr(0, equal_index)};
+    std::size_t category_index{0};
+    while (category_index < kMemoryCategoriesCount &&
+           GetMemoryCategoryName(static_cast<MemoryCategory>(
+               category_index)) != name) {
+      ++category_index;
+    }
+    if (category_index == kMemoryCategoriesCount) [[unlikely]] {
+      *error = absl::StrCat("'", name, "' is unknown memory category");
+      return false;
+    }
+
+    // Convert from text to uint32_t using the uint32_t-flag parser.
+    std::uint32_t soft_limit_mib, hard_limit_mib;
+    if (!absl::ParseFlag(
+            item.substr(equal_index + 1, colon_index - equal_index - 1),
+            &soft_limit_mib, error) ||
+        !absl::ParseFlag(item.substr(colon_index + 1), &hard_limit_mib,
+                         error)) {
+      return false;
+    }
+
+    if (soft_limit_mib != 0 && hard_limit_mib != 0 &&
+        soft_limit_mib > hard_limit_mib) [[unlikely]] {
+      *error = absl::StrCat(name, " soft limit ", soft_limit_mib,
+                            " exceeds hard limit ", hard_limit_mib);
+      return false;
+    }
+
+    budgets.budgets[category_index] = {.soft_limit = soft_limit_mib * kMiB,
+                                       .hard_limit = hard_limit_mib * kMiB};
+  }
+
+  *b = budgets;
+  return true;
+}
+
 }  // namespace wb::apps::flags
 
 ABSL_FLAG(wb::apps::flags::AssetsPath, assets_path,
@@ -182,6 +300,32 @@ ABSL_FLAG(wb::apps::flags::WindowHeight, main_window_height,
           wb::apps::flags::WindowHeight{600U},
           "main window initial height in pixels.");
 
+ABSL_FLAG(wb::apps::flags::FramePipelineDepth, frame_pipeline_depth,
+          wb::apps::flags::FramePipelineDepth{2U},
+          "how many frames kernel pipelines: 1 serializes simulation and "
+          "output, 2 overlaps simulation of frame N+1 with output of frame N.");
+
+ABSL_FLAG(wb::apps::flags::WorkerPinning, worker_pinning,
+          wb::apps::flags::WorkerPinning{wb::base::WorkerPinning::kNone},
+          "how to place marl worker threads on CPUs: none (worker per logical "
+          "CPU, OS places workers), cores (worker per physical core pinned to "
+          "it) or ccx (worker per physical core pinned to its L3 cache "
+          "group).  Linux only.");
+
+ABSL_FLAG(bool, should_reserve_main_thread_core, false,
+          "should reserve physical core for the main thread, so marl workers "
+          "do not use it.");
+
+ABSL_FLAG(std::uint32_t, normal_lane_workers, 0U,
+          "max marl workers running normal priority tasks at once.  0 means "
+          "all workers.");
+
+ABSL_FLAG(std::uint32_t, background_lane_workers, 0U,
+          "max marl workers running background tasks (asset streaming, "
+          "decompression, telemetry writes) at once.  Background tasks do not "
+          "start while frame critical ones run.  0 means quarter of workers, "
+          "but at least one.");
+
 #ifdef WB_OS_WIN
 ABSL_FLAG(
     wb::apps::flags::PeriodicTimerResolution, periodic_timer_resolution_ms,
@@ -195,6 +339,53 @@ ABSL_FLAG(
     "accuracy of the high-resolution performance counter.");
 #endif  // WB_OS_WIN
 
+ABSL_FLAG(std::uint32_t, emergency_memory_reserve_mib, 32U,
+          "emergency memory reserve size in MiB.  Reserve is released on "
+          "first out of memory to survive transient allocation spikes.  0 "
+          "disables reserve.");
+
+ABSL_FLAG(std::uint32_t, frame_arena_capacity_kib, 1024U,
+          "frame arena capacity in KiB of one frame buffer per thread.  "
+          "Allocations which do not fit fall back to heap.");
+
+ABSL_FLAG(std::uint32_t, large_pages_arena_mib, 0U,
+          "large pages arena size in MiB for hot data (world heaps, frame "
+          "arenas).  Explicit 2 MiB pages are used when reserved by OS, "
+          "transparent huge pages otherwise.  Linux only.  0 disables arena.");
+
+ABSL_FLAG(wb::apps::flags::MemoryBudgets, memory_budgets,
+          wb::apps::flags::MemoryBudgets{},
+          "memory budgets by category as comma separated list of "
+          "category=soft:hard limits in MiB, ex. "
+          "textures=512:768,sounds=64:96.  Categories are textures, sounds, "
+          "world, scripts, ui and logging.  0 limit means no limit.");
+
+ABSL_FLAG(std::uint32_t, memory_budget_report_interval_ms, 0U,
+          "how often (ms) to log memory budgets report.  0 disables periodic "
+          "report.");
+
+ABSL_FLAG(std::string, memory_budget_report_path, "",
+          "path to write memory budgets JSON report to on each periodic "
+          "report.  Empty disables JSON report.");
+
+ABSL_FLAG(std::uint32_t, heap_stats_sample_interval_ms, 0U,
+          "how often (ms) to sample heap statistics (committed, reserved, "
+          "pages, size classes) and log them.  Sampled by world simulation "
+          "step.  0 disables sampling.");
+
+ABSL_FLAG(std::string, heap_stats_path, "",
+          "path to write heap statistics JSON to on each sample.  Empty "
+          "disables JSON.");
+
+ABSL_FLAG(std::uint32_t, catalogs_hot_reload_interval_ms, 0U,
+          "how often (ms) to poll localization catalogs for changes and hot "
+          "reload them.  Polled by world simulation step.  0 disables hot "
+          "reload.");
+
+ABSL_FLAG(bool, should_count_dtlb_misses, false,
+          "should count dTLB loads / misses and log them on exit or not.  "
+          "Measures large pages arena impact.  Linux only.");
+
 ABSL_FLAG(bool, should_dump_heap_allocator_statistics_on_exit, false,
           "should dump heap allocator statistics on exit or not.  Included a "
           "some process info, like system/user elapsed time, peak working "
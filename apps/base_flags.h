@@ -7,11 +7,14 @@
 #ifndef WB_APPS_BASE_FLAGS_H_
 #define WB_APPS_BASE_FLAGS_H_
 
+#include <array>        // array
 #include <cstdint>      // uint32_t
 #include <string>       // string
 #include <string_view>  // string_view
 
+#include "base/cpu_topology.h"                // WorkerPinning
 #include "base/deps/abseil/flags/declare.h"  // ABSL_DECLARE_FLAG
+#include "base/memory/memory_budget.h"       // MemoryBudget
 #include "build/build_config.h"              // WB_OS_WIN
 
 namespace wb::apps::flags {
@@ -115,6 +118,36 @@ std::string AbslUnparseFlag(WindowHeight h);
  */
 bool AbslParseFlag(std::string_view text, WindowHeight* h, std::string* error);
 
+/**
+ * @brief Frame pipeline depth.
+ */
+struct FramePipelineDepth {
+  explicit FramePipelineDepth(std::uint8_t depth_) noexcept : depth{depth_} {}
+
+  /**
+   * @brief Frames in flight.
+   */
+  std::uint8_t depth;  // Valid range is [1..2]
+};
+
+/**
+ * @brief Returns a textual flag value corresponding to the FramePipelineDepth.
+ * @param d FramePipelineDepth.
+ * @return Textual flag value.
+ */
+std::string AbslUnparseFlag(FramePipelineDepth d);
+
+/**
+ * @brief Parses a FramePipelineDepth from the command line flag value `text`.
+ * @param text Command line flag value.
+ * @param d FramePipelineDepth.
+ * @param error Parse flag error.
+ * @return true and sets `*d` on success; returns false and sets `*error` on
+ * failure.
+ */
+bool AbslParseFlag(std::string_view text, FramePipelineDepth* d,
+                   std::string* error);
+
 /**
  * @brief Assets path.
  */
@@ -141,6 +174,70 @@ std::string AbslUnparseFlag(AssetsPath p);
  */
 bool AbslParseFlag(std::string_view text, AssetsPath* p, std::string* error);
 
+/**
+ * @brief Marl worker threads pinning.
+ */
+struct WorkerPinning {
+  explicit WorkerPinning(base::WorkerPinning pinning_) noexcept
+      : pinning{pinning_} {}
+
+  /**
+   * @brief How to place workers on CPUs.
+   */
+  base::WorkerPinning pinning;
+};
+
+/**
+ * @brief Returns a textual flag value corresponding to the WorkerPinning.
+ * @param p WorkerPinning.
+ * @return Textual flag value.
+ */
+std::string AbslUnparseFlag(WorkerPinning p);
+
+/**
+ * @brief Parses a WorkerPinning from the command line flag value `text`.
+ * Valid values are none, cores and ccx.
+ * @param text Command line flag value.
+ * @param p WorkerPinning.
+ * @param error Parse flag error.
+ * @return true and sets `*p` on success; returns false and sets `*error` on
+ * failure.
+ */
+bool AbslParseFlag(std::string_view text, WorkerPinning* p,
+                   std::string* error);
+
+/**
+ * @brief Memory budgets by category.
+ */
+struct MemoryBudgets {
+  /**
+   * @brief Budgets in bytes indexed by memory category.  0 limit means no
+   * limit.
+   */
+  std::array<base::memory::MemoryBudget, base::memory::kMemoryCategoriesCount>
+      budgets;
+};
+
+/**
+ * @brief Returns a textual flag value corresponding to the MemoryBudgets.
+ * @param b MemoryBudgets.
+ * @return Textual flag value.
+ */
+std::string AbslUnparseFlag(const MemoryBudgets& b);
+
+/**
+ * @brief Parses a MemoryBudgets from the command line flag value `text`.
+ * Format is comma separated list of category=soft:hard limits in MiB, ex.
+ * textures=512:768,sounds=64:96.
+ * @param text Command line flag value.
+ * @param b MemoryBudgets.
+ * @param error Parse flag error.
+ * @return true and sets `*b` on success; returns false and sets `*error` on
+ * failure.
+ */
+bool AbslParseFlag(std::string_view text, MemoryBudgets* b,
+                   std::string* error);
+
 }  // namespace wb::apps::flags
 
 // Assets path.
@@ -162,6 +259,27 @@ ABSL_DECLARE_FLAG(wb::apps::flags::WindowWidth, main_window_width);
 // Initial height of the main window in pixels.
 ABSL_DECLARE_FLAG(wb::apps::flags::WindowHeight, main_window_height);
 
+// How many frames kernel pipelines: 1 serializes simulation and output, 2
+// overlaps simulation of frame N+1 with output of frame N.
+ABSL_DECLARE_FLAG(wb::apps::flags::FramePipelineDepth, frame_pipeline_depth);
+
+// How to place marl worker threads on CPUs: none (worker per logical CPU, OS
+// places workers), cores (worker per physical core pinned to it) or ccx
+// (worker per physical core pinned to its L3 cache group).  Linux only.
+ABSL_DECLARE_FLAG(wb::apps::flags::WorkerPinning, worker_pinning);
+
+// Should reserve physical core for the main thread, so marl workers do not use
+// it.
+ABSL_DECLARE_FLAG(bool, should_reserve_main_thread_core);
+
+// Max marl workers running normal priority tasks at once.  0 means all workers.
+ABSL_DECLARE_FLAG(std::uint32_t, normal_lane_workers);
+
+// Max marl workers running background tasks (asset streaming, decompression,
+// telemetry writes) at once.  Background tasks do not start while frame
+// critical ones run.  0 means quarter of workers, but at least one.
+ABSL_DECLARE_FLAG(std::uint32_t, background_lane_workers);
+
 #ifdef WB_OS_WIN
 // Changes minimal resolution (ms) of the Windows periodic timer.  Setting a
 // higher resolution can improve the accuracy of time-out intervals in wait
@@ -174,6 +292,47 @@ ABSL_DECLARE_FLAG(wb::apps::flags::PeriodicTimerResolution,
                   periodic_timer_resolution_ms);
 #endif  // WB_OS_WIN
 
+// Emergency memory reserve size in MiB.  Reserve is released on first out of
+// memory to survive transient allocation spikes.  0 disables reserve.
+ABSL_DECLARE_FLAG(std::uint32_t, emergency_memory_reserve_mib);
+
+// Frame arena capacity in KiB of one frame buffer per thread.  Allocations
+// which do not fit fall back to heap.
+ABSL_DECLARE_FLAG(std::uint32_t, frame_arena_capacity_kib);
+
+// Large pages arena size in MiB for hot data (world heaps, frame arenas).
+// Explicit 2 MiB pages are used when reserved by OS, transparent huge pages
+// otherwise.  Linux only.  0 disables arena.
+ABSL_DECLARE_FLAG(std::uint32_t, large_pages_arena_mib);
+
+// Memory budgets by category as comma separated list of category=soft:hard
+// limits in MiB, ex. textures=512:768,sounds=64:96.  Categories are textures,
+// sounds, world, scripts, ui and logging.  0 limit means no limit.
+ABSL_DECLARE_FLAG(wb::apps::flags::MemoryBudgets, memory_budgets);
+
+// How often (ms) to log memory budgets report.  0 disables periodic report.
+ABSL_DECLARE_FLAG(std::uint32_t, memory_budget_report_interval_ms);
+
+// Path to write memory budgets JSON report to on each periodic report.  Empty
+// disables JSON report.
+ABSL_DECLARE_FLAG(std::string, memory_budget_report_path);
+
+// How often (ms) to sample heap statistics (committed, reserved, pages, size
+// classes) and log them.  Sampled by world simulation step.  0 disables
+// sampling.
+ABSL_DECLARE_FLAG(std::uint32_t, heap_stats_sample_interval_ms);
+
+// Path to write heap statistics JSON to on each sample.  Empty disables JSON.
+ABSL_DECLARE_FLAG(std::string, heap_stats_path);
+
+// How often (ms) to poll localization catalogs for changes and hot reload
+// them.  Polled by world simulation step.  0 disables hot reload.
+ABSL_DECLARE_FLAG(std::uint32_t, catalogs_hot_reload_interval_ms);
+
+// Should count dTLB loads / misses and log them on exit or not.  Measures
+// large pages arena impact.  Linux only.
+ABSL_DECLARE_FLAG(bool, should_count_dtlb_misses);
+
 // Should dump heap allocator statistics on exit or not.  Included some process
 // info, like system / user elapsed time, peak working set size, hard page
 // faults, etc.
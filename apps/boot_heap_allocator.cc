@@ -11,6 +11,7 @@
 #include <cstring>  // std::abort
 
 #include "base/deps/g3log/g3log.h"
+#include "base/memory/large_pages_arena.h"
 #include "build/compiler_config.h"  // WB_COMPILER_
 
 #ifdef WB_MI_MALLOC
@@ -111,4 +112,15 @@ void BootHeapAllocator() noexcept {
 #endif  // WB_MI_MALLOC
 }
 
+void BootLargePagesArena(std::uint32_t arena_mib) noexcept {
+  if (arena_mib == 0) return;
+
+  const base::memory::LargePagesArenaInfo info{
+      base::memory::ReserveLargePagesArena(std::size_t{arena_mib} * 1024U *
+                                           1024U)};
+  G3LOG_IF(WARNING, info.kind == base::memory::LargePagesKind::kNone)
+      << "Unable to reserve " << arena_mib
+      << " MiB large pages arena, hot data uses regular heaps.";
+}
+
 }  // namespace wb::apps
@@ -7,6 +7,8 @@
 #ifndef WB_APPS_BOOT_HEAP_ALLOCATOR_H_
 #define WB_APPS_BOOT_HEAP_ALLOCATOR_H_
 
+#include <cstdint>
+
 #include "build/compiler_config.h"
 
 namespace wb::apps {
@@ -16,6 +18,13 @@ namespace wb::apps {
  */
 void BootHeapAllocator() noexcept;
 
+/**
+ * @brief Reserve large pages arena for hot data (world heaps, frame arenas).
+ * Falls back to regular pages when large ones are not available.
+ * @param arena_mib Arena size in MiB.  0 means no arena.
+ */
+void BootLargePagesArena(std::uint32_t arena_mib) noexcept;
+
 }  // namespace wb::apps
 
 #endif  // !WB_APPS_BOOT_HEAP_ALLOCATOR_H_
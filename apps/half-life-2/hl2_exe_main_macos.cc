@@ -13,6 +13,7 @@
 #include <unistd.h>
 
 #include <cerrno>
+#include <chrono>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdint>
@@ -20,6 +21,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <optional>
 #include <string_view>
 #include <system_error>
 
@@ -35,7 +37,13 @@
 #include "base/deps/g3log/scoped_g3log_initializer.h"
 #include "base/deps/sdl/message_box.h"
 #include "base/intl/l18n.h"
+#include "base/intl/lookup_with_fallback.h"
 #include "base/intl/scoped_process_locale.h"
+#include "base/memory/frame_arena.h"
+#include "base/memory/heap_stats.h"
+#include "base/memory/large_pages_arena.h"
+#include "base/memory/low_memory.h"
+#include "base/memory/memory_budget.h"
 #include "base/scoped_new_handler.h"
 #include "base/scoped_shared_library.h"
 #include "base/std2/system_error_ext.h"
@@ -69,8 +77,8 @@ __attribute__((visibility("default"))) int main(int argc, char* argv[]) {
   // Start with specifying UTF-8 locale for all user-facing data.
   const intl::ScopedProcessLocale scoped_process_locale{
       intl::ScopedProcessLocaleCategory::kAll, intl::locales::kUtf8Locale};
-  const auto l18n = wb::apps::CreateIntl(WB_PRODUCT_FILE_DESCRIPTION_STRING,
-                                         scoped_process_locale);
+  auto l18n = wb::apps::CreateIntl(WB_PRODUCT_FILE_DESCRIPTION_STRING,
+                                   scoped_process_locale);
 
   // Query CPU support for required features.  In case any required feature is
   // missed we return all required features with support state.
@@ -193,14 +201,29 @@ __attribute__((visibility("default"))) int main(int argc, char* argv[]) {
       absl::GetFlag(FLAGS_main_window_width)};
   const wb::apps::flags::WindowHeight main_window_height{
       absl::GetFlag(FLAGS_main_window_height)};
+  const wb::apps::flags::FramePipelineDepth frame_pipeline_depth{
+      absl::GetFlag(FLAGS_frame_pipeline_depth)};
+  const wb::apps::flags::WorkerPinning worker_pinning{
+      absl::GetFlag(FLAGS_worker_pinning)};
+  const bool should_reserve_main_thread_core{
+      absl::GetFlag(FLAGS_should_reserve_main_thread_core)};
+  const std::uint32_t normal_lane_workers{
+      absl::GetFlag(FLAGS_normal_lane_workers)};
+  const std::uint32_t background_lane_workers{
+      absl::GetFlag(FLAGS_background_lane_workers)};
   const bool should_dump_heap_allocator_statistics_on_exit{
       absl::GetFlag(FLAGS_should_dump_heap_allocator_statistics_on_exit)};
   const wb::boot_manager::CommandLineFlags command_line_flags{
       .positional_flags = std::move(positional_flags),
       .assets_path = std::move(assets_path.value),
       .attempts_to_retry_allocate_memory = attempts_to_retry_allocate_memory,
+      .normal_lane_workers = normal_lane_workers,
+      .background_lane_workers = background_lane_workers,
       .main_window_width = main_window_width.size,
       .main_window_height = main_window_height.size,
+      .frame_pipeline_depth = frame_pipeline_depth.depth,
+      .worker_pinning = worker_pinning.pinning,
+      .should_reserve_main_thread_core = should_reserve_main_thread_core,
       .insecure_allow_unsigned_module_target = false,
       .should_dump_heap_allocator_statistics_on_exit =
           should_dump_heap_allocator_statistics_on_exit};
@@ -219,6 +242,49 @@ __attribute__((visibility("default"))) int main(int argc, char* argv[]) {
   // handler.
   InstallGlobalScopedNewHandler(std::move(scoped_new_handler));
 
+  // Keep memory to release on out of memory.
+  const wb::base::memory::ScopedEmergencyMemoryReserve
+      scoped_emergency_memory_reserve{
+          std::size_t{absl::GetFlag(FLAGS_emergency_memory_reserve_mib)} *
+          1024U * 1024U};
+
+  // Keep hot data in large pages arena and measure dTLB impact.
+  wb::apps::BootLargePagesArena(absl::GetFlag(FLAGS_large_pages_arena_mib));
+  // Size frame arenas before threads allocate from them.
+  wb::base::memory::SetThreadFrameArenaCapacity(
+      std::size_t{absl::GetFlag(FLAGS_frame_arena_capacity_kib)} * 1024U);
+  std::optional<wb::base::memory::ScopedDtlbCounters> scoped_dtlb_counters;
+  if (absl::GetFlag(FLAGS_should_count_dtlb_misses)) {
+    scoped_dtlb_counters.emplace();
+  }
+
+  // Apply memory budgets and report usage periodically.
+  const wb::apps::flags::MemoryBudgets memory_budgets{
+      absl::GetFlag(FLAGS_memory_budgets)};
+  auto& memory_budget_tracker = wb::base::memory::GetMemoryBudgetTracker();
+  for (std::size_t i{0}; i < memory_budgets.budgets.size(); ++i) {
+    memory_budget_tracker.SetBudget(
+        static_cast<wb::base::memory::MemoryCategory>(i),
+        memory_budgets.budgets[i]);
+  }
+  const wb::base::memory::ScopedMemoryBudgetReporter
+      scoped_memory_budget_reporter{
+          memory_budget_tracker,
+          std::chrono::milliseconds{
+              absl::GetFlag(FLAGS_memory_budget_report_interval_ms)},
+          absl::GetFlag(FLAGS_memory_budget_report_path)};
+
+  // Sample heap statistics periodically to catch leaks and fragmentation.
+  const wb::base::memory::ScopedHeapStatsSampler scoped_heap_stats_sampler{
+      std::chrono::milliseconds{
+          absl::GetFlag(FLAGS_heap_stats_sample_interval_ms)},
+      absl::GetFlag(FLAGS_heap_stats_path)};
+
+  // Reload changed localization catalogs at frame boundaries.
+  const wb::base::intl::ScopedCatalogsHotReload scoped_catalogs_hot_reload{
+      l18n, std::chrono::milliseconds{
+                absl::GetFlag(FLAGS_catalogs_hot_reload_interval_ms)}};
+
   const auto boot_manager_main = *boot_manager_entry;
   G3CHECK(!!boot_manager_main);
 
@@ -10,6 +10,7 @@
 #include <utility>  // std::move
 
 #include "base/deps/g3log/g3log.h"
+#include "base/std2/filesystem_ext.h"
 
 namespace wb::apps {
 
@@ -34,7 +35,20 @@ namespace wb::apps {
       maybe_user_locale.value_or(locales::kFallbackLocale)};
   G3LOG(INFO) << app_name << " using " << user_locale << " locale for UI.";
 
-  auto intl_lookup{LookupWithFallback::New({user_locale})};
+  // Non-English locales are loaded from binary catalogs near executable.
+  const auto executable_directory =
+      wb::base::std2::filesystem::get_executable_directory();
+  G3LOG_IF(WARNING, !executable_directory)
+      << app_name << " unable to get executable directory, only built-in "
+      << "localization strings are available: "
+      << executable_directory.error().message();
+
+  const std::filesystem::path catalogs_directory{
+      executable_directory ? *executable_directory / "locales"
+                           : std::filesystem::path{}};
+
+  auto intl_lookup{LookupWithFallback::New({user_locale}, kFallbackString,
+                                           catalogs_directory)};
 
   G3LOG_IF(FATAL, !intl_lookup)
       << "Unable to create localization strings lookup for locale "
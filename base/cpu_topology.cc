@@ -0,0 +1,402 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// CPU topology and worker threads placement.
+
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "base/deps/g3log/g3log.h"
+#include "base/macroses.h"
+#include "base/std2/system_error_ext.h"
+#include "build/build_config.h"
+
+#ifdef WB_OS_LINUX
+#include <sched.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#endif
+
+namespace {
+
+/**
+ * @brief Max logical CPUs count.
+ */
+constexpr std::uint32_t kMaxCpusCount{8192};
+
+/**
+ * @brief Counts distinct values of CPU field.
+ * @param cpus CPUs.
+ * @param field CPU field.
+ * @return Distinct values count.
+ */
+[[nodiscard]] std::size_t CountDistinct(
+    const std::vector<wb::base::LogicalCpu>& cpus,
+    std::uint32_t wb::base::LogicalCpu::*field) {
+  std::vector<std::uint32_t> values;
+  values.reserve(cpus.size());
+
+  for (const auto& cpu : cpus) {
+    values.emplace_back(cpu.*field);
+  }
+
+  std::ranges::sort(values);
+  return static_cast<std::size_t>(
+      std::distance(values.begin(), std::ranges::unique(values).begin()));
+}
+
+/**
+ * @brief Parses CPU index.
+ * @param text Text.
+ * @return CPU index or std::nullopt.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE std::optional<std::uint32_t> ParseCpuIndex(
+    std::string_view text) noexcept {
+  std::uint32_t index{0};
+  const auto [end, rc] =
+      std::from_chars(text.data(), text.data() + text.size(), index);
+  return rc == std::errc{} && end == text.data() + text.size()
+             ? std::optional{index}
+             : std::nullopt;
+}
+
+/**
+ * @brief Is logical CPU a worker one?
+ * @param main_thread_cpus Logical CPUs reserved for the main thread.
+ * @param cpu Logical CPU.
+ * @return true if CPU is not reserved.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE bool IsWorkerCpu(
+    const std::vector<std::uint32_t>& main_thread_cpus,
+    const wb::base::LogicalCpu& cpu) noexcept {
+  return std::ranges::find(main_thread_cpus, cpu.index) ==
+         main_thread_cpus.end();
+}
+
+#ifdef WB_OS_LINUX
+/**
+ * @brief Reads first line of sysfs file.
+ * @param path File path.
+ * @return Line or std::nullopt when file can't be read.
+ */
+[[nodiscard]] std::optional<std::string> ReadSysfsLine(
+    const std::filesystem::path& path) {
+  std::ifstream file{path};
+  std::string line;
+  return std::getline(file, line) ? std::optional{std::move(line)}
+                                  : std::nullopt;
+}
+
+/**
+ * @brief Reads first CPU of sysfs CPU list.
+ * @param path CPU list file path.
+ * @return First CPU or std::nullopt.
+ */
+[[nodiscard]] std::optional<std::uint32_t> ReadFirstCpu(
+    const std::filesystem::path& path) {
+  const auto line = ReadSysfsLine(path);
+  if (!line) return std::nullopt;
+
+  const auto cpus = wb::base::ParseCpuList(*line);
+  return cpus && !cpus->empty() ? std::optional{cpus->front()}
+                                : std::nullopt;
+}
+
+/**
+ * @brief Removes CPUs process is not allowed to run on, ex. by taskset or
+ * cgroup cpuset.  CPUs are kept as is when affinity can't be read.
+ * @param cpus Logical CPUs.
+ */
+void KeepAllowedCpus(std::vector<std::uint32_t>& cpus) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (::sched_getaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    G3PLOG_E(WARNING, wb::base::std2::posix_last_error_code())
+        << "Unable to get process CPU affinity, assume all online CPUs are "
+           "allowed.";
+    return;
+  }
+
+  std::erase_if(cpus, [&](std::uint32_t cpu) {
+    return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &cpu_set);
+  });
+}
+
+/**
+ * @brief Reads logical CPU NUMA nodes.
+ * @return Pairs of CPU index and NUMA node.
+ */
+[[nodiscard]] std::vector<std::pair<std::uint32_t, std::uint32_t>>
+ReadNumaNodes() {
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> cpu_nodes;
+
+  std::error_code rc;
+  for (const auto& entry : std::filesystem::directory_iterator{
+           "/sys/devices/system/node", rc}) {
+    const std::string name{entry.path().filename().string()};
+    if (!name.starts_with("node")) continue;
+
+    const auto node = ParseCpuIndex(std::string_view{name}.substr(4));
+    if (!node) continue;
+
+    const auto line = ReadSysfsLine(entry.path() / "cpulist");
+    if (!line) continue;
+
+    if (const auto cpus = wb::base::ParseCpuList(*line); cpus) {
+      for (const std::uint32_t cpu : *cpus) {
+        cpu_nodes.emplace_back(cpu, *node);
+      }
+    }
+  }
+
+  return cpu_nodes;
+}
+
+/**
+ * @brief Queries CPU topology from sysfs.
+ * @return CPU topology or std::nullopt when sysfs is not available.
+ */
+[[nodiscard]] std::optional<wb::base::CpuTopology> QuerySysfsCpuTopology() {
+  const std::filesystem::path cpus_path{"/sys/devices/system/cpu"};
+
+  const auto online_line = ReadSysfsLine(cpus_path / "online");
+  if (!online_line) return std::nullopt;
+
+  auto online_cpus = wb::base::ParseCpuList(*online_line);
+  if (!online_cpus) return std::nullopt;
+
+  // Workers should not be planned on CPUs process can't run on.
+  KeepAllowedCpus(*online_cpus);
+  if (online_cpus->empty()) return std::nullopt;
+
+  const auto cpu_nodes = ReadNumaNodes();
+
+  // Last level cache group keys, made dense below.
+  constexpr std::uint32_t kNoL3CacheBit{1U << 31U};
+  std::vector<std::uint32_t> cache_keys;
+
+  wb::base::CpuTopology topology;
+  topology.cpus.reserve(online_cpus->size());
+
+  for (const std::uint32_t index : *online_cpus) {
+    const std::filesystem::path cpu_path{cpus_path /
+                                         ("cpu" + std::to_string(index))};
+
+    const auto node_it =
+        std::ranges::find(cpu_nodes, index,
+                          &std::pair<std::uint32_t, std::uint32_t>::first);
+    const std::uint32_t numa_node{
+        node_it != cpu_nodes.end() ? node_it->second : 0U};
+
+    std::optional<std::uint32_t> l3_first_cpu;
+    for (std::uint32_t i{0}; !l3_first_cpu; ++i) {
+      const std::filesystem::path cache_path{
+          cpu_path / "cache" / ("index" + std::to_string(i))};
+      const auto level = ReadSysfsLine(cache_path / "level");
+      if (!level) break;
+
+      if (*level == "3") {
+        l3_first_cpu = ReadFirstCpu(cache_path / "shared_cpu_list");
+      }
+    }
+
+    cache_keys.emplace_back(l3_first_cpu.value_or(kNoL3CacheBit | numa_node));
+    topology.cpus.emplace_back(wb::base::LogicalCpu{
+        .index = index,
+        .core = ReadFirstCpu(cpu_path / "topology" / "thread_siblings_list")
+                    .value_or(index),
+        .cache_group = 0,
+        .numa_node = numa_node});
+  }
+
+  std::vector<std::uint32_t> distinct_cache_keys{cache_keys};
+  std::ranges::sort(distinct_cache_keys);
+  distinct_cache_keys.erase(std::ranges::unique(distinct_cache_keys).begin(),
+                            distinct_cache_keys.end());
+
+  for (std::size_t i{0}; i < topology.cpus.size(); ++i) {
+    topology.cpus[i].cache_group = static_cast<std::uint32_t>(std::distance(
+        distinct_cache_keys.begin(),
+        std::ranges::lower_bound(distinct_cache_keys, cache_keys[i])));
+  }
+
+  return topology;
+}
+#endif  // WB_OS_LINUX
+
+}  // namespace
+
+namespace wb::base {
+
+[[nodiscard]] WB_BASE_API std::size_t CpuTopology::GetCoresCount()
+    const noexcept {
+  return CountDistinct(cpus, &LogicalCpu::core);
+}
+
+[[nodiscard]] WB_BASE_API std::size_t CpuTopology::GetCacheGroupsCount()
+    const noexcept {
+  return CountDistinct(cpus, &LogicalCpu::cache_group);
+}
+
+[[nodiscard]] WB_BASE_API std::size_t CpuTopology::GetNumaNodesCount()
+    const noexcept {
+  return CountDistinct(cpus, &LogicalCpu::numa_node);
+}
+
+[[nodiscard]] WB_BASE_API std::optional<std::vector<std::uint32_t>>
+ParseCpuList(std::string_view cpu_list) {
+  while (!cpu_list.empty() &&
+         (cpu_list.back() == '\n' || cpu_list.back() == ' ')) {
+    cpu_list.remove_suffix(1);
+  }
+
+  std::vector<std::uint32_t> cpus;
+
+  while (!cpu_list.empty()) {
+    const std::size_t comma_idx{cpu_list.find(',')};
+    const std::string_view range{cpu_list.substr(0, comma_idx)};
+    cpu_list = comma_idx != std::string_view::npos
+                   ? cpu_list.substr(comma_idx + 1)
+                   : std::string_view{};
+
+    const std::size_t dash_idx{range.find('-')};
+    const auto first = ParseCpuIndex(range.substr(0, dash_idx));
+    const auto last = dash_idx != std::string_view::npos
+                          ? ParseCpuIndex(range.substr(dash_idx + 1))
+                          : first;
+    // Linux supports 8192 CPUs at most.
+    if (!first || !last || *first > *last || *last >= kMaxCpusCount) {
+      return std::nullopt;
+    }
+
+    for (std::uint32_t cpu{*first}; cpu <= *last; ++cpu) {
+      cpus.emplace_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+[[nodiscard]] WB_BASE_API CpuTopology
+QueryCpuTopology(std::uint32_t logical_cpus_count) {
+#ifdef WB_OS_LINUX
+  if (auto topology = QuerySysfsCpuTopology(); topology) {
+    return std::move(*topology);
+  }
+
+  G3LOG(WARNING) << "Unable to read CPU topology from "
+                    "/sys/devices/system/cpu, assume each logical CPU is "
+                    "physical core.";
+#endif  // WB_OS_LINUX
+
+  CpuTopology topology;
+  topology.cpus.reserve(logical_cpus_count);
+
+  for (std::uint32_t i{0}; i < logical_cpus_count; ++i) {
+    topology.cpus.emplace_back(
+        LogicalCpu{.index = i, .core = i, .cache_group = 0, .numa_node = 0});
+  }
+
+  return topology;
+}
+
+[[nodiscard]] WB_BASE_API std::string_view GetWorkerPinningName(
+    WorkerPinning pinning) noexcept {
+  switch (pinning) {
+    case WorkerPinning::kNone:
+      return "none";
+    case WorkerPinning::kCores:
+      return "cores";
+    case WorkerPinning::kCacheGroups:
+      return "ccx";
+    default:
+      G3DCHECK(false) << "Unknown worker pinning " << underlying_cast(pinning)
+                      << ".";
+      return "unknown";
+  }
+}
+
+[[nodiscard]] WB_BASE_API WorkerPlacement
+PlanWorkerPlacement(const CpuTopology& topology, WorkerPinning pinning,
+                    bool should_reserve_main_thread_core) {
+  WorkerPlacement placement;
+
+  // Physical cores in order of first logical CPU.
+  std::vector<std::uint32_t> core_ids;
+  std::vector<std::vector<std::uint32_t>> core_cpus;
+
+  for (const auto& cpu : topology.cpus) {
+    const auto it = std::ranges::find(core_ids, cpu.core);
+    if (it != core_ids.end()) {
+      core_cpus[static_cast<std::size_t>(
+                    std::distance(core_ids.begin(), it))]
+          .emplace_back(cpu.index);
+    } else {
+      core_ids.emplace_back(cpu.core);
+      core_cpus.emplace_back(std::vector{cpu.index});
+    }
+  }
+
+  std::size_t first_worker_core{0};
+  if (should_reserve_main_thread_core && core_cpus.size() > 1) {
+    placement.main_thread_cpus = core_cpus.front();
+    first_worker_core = 1;
+  }
+
+  switch (pinning) {
+    case WorkerPinning::kNone: {
+      std::vector<std::uint32_t> worker_cpus;
+      for (const auto& cpu : topology.cpus) {
+        if (IsWorkerCpu(placement.main_thread_cpus, cpu)) {
+          worker_cpus.emplace_back(cpu.index);
+        }
+      }
+
+      // Not pinned, but keep workers off main thread core if reserved.
+      placement.worker_cpus.resize(
+          worker_cpus.size(), !placement.main_thread_cpus.empty()
+                                  ? worker_cpus
+                                  : std::vector<std::uint32_t>{});
+      break;
+    }
+
+    case WorkerPinning::kCores:
+      placement.worker_cpus.assign(
+          core_cpus.begin() + static_cast<std::ptrdiff_t>(first_worker_core),
+          core_cpus.end());
+      break;
+
+    case WorkerPinning::kCacheGroups:
+      for (std::size_t i{first_worker_core}; i < core_cpus.size(); ++i) {
+        const auto core_cpu = std::ranges::find(
+            topology.cpus, core_cpus[i].front(), &LogicalCpu::index);
+
+        std::vector<std::uint32_t> worker_cpus;
+        for (const auto& cpu : topology.cpus) {
+          if (cpu.cache_group == core_cpu->cache_group &&
+              IsWorkerCpu(placement.main_thread_cpus, cpu)) {
+            worker_cpus.emplace_back(cpu.index);
+          }
+        }
+
+        placement.worker_cpus.emplace_back(std::move(worker_cpus));
+      }
+      break;
+
+    default:
+      G3DCHECK(false) << "Unknown worker pinning "
+                      << underlying_cast(pinning) << ".";
+      break;
+  }
+
+  if (placement.worker_cpus.empty()) placement.worker_cpus.emplace_back();
+
+  return placement;
+}
+
+}  // namespace wb::base
@@ -0,0 +1,145 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// CPU topology and worker threads placement.
+
+#ifndef WB_BASE_CPU_TOPOLOGY_H_
+#define WB_BASE_CPU_TOPOLOGY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "base/config.h"
+#include "build/compiler_config.h"
+
+namespace wb::base {
+
+/**
+ * @brief Logical CPU (hardware thread) placement.
+ */
+struct LogicalCpu {
+  /**
+   * @brief OS logical CPU index.
+   */
+  std::uint32_t index;
+  /**
+   * @brief Physical core id.  Logical CPUs of the same core are SMT siblings.
+   */
+  std::uint32_t core;
+  /**
+   * @brief Last level (L3) cache group id, ex. AMD CCX.  NUMA node when cache
+   * info is not available.
+   */
+  std::uint32_t cache_group;
+  /**
+   * @brief NUMA node id.
+   */
+  std::uint32_t numa_node;
+};
+
+/**
+ * @brief CPU topology.
+ */
+struct CpuTopology {
+  /**
+   * @brief Online logical CPUs sorted by index.
+   */
+  std::vector<LogicalCpu> cpus;
+
+  /**
+   * @brief Gets physical cores count.
+   */
+  [[nodiscard]] WB_BASE_API std::size_t GetCoresCount() const noexcept;
+
+  /**
+   * @brief Gets last level cache groups count.
+   */
+  [[nodiscard]] WB_BASE_API std::size_t GetCacheGroupsCount() const noexcept;
+
+  /**
+   * @brief Gets NUMA nodes count.
+   */
+  [[nodiscard]] WB_BASE_API std::size_t GetNumaNodesCount() const noexcept;
+};
+
+/**
+ * @brief Parses Linux CPU list, ex. 0-3,8,10-11.
+ * @param cpu_list CPU list.
+ * @return CPU indices or std::nullopt when list is malformed.
+ */
+[[nodiscard]] WB_BASE_API std::optional<std::vector<std::uint32_t>>
+ParseCpuList(std::string_view cpu_list);
+
+/**
+ * @brief Queries CPU topology.  Physical cores, SMT siblings, L3 groups and
+ * NUMA nodes are detected on Linux only, each logical CPU is own core in
+ * single cache group and NUMA node on other OSes.  On Linux only online CPUs
+ * process is allowed to run on (see sched_getaffinity) are included.
+ * @param logical_cpus_count Logical CPUs count when topology is not available.
+ * @return CPU topology.
+ */
+[[nodiscard]] WB_BASE_API CpuTopology
+QueryCpuTopology(std::uint32_t logical_cpus_count);
+
+/**
+ * @brief How to place worker threads on CPUs.
+ */
+enum class WorkerPinning : std::uint8_t {
+  /**
+   * @brief Worker per logical CPU, OS places workers.
+   */
+  kNone,
+  /**
+   * @brief Worker per physical core pinned to core, so workers do not share
+   * cores with SMT siblings.
+   */
+  kCores,
+  /**
+   * @brief Worker per physical core pinned to its last level cache group
+   * (CCX), so OS migrates workers within group only.
+   */
+  kCacheGroups,
+};
+
+/**
+ * @brief Gets worker pinning name.
+ * @param pinning Worker pinning.
+ * @return Worker pinning name.
+ */
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_CONST std::string_view
+GetWorkerPinningName(WorkerPinning pinning) noexcept;
+
+/**
+ * @brief Worker threads placement.
+ */
+struct WorkerPlacement {
+  /**
+   * @brief Logical CPUs per worker.  Empty CPUs mean worker is not pinned.
+   */
+  std::vector<std::vector<std::uint32_t>> worker_cpus;
+  /**
+   * @brief Logical CPUs reserved for the main thread.  Empty when no core is
+   * reserved.
+   */
+  std::vector<std::uint32_t> main_thread_cpus;
+};
+
+/**
+ * @brief Plans worker threads placement.
+ * @param topology CPU topology.
+ * @param pinning Worker pinning.
+ * @param should_reserve_main_thread_core Should reserve first physical core
+ * for the main thread?  Ignored when there is single core.
+ * @return Worker threads placement.  Always has at least one worker.
+ */
+[[nodiscard]] WB_BASE_API WorkerPlacement
+PlanWorkerPlacement(const CpuTopology& topology, WorkerPinning pinning,
+                    bool should_reserve_main_thread_core);
+
+}  // namespace wb::base
+
+#endif  // !WB_BASE_CPU_TOPOLOGY_H_
@@ -0,0 +1,135 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// CPU topology and worker threads placement.
+
+#include "cpu_topology.h"
+//
+#include <algorithm>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "build/build_config.h"
+
+#ifdef WB_OS_LINUX
+#include <sched.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Makes 2 CCX x 2 cores x 2 SMT siblings topology.  Siblings are N and
+ * N + 4, like on Linux.
+ * @return CPU topology.
+ */
+[[nodiscard]] wb::base::CpuTopology MakeTwoCcxTopology() {
+  wb::base::CpuTopology topology;
+
+  for (std::uint32_t i{0}; i < 8; ++i) {
+    const std::uint32_t core{i % 4};
+    topology.cpus.emplace_back(wb::base::LogicalCpu{
+        .index = i, .core = core, .cache_group = core / 2, .numa_node = 0});
+  }
+
+  return topology;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CpuTopologyTest, ParseCpuList) {
+  using namespace wb::base;
+
+  using cpus = std::vector<std::uint32_t>;
+
+  EXPECT_EQ(cpus{}, ParseCpuList(""));
+  EXPECT_EQ(cpus{0}, ParseCpuList("0\n"));
+  EXPECT_EQ((cpus{0, 1, 2, 3}), ParseCpuList("0-3"));
+  EXPECT_EQ((cpus{0, 1, 8, 10, 11}), ParseCpuList("0-1,8,10-11"));
+
+  EXPECT_EQ(std::nullopt, ParseCpuList("3-1"));
+  EXPECT_EQ(std::nullopt, ParseCpuList("0,,1"));
+  EXPECT_EQ(std::nullopt, ParseCpuList("a-b"));
+  EXPECT_EQ(std::nullopt, ParseCpuList("0-4294967295"));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CpuTopologyTest, QueryCpuTopology) {
+  using namespace wb::base;
+
+  const CpuTopology topology{QueryCpuTopology(4)};
+
+  ASSERT_FALSE(topology.cpus.empty());
+  EXPECT_GE(topology.GetCoresCount(), 1U);
+  EXPECT_LE(topology.GetCoresCount(), topology.cpus.size());
+  EXPECT_GE(topology.GetCacheGroupsCount(), 1U);
+  EXPECT_LE(topology.GetCacheGroupsCount(), topology.GetCoresCount());
+  EXPECT_GE(topology.GetNumaNodesCount(), 1U);
+
+  EXPECT_TRUE(std::ranges::is_sorted(topology.cpus, {}, &LogicalCpu::index));
+
+#ifdef WB_OS_LINUX
+  // Only CPUs process can run on.
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  ASSERT_EQ(0, ::sched_getaffinity(0, sizeof(cpu_set), &cpu_set));
+  for (const auto& cpu : topology.cpus) {
+    EXPECT_TRUE(CPU_ISSET(cpu.index, &cpu_set)) << cpu.index;
+  }
+#endif
+
+  const CpuTopology two_ccx_topology{MakeTwoCcxTopology()};
+  EXPECT_EQ(4U, two_ccx_topology.GetCoresCount());
+  EXPECT_EQ(2U, two_ccx_topology.GetCacheGroupsCount());
+  EXPECT_EQ(1U, two_ccx_topology.GetNumaNodesCount());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CpuTopologyTest, PlanWorkerPlacement) {
+  using namespace wb::base;
+
+  using cpus = std::vector<std::uint32_t>;
+
+  const CpuTopology topology{MakeTwoCcxTopology()};
+
+  WorkerPlacement placement{
+      PlanWorkerPlacement(topology, WorkerPinning::kNone, false)};
+  EXPECT_EQ(8U, placement.worker_cpus.size());
+  EXPECT_EQ(cpus{}, placement.worker_cpus[0]);
+  EXPECT_EQ(cpus{}, placement.main_thread_cpus);
+
+  placement = PlanWorkerPlacement(topology, WorkerPinning::kNone, true);
+  ASSERT_EQ(6U, placement.worker_cpus.size());
+  EXPECT_EQ((cpus{1, 2, 3, 5, 6, 7}), placement.worker_cpus[0]);
+  EXPECT_EQ((cpus{0, 4}), placement.main_thread_cpus);
+
+  placement = PlanWorkerPlacement(topology, WorkerPinning::kCores, false);
+  ASSERT_EQ(4U, placement.worker_cpus.size());
+  EXPECT_EQ((cpus{0, 4}), placement.worker_cpus[0]);
+  EXPECT_EQ((cpus{3, 7}), placement.worker_cpus[3]);
+
+  placement = PlanWorkerPlacement(topology, WorkerPinning::kCores, true);
+  ASSERT_EQ(3U, placement.worker_cpus.size());
+  EXPECT_EQ((cpus{1, 5}), placement.worker_cpus[0]);
+  EXPECT_EQ((cpus{0, 4}), placement.main_thread_cpus);
+
+  placement = PlanWorkerPlacement(topology, WorkerPinning::kCacheGroups, true);
+  ASSERT_EQ(3U, placement.worker_cpus.size());
+  // Reserved core is excluded from its CCX.
+  EXPECT_EQ((cpus{1, 5}), placement.worker_cpus[0]);
+  EXPECT_EQ((cpus{2, 3, 6, 7}), placement.worker_cpus[1]);
+  EXPECT_EQ((cpus{2, 3, 6, 7}), placement.worker_cpus[2]);
+
+  // Single core is never reserved.
+  CpuTopology single_core;
+  single_core.cpus.emplace_back(
+      LogicalCpu{.index = 0, .core = 0, .cache_group = 0, .numa_node = 0});
+
+  placement = PlanWorkerPlacement(single_core, WorkerPinning::kCores, true);
+  ASSERT_EQ(1U, placement.worker_cpus.size());
+  EXPECT_EQ(cpus{0}, placement.worker_cpus[0]);
+  EXPECT_EQ(cpus{}, placement.main_thread_cpus);
+
+  placement = PlanWorkerPlacement({}, WorkerPinning::kCacheGroups, true);
+  EXPECT_EQ(1U, placement.worker_cpus.size());
+}
@@ -15,6 +15,7 @@
 #include "base/deps/g3log/g3log.h"
 #include "base/deps/mimalloc/mimalloc.h"
 #include "base/internals/scoped_new_handler_internal.h"
+#include "base/memory/low_memory.h"
 #include "base/scoped_new_handler.h"
 #include "base/std2/thread_ext.h"
 #include "build/compiler_config.h"
@@ -60,12 +61,28 @@ WB_BASE_API void DefaultNewFailureHandler() {
 
   is_recursive_new_failure = true;
 
+  // Emergency reserve gives enough room to survive transient allocation
+  // spikes, so use it first.  Does not count as retry.
+  if (memory::ReleaseEmergencyMemoryReserve()) {
+    const std::size_t callbacks_count{memory::RunLowMemoryCallbacks()};
+
+    G3LOG(WARNING) << "Thread (" << std::this_thread::get_id() << ", "
+                   << GetThreadName()
+                   << ") failed to allocate memory via new.  Released "
+                      "emergency memory reserve and called "
+                   << callbacks_count << " low memory callbacks.";
+    return;
+  }
+
   const uint32_t max_new_retries_count{
       internals::GetGlobalScopedNewHandlerMaxNewRetriesCount()};
 
   if (actual_new_retries_count < max_new_retries_count) [[likely]] {
     ++actual_new_retries_count;
 
+    // Ask subsystems to drop caches, evict assets, etc.
+    memory::RunLowMemoryCallbacks();
+
     ::mi_collect(false);
 
 #ifdef WB_OS_WIN
@@ -12,7 +12,9 @@
 namespace wb::base {
 
 /**
- * @brief Default new memory allocation failure handler.
+ * @brief Default new memory allocation failure handler.  Releases emergency
+ * memory reserve first, then calls low memory callbacks on each retry and
+ * exits when retries are exhausted.
  * @return void.
  */
 WB_BASE_API void DefaultNewFailureHandler();
@@ -0,0 +1,16 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// `absl::FunctionRef` is non-owning, allocation free reference to callable.
+
+#ifndef WB_BASE_DEPS_ABSEIL_FUNCTIONAL_FUNCTION_REF_H_
+#define WB_BASE_DEPS_ABSEIL_FUNCTIONAL_FUNCTION_REF_H_
+
+#include "base/deps/abseil/abseil_config.h"
+
+WB_BEGIN_ABSEIL_WARNING_OVERRIDE_SCOPE()
+#include "deps/abseil/absl/functional/function_ref.h"
+WB_END_ABSEIL_WARNING_OVERRIDE_SCOPE()
+
+#endif  // !WB_BASE_DEPS_ABSEIL_FUNCTIONAL_FUNCTION_REF_H_
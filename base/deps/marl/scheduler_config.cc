@@ -6,6 +6,10 @@
 
 #include "base/deps/marl/scheduler_config.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include "base/deps/abseil/strings/str_cat.h"
 #include "base/deps/g3log/g3log.h"
 #include "base/std2/thread_ext.h"
@@ -94,6 +98,38 @@ class WhiteboxThreadStartState::Impl final {
 const std2::native_thread_name
     WhiteboxThreadStartState::Impl::kThreadNamePrefix = "WhiteBox_Worker#";
 
+#ifdef WB_OS_LINUX
+/**
+ * @brief Pins each worker to own set of logical CPUs.
+ */
+class WorkerAffinityPolicy final : public ::marl::Thread::Affinity::Policy {
+ public:
+  explicit WorkerAffinityPolicy(
+      std::vector<std::vector<std::uint32_t>> worker_cpus) noexcept
+      : worker_cpus_{std::move(worker_cpus)} {
+    G3DCHECK(!worker_cpus_.empty());
+  }
+
+  [[nodiscard]] ::marl::Thread::Affinity get(
+      std::uint32_t threadId, ::marl::Allocator *allocator) const override {
+    ::marl::Thread::Affinity affinity{allocator};
+
+    const auto &cpus = worker_cpus_[threadId % worker_cpus_.size()];
+    for (const std::uint32_t cpu : cpus) {
+      ::marl::Thread::Core core{};
+      core.pthread.index = static_cast<std::uint16_t>(cpu);
+
+      affinity.add(::marl::Thread::Affinity{{core}, allocator});
+    }
+
+    return affinity;
+  }
+
+ private:
+  const std::vector<std::vector<std::uint32_t>> worker_cpus_;
+};
+#endif  // WB_OS_LINUX
+
 WhiteboxThreadStartState::WhiteboxThreadStartState(int workerId) noexcept
     : impl_{std::make_unique<Impl>(workerId)} {}
 
@@ -104,4 +140,17 @@ WB_BASE_API std::unique_ptr<::marl::Thread::StartState> make_thread_start_state(
   return std::make_unique<WhiteboxThreadStartState>(workerId);
 }
 
+WB_BASE_API std::shared_ptr<::marl::Thread::Affinity::Policy>
+make_worker_affinity_policy([[maybe_unused]] const WorkerPlacement &placement) {
+#ifdef WB_OS_LINUX
+  const bool is_pinned{std::ranges::any_of(
+      placement.worker_cpus, [](const auto &cpus) { return !cpus.empty(); })};
+  if (is_pinned) {
+    return std::make_shared<WorkerAffinityPolicy>(placement.worker_cpus);
+  }
+#endif  // WB_OS_LINUX
+
+  return nullptr;
+}
+
 }  // namespace wb::base::deps::marl
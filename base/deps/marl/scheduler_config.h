@@ -10,6 +10,7 @@
 #include <memory>
 
 #include "base/config.h"
+#include "base/cpu_topology.h"
 #include "base/deps/marl/thread.h"
 #include "base/macroses.h"
 #include "build/compiler_config.h"
@@ -47,6 +48,15 @@ WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
 WB_BASE_API std::unique_ptr<::marl::Thread::StartState> make_thread_start_state(
     int workerId);
 
+/**
+ * @brief Make worker threads affinity policy which pins workers as planned.
+ * @param placement Worker threads placement.
+ * @return Affinity policy or nullptr when workers are not pinned or pinning is
+ * not supported (Linux only).
+ */
+WB_BASE_API std::shared_ptr<::marl::Thread::Affinity::Policy>
+make_worker_affinity_policy(const WorkerPlacement &placement);
+
 }  // namespace wb::base::deps::marl
 
 #endif  // !WB_BASE_DEPS_MARL_SCHEDULER_CONFIG_H_
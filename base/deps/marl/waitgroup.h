@@ -2,15 +2,15 @@
 // Use of this source code is governed by a 3-Clause BSD license that can be
 // found in the LICENSE file.
 //
-// marl event.h wrapper.
+// marl waitgroup.h wrapper.
 
-#ifndef WB_BASE_DEPS_MARL_EVENT_H_
-#define WB_BASE_DEPS_MARL_EVENT_H_
+#ifndef WB_BASE_DEPS_MARL_WAITGROUP_H_
+#define WB_BASE_DEPS_MARL_WAITGROUP_H_
 
 #include "base/deps/marl/marl_config.h"
 
 WB_BEGIN_MARL_WARNING_OVERRIDE_SCOPE()
-#include "deps/marl/include/marl/event.h"
+#include "deps/marl/include/marl/waitgroup.h"
 WB_END_MARL_WARNING_OVERRIDE_SCOPE()
 
-#endif  // !WB_BASE_DEPS_MARL_EVENT_H_
+#endif  // !WB_BASE_DEPS_MARL_WAITGROUP_H_
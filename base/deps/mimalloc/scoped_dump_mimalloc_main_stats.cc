@@ -8,6 +8,7 @@
 
 #include "base/deps/g3log/g3log.h"
 #include "base/deps/mimalloc/mimalloc.h"
+#include "base/memory/subsystem_heap.h"
 #include "base/std2/string_view_ext.h"
 
 namespace {
@@ -55,6 +56,9 @@ ScopedDumpMiMainStats::~ScopedDumpMiMainStats() noexcept {
     // Print the main statistics (and process statistics).  Most detailed when
     // using a debug build.
     PrintMiStats();
+
+    // Subsystem heaps share main statistics, so print their own ones.
+    base::memory::LogSubsystemHeapsStats();
   }
 }
 
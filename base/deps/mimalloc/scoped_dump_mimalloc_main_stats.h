@@ -14,7 +14,8 @@ namespace wb::mi {
 
 /**
  * @brief Reset statistics.  Merge thread local statistics with the main
- * statistics and reset. Dumps the main mimalloc statistics.  Depends on g3log!
+ * statistics and reset. Dumps the main mimalloc statistics and subsystem heaps
+ * statistics.  Depends on g3log!
  */
 class WB_BASE_API ScopedDumpMiMainStats {
  public:
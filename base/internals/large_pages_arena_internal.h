@@ -0,0 +1,23 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Large pages backed mimalloc arena for hot data.
+
+#ifndef WB_BASE_INTERNALS_LARGE_PAGES_ARENA_INTERNAL_H_
+#define WB_BASE_INTERNALS_LARGE_PAGES_ARENA_INTERNAL_H_
+
+#include "base/deps/mimalloc/mimalloc.h"
+
+namespace wb::base::internals {
+
+/**
+ * @brief Creates heap in large pages arena.  Heap allocates only in arena and
+ * fails when arena is full.  Heap is owned by calling thread.
+ * @return Heap or nullptr when no large pages arena.
+ */
+[[nodiscard]] mi_heap_t* NewLargePagesArenaHeap() noexcept;
+
+}  // namespace wb::base::internals
+
+#endif  // !WB_BASE_INTERNALS_LARGE_PAGES_ARENA_INTERNAL_H_
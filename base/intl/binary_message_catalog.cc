@@ -0,0 +1,264 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Binary message catalog format.
+
+#include "base/intl/binary_message_catalog.h"
+
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "base/deps/g3log/g3log.h"
+
+namespace {
+
+static_assert(sizeof(wb::base::intl::BinaryMessageCatalogHeader) == 40 &&
+                  std::is_trivially_copyable_v<
+                      wb::base::intl::BinaryMessageCatalogHeader>,
+              "Binary message catalog header layout changed.  Bump "
+              "kBinaryMessageCatalogVersion.");
+static_assert(sizeof(wb::base::intl::BinaryMessageCatalogSlot) == 16 &&
+                  std::is_trivially_copyable_v<
+                      wb::base::intl::BinaryMessageCatalogSlot>,
+              "Binary message catalog slot layout changed.  Bump "
+              "kBinaryMessageCatalogVersion.");
+
+/**
+ * @brief Binary message catalog sections alignment.
+ */
+constexpr std::size_t kSectionAlignment{
+    alignof(wb::base::intl::BinaryMessageCatalogSlot)};
+
+/**
+ * @brief Aligns |offset| up to section alignment.
+ * @param offset Offset.
+ * @return Aligned offset.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST constexpr std::size_t AlignSection(
+    std::size_t offset) noexcept {
+  return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+/**
+ * @brief Is |offset| + |size| within |bytes_count| and |offset| aligned to
+ * |alignment|?
+ * @param offset Section offset.
+ * @param size Section size.
+ * @param alignment Section alignment.
+ * @param bytes_count Catalog size.
+ * @return true if section is valid.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST constexpr bool IsValidSection(
+    std::uint64_t offset, std::uint64_t size, std::uint64_t alignment,
+    std::uint64_t bytes_count) noexcept {
+  return offset % alignment == 0 && offset <= bytes_count &&
+         size <= bytes_count - offset;
+}
+
+/**
+ * @brief Logs invalid catalog |reason| and returns kArgumentError.
+ * @param reason Reason why catalog is invalid.
+ * @return kArgumentError.
+ */
+[[nodiscard]] wb::base::intl::LookupResult<
+    wb::base::intl::BinaryMessageCatalogView>
+InvalidCatalog(const char* reason) noexcept {
+  G3LOG(WARNING) << "Invalid binary message catalog: " << reason;
+  return wb::base::intl::LookupResult<
+      wb::base::intl::BinaryMessageCatalogView>{
+      std::unexpect, wb::base::intl::Status::kArgumentError};
+}
+
+}  // namespace
+
+namespace wb::base::intl {
+
+[[nodiscard]] LookupResult<BinaryMessageCatalogView>
+BinaryMessageCatalogView::New(std::span<const std::byte> bytes) noexcept {
+  if (bytes.size() < sizeof(BinaryMessageCatalogHeader)) [[unlikely]] {
+    return InvalidCatalog("too small for header.");
+  }
+
+  if (reinterpret_cast<std::uintptr_t>(bytes.data()) % kSectionAlignment != 0)
+      [[unlikely]] {
+    return InvalidCatalog("bytes are not aligned.");
+  }
+
+  BinaryMessageCatalogHeader header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+
+  if (header.magic != kBinaryMessageCatalogMagic) [[unlikely]] {
+    return InvalidCatalog("magic mismatch.");
+  }
+
+  if (header.version != kBinaryMessageCatalogVersion) [[unlikely]] {
+    return InvalidCatalog("version mismatch.");
+  }
+
+  if (header.string_layout !=
+          static_cast<std::uint32_t>(StringLayout::LeftToRight) &&
+      header.string_layout !=
+          static_cast<std::uint32_t>(StringLayout::RightToLeft)) [[unlikely]] {
+    return InvalidCatalog("unknown string layout.");
+  }
+
+  if (!std::has_single_bit(header.buckets_count) ||
+      !std::has_single_bit(header.slots_count) ||
+      header.messages_count >= header.slots_count) [[unlikely]] {
+    return InvalidCatalog("buckets or slots count is invalid.");
+  }
+
+  if (header.buckets_count > std::numeric_limits<std::uint16_t>::max() ||
+      !IsValidSection(header.displacements_offset,
+                      std::uint64_t{header.buckets_count} *
+                          sizeof(std::uint16_t),
+                      alignof(std::uint16_t), bytes.size()) ||
+      !IsValidSection(header.slots_offset,
+                      std::uint64_t{header.slots_count} *
+                          sizeof(BinaryMessageCatalogSlot),
+                      alignof(BinaryMessageCatalogSlot), bytes.size()) ||
+      !IsValidSection(header.strings_offset, header.strings_size, 1,
+                      bytes.size())) [[unlikely]] {
+    return InvalidCatalog("section is out of bounds.");
+  }
+
+  // Alignment is checked above, and mapped catalog is never written, so it is
+  // safe to view bytes as arrays of trivially copyable types.
+  const std::span<const std::uint16_t> displacements{
+      reinterpret_cast<const std::uint16_t*>(bytes.data() +
+                                             header.displacements_offset),
+      header.buckets_count};
+  const std::span<const BinaryMessageCatalogSlot> slots{
+      reinterpret_cast<const BinaryMessageCatalogSlot*>(bytes.data() +
+                                                        header.slots_offset),
+      header.slots_count};
+  const auto* strings =
+      reinterpret_cast<const char*>(bytes.data() + header.strings_offset);
+
+  // Check once here, so Find never reads out of bounds or returns not
+  // null-terminated strings.
+  std::uint32_t messages_count{0};
+  for (const BinaryMessageCatalogSlot& slot : slots) {
+    if (slot.id == 0) continue;
+
+    if (std::uint64_t{slot.text_offset} + slot.text_size >=
+            header.strings_size ||
+        strings[std::uint64_t{slot.text_offset} + slot.text_size] != '\0')
+        [[unlikely]] {
+      return InvalidCatalog("message text is out of bounds.");
+    }
+
+    ++messages_count;
+  }
+
+  if (messages_count != header.messages_count) [[unlikely]] {
+    return InvalidCatalog("messages count mismatch.");
+  }
+
+  return BinaryMessageCatalogView{displacements, slots, strings,
+                                  static_cast<StringLayout>(
+                                      header.string_layout)};
+}
+
+[[nodiscard]] LookupResult<std::vector<std::byte>> WriteBinaryMessageCatalog(
+    std::span<const MessageCatalogEntry> messages,
+    StringLayout string_layout) noexcept {
+  const std::size_t buckets_count{
+      internal::MessageBucketsCount(messages.size())};
+  const std::size_t slots_count{internal::MessageSlotsCount(messages.size())};
+
+  if (buckets_count > std::numeric_limits<std::uint16_t>::max() ||
+      slots_count > std::numeric_limits<std::uint32_t>::max()) [[unlikely]] {
+    G3LOG(WARNING) << "Too many messages (" << messages.size()
+                   << ") for binary message catalog.";
+    return LookupResult<std::vector<std::byte>>{std::unexpect,
+                                                Status::kArgumentError};
+  }
+
+  std::vector<std::uint64_t> ids;
+  ids.reserve(messages.size());
+
+  std::size_t strings_size{0};
+  for (const MessageCatalogEntry& message : messages) {
+    // Zero id marks empty slot.
+    if (message.id == 0) [[unlikely]] {
+      G3LOG(WARNING) << "Zero message id is reserved, message '"
+                     << message.text << "'.";
+      return LookupResult<std::vector<std::byte>>{std::unexpect,
+                                                  Status::kArgumentError};
+    }
+
+    ids.push_back(message.id);
+    strings_size += message.text.size() + 1;
+  }
+
+  std::vector<std::uint16_t> displacements(buckets_count);
+  std::vector<std::size_t> message_slots(messages.size());
+  if (!internal::PlaceMessageIds(ids, slots_count, displacements,
+                                 message_slots)) [[unlikely]] {
+    G3LOG(WARNING) << "Unable to build binary message catalog perfect hash, "
+                      "message ids collide.";
+    return LookupResult<std::vector<std::byte>>{std::unexpect,
+                                                Status::kArgumentError};
+  }
+
+  const std::size_t displacements_offset{
+      AlignSection(sizeof(BinaryMessageCatalogHeader))};
+  const std::size_t slots_offset{AlignSection(
+      displacements_offset + buckets_count * sizeof(std::uint16_t))};
+  const std::size_t strings_offset{
+      slots_offset + slots_count * sizeof(BinaryMessageCatalogSlot)};
+  const std::size_t catalog_size{strings_offset + strings_size};
+
+  if (catalog_size > std::numeric_limits<std::uint32_t>::max()) [[unlikely]] {
+    G3LOG(WARNING) << "Binary message catalog is too large (" << catalog_size
+                   << " bytes).";
+    return LookupResult<std::vector<std::byte>>{std::unexpect,
+                                                Status::kArgumentError};
+  }
+
+  std::vector<BinaryMessageCatalogSlot> slots(slots_count);
+  std::vector<char> strings;
+  strings.reserve(strings_size);
+
+  for (std::size_t i{0}; i < messages.size(); ++i) {
+    const MessageCatalogEntry& message{messages[i]};
+
+    slots[message_slots[i]] = BinaryMessageCatalogSlot{
+        message.id, static_cast<std::uint32_t>(strings.size()),
+        static_cast<std::uint32_t>(message.text.size())};
+
+    strings.insert(strings.end(), message.text.begin(), message.text.end());
+    strings.push_back('\0');
+  }
+
+  const BinaryMessageCatalogHeader header{
+      kBinaryMessageCatalogMagic,
+      kBinaryMessageCatalogVersion,
+      static_cast<std::uint32_t>(string_layout),
+      static_cast<std::uint32_t>(messages.size()),
+      static_cast<std::uint32_t>(buckets_count),
+      static_cast<std::uint32_t>(slots_count),
+      static_cast<std::uint32_t>(displacements_offset),
+      static_cast<std::uint32_t>(slots_offset),
+      static_cast<std::uint32_t>(strings_offset),
+      static_cast<std::uint32_t>(strings_size)};
+
+  std::vector<std::byte> catalog(catalog_size);
+  std::memcpy(catalog.data(), &header, sizeof(header));
+  std::memcpy(catalog.data() + displacements_offset, displacements.data(),
+              displacements.size() * sizeof(std::uint16_t));
+  std::memcpy(catalog.data() + slots_offset, slots.data(),
+              slots.size() * sizeof(BinaryMessageCatalogSlot));
+  if (!strings.empty()) {
+    std::memcpy(catalog.data() + strings_offset, strings.data(),
+                strings.size());
+  }
+
+  return catalog;
+}
+
+}  // namespace wb::base::intl
@@ -0,0 +1,213 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Binary message catalog format.  Designed to be memory mapped and used in
+// place, so lookups return views into mapping without copies.
+//
+// Layout (native endianness, all sections are 8 bytes aligned):
+//
+// BinaryMessageCatalogHeader header;
+// std::uint16_t displacements[header.buckets_count];
+// BinaryMessageCatalogSlot slots[header.slots_count];
+// char strings[header.strings_size];  // Null-terminated UTF-8 messages.
+//
+// Message slot is found by the same hash and displace scheme as compile-time
+// MessageCatalog uses.
+
+#ifndef WB_BASE_INTL_BINARY_MESSAGE_CATALOG_H_
+#define WB_BASE_INTL_BINARY_MESSAGE_CATALOG_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "base/config.h"
+#include "base/intl/lookup.h"
+#include "base/intl/message_catalog.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::intl {
+
+/**
+ * @brief Binary message catalog file extension.
+ */
+constexpr char kBinaryMessageCatalogExtension[]{".wbmc"};
+
+/**
+ * @brief Binary message catalog magic.
+ */
+constexpr std::array<char, 4> kBinaryMessageCatalogMagic{'W', 'B', 'M', 'C'};
+
+/**
+ * @brief Binary message catalog format version.  Bump on any layout or hash
+ * change.
+ */
+constexpr std::uint32_t kBinaryMessageCatalogVersion{1};
+
+/**
+ * @brief Binary message catalog header.
+ */
+struct BinaryMessageCatalogHeader {
+  /**
+   * @brief kBinaryMessageCatalogMagic.
+   */
+  std::array<char, 4> magic;
+  /**
+   * @brief kBinaryMessageCatalogVersion.
+   */
+  std::uint32_t version;
+  /**
+   * @brief StringLayout of messages.
+   */
+  std::uint32_t string_layout;
+  /**
+   * @brief Messages count.
+   */
+  std::uint32_t messages_count;
+  /**
+   * @brief Buckets count, power of 2.
+   */
+  std::uint32_t buckets_count;
+  /**
+   * @brief Slots count, power of 2.
+   */
+  std::uint32_t slots_count;
+  /**
+   * @brief Displacements offset from catalog start.
+   */
+  std::uint32_t displacements_offset;
+  /**
+   * @brief Slots offset from catalog start.
+   */
+  std::uint32_t slots_offset;
+  /**
+   * @brief Strings offset from catalog start.
+   */
+  std::uint32_t strings_offset;
+  /**
+   * @brief Strings size in bytes.
+   */
+  std::uint32_t strings_size;
+};
+
+/**
+ * @brief Binary message catalog slot.  Empty slot has zero id.
+ */
+struct BinaryMessageCatalogSlot {
+  /**
+   * @brief Message id.
+   */
+  std::uint64_t id;
+  /**
+   * @brief Message text offset in strings.
+   */
+  std::uint32_t text_offset;
+  /**
+   * @brief Message text size without null terminator.
+   */
+  std::uint32_t text_size;
+};
+
+/**
+ * @brief Read-only view of binary message catalog bytes.  Does not own bytes.
+ */
+class WB_BASE_API BinaryMessageCatalogView {
+ public:
+  /**
+   * @brief Validates |bytes| are binary message catalog and creates view.
+   * @param bytes Catalog bytes.  Should be 8 bytes aligned and outlive view.
+   * @return Catalog view or kArgumentError when |bytes| are not catalog.
+   */
+  [[nodiscard]] static LookupResult<BinaryMessageCatalogView> New(
+      std::span<const std::byte> bytes) noexcept;
+
+  /**
+   * @brief Finds message by id.
+   * @param id Message id.
+   * @return Null-terminated message text or nullopt if no message.
+   */
+  [[nodiscard]] std::optional<std::string_view> Find(
+      std::uint64_t id) const noexcept {
+    const std::uint16_t displacement{displacements_[internal::MessageBucketIndex(
+        id, displacements_.size())]};
+    const BinaryMessageCatalogSlot& slot{
+        slots_[internal::MessageSlotIndex(id, displacement, slots_.size())]};
+
+    return slot.id == id && id != 0
+               ? std::optional<std::string_view>{std::in_place,
+                                                 strings_ + slot.text_offset,
+                                                 slot.text_size}
+               : std::nullopt;
+  }
+
+  /**
+   * @brief Gets messages string layout.
+   * @return StringLayout.
+   */
+  [[nodiscard]] StringLayout Layout() const noexcept { return string_layout_; }
+
+ private:
+  WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+    // Private member is not accessible to the DLL's client, including inline
+    // functions.
+    WB_MSVC_DISABLE_WARNING(4251)
+    /**
+     * @brief Buckets displacements.
+     */
+    std::span<const std::uint16_t> displacements_;
+    /**
+     * @brief Slots.
+     */
+    std::span<const BinaryMessageCatalogSlot> slots_;
+  WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+  /**
+   * @brief Strings.
+   */
+  const char* strings_;
+  /**
+   * @brief Messages string layout.
+   */
+  StringLayout string_layout_;
+
+  WB_ATTRIBUTE_UNUSED_FIELD
+  std::array<std::byte, sizeof(char*) - sizeof(string_layout_)> pad_;
+
+  /**
+   * @brief Creates binary message catalog view.
+   * @param displacements Buckets displacements.
+   * @param slots Slots.
+   * @param strings Strings.
+   * @param string_layout Messages string layout.
+   * @return nothing.
+   */
+  BinaryMessageCatalogView(std::span<const std::uint16_t> displacements,
+                           std::span<const BinaryMessageCatalogSlot> slots,
+                           const char* strings,
+                           StringLayout string_layout) noexcept
+      : displacements_{displacements},
+        slots_{slots},
+        strings_{strings},
+        string_layout_{string_layout},
+        pad_{} {}
+};
+
+/**
+ * @brief Builds binary message catalog from |messages|.  Used by build tools.
+ * @param messages Messages by ids.
+ * @param string_layout Messages string layout.
+ * @return Catalog bytes or kArgumentError on message ids collision.
+ */
+[[nodiscard]] WB_BASE_API LookupResult<std::vector<std::byte>>
+WriteBinaryMessageCatalog(std::span<const MessageCatalogEntry> messages,
+                          StringLayout string_layout) noexcept;
+
+}  // namespace wb::base::intl
+
+#endif  // !WB_BASE_INTL_BINARY_MESSAGE_CATALOG_H_
@@ -0,0 +1,146 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Binary message catalog format.
+
+#include "binary_message_catalog.h"
+//
+#include <cstring>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+namespace {
+
+/**
+ * @brief Creates message catalog entry from |text|.
+ */
+[[nodiscard]] constexpr wb::base::intl::MessageCatalogEntry MakeEntry(
+    std::string_view text) noexcept {
+  return {wb::base::intl::I18nStringViewHash{}(text), text};
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(BinaryMessageCatalogTest, WriteAndFindMessages) {
+  using namespace wb::base::intl;
+
+  const auto messages = std::to_array<MessageCatalogEntry>(
+      {MakeEntry("Hello"), MakeEntry("World"), MakeEntry("Hello, {0}!"),
+       MakeEntry("Can't load whitebox kernel '{0}'."), MakeEntry("")});
+  // Empty message has zero id.
+  const auto catalog_bytes = WriteBinaryMessageCatalog(
+      std::span{messages}.first(messages.size() - 1), StringLayout::RightToLeft);
+
+  ASSERT_TRUE(catalog_bytes.has_value());
+
+  const auto catalog = BinaryMessageCatalogView::New(*catalog_bytes);
+
+  ASSERT_TRUE(catalog.has_value());
+  EXPECT_EQ(StringLayout::RightToLeft, catalog->Layout());
+
+  for (std::size_t i{0}; i < messages.size() - 1; ++i) {
+    const auto text = catalog->Find(messages[i].id);
+
+    ASSERT_TRUE(text.has_value()) << messages[i].text;
+    EXPECT_EQ(messages[i].text, *text);
+    // Null-terminated.
+    EXPECT_EQ('\0', text->data()[text->size()]);
+  }
+
+  EXPECT_FALSE(catalog->Find(0).has_value());
+  EXPECT_FALSE(catalog->Find(I18nStringViewHash{}("Missed")).has_value());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(BinaryMessageCatalogTest, WriteEmptyCatalog) {
+  using namespace wb::base::intl;
+
+  const auto catalog_bytes =
+      WriteBinaryMessageCatalog({}, StringLayout::LeftToRight);
+
+  ASSERT_TRUE(catalog_bytes.has_value());
+
+  const auto catalog = BinaryMessageCatalogView::New(*catalog_bytes);
+
+  ASSERT_TRUE(catalog.has_value());
+  EXPECT_EQ(StringLayout::LeftToRight, catalog->Layout());
+  EXPECT_FALSE(catalog->Find(I18nStringViewHash{}("Hello")).has_value());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(BinaryMessageCatalogTest, WriteFailsOnDuplicateOrZeroIds) {
+  using namespace wb::base::intl;
+
+  const auto duplicate_messages = std::to_array<MessageCatalogEntry>(
+      {MakeEntry("Hello"), MakeEntry("World"), MakeEntry("Hello")});
+
+  EXPECT_EQ(Status::kArgumentError,
+            WriteBinaryMessageCatalog(duplicate_messages,
+                                      StringLayout::LeftToRight)
+                .error());
+
+  const auto zero_id_messages =
+      std::to_array<MessageCatalogEntry>({MakeEntry("Hello"), {0, "World"}});
+
+  EXPECT_EQ(Status::kArgumentError,
+            WriteBinaryMessageCatalog(zero_id_messages,
+                                      StringLayout::LeftToRight)
+                .error());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(BinaryMessageCatalogTest, NewFailsOnInvalidCatalog) {
+  using namespace wb::base::intl;
+
+  const auto messages =
+      std::to_array<MessageCatalogEntry>({MakeEntry("Hello")});
+  const auto catalog_bytes =
+      WriteBinaryMessageCatalog(messages, StringLayout::LeftToRight);
+
+  ASSERT_TRUE(catalog_bytes.has_value());
+
+  {
+    // Truncated.
+    EXPECT_EQ(Status::kArgumentError,
+              BinaryMessageCatalogView::New(
+                  std::span{*catalog_bytes}.first(catalog_bytes->size() - 1))
+                  .error());
+    EXPECT_EQ(Status::kArgumentError,
+              BinaryMessageCatalogView::New(std::span{*catalog_bytes}.first(
+                                                sizeof(BinaryMessageCatalogHeader) -
+                                                1))
+                  .error());
+  }
+
+  {
+    // Bad magic.
+    auto bad_magic_bytes = *catalog_bytes;
+    bad_magic_bytes[0] = std::byte{'X'};
+
+    EXPECT_EQ(Status::kArgumentError,
+              BinaryMessageCatalogView::New(bad_magic_bytes).error());
+  }
+
+  {
+    // Bad version.
+    auto bad_version_bytes = *catalog_bytes;
+    constexpr std::uint32_t kBadVersion{kBinaryMessageCatalogVersion + 1};
+    std::memcpy(bad_version_bytes.data() +
+                    offsetof(BinaryMessageCatalogHeader, version),
+                &kBadVersion, sizeof(kBadVersion));
+
+    EXPECT_EQ(Status::kArgumentError,
+              BinaryMessageCatalogView::New(bad_version_bytes).error());
+  }
+
+  {
+    // Not null-terminated message.
+    auto not_terminated_bytes = *catalog_bytes;
+    not_terminated_bytes.back() = std::byte{'!'};
+
+    EXPECT_EQ(Status::kArgumentError,
+              BinaryMessageCatalogView::New(not_terminated_bytes).error());
+  }
+}
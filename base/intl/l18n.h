@@ -6,20 +6,28 @@
 //
 // Usage example:
 //
-// const std::string &hello_message{intl::l18n(intl, "Hello, international
+// const std::string_view hello_message{intl::l18n(intl, "Hello, international
 // world!")};
 //
 // or
 //
 // const std::string greetings{intl::l18n_fmt(intl, "Hi, {0}!", user_name)};
 //
+// or, without allocations,
+//
+// std::array<char, 64> buffer;
+// const std::string_view greetings{
+//     intl::l18n_fmt_to(intl, buffer, "Hi, {0}!", user_name)};
+//
 // Based on
 // https://cs.opensource.google/fuchsia/fuchsia/+/main:src/lib/intl/lookup/cpp/lookup.h
 
 #ifndef WB_BASE_INTL_L18N_H_
 #define WB_BASE_INTL_L18N_H_
 
+#include <cstddef>  // size_t
 #include <cstdint>  // uint64_t
+#include <span>
 #include <string>
 #include <string_view>
 
@@ -42,19 +50,20 @@ class I18nStringViewHash {
   constexpr I18nStringViewHash() noexcept = default;
 
   /**
-   * Computes string_view hash.
+   * Computes string_view hash.  Iterative, so no stack depth limits for long
+   * strings.
    * @param s string_view
    * @param index start position of |s| to compute hash from till |s.size()|.
    * @return Hash.
    */
   [[nodiscard]] WB_ATTRIBUTE_CONST constexpr std::uint64_t operator()(
       std::string_view s, size_t index = 0) const noexcept {
-    return index < s.size()
-               ? (static_cast<std::uint64_t>(
-                      primes[index % std::size(primes)]) *
-                  (index + 1) * static_cast<std::uint64_t>(s[index])) ^
-                     (this->operator()(s, index + 1))
-               : 0;
+    std::uint64_t hash{0};
+    for (; index < s.size(); ++index) {
+      hash ^= static_cast<std::uint64_t>(primes[index % std::size(primes)]) *
+              (index + 1) * static_cast<std::uint64_t>(s[index]);
+    }
+    return hash;
   }
 
   WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(I18nStringViewHash);
@@ -78,32 +87,105 @@ class I18nStringViewHash {
 };
 
 /**
- * Localizes |string|.
+ * @brief Message id.  Constructor is consteval, so message hash is always
+ * computed at compile time and only id is left in the binary.  Use string
+ * literal directly where MessageId is expected:
+ *
+ * l18n(lookup, "Hello, international world!");
+ */
+class MessageId {
+ public:
+  /**
+   * @brief Creates message id from message literal.
+   * @tparam kMessageSize Message literal size with null terminator.
+   * @param message Message literal.
+   * @return nothing.
+   */
+  template <std::size_t kMessageSize>
+  consteval MessageId(const char (&message)[kMessageSize]) noexcept  // NOLINT
+      : id_{I18nStringViewHash{}(
+            std::string_view{message, kMessageSize - 1})} {}
+
+  /**
+   * @brief Creates message id from constant message.
+   * @param message Message.
+   * @return nothing.
+   */
+  consteval explicit MessageId(std::string_view message) noexcept
+      : id_{I18nStringViewHash{}(message)} {}
+
+  /**
+   * @brief Gets message id value.
+   * @return Message id.
+   */
+  [[nodiscard]] constexpr std::uint64_t value() const noexcept { return id_; }
+
+ private:
+  /**
+   * @brief Message id.
+   */
+  std::uint64_t id_;
+};
+
+/**
+ * Localizes message.
  * @param lookup Localization lookup.
- * @param string String to localize.
- * @return Localized string.
+ * @param message_id Message id, computed at compile time from string literal.
+ * @return Localized string.  Valid in current and next frame when catalogs are
+ * reloaded, see LookupWithFallback::String.
  */
-[[nodiscard]] inline const std::string& l18n(
-    const LookupWithFallback& lookup, std::string_view&& string) noexcept {
-  const std::uint64_t hash{I18nStringViewHash{}(string)};
-  return lookup.String(hash);
+[[nodiscard]] inline std::string_view l18n(const LookupWithFallback& lookup,
+                                           MessageId message_id) noexcept {
+  return lookup.String(message_id.value());
 }
 
 /**
- * Localizes |string| with format args |args|.
+ * Localizes message with format args |args|.
  * @param lookup Localization lookup.
- * @param string String to localize.
+ * @param message_id Message id, computed at compile time from string literal.
  * @param args Format args.
  * @return Localized string.
  */
 template <typename... TArgs>
 [[nodiscard]] inline std::string l18n_fmt(const LookupWithFallback& lookup,
-                                          std::string_view&& string,
+                                          MessageId message_id,
                                           TArgs&&... args) noexcept {
-  const std::uint64_t hash{I18nStringViewHash{}(string)};
   // No forwarding, as fmt::make_format_args expect references :(.
-  return lookup.Format(hash,
-                       fmt::make_format_args(args...));
+  return lookup.Format(message_id.value(), fmt::make_format_args(args...));
+}
+
+/**
+ * Localizes message with format args |args| and appends it to |buffer|.  No
+ * allocations when |buffer| has enough capacity.
+ * @param lookup Localization lookup.
+ * @param buffer Buffer to append localized string to.
+ * @param message_id Message id, computed at compile time from string literal.
+ * @param args Format args.
+ * @return nothing.
+ */
+template <typename... TArgs>
+inline void l18n_fmt_to(const LookupWithFallback& lookup,
+                        fmt::memory_buffer& buffer, MessageId message_id,
+                        TArgs&&... args) noexcept {
+  lookup.FormatTo(message_id.value(), buffer, fmt::make_format_args(args...));
+}
+
+/**
+ * Localizes message with format args |args| into |buffer|.  Never allocates.
+ * @param lookup Localization lookup.
+ * @param buffer Buffer to write localized string to.  Result is truncated to
+ * fit and null-terminated.
+ * @param message_id Message id, computed at compile time from string literal.
+ * @param args Format args.
+ * @return Localized string in |buffer|.
+ */
+template <typename... TArgs>
+inline std::string_view l18n_fmt_to(const LookupWithFallback& lookup,
+                                    std::span<char> buffer,
+                                    MessageId message_id,
+                                    TArgs&&... args) noexcept {
+  return lookup.FormatTo(message_id.value(), buffer,
+                         fmt::make_format_args(args...));
 }
 
 }  // namespace wb::base::intl
@@ -6,6 +6,8 @@
 
 #include "l18n.h"
 //
+#include <array>
+
 #include "base/deps/fmt/format.h"
 #include "base/deps/googletest/gtest/gtest.h"
 #include "base/tests/g3log_death_utils.h"
@@ -29,6 +31,25 @@ GTEST_TEST(L18nTest, CallOperatorHashes) {
   static_assert(I18nStringViewHash{}("123", 3) == 0U);
   static_assert(I18nStringViewHash{}("ABC 123", 0) == 4973U);
   static_assert(I18nStringViewHash{}("ABC 123", 1) == 5103U);
+
+  // Long strings should not overflow stack.
+  const std::string long_string(1024U * 1024U, 'a');
+  EXPECT_NE(0U, I18nStringViewHash{}(long_string));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(L18nTest, MessageIdIsComputedAtCompileTime) {
+  using namespace wb::base::intl;
+
+  static_assert(MessageId{""}.value() == 0U);
+  static_assert(MessageId{"abc"}.value() == 1859U);
+  static_assert(MessageId{"ABC 123"}.value() ==
+                I18nStringViewHash{}("ABC 123"));
+  static_assert(MessageId{std::string_view{"ABC"}}.value() == 739U);
+
+  // Literal converts to message id implicitly.
+  constexpr auto to_value = [](MessageId id) { return id.value(); };
+  static_assert(to_value("123") == 947U);
 }
 
 // NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -65,6 +86,47 @@ GTEST_TEST(L18nTest, l18nFmtLookups) {
       << "Should ignore additional args.";
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(L18nTest, l18nFmtToLookups) {
+  using namespace wb::base::intl;
+
+  const auto lookup = LookupWithFallback::New({"en_US.UTF-8"});
+
+  ASSERT_TRUE(lookup);
+
+  {
+    fmt::memory_buffer buffer;
+
+    l18n_fmt_to(*lookup, buffer, "Can't load boot manager '{0}'.",
+                "bootmgr.so");
+    l18n_fmt_to(*lookup, buffer, "Unknown string.");
+
+    EXPECT_EQ(fmt::to_string(buffer),
+              std::string{"Can't load boot manager 'bootmgr.so'."} +
+                  kFallbackString);
+  }
+
+  {
+    std::array<char, 64> buffer;
+
+    EXPECT_EQ(l18n_fmt_to(*lookup, buffer, "Can't load boot manager '{0}'.",
+                          1),
+              "Can't load boot manager '1'.");
+    EXPECT_EQ(l18n_fmt_to(*lookup, buffer, "Unknown string."),
+              kFallbackString);
+  }
+
+  {
+    std::array<char, 8> buffer;
+
+    EXPECT_EQ(l18n_fmt_to(*lookup, buffer, "Can't load boot manager '{0}'.",
+                          1),
+              "Can't l")
+        << "Should truncate to fit buffer.";
+    EXPECT_EQ('\0', buffer.back());
+  }
+}
+
 #ifdef GTEST_HAS_DEATH_TEST
 // NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
 GTEST_TEST(L18nTestDeathTest, MissedArgumentTriggersTerminate) {
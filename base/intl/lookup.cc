@@ -6,23 +6,93 @@
 
 #include "base/intl/lookup.h"
 
+#include <algorithm>
 #include <array>
-#include <unordered_map>
+#include <optional>
+#include <variant>
 
 #include "base/deps/g3log/g3log.h"
-#include "base/intl/l18n.h"
+#include "base/intl/binary_message_catalog.h"
+#include "base/intl/message_catalog.h"
+#include "base/scoped_memory_mapped_file.h"
 
 namespace {
 
 /**
- * Computes hash for |string|.
- * @param string String to hash.
- * @return String hash.
+ * @brief English (United States) messages.
  */
-[[nodiscard]] WB_ATTRIBUTE_CONST WB_ATTRIBUTE_FORCEINLINE constexpr uint64_t
-hash(std::string_view&& string) noexcept {
-  return wb::base::intl::I18nStringViewHash{}(string);
-}
+constexpr auto kEnUsMessages = std::to_array<std::string_view>({
+#ifdef WB_OS_WIN
+    "Windows is too old.  At least Windows 10, version 1903 (May 19, 2019)+ "
+    "required.",
+    "Please, update Windows to Windows 10, version 1903 (May 19, 2019) or "
+    "greater.",
+    "See technical details",
+    "Hide technical details",
+#endif
+    "Please, run app not as root / administrator. Priveleged accounts are not "
+    "supported.",
+    "Your user account is root or administrator. Running app as root or "
+    "administrator have security risks.",
+    "Boot Manager - Error",
+    "<A "
+    "HREF=\"https://github.com/The-White-Box/whitebox/"
+    "issues\">Nudge</"
+    "A> "
+    "authors",
+    "Can't get executable directory.  Unable to load the kernel.",
+    "Can't get '{0}' entry point from '{1}'.",
+    "Can't load whitebox kernel '{0}'.",
+    "{0} - Error",
+    "Please, check app is installed correctly and you have enough permissions "
+    "to run it.",
+    "Can't get current directory.  May be app located too deep (> 1024)?",
+    "Can't get current directory.  Unable to load the kernel.",
+    "Can't load boot manager '{0}'.",
+    "Whitebox Kernel - Error",
+    "Please, check mouse is connected and working.",
+    "Unable to register mouse as <A "
+    "HREF=\"https://docs.microsoft.com/en-us/windows/win32/inputdev/"
+    "about-raw-input\">Raw Input</A> device.",
+    "Please, check keyboard is connected and working.",
+    "Unable to register keyboard as <A "
+    "HREF=\"https://docs.microsoft.com/en-us/windows/win32/inputdev/"
+    "about-raw-input\">Raw Input</A> device.",
+    "Please, check your SDL library installed and working.",
+    "SDL build/runtime v.{0}/v.{1}, revision '{2}' initialization "
+    "failed.\n\n{3}.",
+    "SDL image parser initialization failed for image types {0}.\n\n{1}.",
+    "Please, check you installed '{0}' libraries/drivers.",
+    "SDL window create failed with '{0}' context.\n\n{1}",
+    "Unable to create main '{0}' window.",
+    "Sorry, only single '{0}' can run at a time.",
+    "Can't run multiple copies of '{0}' at once.  Please, stop existing copy "
+    "or return to the game.",
+    "Can't parse command line flags.  See log for details.",
+    "Please ensure you have enough free memory and use command line "
+    "correctly.",
+    "Sorry, your CPU has missed some required features to run the game.",
+    "Sorry, unable to load the app.  Please, contact support.",
+    "Unable to get parent directory for '{0}'.  Please, contact support.",
+    "CPU features support table for {0}:\n{1}",
+    "dirname '{0}' failed.",
+    "{0}     {1}",
+});
+
+static_assert(wb::base::intl::HasUniqueMessageIds(kEnUsMessages),
+              "English (United States) messages have I18nStringViewHash "
+              "collision or empty message.  Rephrase colliding message.");
+
+/**
+ * @brief English (United States) messages catalog.  Built at compile time, so
+ * no startup cost.
+ */
+constexpr auto kEnUsMessageCatalog =
+    wb::base::intl::MakeMessageCatalog(kEnUsMessages);
+
+static_assert(kEnUsMessageCatalog.IsPerfect(),
+              "English (United States) messages catalog perfect hash can't be "
+              "built.");
 
 }  // namespace
 
@@ -37,181 +107,46 @@ class Lookup::LookupImpl final {
 
   WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(LookupImpl);
 
-  WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
-    // C4868 compiler may not enforce left-to-right evaluation order
-    // in braced initializer list.  hash is pure function here.
-    WB_MSVC_DISABLE_WARNING(4868)
-    [[nodiscard]] static LookupResult<un<Lookup::LookupImpl>> New(
-        const std::set<std::string_view>& locale_ids) noexcept {
-      // TODO(dimhotepus): Load locales.
-      if (locale_ids.find("English_United States.utf8") != locale_ids.end() ||
-          locale_ids.find("en_US.UTF-8") != locale_ids.end()) {
+  [[nodiscard]] static LookupResult<un<Lookup::LookupImpl>> New(
+      const std::vector<std::string_view>& locale_ids,
+      const std::filesystem::path& catalogs_directory) noexcept {
+    for (auto it = locale_ids.begin(); it != locale_ids.end(); ++it) {
+      const std::string_view locale_id{*it};
+      // Keep preference order, but do not reload already failed locale.
+      if (std::find(locale_ids.begin(), it, locale_id) != it) continue;
+
+      if (locale_id == "English_United States.utf8" ||
+          locale_id == "en_US.UTF-8") {
         return un<Lookup::LookupImpl>{new (std::nothrow) Lookup::LookupImpl{
-            MessagesById{
-        //-V509,
-#ifdef WB_OS_WIN
-                {hash("Windows is too old.  At least Windows 10, version 1903 "
-                      "(May 19, 2019)+ required."),
-                 "Windows is too old.  At least Windows 10, version 1903 (May "
-                 "19, 2019)+ required."},
-                {hash("Please, update Windows to Windows 10, version 1903 (May "
-                      "19, 2019) or greater."),
-                 "Please, update Windows to Windows 10, version 1903 (May 19, "
-                 "2019) or greater."},
-                {hash("See technical details"), "See technical details"},
-                {hash("Hide technical details"), "Hide technical details"},
-#endif
-                {hash("Please, run app not as root / administrator. Priveleged "
-                      "accounts are not supported."),
-                 "Please, run app not as root / administrator. Priveleged "
-                 "accounts are not supported."},
-                {hash("Your user account is root or administrator. Running app "
-                      "as root or administrator have security risks."),
-                 "Your user account is root or administrator. Running app as "
-                 "root or administrator have security risks."},
-                {hash("Boot Manager - Error"), "Boot Manager - Error"},
-                {hash("<A "
-                      "HREF=\"https://github.com/The-White-Box/whitebox/"
-                      "issues\">Nudge</"
-                      "A> "
-                      "authors"),
-                 "<A "
-                 "HREF=\"https://github.com/The-White-Box/whitebox/"
-                 "issues\">Nudge</"
-                 "A> "
-                 "authors"},
-                {hash("Can't get executable directory.  Unable to load the "
-                      "kernel."),
-                 "Can't get executable directory.  Unable to load the kernel."},
-                {hash("Can't get '{0}' entry point from '{1}'."),
-                 "Can't get '{0}' entry point from '{1}'."},
-                {hash("Can't load whitebox kernel '{0}'."),
-                 "Can't load whitebox kernel '{0}'."},
-                {hash("{0} - Error"), "{0} - Error"},
-                {
-                    hash(
-                        "Please, check app is installed correctly and you have "
-                        "enough permissions to run it."),
-                    "Please, check app is installed correctly and you have "
-                    "enough permissions to run it.",
-                },
-                {
-                    hash("Can't get current directory.  May be app located too "
-                         "deep (> 1024)?"),
-                    "Can't get current directory.  May be app located too deep "
-                    "(> 1024)?",
-                },
-                {
-                    hash("Can't get current directory.  Unable to load the "
-                         "kernel."),
-                    "Can't get current directory.  Unable to load the kernel.",
-                },
-                {
-                    hash("Can't load boot manager '{0}'."),
-                    "Can't load boot manager '{0}'.",
-                },
-                {
-                    hash("Whitebox Kernel - Error"),
-                    "Whitebox Kernel - Error",
-                },
-                {
-                    hash("Please, check mouse is connected and working."),
-                    "Please, check mouse is connected and working.",
-                },
-                {
-                    hash(
-                        "Unable to register mouse as <A "
-                        "HREF=\"https://docs.microsoft.com/en-us/windows/win32/"
-                        "inputdev/"
-                        "about-raw-input\">Raw Input</A> device."),
-                    "Unable to register mouse as <A "
-                    "HREF=\"https://docs.microsoft.com/en-us/windows/win32/"
-                    "inputdev/"
-                    "about-raw-input\">Raw Input</A> device.",
-                },
-                {
-                    hash("Please, check keyboard is connected and working."),
-                    "Please, check keyboard is connected and working.",
-                },
-                {
-                    hash(
-                        "Unable to register keyboard as <A "
-                        "HREF=\"https://docs.microsoft.com/en-us/windows/win32/"
-                        "inputdev/"
-                        "about-raw-input\">Raw Input</A> device."),
-                    "Unable to register keyboard as <A "
-                    "HREF=\"https://docs.microsoft.com/en-us/windows/win32/"
-                    "inputdev/"
-                    "about-raw-input\">Raw Input</A> device.",
-                },
-                {
-                    hash("Please, check your SDL library installed and "
-                         "working."),
-                    "Please, check your SDL library installed and working.",
-                },
-                {
-                    hash("SDL build/runtime v.{0}/v.{1}, revision '{2}' "
-                         "initialization failed.\n\n{3}."),
-                    "SDL build/runtime v.{0}/v.{1}, revision '{2}' "
-                    "initialization failed.\n\n{3}.",
-                },
-                {hash("SDL image parser initialization failed for image types "
-                      "{0}.\n\n{1}."),
-                 "SDL image parser initialization failed for image types "
-                 "{0}.\n\n{1}."},
-                {hash("Please, check you installed '{0}' libraries/drivers."),
-                 "Please, check you installed '{0}' libraries/drivers."},
-                {hash("SDL window create failed with '{0}' context.\n\n{1}"),
-                 "SDL window create failed with '{0}' context.\n\n{1}"},
-                {hash("Unable to create main '{0}' window."),
-                 "Unable to create main '{0}' window."},
-                {hash("Sorry, only single '{0}' can run at a time."),
-                 "Sorry, only single '{0}' can run at a time."},
-                {hash("Can't run multiple copies of '{0}' at once.  Please, "
-                      "stop existing copy or return to the game."),
-                 "Can't run multiple copies of '{0}' at once.  Please, stop "
-                 "existing copy or return to the game."},
-                {hash("Can't parse command line flags.  See log for details."),
-                 "Can't parse command line flags.  See log for details."},
-                {hash("Please ensure you have enough free memory and use "
-                      "command line correctly."),
-                 "Please ensure you have enough free memory and use command "
-                 "line correctly."},
-                {hash("Sorry, your CPU has missed some required features to "
-                      "run the game."),
-                 "Sorry, your CPU has missed some required features to run the "
-                 "game."},
-                {hash("Sorry, unable to load the app.  Please, contact "
-                      "support."),
-                 "Sorry, unable to load the app.  Please, contact support."},
-                {hash("Unable to get parent directory for '{0}'.  Please, "
-                      "contact support."),
-                 "Unable to get parent directory for '{0}'.  Please, contact "
-                 "support."},
-                {hash("CPU features support table for {0}:\n{1}"),
-                 "CPU features support table for {0}:\n{1}"},
-                {hash("dirname '{0}' failed."), "dirname '{0}' failed."},
-                {hash("{0}     {1}"), "{0}     {1}"},
-            },
-            StringLayout::LeftToRight}};
+            kEnUsMessageCatalog.View(), StringLayout::LeftToRight,
+            std::nullopt}};
       }
 
-      return LookupResult<un<Lookup::LookupImpl>>{std::unexpect,
-                                                  Status::kArgumentError};
+      if (catalogs_directory.empty()) continue;
+
+      auto impl = NewFromCatalogFile(catalogs_directory /
+                                     Lookup::GetCatalogFileName(locale_id));
+      if (impl) return impl;
     }
-  WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
 
-  [[nodiscard]] LookupResult<Lookup::Ref<const std::string>> String(
+    return LookupResult<un<Lookup::LookupImpl>>{std::unexpect,
+                                                Status::kArgumentError};
+  }
+
+  [[nodiscard]] LookupResult<std::string_view> String(
       uint64_t message_id) const noexcept {
-    if (const auto& message = messages_by_id_.find(message_id);
-        message != messages_by_id_.end()) [[likely]] {
-      return std::ref(message->second);
+    const std::optional<std::string_view> message{std::visit(
+        [message_id](const auto& catalog) noexcept {
+          return catalog.Find(message_id);
+        },
+        messages_by_id_)};
+    if (message) [[likely]] {
+      return *message;
     }
 
     G3LOG(WARNING) << "Missed localization string for " << message_id
                    << " message id.";
-    return LookupResult<Lookup::Ref<const std::string>>{std::unexpect,
-                                                        Status::kUnavailable};
+    return LookupResult<std::string_view>{std::unexpect, Status::kUnavailable};
   }
 
   [[nodiscard]] WB_ATTRIBUTE_CONST StringLayout Layout() const noexcept {
@@ -219,12 +154,15 @@ class Lookup::LookupImpl final {
   }
 
  private:
-  using MessagesById = std::unordered_map<uint64_t, std::string>;
-
   /**
-   * Id to message map.
+   * Memory mapped binary catalog file, if any.  Messages point into it.
    */
-  const MessagesById messages_by_id_;
+  const std::optional<ScopedMemoryMappedFile> catalog_file_;
+  /**
+   * Id to message catalog.
+   */
+  const std::variant<MessageCatalogView, BinaryMessageCatalogView>
+      messages_by_id_;
   /**
    * L18n string layout.
    */
@@ -235,18 +173,54 @@ class Lookup::LookupImpl final {
 
   /**
    * @brief Creates lookup implementation.
-   * @param messages_by_id Messages by ids map.
+   * @param messages_by_id Messages by ids catalog.
+   * @param string_layout String layout.
+   * @param catalog_file Memory mapped catalog file |messages_by_id| points to.
    * @return nothing.
    */
-  LookupImpl(MessagesById messages_by_id, StringLayout string_layout) noexcept
-      : messages_by_id_{std::move(messages_by_id)},
+  LookupImpl(std::variant<MessageCatalogView, BinaryMessageCatalogView>
+                 messages_by_id,
+             StringLayout string_layout,
+             std::optional<ScopedMemoryMappedFile> catalog_file) noexcept
+      : catalog_file_{std::move(catalog_file)},
+        messages_by_id_{messages_by_id},
         string_layout_{string_layout},
         pad_{} {}
+
+  /**
+   * @brief Creates lookup implementation from binary catalog file.  File is
+   * memory mapped, so messages are loaded on demand and never copied.
+   * @param catalog_path Binary catalog file path.
+   * @return Lookup implementation.
+   */
+  [[nodiscard]] static LookupResult<un<Lookup::LookupImpl>> NewFromCatalogFile(
+      const std::filesystem::path& catalog_path) noexcept {
+    auto catalog_file = ScopedMemoryMappedFile::New(catalog_path);
+    if (!catalog_file) [[unlikely]] {
+      G3LOG(INFO) << "No localization catalog " << catalog_path << ": "
+                  << catalog_file.error().message();
+      return LookupResult<un<Lookup::LookupImpl>>{std::unexpect,
+                                                  Status::kUnavailable};
+    }
+
+    // Mapping address is stable on move, so view survives move into impl.
+    const auto catalog = BinaryMessageCatalogView::New(catalog_file->data());
+    if (!catalog) [[unlikely]] {
+      G3LOG(WARNING) << "Localization catalog " << catalog_path
+                     << " is invalid, skipping.";
+      return LookupResult<un<Lookup::LookupImpl>>{std::unexpect,
+                                                  catalog.error()};
+    }
+
+    return un<Lookup::LookupImpl>{new (std::nothrow) Lookup::LookupImpl{
+        *catalog, catalog->Layout(), std::move(*catalog_file)}};
+  }
 };
 
 [[nodiscard]] LookupResult<Lookup> Lookup::New(
-    const std::set<std::string_view>& locale_ids) noexcept {
-  auto impl_result = LookupImpl::New(locale_ids);
+    const std::vector<std::string_view>& locale_ids,
+    const std::filesystem::path& catalogs_directory) noexcept {
+  auto impl_result = LookupImpl::New(locale_ids, catalogs_directory);
   if (impl_result) [[likely]] {
     return Lookup{std::move(*impl_result)};
   }
@@ -254,7 +228,14 @@ class Lookup::LookupImpl final {
   return LookupResult<Lookup>{std::unexpect, impl_result.error()};
 }
 
-[[nodiscard]] LookupResult<Lookup::Ref<const std::string>> Lookup::String(
+[[nodiscard]] std::string Lookup::GetCatalogFileName(
+    std::string_view locale_id) noexcept {
+  std::string file_name{locale_id.substr(0, locale_id.find_first_of(".@"))};
+  file_name += kBinaryMessageCatalogExtension;
+  return file_name;
+}
+
+[[nodiscard]] LookupResult<std::string_view> Lookup::String(
     uint64_t message_id) const noexcept {
   G3DCHECK(!!impl_);
   return impl_->String(message_id);
@@ -262,19 +243,59 @@ class Lookup::LookupImpl final {
 
 [[nodiscard]] LookupResult<std::string> Lookup::Format(
     uint64_t message_id, fmt::format_args format_args) const noexcept {
+  fmt::memory_buffer buffer;
+  auto result = FormatTo(message_id, buffer, format_args);
+  if (result) [[likely]] {
+    return fmt::to_string(buffer);
+  }
+
+  return LookupResult<std::string>{std::unexpect, result.error()};
+}
+
+[[nodiscard]] LookupResult<void> Lookup::FormatTo(
+    uint64_t message_id, fmt::memory_buffer& buffer,
+    fmt::format_args format_args) const noexcept {
   auto result = String(message_id);
   if (result) [[likely]] {
     try {
-      return fmt::vformat(result->get(), format_args);
+      fmt::vformat_to(fmt::appender{buffer}, *result, format_args);
+      return {};
     } catch (fmt::format_error& ex) {
       G3LOG(FATAL) << "Format error for message id '" << message_id
-                   << "': " << ex.what() << ". String is '" << result->get()
-                   << "'.";
+                   << "': " << ex.what() << ". String is '" << *result << "'.";
       // Never reached.
     }
   }
 
-  return LookupResult<std::string>{std::unexpect, result.error()};
+  return LookupResult<void>{std::unexpect, result.error()};
+}
+
+[[nodiscard]] LookupResult<std::string_view> Lookup::FormatTo(
+    uint64_t message_id, std::span<char> buffer,
+    fmt::format_args format_args) const noexcept {
+  G3DCHECK(!buffer.empty());
+  if (buffer.empty()) [[unlikely]] {
+    return LookupResult<std::string_view>{std::unexpect,
+                                          Status::kArgumentError};
+  }
+
+  auto result = String(message_id);
+  if (result) [[likely]] {
+    try {
+      // Leave space for null terminator.
+      char* end{fmt::vformat_to_n(buffer.data(), buffer.size() - 1, *result,
+                                  format_args)
+                    .out};
+      *end = '\0';
+      return std::string_view{buffer.data(), end};
+    } catch (fmt::format_error& ex) {
+      G3LOG(FATAL) << "Format error for message id '" << message_id
+                   << "': " << ex.what() << ". String is '" << *result << "'.";
+      // Never reached.
+    }
+  }
+
+  return LookupResult<std::string_view>{std::unexpect, result.error()};
 }
 
 [[nodiscard]] WB_ATTRIBUTE_CONST StringLayout Lookup::Layout() const noexcept {
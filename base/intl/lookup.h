@@ -6,12 +6,17 @@
 //
 // Usage example:
 //
-// const std::string &hello_message{lookup.String(122)};
+// const std::string_view hello_message{*lookup.String(122)};
 //
 // or
 //
 // const std::string greetings{lookup.Format(123, user_name)};
 //
+// or, without allocations,
+//
+// fmt::memory_buffer greetings;
+// lookup.FormatTo(123, greetings, user_name);
+//
 // Based on
 // https://cs.opensource.google/fuchsia/fuchsia/+/main:src/lib/intl/lookup/cpp/lookup.h
 
@@ -19,15 +24,17 @@
 #define WB_BASE_INTL_LOOKUP_H_
 
 #include <cstdint>  // uint64_t
+#include <filesystem>
 #include <memory>
-#include <set>
+#include <span>
 #include <string>
 #include <string_view>
 #include <expected>
+#include <vector>
 
 #include "base/config.h"
 #include "base/macroses.h"
-#include "base/deps/fmt/core.h"
+#include "base/deps/fmt/format.h"
 #include "build/compiler_config.h"
 
 namespace wb::base::intl {
@@ -76,9 +83,6 @@ using LookupResult = std::expected<T, Status>;
  */
 class WB_BASE_API Lookup {
  public:
-  template <typename T>
-  using Ref = std::reference_wrapper<T>;
-
   Lookup() noexcept = delete;
   WB_NO_COPY_CTOR_AND_ASSIGNMENT(Lookup);
 
@@ -87,19 +91,35 @@ class WB_BASE_API Lookup {
   ~Lookup() noexcept;
 
   /**
-   * @brief Creates new lookup by locale ids.
-   * @param locale_ids Set of locale ids, order by descending preference.
+   * @brief Creates new lookup by locale ids.  English (United States) messages
+   * are built in, other locales are memory mapped from binary catalogs
+   * |catalogs_directory|/<locale>.wbmc.
+   * @param locale_ids Locale ids, order by descending preference.  Duplicates
+   * are tried once.
+   * @param catalogs_directory Binary message catalogs directory.  Empty to use
+   * built-in messages only.
    * @return Lookup.
    */
   [[nodiscard]] static LookupResult<Lookup> New(
-      const std::set<std::string_view>& locale_ids) noexcept;
+      const std::vector<std::string_view>& locale_ids,
+      const std::filesystem::path& catalogs_directory = {}) noexcept;
+
+  /**
+   * @brief Gets binary catalog file name for locale.  Encoding and modifier
+   * are dropped, so "en_US.UTF-8" and "en_US@euro" map to "en_US.wbmc".
+   * @param locale_id Locale id.
+   * @return Catalog file name.
+   */
+  [[nodiscard]] static std::string GetCatalogFileName(
+      std::string_view locale_id) noexcept;
 
   /**
-   * @brief Gets localized string by message id.
+   * @brief Gets localized string by message id.  String lives as long as
+   * lookup and is null-terminated.
    * @param message_id Message id.
    * @return Localized string.
    */
-  [[nodiscard]] LookupResult<Ref<const std::string>> String(
+  [[nodiscard]] LookupResult<std::string_view> String(
       std::uint64_t message_id) const noexcept;
 
   /**
@@ -111,6 +131,30 @@ class WB_BASE_API Lookup {
   [[nodiscard]] LookupResult<std::string> Format(
       std::uint64_t message_id, fmt::format_args format_args) const noexcept;
 
+  /**
+   * @brief Appends localized formatted string by message id to |buffer|.  No
+   * allocations when |buffer| has enough capacity, so fine for per frame text.
+   * @param message_id Message id.
+   * @param buffer Buffer to append to.
+   * @param format_args Message format args.
+   * @return Nothing or error.
+   */
+  [[nodiscard]] LookupResult<void> FormatTo(
+      std::uint64_t message_id, fmt::memory_buffer& buffer,
+      fmt::format_args format_args) const noexcept;
+
+  /**
+   * @brief Writes localized formatted string by message id to |buffer|.  Never
+   * allocates.  Result is truncated to fit |buffer| and null-terminated.
+   * @param message_id Message id.
+   * @param buffer Buffer to write to.  Should not be empty.
+   * @param format_args Message format args.
+   * @return Written part of |buffer|, without null terminator.
+   */
+  [[nodiscard]] LookupResult<std::string_view> FormatTo(
+      std::uint64_t message_id, std::span<char> buffer,
+      fmt::format_args format_args) const noexcept;
+
   /**
    * @brief Gets string layout.
    * @return StringLayout.
@@ -6,6 +6,11 @@
 
 #include "lookup.h"
 //
+#include <array>
+#include <filesystem>
+#include <fstream>
+
+#include "binary_message_catalog.h"
 #include "l18n.h"
 //
 #include "base/deps/googletest/gtest/gtest.h"
@@ -46,7 +51,8 @@ GTEST_TEST(LookupTest, NewEnUsUtf8Locale) {
         lookup->String(hash("Unable to create main '{0}' window."));
 
     ASSERT_TRUE(localized);
-    EXPECT_EQ(std::string{"Unable to create main '{0}' window."}, localized->get());
+    EXPECT_EQ(std::string_view{"Unable to create main '{0}' window."},
+              *localized);
   }
 
   {
@@ -91,4 +97,105 @@ GTEST_TEST(LookupTest, NewEnUsUtf8Locale) {
     ASSERT_FALSE(non_formatted_too_many_args);
     EXPECT_EQ(Status::kUnavailable, non_formatted_too_many_args.error());
   }
-}
\ No newline at end of file
+
+  {
+    fmt::memory_buffer buffer;
+
+    ASSERT_TRUE(lookup->FormatTo(hash("Unable to create main '{0}' window."),
+                                 buffer, fmt::make_format_args("WhiteBox")));
+    EXPECT_EQ(std::string{"Unable to create main 'WhiteBox' window."},
+              fmt::to_string(buffer));
+
+    auto non_formatted = lookup->FormatTo(hash("Unknown string '{0}'."), buffer,
+                                          fmt::make_format_args("WhiteBox"));
+
+    ASSERT_FALSE(non_formatted);
+    EXPECT_EQ(Status::kUnavailable, non_formatted.error());
+    EXPECT_EQ(std::string{"Unable to create main 'WhiteBox' window."},
+              fmt::to_string(buffer))
+        << "Buffer should be left intact on error.";
+  }
+
+  {
+    std::array<char, 16> buffer;
+
+    auto formatted =
+        lookup->FormatTo(hash("Unable to create main '{0}' window."), buffer,
+                         fmt::make_format_args("WhiteBox"));
+
+    ASSERT_TRUE(formatted);
+    EXPECT_EQ(std::string_view{"Unable to creat"}, *formatted);
+    EXPECT_EQ('\0', buffer.back());
+
+    EXPECT_EQ(Status::kArgumentError,
+              lookup
+                  ->FormatTo(hash("Unable to create main '{0}' window."),
+                             std::span<char>{},
+                             fmt::make_format_args("WhiteBox"))
+                  .error());
+  }
+}
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LookupTest, NewFromBinaryCatalog) {
+  using namespace wb::base::intl;
+
+  const std::filesystem::path catalogs_directory{
+      std::filesystem::temp_directory_path() / "wb-lookup-catalogs"};
+  std::filesystem::create_directories(catalogs_directory);
+
+  {
+    const auto messages = std::to_array<MessageCatalogEntry>(
+        {{hash("Unable to create main '{0}' window."),
+          "Невозможно создать главное окно '{0}'."}});
+    const auto catalog =
+        WriteBinaryMessageCatalog(messages, StringLayout::RightToLeft);
+
+    ASSERT_TRUE(catalog);
+
+    std::ofstream catalog_file{catalogs_directory / "ru_RU.wbmc",
+                               std::ios::binary | std::ios::trunc};
+    catalog_file.write(reinterpret_cast<const char *>(catalog->data()),
+                       static_cast<std::streamsize>(catalog->size()));
+  }
+
+  {
+    const auto lookup = Lookup::New({"ru_RU.UTF-8"}, catalogs_directory);
+
+    ASSERT_TRUE(lookup);
+    EXPECT_EQ(StringLayout::RightToLeft, lookup->Layout());
+
+    auto localized =
+        lookup->String(hash("Unable to create main '{0}' window."));
+
+    ASSERT_TRUE(localized);
+    EXPECT_EQ(std::string_view{"Невозможно создать главное окно '{0}'."},
+              *localized);
+
+    auto formatted = lookup->Format(hash("Unable to create main '{0}' window."),
+                                    fmt::make_format_args("WhiteBox"));
+
+    ASSERT_TRUE(formatted);
+    EXPECT_EQ(std::string{"Невозможно создать главное окно 'WhiteBox'."},
+              *formatted);
+
+    EXPECT_EQ(Status::kUnavailable,
+              lookup->String(hash("Unknown string.")).error());
+  }
+
+  // Locales are tried in preference order, not in alphabetical one.
+  EXPECT_EQ(StringLayout::RightToLeft,
+            Lookup::New({"ru_RU.UTF-8", "en_US.UTF-8"}, catalogs_directory)
+                ->Layout());
+  EXPECT_EQ(StringLayout::LeftToRight,
+            Lookup::New({"de_DE.UTF-8", "de_DE.UTF-8", "en_US.UTF-8",
+                         "ru_RU.UTF-8"},
+                        catalogs_directory)
+                ->Layout());
+
+  EXPECT_EQ(Status::kArgumentError,
+            Lookup::New({"de_DE.UTF-8"}, catalogs_directory)
+                .error_or(Status::kOk));
+
+  std::error_code rc;
+  std::filesystem::remove_all(catalogs_directory, rc);
+}
@@ -6,7 +6,7 @@
 //
 // Usage example:
 //
-// const std::string &hello_message{intl::l18n(intl, "Hello, international
+// const std::string_view hello_message{intl::l18n(intl, "Hello, international
 // world!")};
 //
 // or
@@ -18,29 +18,123 @@
 
 #include "base/intl/lookup_with_fallback.h"
 
+#include <algorithm>
+
 #include "base/deps/g3log/g3log.h"
 
+namespace {
+
+/**
+ * @brief Gets catalog files modification times.
+ * @param locale_ids Locale ids.
+ * @param catalogs_directory Catalogs directory.
+ * @return Catalog files modification times by locale id.  Missed files have
+ * minimal time.
+ */
+[[nodiscard]] std::vector<std::filesystem::file_time_type>
+GetCatalogsWriteTimes(std::span<const std::string_view> locale_ids,
+                      const std::filesystem::path& catalogs_directory) {
+  std::vector<std::filesystem::file_time_type> write_times;
+  if (catalogs_directory.empty()) return write_times;
+
+  write_times.reserve(locale_ids.size());
+
+  for (const std::string_view locale_id : locale_ids) {
+    std::error_code rc;
+    const auto write_time = std::filesystem::last_write_time(
+        catalogs_directory /
+            wb::base::intl::Lookup::GetCatalogFileName(locale_id),
+        rc);
+    write_times.push_back(!rc ? write_time
+                              : std::filesystem::file_time_type::min());
+  }
+
+  return write_times;
+}
+
+/**
+ * @brief Mutex to serialize hot reload and hot reload scope changes.
+ */
+ABSL_CONST_INIT absl::Mutex hot_reload_mutex{absl::kConstInit};
+
+/**
+ * @brief Lookup to hot reload or nullptr when no hot reload scope.
+ */
+wb::base::intl::LookupWithFallback* hot_reload_lookup
+    ABSL_GUARDED_BY(hot_reload_mutex){nullptr};
+
+/**
+ * @brief Hot reload poll interval ticks.  0 when catalogs are not polled.
+ */
+std::chrono::steady_clock::rep hot_reload_interval_ticks
+    ABSL_GUARDED_BY(hot_reload_mutex){0};
+
+/**
+ * @brief Next catalogs poll time ticks.
+ */
+std::chrono::steady_clock::rep next_hot_reload_ticks
+    ABSL_GUARDED_BY(hot_reload_mutex){0};
+
+}  // namespace
+
 namespace wb::base::intl {
 
 LookupWithFallback::LookupWithFallback(LookupWithFallback&& l) noexcept
-    : lookup_{std::move(l.lookup_)},
-      fallback_string_{std::move(l.fallback_string_)} {}
+    : lookup_{l.lookup_.exchange(nullptr)},
+      readers_{},
+      phase_{l.phase_.load()},
+      writers_mutex_{},
+      retired_{},
+      reclaims_count_{0},
+      locale_ids_{},
+      catalogs_directory_{},
+      catalogs_write_times_{},
+      fallback_string_{std::move(l.fallback_string_)} {
+  absl::MutexLock lock{&l.writers_mutex_};
+  retired_ = std::move(l.retired_);
+  reclaims_count_ = l.reclaims_count_;
+  locale_ids_ = std::move(l.locale_ids_);
+  catalogs_directory_ = std::move(l.catalogs_directory_);
+  catalogs_write_times_ = std::move(l.catalogs_write_times_);
+}
+
+LookupWithFallback::~LookupWithFallback() noexcept {
+  G3DCHECK(readers_[0].load() == 0 && readers_[1].load() == 0)
+      << "Lookup is destroyed while being read.";
+  // Retired ones are freed by vector.
+  delete lookup_.exchange(nullptr);
+}
 
 [[nodiscard]] LookupResult<LookupWithFallback> LookupWithFallback::New(
-    const std::set<std::string_view>& locale_ids,
-    std::string fallback_string) noexcept {
-  auto lookup_result = Lookup::New(locale_ids);
+    const std::vector<std::string_view>& locale_ids,
+    std::string fallback_string,
+    const std::filesystem::path& catalogs_directory) noexcept {
+  // Get times before load, so catalog changed during load is reloaded later.
+  auto write_times = GetCatalogsWriteTimes(locale_ids, catalogs_directory);
+
+  auto lookup_result = Lookup::New(locale_ids, catalogs_directory);
   if (lookup_result) [[likely]] {
-    return LookupWithFallback(std::move(*lookup_result),
-                              std::move(fallback_string));
+    un<Lookup> lookup{new (std::nothrow) Lookup{std::move(*lookup_result)}};
+    G3CHECK(!!lookup);
+
+    LookupWithFallback lookup_with_fallback{std::move(lookup),
+                                            std::move(fallback_string)};
+    {
+      absl::MutexLock lock{&lookup_with_fallback.writers_mutex_};
+      lookup_with_fallback.RememberLoadedLocked(
+          locale_ids, catalogs_directory, std::move(write_times));
+    }
+    return lookup_with_fallback;
   }
 
   return std::unexpected{lookup_result.error()};
 }
 
-[[nodiscard]] const std::string& LookupWithFallback::String(
+[[nodiscard]] std::string_view LookupWithFallback::String(
     uint64_t message_id) const noexcept {
-  auto string = lookup_.String(message_id);
+  const ReadScope scope{*this};
+
+  auto string = lookup_.load()->String(message_id);
   if (string) [[likely]] {
     return *string;
   }
@@ -52,9 +146,11 @@ LookupWithFallback::LookupWithFallback(LookupWithFallback&& l) noexcept
 
 [[nodiscard]] std::string LookupWithFallback::Format(
     uint64_t message_id, fmt::format_args format_args) const noexcept {
-  auto string = lookup_.Format(message_id, format_args);
+  const ReadScope scope{*this};
+
+  auto string = lookup_.load()->Format(message_id, format_args);
   if (string) [[likely]] {
-    return *string;
+    return std::move(*string);
   }
 
   G3LOG(WARNING) << "Missed localization string for " << message_id
@@ -62,14 +158,227 @@ LookupWithFallback::LookupWithFallback(LookupWithFallback&& l) noexcept
   return fallback_string_;
 }
 
-[[nodiscard]] WB_ATTRIBUTE_CONST StringLayout
-LookupWithFallback::Layout() const noexcept {
-  return lookup_.Layout();
+void LookupWithFallback::FormatTo(uint64_t message_id,
+                                  fmt::memory_buffer& buffer,
+                                  fmt::format_args format_args) const noexcept {
+  const ReadScope scope{*this};
+
+  if (lookup_.load()->FormatTo(message_id, buffer, format_args)) [[likely]] {
+    return;
+  }
+
+  G3LOG(WARNING) << "Missed localization string for " << message_id
+                 << " message id.";
+  buffer.append(fallback_string_);
+}
+
+std::string_view LookupWithFallback::FormatTo(
+    uint64_t message_id, std::span<char> buffer,
+    fmt::format_args format_args) const noexcept {
+  G3DCHECK(!buffer.empty());
+  if (buffer.empty()) [[unlikely]] return {};
+
+  const ReadScope scope{*this};
+
+  const auto string =
+      lookup_.load()->FormatTo(message_id, buffer, format_args);
+  if (string) [[likely]] {
+    return *string;
+  }
+
+  G3LOG(WARNING) << "Missed localization string for " << message_id
+                 << " message id.";
+
+  const std::size_t size{
+      std::min(fallback_string_.size(), buffer.size() - 1)};
+  std::copy_n(fallback_string_.data(), size, buffer.data());
+  buffer[size] = '\0';
+  return std::string_view{buffer.data(), size};
+}
+
+[[nodiscard]] StringLayout LookupWithFallback::Layout() const noexcept {
+  const ReadScope scope{*this};
+
+  return lookup_.load()->Layout();
+}
+
+[[nodiscard]] LookupResult<void> LookupWithFallback::Reload(
+    const std::vector<std::string_view>& locale_ids,
+    const std::filesystem::path& catalogs_directory) noexcept {
+  // Load outside of lock, may touch disk.
+  auto write_times = GetCatalogsWriteTimes(locale_ids, catalogs_directory);
+  auto lookup_result = Lookup::New(locale_ids, catalogs_directory);
+  if (!lookup_result) [[unlikely]] {
+    G3LOG(WARNING) << "Unable to reload localization catalogs, keep current "
+                      "ones.";
+    return LookupResult<void>{std::unexpect, lookup_result.error()};
+  }
+
+  un<Lookup> lookup{new (std::nothrow) Lookup{std::move(*lookup_result)}};
+  G3CHECK(!!lookup);
+
+  absl::MutexLock lock{&writers_mutex_};
+
+  // Readers which already loaded old lookup are in current phase, so retire it
+  // with current phase.
+  un<Lookup> retired_lookup{lookup_.exchange(lookup.release())};
+  retired_.push_back(RetiredLookup{std::move(retired_lookup), phase_.load(),
+                                   reclaims_count_});
+
+  RememberLoadedLocked(locale_ids, catalogs_directory, std::move(write_times));
+  // Not reclaimed here, as callers may still use strings of retired lookup
+  // got outside of read scope.  Reclaim frees it after full frame.
+
+  return {};
+}
+
+[[nodiscard]] LookupResult<bool> LookupWithFallback::ReloadIfChanged()
+    noexcept {
+  std::vector<std::string> locale_ids;
+  std::filesystem::path catalogs_directory;
+  std::vector<std::filesystem::file_time_type> write_times;
+
+  {
+    absl::MutexLock lock{&writers_mutex_};
+
+    locale_ids = locale_ids_;
+    catalogs_directory = catalogs_directory_;
+    write_times = catalogs_write_times_;
+  }
+
+  const std::vector<std::string_view> locale_id_views{locale_ids.begin(),
+                                                      locale_ids.end()};
+  // Poll outside of lock, touches disk.
+  if (GetCatalogsWriteTimes(locale_id_views, catalogs_directory) ==
+      write_times) [[likely]] {
+    return false;
+  }
+
+  G3LOG(INFO) << "Localization catalogs in " << catalogs_directory
+              << " changed, reloading.";
+
+  auto reload_result = Reload(locale_id_views, catalogs_directory);
+  if (!reload_result) [[unlikely]] {
+    return LookupResult<bool>{std::unexpect, reload_result.error()};
+  }
+
+  return true;
+}
+
+std::size_t LookupWithFallback::Reclaim() noexcept {
+  absl::MutexLock lock{&writers_mutex_};
+  ++reclaims_count_;
+  return ReclaimLocked();
 }
 
-LookupWithFallback::LookupWithFallback(Lookup lookup,
+std::size_t LookupWithFallback::ReclaimLocked() noexcept {
+  // Lookup retired before previous Reclaim lived full frame, so strings got
+  // from it outside of read scope in previous frame are not used anymore.
+  const auto is_frame_over = [this](const RetiredLookup& retired) noexcept
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(writers_mutex_) {
+        return reclaims_count_ - retired.reclaims_count >= 2;
+      };
+
+  while (!retired_.empty()) {
+    const std::uint64_t phase{phase_.load()};
+
+    // Readers of previous phase are still there and may see lookups retired
+    // before current phase.
+    if (readers_[(phase - 1) & 1U].load() != 0) break;
+
+    // Grace period is over for lookups retired before current phase.
+    std::erase_if(retired_, [&](const RetiredLookup& retired) noexcept {
+      return retired.phase < phase && is_frame_over(retired);
+    });
+
+    // Start new grace period for lookups retired in current phase only when
+    // they can be freed after it.  Readers which start after see only current
+    // lookup.
+    if (std::ranges::none_of(retired_, [&](const RetiredLookup& retired) {
+          return retired.phase == phase && is_frame_over(retired);
+        })) {
+      break;
+    }
+
+    phase_.store(phase + 1);
+  }
+
+  return retired_.size();
+}
+
+LookupWithFallback::LookupWithFallback(un<Lookup> lookup,
                                        std::string fallback_string) noexcept
-    : lookup_{std::move(lookup)},
+    : lookup_{lookup.release()},
+      readers_{},
+      // Start from 1, so previous phase readers counter is valid and empty.
+      phase_{1},
+      writers_mutex_{},
+      retired_{},
+      reclaims_count_{0},
+      locale_ids_{},
+      catalogs_directory_{},
+      catalogs_write_times_{},
       fallback_string_{std::move(fallback_string)} {}
 
+void LookupWithFallback::RememberLoadedLocked(
+    const std::vector<std::string_view>& locale_ids,
+    const std::filesystem::path& catalogs_directory,
+    std::vector<std::filesystem::file_time_type> write_times) noexcept {
+  locale_ids_.assign(locale_ids.begin(), locale_ids.end());
+  catalogs_directory_ = catalogs_directory;
+  catalogs_write_times_ = std::move(write_times);
+}
+
+ScopedCatalogsHotReload::ScopedCatalogsHotReload(
+    LookupWithFallback& lookup,
+    std::chrono::milliseconds poll_interval) noexcept {
+  absl::MutexLock lock{&hot_reload_mutex};
+
+  G3CHECK(!hot_reload_lookup)
+      << "Only one catalogs hot reload scope can exist at a time.";
+
+  const auto interval_ticks =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          poll_interval)
+          .count();
+
+  hot_reload_lookup = &lookup;
+  hot_reload_interval_ticks = interval_ticks;
+  next_hot_reload_ticks =
+      std::chrono::steady_clock::now().time_since_epoch().count() +
+      interval_ticks;
+}
+
+ScopedCatalogsHotReload::~ScopedCatalogsHotReload() noexcept {
+  absl::MutexLock lock{&hot_reload_mutex};
+
+  hot_reload_lookup = nullptr;
+  hot_reload_interval_ticks = 0;
+}
+
+WB_BASE_API bool HotReloadCatalogsIfDue() noexcept {
+  absl::MutexLock lock{&hot_reload_mutex};
+
+  if (!hot_reload_lookup) [[unlikely]] {
+    return false;
+  }
+
+  bool is_reloaded{false};
+
+  const auto now_ticks =
+      std::chrono::steady_clock::now().time_since_epoch().count();
+  if (hot_reload_interval_ticks != 0 && now_ticks >= next_hot_reload_ticks) {
+    next_hot_reload_ticks = now_ticks + hot_reload_interval_ticks;
+
+    const auto reload_result = hot_reload_lookup->ReloadIfChanged();
+    is_reloaded = reload_result.value_or(false);
+  }
+
+  // Frame boundary.  Catalogs retired before previous one are freed, so strings
+  // of previous frame stay valid in this one.
+  hot_reload_lookup->Reclaim();
+
+  return is_reloaded;
+}
+
 }  // namespace wb::base::intl
@@ -6,18 +6,45 @@
 //
 // Usage example:
 //
-// const std::string &hello_message{lookup_with_fallback.String(122)};
+// const std::string_view hello_message{lookup_with_fallback.String(122)};
 //
 // or
 //
 // const std::string greetings{lookup_with_fallback.Format(123, user_name)};
 //
+// or, without allocations,
+//
+// std::array<char, 64> greetings;
+// lookup_with_fallback.FormatTo(123, greetings, user_name);
+//
+// Catalogs can be reloaded or locale switched at runtime from any thread:
+//
+// lookup_with_fallback.Reload({"de_DE.UTF-8"}, catalogs_directory);
+//
+// Readers never block.  Call Reclaim once per frame at frame boundary to free
+// retired catalogs.  Strings stay valid till the second Reclaim after their
+// catalog is replaced, so strings of current and previous frame can be used.
+// Keep ReadScope while using returned strings longer.
+//
+// Changed catalog files can be hot-reloaded in scope of
+// ScopedCatalogsHotReload by calling HotReloadCatalogsIfDue at frame boundary.
+//
 // Based on
 // https://cs.opensource.google/fuchsia/fuchsia/+/main:src/lib/intl/lookup/cpp/lookup.h
 
 #ifndef WB_BASE_INTL_LOOKUP_WITH_FALLBACK_H_
 #define WB_BASE_INTL_LOOKUP_WITH_FALLBACK_H_
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "base/deps/abseil/base/thread_annotations.h"
+#include "base/deps/abseil/synchronization/mutex.h"
 #include "base/intl/lookup.h"
 
 namespace wb::base::intl {
@@ -29,33 +56,80 @@ constexpr char kFallbackString[]{"N/A"};
 
 /**
  * @brief The API used to look up localized messages by their unique message ID.
+ * Current catalog is published RCU-style: readers load it lock-free, Reload
+ * swaps it atomically and retires old one, which is freed after grace period,
+ * when all readers which could see it left their read-side critical sections.
  */
 class WB_BASE_API LookupWithFallback {
  public:
+  /**
+   * @brief Read-side critical section.  Catalog seen inside scope and strings
+   * from it are not freed till scope ends.  Wait-free, may be nested.
+   */
+  class ReadScope {
+   public:
+    /**
+     * @brief Enters read-side critical section.
+     * @param lookup Lookup to read.
+     * @return nothing.
+     */
+    explicit ReadScope(const LookupWithFallback& lookup) noexcept
+        : readers_{&lookup.readers_[lookup.phase_.load() & 1U]} {
+      readers_->fetch_add(1);
+    }
+
+    /**
+     * @brief Leaves read-side critical section.
+     * @return nothing.
+     */
+    ~ReadScope() noexcept { readers_->fetch_sub(1); }
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ReadScope);
+
+   private:
+    /**
+     * @brief Readers count of grace period scope is entered in.
+     */
+    std::atomic<std::uint32_t>* readers_;
+  };
+
   LookupWithFallback() noexcept = delete;
   WB_NO_COPY_CTOR_AND_ASSIGNMENT(LookupWithFallback);
 
   LookupWithFallback(LookupWithFallback&&) noexcept;
   LookupWithFallback& operator=(LookupWithFallback&&) noexcept = delete;
 
+  /**
+   * @brief Destroys lookup.  No readers should be left.
+   * @return nothing.
+   */
+  ~LookupWithFallback() noexcept;
+
   /**
    * @brief Creates new lookup by locale ids.  If no string found
    * |fallback_string| is used as fallback.
-   * @param locale_ids Set of locale ids, order by descending preference.
+   * @param locale_ids Locale ids, order by descending preference.  Duplicates
+   * are tried once.
    * @param fallback_string String to return if requested one not found.
+   * @param catalogs_directory Binary message catalogs directory.  Empty to use
+   * built-in messages only.
    * @return Lookup.
    */
   [[nodiscard]] static LookupResult<LookupWithFallback> New(
-      const std::set<std::string_view>& locale_ids,
-      std::string fallback_string = kFallbackString) noexcept;
+      const std::vector<std::string_view>& locale_ids,
+      std::string fallback_string = kFallbackString,
+      const std::filesystem::path& catalogs_directory = {}) noexcept;
 
   /**
    * @brief Gets localized string by message id.  Returns fallback string if one
-   * not found.
+   * not found.  String is null-terminated.  When catalog is replaced by Reload,
+   * string lives till the second Reclaim after, ie. at least one full frame
+   * when Reclaim is called once per frame.  Hold ReadScope while using it
+   * longer.
    * @param message_id Message id.
    * @return Localized string.
    */
-  [[nodiscard]] const std::string& String(uint64_t message_id) const noexcept;
+  [[nodiscard]] std::string_view String(uint64_t message_id) const noexcept;
 
   /**
    * @brief Gets localized formatted string by message id.
@@ -66,18 +140,133 @@ class WB_BASE_API LookupWithFallback {
   [[nodiscard]] std::string Format(uint64_t message_id,
                                    fmt::format_args format_args) const noexcept;
 
+  /**
+   * @brief Appends localized formatted string by message id to |buffer|.
+   * Appends fallback string if one not found.  No allocations when |buffer|
+   * has enough capacity.
+   * @param message_id Message id.
+   * @param buffer Buffer to append to.
+   * @param format_args Message format args.
+   * @return nothing.
+   */
+  void FormatTo(uint64_t message_id, fmt::memory_buffer& buffer,
+                fmt::format_args format_args) const noexcept;
+
+  /**
+   * @brief Writes localized formatted string by message id to |buffer|.
+   * Writes fallback string if one not found.  Never allocates.  Result is
+   * truncated to fit |buffer| and null-terminated.
+   * @param message_id Message id.
+   * @param buffer Buffer to write to.  Should not be empty.
+   * @param format_args Message format args.
+   * @return Written part of |buffer|, without null terminator.
+   */
+  std::string_view FormatTo(uint64_t message_id, std::span<char> buffer,
+                            fmt::format_args format_args) const noexcept;
+
   /**
    * @brief Gets string layout.
    * @return StringLayout.
    */
-  [[nodiscard]] WB_ATTRIBUTE_CONST StringLayout Layout() const noexcept;
+  [[nodiscard]] StringLayout Layout() const noexcept;
+
+  /**
+   * @brief Loads catalogs for |locale_ids| and atomically publishes them.
+   * Used both to switch locale and to hot-reload changed catalogs.  Readers
+   * are never blocked, old catalog is retired and freed by Reclaim, never by
+   * Reload itself.
+   * @param locale_ids Locale ids, order by descending preference.  Duplicates
+   * are tried once.
+   * @param catalogs_directory Binary message catalogs directory.  Empty to use
+   * built-in messages only.
+   * @return Nothing or error.  On error current catalog is kept.
+   */
+  [[nodiscard]] LookupResult<void> Reload(
+      const std::vector<std::string_view>& locale_ids,
+      const std::filesystem::path& catalogs_directory = {}) noexcept;
+
+  /**
+   * @brief Reloads catalogs of last loaded locale ids if their files changed
+   * since load.  Polls catalog files modification time, so do not call too
+   * often.
+   * @return true if reloaded, false if nothing changed, or error.  On error
+   * current catalog is kept.
+   */
+  [[nodiscard]] LookupResult<bool> ReloadIfChanged() noexcept;
+
+  /**
+   * @brief Frees retired catalogs which were retired before previous Reclaim
+   * and which grace period is over.  Never blocks on readers.  Call once per
+   * frame at known-safe point, ex. frame boundary.
+   * @return Retired catalogs count still waiting to be freed.
+   */
+  std::size_t Reclaim() noexcept;
 
  private:
-  Lookup lookup_;
+  /**
+   * @brief Catalog retired by Reload.
+   */
+  struct RetiredLookup {
+    /**
+     * @brief Retired lookup.
+     */
+    un<Lookup> lookup;
+    /**
+     * @brief Grace period phase lookup retired in.
+     */
+    std::uint64_t phase;
+    /**
+     * @brief Reclaims count when lookup retired.
+     */
+    std::uint64_t reclaims_count;
+  };
+
   WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
     // Private member is not accessible to the DLL's client, including inline
     // functions.
     WB_MSVC_DISABLE_WARNING(4251)
+    /**
+     * @brief Current lookup.
+     */
+    std::atomic<Lookup*> lookup_;
+    /**
+     * @brief Readers count in read-side critical sections, by phase parity.
+     */
+    mutable std::array<std::atomic<std::uint32_t>, 2> readers_;
+    /**
+     * @brief Grace period phase.  Readers enter current phase counter, phase
+     * is advanced only when readers of previous one left.
+     */
+    std::atomic<std::uint64_t> phase_;
+    /**
+     * @brief Serializes writers.
+     */
+    absl::Mutex writers_mutex_;
+    /**
+     * @brief Retired lookups waiting for grace period.
+     */
+    std::vector<RetiredLookup> retired_ ABSL_GUARDED_BY(writers_mutex_);
+    /**
+     * @brief Reclaim calls count.  Retired lookups live at least one full
+     * frame between Reclaim calls.
+     */
+    std::uint64_t reclaims_count_ ABSL_GUARDED_BY(writers_mutex_);
+    /**
+     * @brief Last loaded locale ids.
+     */
+    std::vector<std::string> locale_ids_ ABSL_GUARDED_BY(writers_mutex_);
+    /**
+     * @brief Last loaded catalogs directory.
+     */
+    std::filesystem::path catalogs_directory_ ABSL_GUARDED_BY(writers_mutex_);
+    /**
+     * @brief Catalog files modification times of last load, by locale id.
+     */
+    std::vector<std::filesystem::file_time_type> catalogs_write_times_
+        ABSL_GUARDED_BY(writers_mutex_);
+    /**
+     * @brief Fallback string.
+     */
     std::string fallback_string_;
   WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
 
@@ -87,9 +276,63 @@ class WB_BASE_API LookupWithFallback {
    * @param fallback_string Fallback string.
    * @return nothing.
    */
-  LookupWithFallback(Lookup lookup, std::string fallback_string) noexcept;
+  LookupWithFallback(un<Lookup> lookup, std::string fallback_string) noexcept;
+
+  /**
+   * @brief Remembers loaded locale ids and catalog files modification times,
+   * so changed catalogs can be reloaded.
+   * @param locale_ids Locale ids.
+   * @param catalogs_directory Catalogs directory.
+   * @param write_times Catalog files modification times.
+   * @return nothing.
+   */
+  void RememberLoadedLocked(
+      const std::vector<std::string_view>& locale_ids,
+      const std::filesystem::path& catalogs_directory,
+      std::vector<std::filesystem::file_time_type> write_times) noexcept
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(writers_mutex_);
+
+  /**
+   * @brief Frees retired catalogs which lived full frame and which grace period
+   * is over.
+   * @return Retired catalogs count still waiting to be freed.
+   */
+  std::size_t ReclaimLocked() noexcept
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(writers_mutex_);
 };
 
+/**
+ * @brief Enables hot reload of changed catalogs of |lookup| in scope.
+ * Catalogs are reloaded by HotReloadCatalogsIfDue.  Only one hot reload scope
+ * can exist at a time.
+ */
+class WB_BASE_API ScopedCatalogsHotReload {
+ public:
+  /**
+   * @brief Enables hot reload.  Nothing is reloaded when |poll_interval| is 0,
+   * but retired catalogs are still reclaimed.
+   * @param lookup Lookup to reload.  Should outlive scope.
+   * @param poll_interval How often to poll catalog files for changes.
+   */
+  ScopedCatalogsHotReload(LookupWithFallback& lookup,
+                          std::chrono::milliseconds poll_interval) noexcept;
+  /**
+   * @brief Disables hot reload.
+   */
+  ~ScopedCatalogsHotReload() noexcept;
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ScopedCatalogsHotReload);
+};
+
+/**
+ * @brief Reloads changed catalogs when poll interval is elapsed and reclaims
+ * retired ones.  Call once per frame at frame boundary: strings of current and
+ * previous frame stay valid, see LookupWithFallback::String.  Cheap when poll
+ * is not due.
+ * @return true if catalogs were reloaded.
+ */
+WB_BASE_API bool HotReloadCatalogsIfDue() noexcept;
+
 }  // namespace wb::base::intl
 
 #endif  // !WB_BASE_INTL_LOOKUP_WITH_FALLBACK_H_
@@ -6,6 +6,15 @@
 
 #include "lookup_with_fallback.h"
 //
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "binary_message_catalog.h"
 #include "l18n.h"
 //
 #include "base/deps/googletest/gtest/gtest.h"
@@ -22,6 +31,71 @@ hash(std::string_view &&string) noexcept {
   return wb::base::intl::I18nStringViewHash{}(string);
 }
 
+/**
+ * @brief Writes binary catalog |file_name| with single |message| translation
+ * to |directory|.
+ * @param directory Catalogs directory.
+ * @param file_name Catalog file name.
+ * @param message Source message.
+ * @param translation Message translation.
+ * @return true on success.
+ */
+[[nodiscard]] bool WriteCatalog(const std::filesystem::path &directory,
+                                std::string_view file_name,
+                                std::string_view message,
+                                std::string_view translation) noexcept {
+  using namespace wb::base::intl;
+
+  const auto messages = std::to_array<MessageCatalogEntry>(
+      {{I18nStringViewHash{}(message), translation}});
+  const auto catalog =
+      WriteBinaryMessageCatalog(messages, StringLayout::LeftToRight);
+  if (!catalog) return false;
+
+  std::filesystem::create_directories(directory);
+
+  std::ofstream catalog_file{directory / file_name,
+                             std::ios::binary | std::ios::trunc};
+  catalog_file.write(reinterpret_cast<const char *>(catalog->data()),
+                     static_cast<std::streamsize>(catalog->size()));
+  return !!catalog_file;
+}
+
+/**
+ * @brief Atomically replaces catalog |file_name| in |directory| with one
+ * which has single |message| translation and later modification time.
+ * @param directory Catalogs directory.
+ * @param file_name Catalog file name.
+ * @param message Source message.
+ * @param translation Message translation.
+ * @return true on success.
+ */
+[[nodiscard]] bool ReplaceCatalog(const std::filesystem::path &directory,
+                                  std::string_view file_name,
+                                  std::string_view message,
+                                  std::string_view translation) noexcept {
+  const std::filesystem::path path{directory / file_name};
+  std::filesystem::path new_path{path};
+  new_path += ".new";
+
+  std::error_code rc;
+  const auto write_time = std::filesystem::last_write_time(path, rc);
+  if (rc) return false;
+
+  if (!WriteCatalog(directory, new_path.filename().string(), message,
+                    translation)) {
+    return false;
+  }
+
+  // File system time resolution may be coarse, so ensure time changed.
+  std::filesystem::last_write_time(
+      new_path, write_time + std::chrono::seconds{1}, rc);
+  if (rc) return false;
+
+  std::filesystem::rename(new_path, path, rc);
+  return !rc;
+}
+
 }  // namespace
 
 // NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -90,4 +164,189 @@ GTEST_TEST(LookupWithFallbackTest, NewEnUsUtf8Locale) {
 
     EXPECT_EQ(kTestFallbackString, non_formatted_too_many_args);
   }
-}
\ No newline at end of file
+
+  {
+    fmt::memory_buffer buffer;
+
+    lookup->FormatTo(hash("Unable to create main '{0}' window."), buffer,
+                     fmt::make_format_args("WhiteBox"));
+    lookup->FormatTo(hash("Unknown string '{0}'."), buffer,
+                     fmt::make_format_args("WhiteBox"));
+
+    EXPECT_EQ(std::string{"Unable to create main 'WhiteBox' window."} +
+                  kTestFallbackString,
+              fmt::to_string(buffer));
+  }
+
+  {
+    std::array<char, 5> buffer;
+
+    EXPECT_EQ(std::string_view{"Fall"},
+              lookup->FormatTo(hash("Unknown string '{0}'."), buffer,
+                               fmt::make_format_args("WhiteBox")))
+        << "Fallback should be truncated to fit buffer.";
+    EXPECT_EQ('\0', buffer.back());
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LookupWithFallbackTest, Reload) {
+  using namespace wb::base::intl;
+
+  const std::filesystem::path catalogs_directory{
+      std::filesystem::temp_directory_path() / "wb-reload-catalogs"};
+
+  ASSERT_TRUE(WriteCatalog(catalogs_directory, "de_DE.wbmc",
+                           "Boot Manager - Error", "Boot Manager - Fehler"));
+
+  auto lookup = LookupWithFallback::New({"en_US.UTF-8"});
+
+  ASSERT_TRUE(lookup);
+  EXPECT_EQ("Boot Manager - Error",
+            lookup->String(hash("Boot Manager - Error")));
+
+  EXPECT_EQ(Status::kArgumentError,
+            lookup->Reload({"unknown-locale"}, catalogs_directory).error());
+  EXPECT_EQ("Boot Manager - Error",
+            lookup->String(hash("Boot Manager - Error")))
+      << "Failed reload should keep current catalog.";
+
+  {
+    const LookupWithFallback::ReadScope scope{*lookup};
+    const std::string_view english{
+        lookup->String(hash("Boot Manager - Error"))};
+
+    ASSERT_TRUE(lookup->Reload({"de_DE.UTF-8"}, catalogs_directory));
+    EXPECT_EQ("Boot Manager - Fehler",
+              lookup->String(hash("Boot Manager - Error")));
+
+    EXPECT_EQ(1U, lookup->Reclaim())
+        << "Catalog should not be freed while read scope is alive.";
+    EXPECT_EQ("Boot Manager - Error", english);
+  }
+
+  EXPECT_EQ(0U, lookup->Reclaim());
+
+  // Hot-reload changed catalog.
+  ASSERT_TRUE(WriteCatalog(catalogs_directory, "de_DE.wbmc.new",
+                           "Boot Manager - Error", "Bootmanager - Fehler"));
+  std::filesystem::rename(catalogs_directory / "de_DE.wbmc.new",
+                          catalogs_directory / "de_DE.wbmc");
+
+  // String got outside of read scope.
+  const std::string_view german{lookup->String(hash("Boot Manager - Error"))};
+
+  ASSERT_TRUE(lookup->Reload({"de_DE.UTF-8"}, catalogs_directory));
+  EXPECT_EQ("Bootmanager - Fehler",
+            lookup->String(hash("Boot Manager - Error")));
+
+  // Retired catalog lives full frame.
+  EXPECT_EQ(1U, lookup->Reclaim());
+  EXPECT_EQ("Boot Manager - Fehler", german);
+  EXPECT_EQ(0U, lookup->Reclaim());
+
+  std::error_code rc;
+  std::filesystem::remove_all(catalogs_directory, rc);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LookupWithFallbackTest, ReloadWhileReading) {
+  using namespace wb::base::intl;
+
+  const std::filesystem::path catalogs_directory{
+      std::filesystem::temp_directory_path() / "wb-reload-read-catalogs"};
+
+  ASSERT_TRUE(WriteCatalog(catalogs_directory, "de_DE.wbmc",
+                           "Boot Manager - Error", "Boot Manager - Fehler"));
+
+  auto lookup = LookupWithFallback::New({"en_US.UTF-8"});
+
+  ASSERT_TRUE(lookup);
+
+  std::atomic_bool should_stop{false};
+  std::atomic_size_t bad_reads_count{0};
+
+  std::vector<std::thread> readers;
+  for (std::size_t i{0}; i < 4; ++i) {
+    readers.emplace_back([&]() noexcept {
+      while (!should_stop.load(std::memory_order_relaxed)) {
+        const LookupWithFallback::ReadScope scope{*lookup};
+        const std::string_view string{
+            lookup->String(hash("Boot Manager - Error"))};
+
+        if (string != "Boot Manager - Error" &&
+            string != "Boot Manager - Fehler") {
+          bad_reads_count.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+
+  for (std::size_t i{0}; i < 200; ++i) {
+    EXPECT_TRUE(lookup->Reload(
+        i % 2 == 0 ? std::vector<std::string_view>{"de_DE.UTF-8"}
+                   : std::vector<std::string_view>{"en_US.UTF-8"},
+        catalogs_directory));
+    lookup->Reclaim();
+  }
+
+  should_stop.store(true, std::memory_order_relaxed);
+  for (auto &reader : readers) reader.join();
+
+  EXPECT_EQ(0U, bad_reads_count.load());
+  EXPECT_EQ(0U, lookup->Reclaim());
+
+  std::error_code rc;
+  std::filesystem::remove_all(catalogs_directory, rc);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LookupWithFallbackTest, HotReloadChangedCatalogs) {
+  using namespace wb::base::intl;
+  using namespace std::chrono_literals;
+
+  const std::filesystem::path catalogs_directory{
+      std::filesystem::temp_directory_path() / "wb-hot-reload-catalogs"};
+
+  ASSERT_TRUE(WriteCatalog(catalogs_directory, "de_DE.wbmc",
+                           "Boot Manager - Error", "Boot Manager - Fehler"));
+
+  auto lookup = LookupWithFallback::New({"de_DE.UTF-8", "en_US.UTF-8"},
+                                        kFallbackString, catalogs_directory);
+
+  ASSERT_TRUE(lookup);
+  EXPECT_FALSE(lookup->ReloadIfChanged().value_or(true));
+
+  ASSERT_TRUE(ReplaceCatalog(catalogs_directory, "de_DE.wbmc",
+                             "Boot Manager - Error", "Bootmanager - Fehler"));
+
+  EXPECT_TRUE(lookup->ReloadIfChanged().value_or(false));
+  EXPECT_EQ("Bootmanager - Fehler",
+            lookup->String(hash("Boot Manager - Error")));
+  EXPECT_FALSE(lookup->ReloadIfChanged().value_or(true));
+
+  {
+    const ScopedCatalogsHotReload scoped_hot_reload{*lookup, 1ms};
+
+    ASSERT_TRUE(ReplaceCatalog(catalogs_directory, "de_DE.wbmc",
+                               "Boot Manager - Error", "Boot-Manager-Fehler"));
+    std::this_thread::sleep_for(2ms);
+
+    EXPECT_TRUE(HotReloadCatalogsIfDue());
+    EXPECT_EQ("Boot-Manager-Fehler",
+              lookup->String(hash("Boot Manager - Error")));
+    // Retired catalog is reclaimed at frame boundary.
+    EXPECT_EQ(0U, lookup->Reclaim());
+  }
+
+  // Catalog is removed, so fall back to built-in English one.
+  std::filesystem::remove(catalogs_directory / "de_DE.wbmc");
+
+  EXPECT_FALSE(HotReloadCatalogsIfDue()) << "No hot reload scope.";
+  EXPECT_TRUE(lookup->ReloadIfChanged().value_or(false));
+  EXPECT_EQ("Boot Manager - Error",
+            lookup->String(hash("Boot Manager - Error")));
+
+  std::error_code rc;
+  std::filesystem::remove_all(catalogs_directory, rc);
+}
@@ -0,0 +1,376 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Compile-time perfect-hash table of localized messages by message id.
+//
+// const auto catalog = MakeMessageCatalog(
+//     std::to_array<std::string_view>({"Hello", "World"}));
+// static_assert(catalog.IsPerfect());
+// catalog.Find(I18nStringViewHash{}("Hello")) == "Hello";
+
+#ifndef WB_BASE_INTL_MESSAGE_CATALOG_H_
+#define WB_BASE_INTL_MESSAGE_CATALOG_H_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "base/intl/l18n.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::intl {
+
+/**
+ * @brief Message catalog slot.  Empty slot has null text.
+ */
+struct MessageCatalogEntry {
+  /**
+   * @brief Message id.
+   */
+  std::uint64_t id;
+  /**
+   * @brief Message text.
+   */
+  std::string_view text;
+};
+
+namespace internal {
+
+/**
+ * @brief Mixes message id bits, as I18nStringViewHash values are far from
+ * uniform.  MurmurHash3 64-bit finalizer.
+ * @param id Message id.
+ * @return Mixed message id.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST WB_ATTRIBUTE_FORCEINLINE constexpr std::uint64_t
+MixMessageId(std::uint64_t id) noexcept {
+  id ^= id >> 33U;
+  id *= 0xff51afd7ed558ccdULL;
+  id ^= id >> 33U;
+  id *= 0xc4ceb9fe1a85ec53ULL;
+  id ^= id >> 33U;
+  return id;
+}
+
+/**
+ * @brief Gets bucket index for message id.
+ * @param id Message id.
+ * @param buckets_count Buckets count, power of 2.
+ * @return Bucket index.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST WB_ATTRIBUTE_FORCEINLINE constexpr std::size_t
+MessageBucketIndex(std::uint64_t id, std::size_t buckets_count) noexcept {
+  return (MixMessageId(id) >> 32U) & (buckets_count - 1);
+}
+
+/**
+ * @brief Gets slot index for message id displaced by |displacement|.
+ * @param id Message id.
+ * @param displacement Bucket displacement.
+ * @param slots_count Slots count, power of 2.
+ * @return Slot index.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST WB_ATTRIBUTE_FORCEINLINE constexpr std::size_t
+MessageSlotIndex(std::uint64_t id, std::uint16_t displacement,
+                 std::size_t slots_count) noexcept {
+  return MixMessageId(id ^ (0x9e3779b97f4a7c15ULL * (displacement + 1ULL))) &
+         (slots_count - 1);
+}
+
+/**
+ * @brief Gets buckets count for |messages_count| messages.  ~2 messages per
+ * bucket.
+ * @param messages_count Messages count.
+ * @return Buckets count, power of 2.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST constexpr std::size_t MessageBucketsCount(
+    std::size_t messages_count) noexcept {
+  return std::bit_ceil((messages_count + 1) / 2);
+}
+
+/**
+ * @brief Gets slots count for |messages_count| messages.  Load factor is <=
+ * 2/3.
+ * @param messages_count Messages count.
+ * @return Slots count, power of 2.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST constexpr std::size_t MessageSlotsCount(
+    std::size_t messages_count) noexcept {
+  return std::bit_ceil(messages_count + messages_count / 2 + 1);
+}
+
+/**
+ * @brief Builds perfect hash for message |ids|: finds bucket |displacements|
+ * for which all ids land into distinct slots.  Usable both at compile time and
+ * at runtime.
+ * @param ids Message ids.
+ * @param slots_count Slots count, power of 2.
+ * @param displacements Buckets displacements, power of 2 size.
+ * @param message_slots Slot index for each message id.
+ * @return true if perfect hash is built, false on ids collision.
+ */
+[[nodiscard]] constexpr bool PlaceMessageIds(
+    std::span<const std::uint64_t> ids, std::size_t slots_count,
+    std::span<std::uint16_t> displacements,
+    std::span<std::size_t> message_slots) noexcept {
+  const std::size_t buckets_count{displacements.size()};
+
+  std::vector<std::vector<std::size_t>> buckets(buckets_count);
+  for (std::size_t i{0}; i < ids.size(); ++i) {
+    buckets[MessageBucketIndex(ids[i], buckets_count)].push_back(i);
+  }
+
+  // Place largest buckets first, as they are the hardest to place.
+  std::vector<std::size_t> buckets_order(buckets_count);
+  for (std::size_t i{0}; i < buckets_count; ++i) buckets_order[i] = i;
+
+  std::sort(buckets_order.begin(), buckets_order.end(),
+            [&](std::size_t left, std::size_t right) {
+              return buckets[left].size() != buckets[right].size()
+                         ? buckets[left].size() > buckets[right].size()
+                         : left < right;
+            });
+
+  std::vector<unsigned char> is_slot_used(slots_count);
+  std::vector<std::size_t> bucket_slots;
+
+  for (const std::size_t bucket : buckets_order) {
+    const std::vector<std::size_t>& bucket_messages{buckets[bucket]};
+    if (bucket_messages.empty()) break;
+
+    for (std::size_t i{0}; i < bucket_messages.size(); ++i) {
+      for (std::size_t j{i + 1}; j < bucket_messages.size(); ++j) {
+        // Same ids can't be placed into distinct slots.
+        if (ids[bucket_messages[i]] == ids[bucket_messages[j]]) [[unlikely]] {
+          return false;
+        }
+      }
+    }
+
+    bool is_placed{false};
+
+    for (std::uint32_t displacement{0};
+         !is_placed &&
+         displacement <= std::numeric_limits<std::uint16_t>::max();
+         ++displacement) {
+      const auto candidate = static_cast<std::uint16_t>(displacement);
+
+      bucket_slots.clear();
+      is_placed = true;
+
+      for (const std::size_t message : bucket_messages) {
+        const std::size_t slot{
+            MessageSlotIndex(ids[message], candidate, slots_count)};
+
+        if (is_slot_used[slot] ||
+            std::find(bucket_slots.begin(), bucket_slots.end(), slot) !=
+                bucket_slots.end()) {
+          is_placed = false;
+          break;
+        }
+
+        bucket_slots.push_back(slot);
+      }
+
+      if (is_placed) {
+        for (std::size_t i{0}; i < bucket_messages.size(); ++i) {
+          is_slot_used[bucket_slots[i]] = 1;
+          message_slots[bucket_messages[i]] = bucket_slots[i];
+        }
+
+        displacements[bucket] = candidate;
+      }
+    }
+
+    if (!is_placed) [[unlikely]] {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace internal
+
+/**
+ * @brief Type-erased read-only view of message catalog.  Lookup is two loads
+ * and one compare.
+ */
+class MessageCatalogView {
+ public:
+  /**
+   * @brief Creates message catalog view.
+   * @param displacements Buckets displacements.
+   * @param slots Slots.
+   * @return nothing.
+   */
+  constexpr MessageCatalogView(
+      std::span<const std::uint16_t> displacements,
+      std::span<const MessageCatalogEntry> slots) noexcept
+      : displacements_{displacements}, slots_{slots} {}
+
+  /**
+   * @brief Finds message by id.
+   * @param id Message id.
+   * @return Message text or nullopt if no message.
+   */
+  [[nodiscard]] constexpr std::optional<std::string_view> Find(
+      std::uint64_t id) const noexcept {
+    const std::uint16_t displacement{displacements_[internal::MessageBucketIndex(
+        id, displacements_.size())]};
+    const MessageCatalogEntry& entry{
+        slots_[internal::MessageSlotIndex(id, displacement, slots_.size())]};
+
+    return entry.id == id && entry.text.data() != nullptr
+               ? std::optional<std::string_view>{entry.text}
+               : std::nullopt;
+  }
+
+ private:
+  /**
+   * @brief Buckets displacements.
+   */
+  std::span<const std::uint16_t> displacements_;
+  /**
+   * @brief Slots.
+   */
+  std::span<const MessageCatalogEntry> slots_;
+};
+
+WB_GCC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Tail padding depends on messages count, it is ok.
+  WB_GCC_DISABLE_PADDED_WARNING()
+
+  /**
+   * @brief Compile-time perfect-hash (hash and displace) table of messages by
+   * I18nStringViewHash message ids.
+   * @tparam kMessagesCount Messages count.
+   */
+  template <std::size_t kMessagesCount>
+  class MessageCatalog {
+   public:
+    /**
+     * @brief Buckets count.
+     */
+    static constexpr std::size_t kBucketsCount{
+        internal::MessageBucketsCount(kMessagesCount)};
+    /**
+     * @brief Slots count.
+     */
+    static constexpr std::size_t kSlotsCount{
+        internal::MessageSlotsCount(kMessagesCount)};
+
+    /**
+     * @brief Builds perfect-hash table for |messages|.  Check IsPerfect after
+     * build.
+     * @param messages Messages.
+     * @return nothing.
+     */
+    consteval explicit MessageCatalog(
+        const std::array<std::string_view, kMessagesCount>& messages) noexcept
+        : displacements_{}, slots_{}, is_perfect_{false} {
+      std::array<std::uint64_t, kMessagesCount> ids{};
+      for (std::size_t i{0}; i < kMessagesCount; ++i) {
+        ids[i] = I18nStringViewHash{}(messages[i]);
+      }
+
+      std::array<std::size_t, kMessagesCount> message_slots{};
+      if (!internal::PlaceMessageIds(ids, kSlotsCount, displacements_,
+                                     message_slots)) [[unlikely]] {
+        return;
+      }
+
+      for (std::size_t i{0}; i < kMessagesCount; ++i) {
+        slots_[message_slots[i]] = MessageCatalogEntry{ids[i], messages[i]};
+      }
+
+      is_perfect_ = true;
+    }
+
+    /**
+     * @brief Is perfect hash built?  False when I18nStringViewHash collides.
+     * @return true if all messages placed.
+     */
+    [[nodiscard]] constexpr bool IsPerfect() const noexcept {
+      return is_perfect_;
+    }
+
+    /**
+     * @brief Gets type-erased catalog view.
+     * @return Catalog view.
+     */
+    [[nodiscard]] constexpr MessageCatalogView View() const noexcept {
+      return MessageCatalogView{displacements_, slots_};
+    }
+
+    /**
+     * @brief Finds message by id.
+     * @param id Message id.
+     * @return Message text or nullopt if no message.
+     */
+    [[nodiscard]] constexpr std::optional<std::string_view> Find(
+        std::uint64_t id) const noexcept {
+      return View().Find(id);
+    }
+
+   private:
+    /**
+     * @brief Buckets displacements.
+     */
+    std::array<std::uint16_t, kBucketsCount> displacements_;
+    /**
+     * @brief Slots.
+     */
+    std::array<MessageCatalogEntry, kSlotsCount> slots_;
+    /**
+     * @brief Are all messages placed?
+     */
+    bool is_perfect_;
+  };
+
+WB_GCC_END_WARNING_OVERRIDE_SCOPE()
+
+/**
+ * @brief Checks all |messages| have distinct non-zero I18nStringViewHash ids.
+ * @tparam kMessagesCount Messages count.
+ * @param messages Messages.
+ * @return true if no message id collisions.
+ */
+template <std::size_t kMessagesCount>
+[[nodiscard]] consteval bool HasUniqueMessageIds(
+    const std::array<std::string_view, kMessagesCount>& messages) noexcept {
+  std::array<std::uint64_t, kMessagesCount> ids{};
+  for (std::size_t i{0}; i < kMessagesCount; ++i) {
+    ids[i] = I18nStringViewHash{}(messages[i]);
+    // Zero is hash of empty string, which is not a message.
+    if (ids[i] == 0) return false;
+  }
+
+  std::sort(ids.begin(), ids.end());
+  return std::adjacent_find(ids.begin(), ids.end()) == ids.end();
+}
+
+/**
+ * @brief Builds message catalog at compile time.
+ * @tparam kMessagesCount Messages count.
+ * @param messages Messages.
+ * @return Message catalog.
+ */
+template <std::size_t kMessagesCount>
+[[nodiscard]] consteval MessageCatalog<kMessagesCount> MakeMessageCatalog(
+    const std::array<std::string_view, kMessagesCount>& messages) noexcept {
+  return MessageCatalog<kMessagesCount>{messages};
+}
+
+}  // namespace wb::base::intl
+
+#endif  // !WB_BASE_INTL_MESSAGE_CATALOG_H_
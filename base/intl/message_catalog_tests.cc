@@ -0,0 +1,97 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Compile-time perfect-hash table of localized messages by message id.
+
+#include "message_catalog.h"
+//
+#include "base/deps/googletest/gtest/gtest.h"
+
+namespace {
+
+/**
+ * Computes hash for |string|.
+ * @param string String to hash.
+ * @return String hash.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST WB_ATTRIBUTE_FORCEINLINE constexpr uint64_t
+hash(std::string_view &&string) noexcept {
+  return wb::base::intl::I18nStringViewHash{}(string);
+}
+
+constexpr auto kTestMessages = std::to_array<std::string_view>(
+    {"Hello", "World", "{0} - Error", "Can't load '{0}'.", "a", "abc", "ABC",
+     "123", "ABC 123", "Sorry, only single '{0}' can run at a time."});
+
+constexpr auto kTestCatalog = wb::base::intl::MakeMessageCatalog(kTestMessages);
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MessageCatalogTest, HasUniqueMessageIds) {
+  using namespace wb::base::intl;
+
+  static_assert(HasUniqueMessageIds(kTestMessages));
+  static_assert(
+      !HasUniqueMessageIds(std::to_array<std::string_view>({"a", "b", "a"})));
+  static_assert(
+      !HasUniqueMessageIds(std::to_array<std::string_view>({"a", ""})));
+  static_assert(HasUniqueMessageIds(std::array<std::string_view, 0>{}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MessageCatalogTest, IsPerfect) {
+  using namespace wb::base::intl;
+
+  static_assert(kTestCatalog.IsPerfect());
+  static_assert(!MakeMessageCatalog(
+                     std::to_array<std::string_view>({"a", "b", "a"}))
+                     .IsPerfect());
+  static_assert(MakeMessageCatalog(std::array<std::string_view, 0>{})
+                    .IsPerfect());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MessageCatalogTest, FindAtCompileTime) {
+  static_assert(kTestCatalog.Find(hash("Hello")) == "Hello");
+  static_assert(kTestCatalog.Find(hash("ABC 123")) == "ABC 123");
+  static_assert(kTestCatalog.Find(hash("{0} - Error")) == "{0} - Error");
+  static_assert(!kTestCatalog.Find(hash("Unknown")));
+  static_assert(!kTestCatalog.Find(0));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MessageCatalogTest, FindAllMessages) {
+  using namespace wb::base::intl;
+
+  const MessageCatalogView view{kTestCatalog.View()};
+
+  for (const std::string_view message : kTestMessages) {
+    const auto found = view.Find(hash(std::string_view{message}));
+
+    ASSERT_TRUE(found.has_value()) << message;
+    EXPECT_EQ(message, *found);
+    // Zero-copy, points to original message.
+    EXPECT_EQ(message.data(), found->data());
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MessageCatalogTest, FindMissedMessages) {
+  using namespace wb::base::intl;
+
+  const MessageCatalogView view{kTestCatalog.View()};
+
+  EXPECT_FALSE(view.Find(hash("Unknown")).has_value());
+  EXPECT_FALSE(view.Find(hash("hello")).has_value());
+  EXPECT_FALSE(view.Find(0).has_value());
+
+  for (std::uint64_t id{1}; id < 4096; ++id) {
+    const auto found = view.Find(id);
+
+    if (found.has_value()) {
+      EXPECT_EQ(id, hash(std::string_view{*found}));
+    }
+  }
+}
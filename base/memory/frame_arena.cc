@@ -0,0 +1,296 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Per-thread double buffered frame arenas.
+
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <thread>
+
+#include "base/deps/abseil/base/thread_annotations.h"
+#include "base/deps/abseil/synchronization/mutex.h"
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/mimalloc/mimalloc.h"
+#include "base/memory/large_pages_arena.h"
+
+namespace {
+
+/**
+ * @brief Frame buffer alignment.  Cache line, so arenas of different threads
+ * never share one.
+ */
+constexpr std::size_t kBufferAlignment{64};
+
+/**
+ * @brief Frame epoch thread frame arenas follow.
+ */
+std::atomic_uint64_t thread_frame_epoch{0};
+
+/**
+ * @brief Frame arena of a thread and memory resource over it.
+ */
+struct ThreadFrameArena {
+  /**
+   * @brief Creates thread frame arena.
+   * @param capacity Bytes capacity of one frame buffer.
+   */
+  explicit ThreadFrameArena(std::size_t capacity) noexcept
+      : arena{capacity, &thread_frame_epoch}, resource{arena} {}
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ThreadFrameArena);
+
+  /**
+   * @brief Frame arena.
+   */
+  wb::base::memory::FrameArena arena;
+  /**
+   * @brief Memory resource over arena.
+   */
+  wb::base::memory::FrameArenaResource resource;
+};
+
+/**
+ * @brief Capacity of frame arenas to create.
+ */
+std::atomic_size_t thread_frame_arena_capacity{
+    wb::base::memory::kDefaultFrameArenaCapacity};
+
+/**
+ * @brief Mutex to serialize accesses to thread_frame_arenas.
+ */
+ABSL_CONST_INIT absl::Mutex thread_frame_arenas_mutex{absl::kConstInit};
+
+/**
+ * @brief Frame arenas of all threads.  Never freed, as threads may outlive
+ * static destructors.
+ */
+std::vector<ThreadFrameArena*>* thread_frame_arenas
+    ABSL_GUARDED_BY(thread_frame_arenas_mutex){nullptr};
+
+/**
+ * @brief Frame arena of current thread.
+ */
+thread_local ThreadFrameArena* thread_frame_arena{nullptr};
+
+/**
+ * @brief Gets frame arena of current thread, creating it on first call.
+ * @return Thread frame arena.
+ */
+[[nodiscard]] ThreadFrameArena& GetThreadFrameArenaEntry() noexcept {
+  if (thread_frame_arena) [[likely]] {
+    return *thread_frame_arena;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  thread_frame_arena = new ThreadFrameArena{
+      thread_frame_arena_capacity.load(std::memory_order_relaxed)};
+
+  absl::MutexLock lock{&thread_frame_arenas_mutex};
+  if (!thread_frame_arenas) {
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+    thread_frame_arenas = new std::vector<ThreadFrameArena*>;
+  }
+  thread_frame_arenas->push_back(thread_frame_arena);
+
+  return *thread_frame_arena;
+}
+
+}  // namespace
+
+namespace wb::base::memory {
+
+FrameArena::FrameArena(std::size_t capacity,
+                       const std::atomic_uint64_t* frame_epoch) noexcept
+    : buffers_{},
+      capacity_{capacity},
+      frame_epoch_{frame_epoch},
+      epoch_{frame_epoch ? frame_epoch->load(std::memory_order_acquire) : 0},
+      used_{0},
+      high_water_mark_{0},
+      overflow_bytes_{0},
+      overflow_count_{0},
+      current_{0},
+      is_overflow_logged_{false},
+      pad_{} {
+  for (auto& buffer : buffers_) {
+    // Frame memory is hot, so keep it in large pages arena if any.
+    buffer.memory = static_cast<std::byte*>(
+        AllocateInLargePagesArena(capacity, kBufferAlignment));
+    G3CHECK(capacity == 0 || buffer.memory != nullptr)
+        << "Unable to allocate " << capacity << " bytes for frame arena.";
+  }
+}
+
+FrameArena::~FrameArena() noexcept {
+  for (auto& buffer : buffers_) {
+    for (void* overflow : buffer.overflows) {
+      ::mi_free(overflow);
+    }
+    ::mi_free(buffer.memory);
+  }
+}
+
+[[nodiscard]] void* FrameArena::Allocate(std::size_t bytes,
+                                         std::size_t alignment) noexcept {
+  G3DCHECK(std::has_single_bit(alignment))
+      << "Alignment " << alignment << " is not power of 2.";
+
+  if (frame_epoch_ && frame_epoch_->load(std::memory_order_acquire) !=
+                          epoch_.load(std::memory_order_relaxed))
+      [[unlikely]] {
+    FollowFrameEpoch();
+  }
+
+  Buffer& buffer{buffers_[current_]};
+
+  const auto address = reinterpret_cast<std::uintptr_t>(buffer.memory);
+  const std::size_t offset{
+      ((address + buffer.used + alignment - 1) & ~(alignment - 1)) - address};
+
+  if (offset <= capacity_ && bytes <= capacity_ - offset) [[likely]] {
+    buffer.used = offset + bytes;
+    used_.store(buffer.used + buffer.overflow_bytes,
+                std::memory_order_relaxed);
+    return buffer.memory + offset;
+  }
+
+  return AllocateOverflow(bytes, alignment);
+}
+
+void FrameArena::BeginFrame() noexcept {
+  {
+    const Buffer& buffer{buffers_[current_]};
+    // Only owner thread writes.
+    high_water_mark_.store(
+        std::max(high_water_mark_.load(std::memory_order_relaxed),
+                 buffer.used + buffer.overflow_bytes),
+        std::memory_order_relaxed);
+  }
+
+  // Buffer of frame before previous one is free now.
+  current_ ^= 1U;
+
+  Buffer& buffer{buffers_[current_]};
+  for (void* overflow : buffer.overflows) {
+    ::mi_free(overflow);
+  }
+
+  buffer.overflows.clear();
+  buffer.overflow_bytes = 0;
+  buffer.used = 0;
+  used_.store(0, std::memory_order_relaxed);
+
+  is_overflow_logged_ = false;
+}
+
+[[nodiscard]] FrameArenaStats FrameArena::GetStats() const noexcept {
+  const std::size_t used{used_.load(std::memory_order_relaxed)};
+  // Arena which did not allocate since frame epoch changed has nothing in
+  // current frame.
+  const bool is_current_frame{
+      !frame_epoch_ || frame_epoch_->load(std::memory_order_relaxed) ==
+                           epoch_.load(std::memory_order_relaxed)};
+
+  return {.capacity = capacity_,
+          .used = is_current_frame ? used : 0,
+          .high_water_mark = std::max(
+              high_water_mark_.load(std::memory_order_relaxed), used),
+          .overflow_bytes = overflow_bytes_.load(std::memory_order_relaxed),
+          .overflow_count = overflow_count_.load(std::memory_order_relaxed)};
+}
+
+void FrameArena::FollowFrameEpoch() noexcept {
+  const std::uint64_t epoch{frame_epoch_->load(std::memory_order_acquire)};
+  const std::uint64_t frames_count{epoch -
+                                   epoch_.load(std::memory_order_relaxed)};
+
+  BeginFrame();
+  // Memory of both buffers is free after 2+ frames.
+  if (frames_count > 1) BeginFrame();
+
+  epoch_.store(epoch, std::memory_order_relaxed);
+}
+
+[[nodiscard]] void* FrameArena::AllocateOverflow(
+    std::size_t bytes, std::size_t alignment) noexcept {
+  if (!is_overflow_logged_) [[unlikely]] {
+    G3LOG(WARNING) << "Frame arena of thread " << std::this_thread::get_id()
+                   << " overflowed " << capacity_ << " bytes capacity on "
+                   << bytes << " bytes allocation, falling back to mimalloc.  "
+                      "Consider increasing frame arena capacity.";
+    is_overflow_logged_ = true;
+  }
+
+  void* memory{::mi_malloc_aligned(bytes, alignment)};
+  G3CHECK(memory != nullptr)
+      << "Unable to allocate " << bytes << " bytes for frame arena overflow.";
+
+  Buffer& buffer{buffers_[current_]};
+  buffer.overflows.push_back(memory);
+  buffer.overflow_bytes += bytes;
+  used_.store(buffer.used + buffer.overflow_bytes, std::memory_order_relaxed);
+
+  // Only owner thread writes.
+  overflow_bytes_.store(overflow_bytes_.load(std::memory_order_relaxed) + bytes,
+                        std::memory_order_relaxed);
+  overflow_count_.store(overflow_count_.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+
+  return memory;
+}
+
+[[nodiscard]] void* FrameArenaResource::do_allocate(std::size_t bytes,
+                                                    std::size_t alignment) {
+  return arena_.Allocate(bytes, alignment);
+}
+
+[[nodiscard]] bool FrameArenaResource::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept {
+  const auto* resource = dynamic_cast<const FrameArenaResource*>(&other);
+  return resource && &resource->arena_ == &arena_;
+}
+
+WB_BASE_API void SetThreadFrameArenaCapacity(std::size_t capacity) noexcept {
+  thread_frame_arena_capacity.store(capacity, std::memory_order_relaxed);
+}
+
+[[nodiscard]] WB_BASE_API FrameArena& GetThreadFrameArena() noexcept {
+  return GetThreadFrameArenaEntry().arena;
+}
+
+[[nodiscard]] WB_BASE_API std::pmr::memory_resource*
+GetThreadFrameMemoryResource() noexcept {
+  return &GetThreadFrameArenaEntry().resource;
+}
+
+WB_BASE_API void BeginFrameOnThreadFrameArenas() noexcept {
+  // Arenas are owned by their threads, so they start frame themselves.
+  thread_frame_epoch.fetch_add(1, std::memory_order_release);
+}
+
+[[nodiscard]] WB_BASE_API FrameArenaStats
+GetThreadFrameArenasStats() noexcept {
+  FrameArenaStats stats{};
+
+  absl::MutexLock lock{&thread_frame_arenas_mutex};
+  if (!thread_frame_arenas) return stats;
+
+  for (const ThreadFrameArena* entry : *thread_frame_arenas) {
+    const FrameArenaStats arena_stats{entry->arena.GetStats()};
+
+    stats.capacity += arena_stats.capacity;
+    stats.used += arena_stats.used;
+    stats.high_water_mark += arena_stats.high_water_mark;
+    stats.overflow_bytes += arena_stats.overflow_bytes;
+    stats.overflow_count += arena_stats.overflow_count;
+  }
+
+  return stats;
+}
+
+}  // namespace wb::base::memory
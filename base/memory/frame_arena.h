@@ -0,0 +1,263 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Per-thread double buffered frame arenas.
+
+#ifndef WB_BASE_MEMORY_FRAME_ARENA_H_
+#define WB_BASE_MEMORY_FRAME_ARENA_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "base/config.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::memory {
+
+/**
+ * @brief Default frame arena buffer capacity.
+ */
+constexpr std::size_t kDefaultFrameArenaCapacity{1U << 20U};
+
+/**
+ * @brief Frame arena statistics.
+ */
+struct FrameArenaStats {
+  /**
+   * @brief Bytes capacity of one frame buffer.
+   */
+  std::size_t capacity;
+  /**
+   * @brief Bytes allocated in current frame, including overflow.
+   */
+  std::size_t used;
+  /**
+   * @brief Max bytes allocated in one frame, including overflow.
+   */
+  std::size_t high_water_mark;
+  /**
+   * @brief Bytes which did not fit frame buffer and were allocated by
+   * mimalloc, since creation.
+   */
+  std::size_t overflow_bytes;
+  /**
+   * @brief Count of allocations which did not fit frame buffer, since
+   * creation.
+   */
+  std::size_t overflow_count;
+};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Bump allocator which memory is released in bulk on frame boundary.
+   * Has two buffers used by turns, so memory allocated in frame N stays valid
+   * during frame N + 1 and is reused in frame N + 2.  Allocations which do not
+   * fit buffer fall back to mimalloc and are released on the same schedule.
+   *
+   * Arena may follow frame epoch counter instead of explicit BeginFrame calls:
+   * when epoch changes, arena starts new frame(s) on its next allocation.  So
+   * frame thread never touches arenas of other threads.
+   *
+   * Not thread-safe, except GetStats.  Use one arena per thread, see
+   * GetThreadFrameArena().
+   */
+  class WB_BASE_API FrameArena {
+   public:
+    /**
+     * @brief Creates frame arena.
+     * @param capacity Bytes capacity of one frame buffer.
+     * @param frame_epoch Frame epoch counter to follow.  nullptr when frames
+     * are started by BeginFrame only.
+     */
+    explicit FrameArena(
+        std::size_t capacity,
+        const std::atomic_uint64_t* frame_epoch = nullptr) noexcept;
+    ~FrameArena() noexcept;
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(FrameArena);
+
+    /**
+     * @brief Allocates memory valid till the end of the next frame.
+     * @param bytes Bytes count.
+     * @param alignment Alignment, power of 2.
+     * @return Memory.  Never nullptr, terminates on out of memory.
+     */
+    [[nodiscard]] void* Allocate(std::size_t bytes,
+                                 std::size_t alignment) noexcept;
+
+    /**
+     * @brief Starts new frame.  Releases memory allocated two frames ago.
+     * Should be called by arena owner thread.
+     */
+    void BeginFrame() noexcept;
+
+    /**
+     * @brief Gets arena statistics.  Thread-safe, approximate while owner
+     * thread allocates.
+     */
+    [[nodiscard]] FrameArenaStats GetStats() const noexcept;
+
+   private:
+    /**
+     * @brief One frame buffer.
+     */
+    struct Buffer {
+      /**
+       * @brief Memory.
+       */
+      std::byte* memory;
+      /**
+       * @brief Bytes used.
+       */
+      std::size_t used;
+      /**
+       * @brief Overflow allocations, released on buffer reset.
+       */
+      std::vector<void*> overflows;
+      /**
+       * @brief Overflow bytes.
+       */
+      std::size_t overflow_bytes;
+    };
+
+    /**
+     * @brief Frame buffers, used by turns.
+     */
+    std::array<Buffer, 2> buffers_;
+    /**
+     * @brief Bytes capacity of one frame buffer.
+     */
+    std::size_t capacity_;
+    /**
+     * @brief Frame epoch counter to follow, may be nullptr.
+     */
+    const std::atomic_uint64_t* frame_epoch_;
+    /**
+     * @brief Frame epoch of current frame buffer.
+     */
+    std::atomic_uint64_t epoch_;
+    /**
+     * @brief Bytes allocated in current frame, including overflow.  Published
+     * for GetStats.
+     */
+    std::atomic_size_t used_;
+    /**
+     * @brief Max bytes allocated in one frame.
+     */
+    std::atomic_size_t high_water_mark_;
+    /**
+     * @brief Total overflow bytes.
+     */
+    std::atomic_size_t overflow_bytes_;
+    /**
+     * @brief Total overflow allocations count.
+     */
+    std::atomic_size_t overflow_count_;
+    /**
+     * @brief Index of current frame buffer.
+     */
+    std::size_t current_;
+    /**
+     * @brief Was overflow logged in current frame?
+     */
+    bool is_overflow_logged_;
+
+    WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 7> pad_;
+
+    /**
+     * @brief Starts frames which frame epoch counter passed since last
+     * allocation.
+     */
+    void FollowFrameEpoch() noexcept;
+
+    /**
+     * @brief Allocates |bytes| with |alignment| by mimalloc.
+     * @param bytes Bytes count.
+     * @param alignment Alignment.
+     * @return Memory.
+     */
+    [[nodiscard]] void* AllocateOverflow(std::size_t bytes,
+                                         std::size_t alignment) noexcept;
+  };
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+/**
+ * @brief std::pmr::memory_resource over frame arena.  Deallocation is no-op,
+ * memory is released on frame boundary.  Use with containers which live no
+ * longer than the next frame.
+ */
+class WB_BASE_API FrameArenaResource : public std::pmr::memory_resource {
+ public:
+  /**
+   * @brief Creates resource over |arena|.
+   * @param arena Frame arena.
+   */
+  explicit FrameArenaResource(FrameArena& arena) noexcept : arena_{arena} {}
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(FrameArenaResource);
+
+ private:
+  /**
+   * @brief Frame arena.
+   */
+  FrameArena& arena_;
+
+  [[nodiscard]] void* do_allocate(std::size_t bytes,
+                                  std::size_t alignment) override;
+
+  void do_deallocate(void*, std::size_t,
+                     std::size_t) noexcept override {}
+
+  [[nodiscard]] WB_ATTRIBUTE_PURE bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override;
+};
+
+/**
+ * @brief Sets buffer capacity of thread frame arenas created after this call.
+ * Should be called on startup before threads allocate from frame arenas.
+ * @param capacity Bytes capacity of one frame buffer.
+ */
+WB_BASE_API void SetThreadFrameArenaCapacity(std::size_t capacity) noexcept;
+
+/**
+ * @brief Gets frame arena of the current thread.  Created on first call and
+ * lives till process exit.
+ * @return Frame arena.
+ */
+[[nodiscard]] WB_BASE_API FrameArena& GetThreadFrameArena() noexcept;
+
+/**
+ * @brief Gets memory resource over frame arena of the current thread.
+ * @return Memory resource.
+ */
+[[nodiscard]] WB_BASE_API std::pmr::memory_resource*
+GetThreadFrameMemoryResource() noexcept;
+
+/**
+ * @brief Starts new frame for arenas of all threads.  Each thread arena starts
+ * it lazily on its next allocation, so memory allocated in previous frame stays
+ * valid during this one on every thread.  Thread-safe.
+ */
+WB_BASE_API void BeginFrameOnThreadFrameArenas() noexcept;
+
+/**
+ * @brief Gets statistics summed over arenas of all threads.  High-water mark
+ * is sum of per-thread high-water marks.  Thread-safe, approximate while
+ * threads allocate.
+ * @return Frame arenas statistics.
+ */
+[[nodiscard]] WB_BASE_API FrameArenaStats GetThreadFrameArenasStats() noexcept;
+
+}  // namespace wb::base::memory
+
+#endif  // !WB_BASE_MEMORY_FRAME_ARENA_H_
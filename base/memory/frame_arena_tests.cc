@@ -0,0 +1,194 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Per-thread double buffered frame arenas.
+
+#include "frame_arena.h"
+//
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FrameArenaTest, AllocateAligned) {
+  using namespace wb::base::memory;
+
+  FrameArena arena{1024};
+
+  for (std::size_t alignment : {1U, 2U, 8U, 16U, 64U}) {
+    void* memory{arena.Allocate(3, alignment)};
+    ASSERT_NE(nullptr, memory);
+    EXPECT_EQ(0U, reinterpret_cast<std::uintptr_t>(memory) % alignment);
+  }
+
+  const FrameArenaStats stats{arena.GetStats()};
+  EXPECT_EQ(1024U, stats.capacity);
+  EXPECT_GE(stats.used, 15U);
+  EXPECT_EQ(stats.used, stats.high_water_mark);
+  EXPECT_EQ(0U, stats.overflow_count);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FrameArenaTest, MemoryLivesOneExtraFrame) {
+  using namespace wb::base::memory;
+
+  FrameArena arena{256};
+
+  auto* frame0 = static_cast<char*>(arena.Allocate(128, 1));
+  std::memset(frame0, 'a', 128);
+
+  arena.BeginFrame();
+  EXPECT_EQ(0U, arena.GetStats().used);
+
+  auto* frame1 = static_cast<char*>(arena.Allocate(128, 1));
+  std::memset(frame1, 'b', 128);
+
+  // Frame 0 memory is still intact in frame 1.
+  EXPECT_NE(frame0, frame1);
+  for (std::size_t i{0}; i < 128; ++i) {
+    ASSERT_EQ('a', frame0[i]) << i;
+  }
+
+  // Frame 0 memory is reused in frame 2.
+  arena.BeginFrame();
+  EXPECT_EQ(frame0, arena.Allocate(128, 1));
+
+  EXPECT_EQ(128U, arena.GetStats().high_water_mark);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FrameArenaTest, OverflowFallsBackToMimalloc) {
+  using namespace wb::base::memory;
+
+  FrameArena arena{64};
+
+  void* fits{arena.Allocate(48, 8)};
+  ASSERT_NE(nullptr, fits);
+
+  auto* overflow = static_cast<char*>(arena.Allocate(100, 16));
+  ASSERT_NE(nullptr, overflow);
+  EXPECT_EQ(0U, reinterpret_cast<std::uintptr_t>(overflow) % 16);
+  std::memset(overflow, 'c', 100);
+
+  FrameArenaStats stats{arena.GetStats()};
+  EXPECT_EQ(148U, stats.used);
+  EXPECT_EQ(148U, stats.high_water_mark);
+  EXPECT_EQ(100U, stats.overflow_bytes);
+  EXPECT_EQ(1U, stats.overflow_count);
+
+  arena.BeginFrame();
+  arena.BeginFrame();
+
+  stats = arena.GetStats();
+  EXPECT_EQ(0U, stats.used);
+  EXPECT_EQ(148U, stats.high_water_mark);
+  EXPECT_EQ(1U, stats.overflow_count);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FrameArenaTest, MemoryResource) {
+  using namespace wb::base::memory;
+
+  FrameArena arena{1024};
+  FrameArenaResource resource{arena};
+  FrameArenaResource other_resource{arena};
+
+  EXPECT_TRUE(resource.is_equal(other_resource));
+  EXPECT_FALSE(resource.is_equal(*std::pmr::new_delete_resource()));
+
+  {
+    std::pmr::vector<int> values{&resource};
+    for (int i{0}; i < 16; ++i) values.push_back(i);
+
+    EXPECT_EQ(15, values.back());
+  }
+
+  EXPECT_GT(arena.GetStats().used, 16 * sizeof(int));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FrameArenaTest, ThreadFrameArenas) {
+  using namespace wb::base::memory;
+
+  FrameArena& arena{GetThreadFrameArena()};
+  EXPECT_EQ(&arena, &GetThreadFrameArena());
+
+  FrameArena* thread_arena{nullptr};
+  std::thread thread{[&thread_arena]() {
+    thread_arena = &GetThreadFrameArena();
+    (void)GetThreadFrameMemoryResource()->allocate(32, 8);
+  }};
+  thread.join();
+
+  EXPECT_NE(&arena, thread_arena);
+  ASSERT_NE(nullptr, thread_arena);
+  EXPECT_EQ(32U, thread_arena->GetStats().used);
+
+  const FrameArenaStats stats{GetThreadFrameArenasStats()};
+  EXPECT_GE(stats.used, 32U);
+  EXPECT_GE(stats.high_water_mark, 32U);
+
+  BeginFrameOnThreadFrameArenas();
+  EXPECT_EQ(0U, thread_arena->GetStats().used);
+  EXPECT_EQ(32U, thread_arena->GetStats().high_water_mark);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FrameArenaTest, FollowFrameEpoch) {
+  using namespace wb::base::memory;
+
+  std::atomic_uint64_t frame_epoch{7};
+  FrameArena arena{1024, &frame_epoch};
+
+  void* frame1{arena.Allocate(512, 8)};
+  EXPECT_EQ(512U, arena.GetStats().used);
+
+  // Frame starts on next allocation, previous frame memory is kept.
+  frame_epoch.fetch_add(1);
+  EXPECT_EQ(0U, arena.GetStats().used);
+  EXPECT_EQ(512U, arena.GetStats().high_water_mark);
+
+  void* frame2{arena.Allocate(512, 8)};
+  EXPECT_NE(frame1, frame2);
+  EXPECT_EQ(512U, arena.GetStats().used);
+
+  // Frame 1 memory is reused in frame 3.
+  frame_epoch.fetch_add(1);
+  EXPECT_EQ(frame1, arena.Allocate(512, 8));
+
+  // Both frames memory is free after 2 frames without allocations.
+  frame_epoch.fetch_add(2);
+  void* frame5{arena.Allocate(1024, 8)};
+  frame_epoch.fetch_add(1);
+  void* frame6{arena.Allocate(1024, 8)};
+  EXPECT_NE(frame5, frame6);
+  EXPECT_EQ(0U, arena.GetStats().overflow_count);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FrameArenaTest, BeginFrameWhileThreadsAllocate) {
+  using namespace wb::base::memory;
+
+  // Less than frame arena capacity even when all land in one frame.
+  std::thread thread{[]() {
+    for (int i{0}; i < 100'000; ++i) {
+      auto* value = static_cast<int*>(
+          GetThreadFrameArena().Allocate(sizeof(int), alignof(int)));
+      *value = i;
+    }
+  }};
+
+  // Frame thread only bumps frame epoch and reads stats.
+  for (int i{0}; i < 1000; ++i) {
+    BeginFrameOnThreadFrameArenas();
+    EXPECT_LE(GetThreadFrameArenasStats().used,
+              GetThreadFrameArenasStats().capacity);
+  }
+
+  thread.join();
+}
@@ -0,0 +1,350 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Periodic structured mimalloc heap statistics sampling.
+
+#include "heap_stats.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "base/deps/abseil/base/thread_annotations.h"
+#include "base/deps/abseil/synchronization/mutex.h"
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/marl/scheduler.h"
+#include "base/deps/mimalloc/mimalloc.h"
+#include "base/std2/filesystem_ext.h"
+#include "base/task_lanes.h"
+
+namespace {
+
+/**
+ * @brief Max tracked size classes.  Mimalloc has less bins, so only huge
+ * blocks of distinct sizes overflow.
+ */
+constexpr std::size_t kMaxSizeClassesCount{128};
+
+/**
+ * @brief Heap visit state.
+ */
+struct HeapVisitState {
+  /**
+   * @brief Size classes.  Capacity is reserved up front, as visited heap
+   * should not be changed by allocations.
+   */
+  std::vector<wb::base::memory::HeapSizeClassStats>& size_classes;
+  /**
+   * @brief Blocks which do not fit into tracked size classes.
+   */
+  wb::base::memory::HeapSizeClassStats huge_blocks;
+};
+
+/**
+ * @brief Accumulates heap area (page) stats.
+ * @param area Heap area.
+ * @param block Block.  nullptr as only areas are visited.
+ * @param arg Heap visit state.
+ * @return true to continue visit.
+ */
+bool VisitHeapArea(const mi_heap_t*, const mi_heap_area_t* area, void* block,
+                   std::size_t, void* arg) noexcept {
+  using wb::base::memory::HeapSizeClassStats;
+
+  if (block) return true;
+
+  auto& state = *static_cast<HeapVisitState*>(arg);
+  auto& size_classes = state.size_classes;
+
+  auto it = std::ranges::find(size_classes, area->block_size,
+                              &HeapSizeClassStats::block_size);
+  HeapSizeClassStats* stats{&state.huge_blocks};
+  if (it != size_classes.end()) {
+    stats = &*it;
+  } else if (size_classes.size() < size_classes.capacity()) {
+    stats = &size_classes.emplace_back(HeapSizeClassStats{
+        .block_size = area->block_size,
+        .pages_count = 0,
+        .reserved_bytes = 0,
+        .committed_bytes = 0,
+        .used_bytes = 0,
+        .used_blocks = 0});
+  }
+
+  ++stats->pages_count;
+  stats->reserved_bytes += area->reserved;
+  stats->committed_bytes += area->committed;
+  stats->used_bytes += area->used * area->block_size;
+  stats->used_blocks += area->used;
+  return true;
+}
+
+/**
+ * @brief Appends JSON field.
+ * @param json JSON.
+ * @param name Field name.
+ * @param value Field value.
+ */
+void AppendJsonField(std::string& json, std::string_view name,
+                     std::size_t value) {
+  // Field names are identifiers, so need no escaping.
+  json += '"';
+  json += name;
+  json += "\":";
+  json += std::to_string(value);
+}
+
+/**
+ * @brief Mutex to serialize sampling and sampler changes.
+ */
+ABSL_CONST_INIT absl::Mutex sampler_mutex{absl::kConstInit};
+
+/**
+ * @brief Sampler JSON file path or nullptr when no JSON file.
+ */
+const std::filesystem::path* sampler_json_path
+    ABSL_GUARDED_BY(sampler_mutex){nullptr};
+
+/**
+ * @brief Elapsed process time of the last logged sample.
+ */
+std::chrono::milliseconds last_sample_elapsed_time
+    ABSL_GUARDED_BY(sampler_mutex){0};
+
+/**
+ * @brief Sample interval ticks.  0 when sampling is disabled.
+ */
+std::atomic<std::chrono::steady_clock::rep> sample_interval_ticks{0};
+
+/**
+ * @brief Next sample time ticks.
+ */
+std::atomic<std::chrono::steady_clock::rep> next_sample_ticks{0};
+
+/**
+ * @brief Logs and writes heap statistics.
+ * @param stats Heap statistics.
+ */
+void LogAndWriteHeapStats(const wb::base::memory::HeapStats& stats) noexcept
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(sampler_mutex) {
+  using namespace wb::base;
+
+  last_sample_elapsed_time = stats.elapsed_time;
+  memory::LogHeapStats(stats);
+
+  if (sampler_json_path) {
+    const std::error_code rc{std2::filesystem::write_file_atomically(
+        *sampler_json_path, memory::FormatHeapStatsJson(stats))};
+    G3LOG_IF(WARNING, !!rc) << "Unable to write heap stats "
+                            << *sampler_json_path << ": " << rc.message();
+  }
+}
+
+/**
+ * @brief Logs and writes heap statistics if sampler still exists.
+ * @param stats Heap statistics.
+ */
+void LogAndWriteHeapStatsIfSampling(
+    const wb::base::memory::HeapStats& stats) noexcept {
+  // Exclusive, as concurrent samples write the same JSON file.
+  absl::MutexLock lock{&sampler_mutex};
+  // Sampler may be gone since sample, and it wrote the last one.
+  if (sample_interval_ticks.load(std::memory_order_relaxed) == 0) return;
+  // Newer sample is already written.
+  if (stats.elapsed_time < last_sample_elapsed_time) return;
+
+  LogAndWriteHeapStats(stats);
+}
+
+}  // namespace
+
+namespace wb::base::memory {
+
+[[nodiscard]] WB_BASE_API HeapStats SampleHeapStats() {
+  HeapStats stats{};
+
+  std::size_t elapsed_ms{0}, user_ms{0}, system_ms{0};
+  ::mi_process_info(&elapsed_ms, &user_ms, &system_ms,
+                    &stats.current_rss_bytes, &stats.peak_rss_bytes,
+                    &stats.current_commit_bytes, &stats.peak_commit_bytes,
+                    &stats.page_faults_count);
+  stats.elapsed_time =
+      std::chrono::milliseconds{static_cast<std::int64_t>(elapsed_ms)};
+  stats.user_time =
+      std::chrono::milliseconds{static_cast<std::int64_t>(user_ms)};
+  stats.system_time =
+      std::chrono::milliseconds{static_cast<std::int64_t>(system_ms)};
+
+  stats.size_classes.reserve(kMaxSizeClassesCount);
+
+  HeapVisitState state{.size_classes = stats.size_classes,
+                       .huge_blocks = {}};
+  // Heap of calling thread, ex. world simulation step one for sampler.  Visit
+  // pages only, visiting blocks is too slow for periodic sampling.
+  (void)::mi_heap_visit_blocks(::mi_heap_get_default(), false, VisitHeapArea,
+                               &state);
+
+  std::ranges::sort(stats.size_classes, {}, &HeapSizeClassStats::block_size);
+  if (state.huge_blocks.pages_count != 0) {
+    stats.size_classes.emplace_back(state.huge_blocks);
+  }
+
+  for (const auto& size_class : stats.size_classes) {
+    stats.reserved_bytes += size_class.reserved_bytes;
+    stats.committed_bytes += size_class.committed_bytes;
+    stats.used_bytes += size_class.used_bytes;
+    stats.pages_count += size_class.pages_count;
+  }
+
+  return stats;
+}
+
+WB_BASE_API void LogHeapStats(const HeapStats& stats) noexcept {
+  G3LOG(INFO) << "Heap stats: " << stats.current_commit_bytes
+              << " committed bytes (" << stats.peak_commit_bytes
+              << " peak), " << stats.current_rss_bytes << " RSS bytes ("
+              << stats.peak_rss_bytes << " peak), "
+              << stats.page_faults_count << " page faults.  Step thread heap: "
+              << stats.reserved_bytes << " reserved, "
+              << stats.committed_bytes << " committed, " << stats.used_bytes
+              << " used bytes in " << stats.pages_count << " pages, "
+              << stats.GetFragmentation() * 100.0 << "% fragmentation.";
+
+  for (const auto& size_class : stats.size_classes) {
+    G3LOG(G3LOG_DEBUG) << "  Size class " << size_class.block_size << ": "
+                       << size_class.used_blocks << " blocks, "
+                       << size_class.used_bytes << " used of "
+                       << size_class.committed_bytes << " committed bytes in "
+                       << size_class.pages_count << " pages.";
+  }
+}
+
+[[nodiscard]] WB_BASE_API std::string FormatHeapStatsJson(
+    const HeapStats& stats) {
+  std::string json{"{"};
+
+  AppendJsonField(json, "elapsed_ms",
+                  static_cast<std::size_t>(stats.elapsed_time.count()));
+  json += ',';
+  AppendJsonField(json, "user_ms",
+                  static_cast<std::size_t>(stats.user_time.count()));
+  json += ',';
+  AppendJsonField(json, "system_ms",
+                  static_cast<std::size_t>(stats.system_time.count()));
+  json += ',';
+  AppendJsonField(json, "current_rss_bytes", stats.current_rss_bytes);
+  json += ',';
+  AppendJsonField(json, "peak_rss_bytes", stats.peak_rss_bytes);
+  json += ',';
+  AppendJsonField(json, "current_commit_bytes", stats.current_commit_bytes);
+  json += ',';
+  AppendJsonField(json, "peak_commit_bytes", stats.peak_commit_bytes);
+  json += ',';
+  AppendJsonField(json, "page_faults_count", stats.page_faults_count);
+  json += ",\"step_thread_heap\":{";
+  AppendJsonField(json, "reserved_bytes", stats.reserved_bytes);
+  json += ',';
+  AppendJsonField(json, "committed_bytes", stats.committed_bytes);
+  json += ',';
+  AppendJsonField(json, "used_bytes", stats.used_bytes);
+  json += ',';
+  AppendJsonField(json, "pages_count", stats.pages_count);
+  json += ",\"size_classes\":[";
+
+  for (std::size_t i{0}; i < stats.size_classes.size(); ++i) {
+    const HeapSizeClassStats& size_class{stats.size_classes[i]};
+
+    if (i != 0) json += ',';
+
+    json += '{';
+    AppendJsonField(json, "block_size", size_class.block_size);
+    json += ',';
+    AppendJsonField(json, "pages_count", size_class.pages_count);
+    json += ',';
+    AppendJsonField(json, "reserved_bytes", size_class.reserved_bytes);
+    json += ',';
+    AppendJsonField(json, "committed_bytes", size_class.committed_bytes);
+    json += ',';
+    AppendJsonField(json, "used_bytes", size_class.used_bytes);
+    json += ',';
+    AppendJsonField(json, "used_blocks", size_class.used_blocks);
+    json += '}';
+  }
+
+  json += "]}}\n";
+  return json;
+}
+
+ScopedHeapStatsSampler::ScopedHeapStatsSampler(
+    std::chrono::milliseconds interval,
+    std::filesystem::path json_path) noexcept
+    : json_path_{std::move(json_path)} {
+  absl::MutexLock lock{&sampler_mutex};
+
+  G3CHECK(sample_interval_ticks.load(std::memory_order_relaxed) == 0)
+      << "Only one heap stats sampler can exist at a time.";
+
+  if (interval.count() == 0) return;
+
+  sampler_json_path = !json_path_.empty() ? &json_path_ : nullptr;
+  last_sample_elapsed_time = std::chrono::milliseconds{0};
+
+  const auto interval_ticks =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval)
+          .count();
+  next_sample_ticks.store(
+      std::chrono::steady_clock::now().time_since_epoch().count() +
+          interval_ticks,
+      std::memory_order_relaxed);
+  sample_interval_ticks.store(interval_ticks, std::memory_order_relaxed);
+}
+
+ScopedHeapStatsSampler::~ScopedHeapStatsSampler() noexcept {
+  absl::MutexLock lock{&sampler_mutex};
+
+  if (sample_interval_ticks.exchange(0, std::memory_order_relaxed) != 0) {
+    LogAndWriteHeapStats(SampleHeapStats());
+  }
+
+  sampler_json_path = nullptr;
+}
+
+WB_BASE_API bool SampleHeapStatsIfDue() noexcept {
+  const auto interval_ticks =
+      sample_interval_ticks.load(std::memory_order_relaxed);
+  if (interval_ticks == 0) [[likely]] {
+    return false;
+  }
+
+  const auto now_ticks =
+      std::chrono::steady_clock::now().time_since_epoch().count();
+  auto next_ticks = next_sample_ticks.load(std::memory_order_relaxed);
+  if (now_ticks < next_ticks) [[likely]] {
+    return false;
+  }
+
+  // Only one caller samples when several ones are late.
+  if (!next_sample_ticks.compare_exchange_strong(
+          next_ticks, now_ticks + interval_ticks, std::memory_order_relaxed)) {
+    return false;
+  }
+
+  // Only calling thread can visit its heap, so snapshot here.  Snapshot visits
+  // pages only, so it is cheap enough for frame thread.
+  HeapStats stats{SampleHeapStats()};
+
+  if (!::marl::Scheduler::get()) {
+    LogAndWriteHeapStatsIfSampling(stats);
+    return true;
+  }
+
+  // Formatting and file write take long, so do not stall caller, ex. frame
+  // thread.
+  ScheduleTask(TaskPriority::kBackground,
+               [sample = std::move(stats)]() noexcept {
+                 LogAndWriteHeapStatsIfSampling(sample);
+               });
+  return true;
+}
+
+}  // namespace wb::base::memory
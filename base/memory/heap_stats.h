@@ -0,0 +1,195 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Periodic structured mimalloc heap statistics sampling.
+
+#ifndef WB_BASE_MEMORY_HEAP_STATS_H_
+#define WB_BASE_MEMORY_HEAP_STATS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "base/config.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::memory {
+
+/**
+ * @brief Heap usage by blocks of the same size (size class).
+ */
+struct HeapSizeClassStats {
+  /**
+   * @brief Block size.  0 for huge blocks which do not fit into tracked size
+   * classes.
+   */
+  std::size_t block_size;
+  /**
+   * @brief Heap pages count.
+   */
+  std::size_t pages_count;
+  /**
+   * @brief Bytes reserved by pages.
+   */
+  std::size_t reserved_bytes;
+  /**
+   * @brief Bytes committed by pages.
+   */
+  std::size_t committed_bytes;
+  /**
+   * @brief Bytes in allocated blocks.
+   */
+  std::size_t used_bytes;
+  /**
+   * @brief Allocated blocks count.
+   */
+  std::size_t used_blocks;
+};
+
+/**
+ * @brief Heap statistics sample.
+ */
+struct HeapStats {
+  /**
+   * @brief Process elapsed time.
+   */
+  std::chrono::milliseconds elapsed_time;
+  /**
+   * @brief Process user time.
+   */
+  std::chrono::milliseconds user_time;
+  /**
+   * @brief Process system time.
+   */
+  std::chrono::milliseconds system_time;
+  /**
+   * @brief Process resident set size (working set on Windows).
+   */
+  std::size_t current_rss_bytes;
+  /**
+   * @brief Process peak resident set size.
+   */
+  std::size_t peak_rss_bytes;
+  /**
+   * @brief Process committed memory.
+   */
+  std::size_t current_commit_bytes;
+  /**
+   * @brief Process peak committed memory.
+   */
+  std::size_t peak_commit_bytes;
+  /**
+   * @brief Process hard page faults count.
+   */
+  std::size_t page_faults_count;
+  /**
+   * @brief Bytes reserved by sampling thread heap.  Sampler samples world
+   * simulation step thread heap.
+   */
+  std::size_t reserved_bytes;
+  /**
+   * @brief Bytes committed by sampling thread heap.
+   */
+  std::size_t committed_bytes;
+  /**
+   * @brief Bytes in allocated blocks of sampling thread heap.
+   */
+  std::size_t used_bytes;
+  /**
+   * @brief Sampling thread heap pages count.
+   */
+  std::size_t pages_count;
+  /**
+   * @brief Sampling thread heap usage by size class, sorted by block size.
+   * Huge blocks are last.
+   */
+  std::vector<HeapSizeClassStats> size_classes;
+
+  /**
+   * @brief Share of committed bytes not used by allocated blocks, [0, 1].
+   */
+  [[nodiscard]] double GetFragmentation() const noexcept {
+    return committed_bytes != 0
+               ? 1.0 - static_cast<double>(used_bytes) /
+                           static_cast<double>(committed_bytes)
+               : 0.0;
+  }
+};
+
+/**
+ * @brief Samples process memory and heap of the calling thread.  Heaps are
+ * owned by threads and can't be visited by others, so call on thread which
+ * allocates most, ex. main one.
+ * @return Heap statistics.
+ */
+[[nodiscard]] WB_BASE_API HeapStats SampleHeapStats();
+
+/**
+ * @brief Logs heap statistics.  Size classes are logged at debug level.
+ * @param stats Heap statistics.
+ */
+WB_BASE_API void LogHeapStats(const HeapStats& stats) noexcept;
+
+/**
+ * @brief Formats heap statistics as JSON.
+ * @param stats Heap statistics.
+ * @return JSON.
+ */
+[[nodiscard]] WB_BASE_API std::string FormatHeapStatsJson(
+    const HeapStats& stats);
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Enables periodic heap statistics sampling in scope.  Samples are
+   * taken by SampleHeapStatsIfDue on the thread which calls it, logged and
+   * written to JSON file.  Last sample is taken on the thread which destroys
+   * sampler, so it should be the step one, too.  Only one sampler can exist at
+   * a time.
+   */
+  class WB_BASE_API ScopedHeapStatsSampler {
+   public:
+    /**
+     * @brief Enables sampling.  Nothing is sampled when |interval| is 0.
+     * @param interval Sample interval.
+     * @param json_path JSON file path.  Rewritten on each sample.  Empty
+     * means no JSON file.
+     */
+    ScopedHeapStatsSampler(std::chrono::milliseconds interval,
+                           std::filesystem::path json_path) noexcept;
+
+    /**
+     * @brief Samples last time and disables sampling.
+     */
+    ~ScopedHeapStatsSampler() noexcept;
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ScopedHeapStatsSampler);
+
+   private:
+    /**
+     * @brief JSON file path.
+     */
+    const std::filesystem::path json_path_;
+  };
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+/**
+ * @brief Samples heap statistics of the calling thread, ex. world simulation
+ * step one, when sample interval is elapsed.  Cheap when sample is not due, so
+ * can be called once per frame.  Statistics are logged and written on
+ * background lane when marl scheduler is bound, inline otherwise.
+ * @return true if sampled.
+ */
+WB_BASE_API bool SampleHeapStatsIfDue() noexcept;
+
+}  // namespace wb::base::memory
+
+#endif  // !WB_BASE_MEMORY_HEAP_STATS_H_
@@ -0,0 +1,155 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Periodic structured mimalloc heap statistics sampling.
+
+#include "heap_stats.h"
+//
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/deps/marl/scheduler.h"
+#include "base/deps/mimalloc/mimalloc.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(HeapStatsTest, SampleHeapStats) {
+  using namespace wb::base::memory;
+
+  std::vector<void*> blocks(100);
+  for (auto& block : blocks) {
+    block = ::mi_malloc(48);
+  }
+
+  const HeapStats stats{SampleHeapStats()};
+
+  EXPECT_GT(stats.current_commit_bytes, 0U);
+  EXPECT_GE(stats.peak_commit_bytes, stats.current_commit_bytes);
+  EXPECT_GT(stats.current_rss_bytes, 0U);
+  EXPECT_GT(stats.pages_count, 0U);
+  EXPECT_LE(stats.committed_bytes, stats.reserved_bytes);
+  EXPECT_LE(stats.used_bytes, stats.committed_bytes);
+  EXPECT_GE(stats.GetFragmentation(), 0.0);
+  EXPECT_LE(stats.GetFragmentation(), 1.0);
+
+  const auto size_class = std::ranges::find(stats.size_classes, 48U,
+                                            &HeapSizeClassStats::block_size);
+  ASSERT_NE(stats.size_classes.end(), size_class);
+  EXPECT_GT(size_class->used_blocks, 0U);
+  EXPECT_EQ(size_class->used_blocks * 48U, size_class->used_bytes);
+
+  for (void* block : blocks) {
+    ::mi_free(block);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(HeapStatsTest, FormatHeapStatsJson) {
+  using namespace std::chrono_literals;
+  using namespace wb::base::memory;
+
+  HeapStats stats{.elapsed_time = 3ms,
+                  .user_time = 2ms,
+                  .system_time = 1ms,
+                  .current_rss_bytes = 10,
+                  .peak_rss_bytes = 11,
+                  .current_commit_bytes = 12,
+                  .peak_commit_bytes = 13,
+                  .page_faults_count = 4,
+                  .reserved_bytes = 64,
+                  .committed_bytes = 32,
+                  .used_bytes = 16,
+                  .pages_count = 1,
+                  .size_classes = {}};
+  stats.size_classes.emplace_back(
+      HeapSizeClassStats{.block_size = 8,
+                         .pages_count = 1,
+                         .reserved_bytes = 64,
+                         .committed_bytes = 32,
+                         .used_bytes = 16,
+                         .used_blocks = 2});
+
+  EXPECT_DOUBLE_EQ(0.5, stats.GetFragmentation());
+  EXPECT_EQ(
+      "{\"elapsed_ms\":3,\"user_ms\":2,\"system_ms\":1,"
+      "\"current_rss_bytes\":10,\"peak_rss_bytes\":11,"
+      "\"current_commit_bytes\":12,\"peak_commit_bytes\":13,"
+      "\"page_faults_count\":4,\"step_thread_heap\":{\"reserved_bytes\":64,"
+      "\"committed_bytes\":32,\"used_bytes\":16,\"pages_count\":1,"
+      "\"size_classes\":[{\"block_size\":8,\"pages_count\":1,"
+      "\"reserved_bytes\":64,\"committed_bytes\":32,\"used_bytes\":16,"
+      "\"used_blocks\":2}]}}\n",
+      FormatHeapStatsJson(stats));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(HeapStatsTest, ScopedHeapStatsSampler) {
+  using namespace std::chrono_literals;
+  using namespace wb::base::memory;
+
+  const std::filesystem::path path{std::filesystem::temp_directory_path() /
+                                   "wb_heap_stats_tests.json"};
+  std::error_code rc;
+  std::filesystem::remove(path, rc);
+
+  EXPECT_FALSE(SampleHeapStatsIfDue());
+
+  {
+    const ScopedHeapStatsSampler sampler{0ms, path};
+    std::this_thread::sleep_for(2ms);
+    EXPECT_FALSE(SampleHeapStatsIfDue());
+  }
+  EXPECT_FALSE(std::filesystem::exists(path));
+
+  {
+    const ScopedHeapStatsSampler sampler{1h, path};
+    EXPECT_FALSE(SampleHeapStatsIfDue());
+  }
+  // Sampled last time on out of scope.
+  EXPECT_TRUE(std::filesystem::exists(path));
+  std::filesystem::remove(path, rc);
+
+  {
+    const ScopedHeapStatsSampler sampler{1ms, path};
+    std::this_thread::sleep_for(2ms);
+    EXPECT_TRUE(SampleHeapStatsIfDue());
+    EXPECT_TRUE(std::filesystem::exists(path));
+  }
+
+  EXPECT_FALSE(SampleHeapStatsIfDue());
+  std::filesystem::remove(path, rc);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(HeapStatsTest, SampleHeapStatsIfDueOnBackgroundLane) {
+  using namespace wb::base::memory;
+  using namespace std::chrono_literals;
+
+  marl::Scheduler scheduler{marl::Scheduler::Config{}.setWorkerThreadCount(2)};
+  scheduler.bind();
+
+  const std::filesystem::path path{std::filesystem::temp_directory_path() /
+                                   "wb_heap_stats_background_tests.json"};
+  std::error_code rc;
+  std::filesystem::remove(path, rc);
+
+  {
+    const ScopedHeapStatsSampler sampler{1ms, path};
+    std::this_thread::sleep_for(2ms);
+    EXPECT_TRUE(SampleHeapStatsIfDue());
+
+    // Written by background task.
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (!std::filesystem::exists(path) &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_TRUE(std::filesystem::exists(path));
+  }
+
+  scheduler.unbind();
+  std::filesystem::remove(path, rc);
+}
@@ -0,0 +1,301 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Large pages backed mimalloc arena for hot data.
+
+#include "large_pages_arena.h"
+
+#include <atomic>
+
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/mimalloc/mimalloc.h"
+#include "base/internals/large_pages_arena_internal.h"
+#include "base/std2/system_error_ext.h"
+#include "build/build_config.h"
+
+#ifdef WB_OS_LINUX
+#include <linux/mman.h>  // MAP_HUGE_2MB
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#endif
+
+namespace {
+
+/**
+ * @brief Pages which back arena.  Published after arena id is set.
+ */
+std::atomic<wb::base::memory::LargePagesKind> arena_kind{
+    wb::base::memory::LargePagesKind::kNone};
+
+/**
+ * @brief Arena size.
+ */
+std::atomic_size_t arena_bytes{0};
+
+/**
+ * @brief Arena id.  Valid when arena_kind is not kNone.
+ */
+mi_arena_id_t arena_id{};
+
+#ifdef WB_OS_LINUX
+/**
+ * @brief Mimalloc arenas consist of 32 MiB blocks and segment is found by
+ * masking pointer, so arena should be aligned to block size.
+ */
+constexpr std::size_t kArenaBlockBytes{32U << 20U};
+
+/**
+ * @brief Maps memory aligned to mimalloc arena block.
+ * @param bytes Bytes count.  Multiple of arena block size.
+ * @param flags Extra mmap flags.
+ * @return Memory or nullptr.
+ */
+[[nodiscard]] void* MapArenaAligned(std::size_t bytes, int flags) noexcept {
+  // Over reserve address space only to be able to align, huge pages are 2 MiB
+  // aligned only.  Explicit huge pages are taken from pool on map, so mapping
+  // them with slack would need one more arena block in pool.
+  const std::size_t reserved_bytes{bytes + kArenaBlockBytes};
+  void* memory{::mmap(nullptr, reserved_bytes, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0)};
+  if (memory == MAP_FAILED) return nullptr;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto address = reinterpret_cast<std::uintptr_t>(memory);
+  const std::uintptr_t aligned_address{(address + kArenaBlockBytes - 1) &
+                                       ~(kArenaBlockBytes - 1)};
+  const std::size_t prefix_bytes{aligned_address - address};
+  const std::size_t suffix_bytes{kArenaBlockBytes - prefix_bytes};
+
+  auto* aligned = static_cast<std::byte*>(memory) + prefix_bytes;
+  if (prefix_bytes != 0) ::munmap(memory, prefix_bytes);
+  if (suffix_bytes != 0) ::munmap(aligned + bytes, suffix_bytes);
+
+  // Replace reservation by exactly |bytes| of real memory.
+  void* mapped{::mmap(aligned, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | flags, -1, 0)};
+  if (mapped == MAP_FAILED) {
+    // Keep mmap error for caller.
+    const int error{errno};
+    ::munmap(aligned, bytes);
+    errno = error;
+    return nullptr;
+  }
+
+  return mapped;
+}
+
+/**
+ * @brief Are transparent huge pages enabled for madvise(MADV_HUGEPAGE)?
+ * @return true if enabled.
+ */
+[[nodiscard]] bool AreTransparentHugePagesEnabled() noexcept {
+  std::ifstream file{"/sys/kernel/mm/transparent_hugepage/enabled"};
+  std::string mode;
+  std::getline(file, mode);
+
+  // Ex. always [madvise] never
+  return !mode.empty() && mode.find("[never]") == std::string::npos;
+}
+
+/**
+ * @brief Opens user space dTLB counter for current thread and threads it
+ * creates.
+ * @param result Cache result to count.
+ * @return Counter descriptor or -1.
+ */
+[[nodiscard]] int OpenDtlbCounter(std::uint64_t result) noexcept {
+  perf_event_attr attributes{};
+  attributes.size = sizeof(attributes);
+  attributes.type = PERF_TYPE_HW_CACHE;
+  attributes.config = PERF_COUNT_HW_CACHE_DTLB |
+                      (PERF_COUNT_HW_CACHE_OP_READ << 8U) | (result << 16U);
+  attributes.inherit = 1;
+  // Not allowed to count kernel when perf_event_paranoid >= 2.
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+
+  return static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1,
+                                    -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+/**
+ * @brief Reads counter.
+ * @param fd Counter descriptor.
+ * @return Counter value.
+ */
+[[nodiscard]] std::uint64_t ReadCounter(int fd) noexcept {
+  std::uint64_t value{0};
+  if (fd == -1 || ::read(fd, &value, sizeof(value)) != sizeof(value)) {
+    return 0;
+  }
+  return value;
+}
+#endif  // WB_OS_LINUX
+
+}  // namespace
+
+namespace wb::base::internals {
+
+[[nodiscard]] mi_heap_t* NewLargePagesArenaHeap() noexcept {
+  return arena_kind.load(std::memory_order_acquire) !=
+                 memory::LargePagesKind::kNone
+             ? ::mi_heap_new_in_arena(arena_id)
+             : nullptr;
+}
+
+}  // namespace wb::base::internals
+
+namespace wb::base::memory {
+
+[[nodiscard]] WB_BASE_API std::string_view GetLargePagesKindName(
+    LargePagesKind kind) noexcept {
+  switch (kind) {
+    case LargePagesKind::kNone:
+      return "none";
+    case LargePagesKind::kRegular:
+      return "regular";
+    case LargePagesKind::kTransparentHuge:
+      return "transparent huge";
+    case LargePagesKind::kExplicitHuge:
+      return "explicit huge";
+    default:
+      G3DCHECK(false) << "Unknown large pages kind " << underlying_cast(kind)
+                      << ".";
+      return "unknown";
+  }
+}
+
+WB_BASE_API LargePagesArenaInfo
+ReserveLargePagesArena(std::size_t bytes) noexcept {
+  G3CHECK(arena_kind.load(std::memory_order_acquire) == LargePagesKind::kNone)
+      << "Large pages arena is already reserved.";
+
+  if (bytes == 0) return GetLargePagesArenaInfo();
+
+#ifdef WB_OS_LINUX
+  bytes = (bytes + kArenaBlockBytes - 1) & ~(kArenaBlockBytes - 1);
+
+  LargePagesKind kind{LargePagesKind::kExplicitHuge};
+  // Explicit huge pages are reserved from pool on map, so map fails when pool
+  // is too small instead of SIGBUS on first touch.
+  void* memory{MapArenaAligned(bytes, MAP_HUGETLB | MAP_HUGE_2MB)};
+  if (!memory) {
+    G3PLOG_E(INFO, std2::posix_last_error_code())
+        << "Explicit 2 MiB pages are not available for " << bytes
+        << " bytes arena (see /proc/sys/vm/nr_hugepages), fall back to "
+           "transparent huge pages.";
+
+    memory = MapArenaAligned(bytes, 0);
+    if (memory) {
+      kind = AreTransparentHugePagesEnabled() &&
+                     ::madvise(memory, bytes, MADV_HUGEPAGE) == 0
+                 ? LargePagesKind::kTransparentHuge
+                 : LargePagesKind::kRegular;
+    }
+  }
+
+  if (!memory) {
+    G3PLOG_E(WARNING, std2::posix_last_error_code())
+        << "Unable to map " << bytes << " bytes for large pages arena.";
+    return GetLargePagesArenaInfo();
+  }
+
+  const bool is_large{kind == LargePagesKind::kExplicitHuge};
+  // Exclusive, so only hot data heaps allocate in arena.
+  if (!::mi_manage_os_memory_ex(memory, bytes, true, is_large, true, -1, true,
+                                &arena_id)) {
+    G3LOG(WARNING) << "Unable to manage " << bytes
+                   << " bytes large pages arena by mimalloc.";
+    ::munmap(memory, bytes);
+    return GetLargePagesArenaInfo();
+  }
+
+  arena_bytes.store(bytes, std::memory_order_relaxed);
+  arena_kind.store(kind, std::memory_order_release);
+
+  G3LOG_IF(WARNING, kind == LargePagesKind::kRegular)
+      << "Transparent huge pages are disabled (see "
+         "/sys/kernel/mm/transparent_hugepage/enabled), large pages arena "
+         "falls back to regular pages.";
+  G3LOG(INFO) << "Reserved " << bytes << " bytes large pages arena backed by "
+              << GetLargePagesKindName(kind) << " pages.";
+#else
+  G3LOG(INFO) << "Large pages arena is supported on Linux only, skip "
+              << bytes << " bytes arena.";
+#endif  // WB_OS_LINUX
+
+  return GetLargePagesArenaInfo();
+}
+
+[[nodiscard]] WB_BASE_API LargePagesArenaInfo
+GetLargePagesArenaInfo() noexcept {
+  const LargePagesKind kind{arena_kind.load(std::memory_order_acquire)};
+  return {.bytes = arena_bytes.load(std::memory_order_relaxed),
+          .kind = kind,
+          .pad_ = {}};
+}
+
+[[nodiscard]] WB_BASE_API void* AllocateInLargePagesArena(
+    std::size_t bytes, std::size_t alignment) noexcept {
+  mi_heap_t* heap{internals::NewLargePagesArenaHeap()};
+  if (heap) {
+    void* memory{::mi_heap_malloc_aligned(heap, bytes, alignment)};
+    // Live blocks migrate to thread default heap, but stay in arena pages.
+    ::mi_heap_delete(heap);
+
+    if (memory) return memory;
+  }
+
+  // Arena is full or absent.
+  return ::mi_malloc_aligned(bytes, alignment);
+}
+
+ScopedDtlbCounters::ScopedDtlbCounters() noexcept
+    : loads_fd_{-1}, load_misses_fd_{-1} {
+#ifdef WB_OS_LINUX
+  loads_fd_ = OpenDtlbCounter(PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+  load_misses_fd_ = OpenDtlbCounter(PERF_COUNT_HW_CACHE_RESULT_MISS);
+
+  if (!IsCounting()) {
+    G3PLOG_E(INFO, std2::posix_last_error_code())
+        << "dTLB counters are not available (see "
+           "/proc/sys/kernel/perf_event_paranoid).";
+  }
+#endif  // WB_OS_LINUX
+}
+
+ScopedDtlbCounters::~ScopedDtlbCounters() noexcept {
+  if (IsCounting()) {
+    const DtlbStats stats{GetStats()};
+
+    G3LOG(INFO) << "dTLB: " << stats.load_misses << " load misses of "
+                << stats.loads << " loads (" << stats.GetMissRate() * 100.0
+                << "%), large pages arena backed by "
+                << GetLargePagesKindName(GetLargePagesArenaInfo().kind)
+                << " pages.";
+  }
+
+#ifdef WB_OS_LINUX
+  if (loads_fd_ != -1) ::close(loads_fd_);
+  if (load_misses_fd_ != -1) ::close(load_misses_fd_);
+#endif  // WB_OS_LINUX
+}
+
+[[nodiscard]] DtlbStats ScopedDtlbCounters::GetStats() const noexcept {
+#ifdef WB_OS_LINUX
+  return {.loads = ReadCounter(loads_fd_),
+          .load_misses = ReadCounter(load_misses_fd_)};
+#else
+  return {.loads = 0, .load_misses = 0};
+#endif  // WB_OS_LINUX
+}
+
+}  // namespace wb::base::memory
@@ -0,0 +1,164 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Large pages backed mimalloc arena for hot data.
+
+#ifndef WB_BASE_MEMORY_LARGE_PAGES_ARENA_H_
+#define WB_BASE_MEMORY_LARGE_PAGES_ARENA_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "base/config.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::memory {
+
+/**
+ * @brief Pages which back large pages arena.
+ */
+enum class LargePagesKind : std::uint8_t {
+  /**
+   * @brief No arena.
+   */
+  kNone,
+  /**
+   * @brief Regular OS pages, large pages are not available.
+   */
+  kRegular,
+  /**
+   * @brief Transparent huge pages, kernel backs arena by 2 MiB pages when it
+   * can.
+   */
+  kTransparentHuge,
+  /**
+   * @brief Explicit (hugetlbfs) 2 MiB pages.
+   */
+  kExplicitHuge,
+};
+
+/**
+ * @brief Gets large pages kind name.
+ * @param kind Large pages kind.
+ * @return Large pages kind name.
+ */
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_CONST std::string_view
+GetLargePagesKindName(LargePagesKind kind) noexcept;
+
+/**
+ * @brief Large pages arena info.
+ */
+struct LargePagesArenaInfo {
+  /**
+   * @brief Arena size.
+   */
+  std::size_t bytes;
+  /**
+   * @brief Pages which back arena.
+   */
+  LargePagesKind kind;
+
+  WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 7> pad_;
+};
+
+/**
+ * @brief Reserves large pages backed arena for hot data (world heap, frame
+ * arenas).  Tries explicit 2 MiB pages first, then transparent huge ones,
+ * then falls back to regular pages.  Linux only, no arena on other OSes.
+ * Should be called once, before hot data allocations.
+ * @param bytes Arena size.  Rounded up to mimalloc arena block size.
+ * @return Reserved arena info.
+ */
+WB_BASE_API LargePagesArenaInfo
+ReserveLargePagesArena(std::size_t bytes) noexcept;
+
+/**
+ * @brief Gets large pages arena info.
+ * @return Large pages arena info.
+ */
+[[nodiscard]] WB_BASE_API LargePagesArenaInfo
+GetLargePagesArenaInfo() noexcept;
+
+/**
+ * @brief Allocates memory in large pages arena when it has room, in regular
+ * memory otherwise.  Free by mi_free on any thread.
+ * @param bytes Bytes count.
+ * @param alignment Alignment.
+ * @return Memory or nullptr.
+ */
+[[nodiscard]] WB_BASE_API void* AllocateInLargePagesArena(
+    std::size_t bytes, std::size_t alignment) noexcept;
+
+/**
+ * @brief dTLB loads / misses.
+ */
+struct DtlbStats {
+  /**
+   * @brief dTLB loads count.
+   */
+  std::uint64_t loads;
+  /**
+   * @brief dTLB load misses count.
+   */
+  std::uint64_t load_misses;
+
+  /**
+   * @brief Share of loads which missed dTLB, [0, 1].
+   */
+  [[nodiscard]] double GetMissRate() const noexcept {
+    return loads != 0 ? static_cast<double>(load_misses) /
+                            static_cast<double>(loads)
+                      : 0.0;
+  }
+};
+
+/**
+ * @brief Counts user space dTLB loads / misses of current thread and threads
+ * it creates in scope (via perf_event_open on Linux), and logs them out of
+ * scope.  Measures large pages arena impact.  Counts nothing when hardware
+ * counters are not available.
+ */
+class WB_BASE_API ScopedDtlbCounters {
+ public:
+  /**
+   * @brief Starts counting.
+   */
+  ScopedDtlbCounters() noexcept;
+
+  /**
+   * @brief Stops counting and logs counts.
+   */
+  ~ScopedDtlbCounters() noexcept;
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ScopedDtlbCounters);
+
+  /**
+   * @brief Is counting?
+   */
+  [[nodiscard]] bool IsCounting() const noexcept {
+    return loads_fd_ != -1 && load_misses_fd_ != -1;
+  }
+
+  /**
+   * @brief Gets current counts.
+   */
+  [[nodiscard]] DtlbStats GetStats() const noexcept;
+
+ private:
+  /**
+   * @brief dTLB loads counter descriptor or -1.
+   */
+  int loads_fd_;
+  /**
+   * @brief dTLB load misses counter descriptor or -1.
+   */
+  int load_misses_fd_;
+};
+
+}  // namespace wb::base::memory
+
+#endif  // !WB_BASE_MEMORY_LARGE_PAGES_ARENA_H_
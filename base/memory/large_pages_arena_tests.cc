@@ -0,0 +1,139 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Large pages backed mimalloc arena for hot data.
+
+#include "large_pages_arena.h"
+//
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/deps/mimalloc/mimalloc.h"
+#include "base/tests/g3log_death_utils.h"
+#include "build/build_config.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LargePagesArenaTest, GetLargePagesKindName) {
+  using namespace wb::base::memory;
+
+  EXPECT_EQ("none", GetLargePagesKindName(LargePagesKind::kNone));
+  EXPECT_EQ("regular", GetLargePagesKindName(LargePagesKind::kRegular));
+  EXPECT_EQ("transparent huge",
+            GetLargePagesKindName(LargePagesKind::kTransparentHuge));
+  EXPECT_EQ("explicit huge",
+            GetLargePagesKindName(LargePagesKind::kExplicitHuge));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LargePagesArenaTest, ReserveNothing) {
+  using namespace wb::base::memory;
+
+  const LargePagesArenaInfo info{ReserveLargePagesArena(0)};
+  EXPECT_EQ(0U, info.bytes);
+  EXPECT_EQ(LargePagesKind::kNone, info.kind);
+
+  EXPECT_EQ(0U, GetLargePagesArenaInfo().bytes);
+  EXPECT_EQ(LargePagesKind::kNone, GetLargePagesArenaInfo().kind);
+
+  // No arena, so regular memory.
+  void* block{AllocateInLargePagesArena(1024, 64)};
+  ASSERT_NE(nullptr, block);
+  ::mi_free(block);
+}
+
+#ifdef GTEST_HAS_DEATH_TEST
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LargePagesArenaDeathTest, ReserveLargePagesArena) {
+  using namespace wb::base::memory;
+
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+
+  // Arena is process-wide and can't be released, so it is reserved in death
+  // test child process and does not leak into other tests.
+  const auto reserveArena = []() {
+    const LargePagesArenaInfo info{ReserveLargePagesArena(1)};
+
+#ifdef WB_OS_LINUX
+    // Rounded up to arena block.
+    if (info.bytes != 32U << 20U || info.kind == LargePagesKind::kNone) {
+      std::exit(1);
+    }
+#else
+    if (info.bytes != 0 || info.kind != LargePagesKind::kNone) std::exit(1);
+#endif
+
+    if (info.bytes != GetLargePagesArenaInfo().bytes ||
+        info.kind != GetLargePagesArenaInfo().kind) {
+      std::exit(2);
+    }
+
+    // Arena overflows to regular memory.
+    std::vector<void*> blocks;
+    for (int i{0}; i < 5; ++i) {
+      void* block{AllocateInLargePagesArena(16U << 20U, 64)};
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      if (!block || reinterpret_cast<std::uintptr_t>(block) % 64U != 0) {
+        std::exit(3);
+      }
+
+      std::memset(block, i, 16U << 20U);
+      blocks.emplace_back(block);
+    }
+
+    for (void* block : blocks) {
+      ::mi_free(block);
+    }
+
+    std::exit(0);
+  };
+
+  EXPECT_EXIT(reserveArena(), ::testing::ExitedWithCode(0), "");
+}
+
+#ifdef WB_OS_LINUX
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LargePagesArenaDeathTest, ReserveLargePagesArenaTwice) {
+  using namespace wb::base;
+  using namespace wb::base::memory;
+
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+
+  const auto reserveArenaTwice = []() {
+    (void)ReserveLargePagesArena(1);
+    (void)ReserveLargePagesArena(1);
+  };
+
+  const auto test_result = tests_internal::MakeG3LogCheckFailureDeathTestResult(
+      "Large pages arena is already reserved.");
+
+  EXPECT_EXIT(reserveArenaTwice(), test_result.exit_predicate,
+              test_result.message);
+}
+#endif  // WB_OS_LINUX
+#endif  // GTEST_HAS_DEATH_TEST
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LargePagesArenaTest, ScopedDtlbCounters) {
+  using namespace wb::base::memory;
+
+  const ScopedDtlbCounters counters;
+
+  std::vector<int> values(1U << 20U);
+  for (std::size_t i{0}; i < values.size(); i += 1024) {
+    values[i] = static_cast<int>(i);
+  }
+
+  const DtlbStats stats{counters.GetStats()};
+  if (counters.IsCounting()) {
+    // Some CPUs have no dTLB loads counter.
+    EXPECT_GE(stats.GetMissRate(), 0.0);
+  } else {
+    EXPECT_EQ(0U, stats.loads);
+    EXPECT_EQ(0U, stats.load_misses);
+    EXPECT_DOUBLE_EQ(0.0, stats.GetMissRate());
+  }
+}
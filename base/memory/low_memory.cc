@@ -0,0 +1,244 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Low memory recovery: emergency memory reserve and low memory callbacks.
+
+#include "low_memory.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/deps/abseil/base/thread_annotations.h"
+#include "base/deps/abseil/synchronization/mutex.h"
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/marl/scheduler.h"
+#include "base/deps/mimalloc/mimalloc.h"
+#include "base/task_lanes.h"
+
+namespace {
+
+/**
+ * @brief Mutex to serialize concurrent accesses to emergency reserve.
+ */
+ABSL_CONST_INIT absl::Mutex reserve_mutex{absl::kConstInit};
+
+/**
+ * @brief Emergency reserve or nullptr when not reserved / released.
+ */
+void* reserve ABSL_GUARDED_BY(reserve_mutex){nullptr};
+
+/**
+ * @brief Emergency reserve size.  0 when no reserve.
+ */
+std::size_t reserve_bytes ABSL_GUARDED_BY(reserve_mutex){0};
+
+/**
+ * @brief Is emergency reserve released and can be restored?  Lets restore be
+ * lock-free when nothing to restore.
+ */
+std::atomic_bool is_reserve_released{false};
+
+/**
+ * @brief Is emergency reserve restore scheduled on background lane?  Lets
+ * schedule only one restore at a time.
+ */
+std::atomic_bool is_reserve_restoring{false};
+
+/**
+ * @brief Mutex to serialize concurrent accesses to low memory callbacks.
+ */
+ABSL_CONST_INIT absl::Mutex callbacks_mutex{absl::kConstInit};
+
+/**
+ * @brief Low memory callbacks by id.
+ */
+using LowMemoryCallbacks =
+    std::vector<std::pair<std::uint64_t, wb::base::memory::LowMemoryCallback>>;
+
+/**
+ * @brief Low memory callbacks snapshot.  Replaced on add / remove, so runner
+ * copies it without allocation when out of memory.
+ */
+std::shared_ptr<const LowMemoryCallbacks> callbacks
+    ABSL_GUARDED_BY(callbacks_mutex);
+
+/**
+ * @brief Next low memory callback id.
+ */
+std::uint64_t next_callback_id ABSL_GUARDED_BY(callbacks_mutex){1};
+
+/**
+ * @brief Allocates and commits reserve.
+ * @param bytes Reserve size.
+ * @return Reserve or nullptr.
+ */
+[[nodiscard]] void* AllocateReserve(std::size_t bytes) noexcept {
+  // mi_malloc does not call new handler on failure, so no recursion when out
+  // of memory.
+  void* memory{::mi_malloc(bytes)};
+  // Touch pages, so they are committed and backed by physical memory.
+  if (memory) std::memset(memory, 0, bytes);
+  return memory;
+}
+
+/**
+ * @brief Allocates released reserve again.  Commits reserve without lock, so
+ * release on out of memory does not wait for it.
+ * @return true if reserve is restored.
+ */
+bool RefillReserve() noexcept {
+  std::size_t bytes;
+  {
+    absl::MutexLock lock{&reserve_mutex};
+
+    if (reserve || reserve_bytes == 0) return false;
+
+    bytes = reserve_bytes;
+  }
+
+  void* memory{AllocateReserve(bytes)};
+  if (!memory) return false;
+
+  {
+    absl::MutexLock lock{&reserve_mutex};
+
+    // Reserve is restored or destroyed meanwhile.
+    if (!reserve && reserve_bytes == bytes) {
+      reserve = memory;
+      memory = nullptr;
+
+      is_reserve_released.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  if (memory) {
+    ::mi_free(memory);
+    return false;
+  }
+
+  G3LOG(INFO) << "Emergency memory reserve of " << bytes
+              << " bytes is restored.";
+  return true;
+}
+
+}  // namespace
+
+namespace wb::base::memory {
+
+ScopedEmergencyMemoryReserve::ScopedEmergencyMemoryReserve(
+    std::size_t bytes) noexcept
+    : bytes_{bytes} {
+  absl::MutexLock lock{&reserve_mutex};
+
+  G3CHECK(reserve_bytes == 0)
+      << "Only one emergency memory reserve can exist at a time.";
+
+  if (bytes_ == 0) return;
+
+  reserve_bytes = bytes_;
+  reserve = AllocateReserve(bytes_);
+
+  G3LOG_IF(WARNING, !reserve)
+      << "Unable to reserve " << bytes_
+      << " bytes of emergency memory, out of memory recovery is limited.";
+}
+
+ScopedEmergencyMemoryReserve::~ScopedEmergencyMemoryReserve() noexcept {
+  absl::MutexLock lock{&reserve_mutex};
+
+  ::mi_free(reserve);
+
+  reserve = nullptr;
+  reserve_bytes = 0;
+  is_reserve_released.store(false, std::memory_order_relaxed);
+}
+
+WB_BASE_API bool ReleaseEmergencyMemoryReserve() noexcept {
+  absl::MutexLock lock{&reserve_mutex};
+
+  if (!reserve) return false;
+
+  ::mi_free(reserve);
+  reserve = nullptr;
+
+  is_reserve_released.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+WB_BASE_API bool RestoreEmergencyMemoryReserve() noexcept {
+  if (!is_reserve_released.load(std::memory_order_relaxed)) [[likely]] {
+    return false;
+  }
+
+  if (!::marl::Scheduler::get()) return RefillReserve();
+
+  // Committing reserve pages takes long, so do not stall caller, ex. frame
+  // thread.
+  if (is_reserve_restoring.exchange(true, std::memory_order_acq_rel)) {
+    return false;
+  }
+
+  ScheduleTask(TaskPriority::kBackground, []() noexcept {
+    (void)RefillReserve();
+    is_reserve_restoring.store(false, std::memory_order_release);
+  });
+  return false;
+}
+
+[[nodiscard]] WB_BASE_API std::uint64_t AddLowMemoryCallback(
+    LowMemoryCallback callback) noexcept {
+  G3DCHECK(!!callback);
+
+  absl::MutexLock lock{&callbacks_mutex};
+
+  auto updated_callbacks =
+      callbacks ? std::make_shared<LowMemoryCallbacks>(*callbacks)
+                : std::make_shared<LowMemoryCallbacks>();
+
+  const std::uint64_t id{next_callback_id++};
+  updated_callbacks->emplace_back(id, std::move(callback));
+
+  callbacks = std::move(updated_callbacks);
+  return id;
+}
+
+WB_BASE_API void RemoveLowMemoryCallback(std::uint64_t id) noexcept {
+  absl::MutexLock lock{&callbacks_mutex};
+
+  auto updated_callbacks =
+      callbacks ? std::make_shared<LowMemoryCallbacks>(*callbacks)
+                : std::make_shared<LowMemoryCallbacks>();
+
+  [[maybe_unused]] const auto removed_count =
+      std::erase_if(*updated_callbacks, [id](const auto& callback) {
+        return callback.first == id;
+      });
+  G3DCHECK(removed_count == 1) << "Unknown low memory callback " << id << ".";
+
+  callbacks = std::move(updated_callbacks);
+}
+
+WB_BASE_API std::size_t RunLowMemoryCallbacks() noexcept {
+  // Copying snapshot pointer needs no memory we have no.
+  std::shared_ptr<const LowMemoryCallbacks> snapshot;
+  {
+    absl::ReaderMutexLock lock{&callbacks_mutex};
+    snapshot = callbacks;
+  }
+
+  if (!snapshot) return 0;
+
+  // Callbacks are called without lock, so they can take locks or change
+  // callbacks.
+  for (const auto& [id, callback] : *snapshot) {
+    callback();
+  }
+
+  return snapshot->size();
+}
+
+}  // namespace wb::base::memory
@@ -0,0 +1,91 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Low memory recovery: emergency memory reserve and low memory callbacks.
+
+#ifndef WB_BASE_MEMORY_LOW_MEMORY_H_
+#define WB_BASE_MEMORY_LOW_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "base/config.h"
+#include "base/macroses.h"
+
+namespace wb::base::memory {
+
+/**
+ * @brief Reserves memory block which is released on first out of memory, so
+ * app survives transient allocation spikes (ex. level transitions).  Only one
+ * reserve can exist at a time.
+ */
+class WB_BASE_API ScopedEmergencyMemoryReserve {
+ public:
+  /**
+   * @brief Reserves and commits |bytes|.  Nothing is reserved when |bytes| is
+   * 0 or memory is not available.
+   * @param bytes Reserve size.
+   */
+  explicit ScopedEmergencyMemoryReserve(std::size_t bytes) noexcept;
+
+  /**
+   * @brief Frees reserve if not released yet.
+   */
+  ~ScopedEmergencyMemoryReserve() noexcept;
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ScopedEmergencyMemoryReserve);
+
+ private:
+  /**
+   * @brief Reserve size.
+   */
+  const std::size_t bytes_;
+};
+
+/**
+ * @brief Releases emergency memory reserve.
+ * @return true if reserve was held and released now.
+ */
+WB_BASE_API bool ReleaseEmergencyMemoryReserve() noexcept;
+
+/**
+ * @brief Reserves emergency memory again after release.  Cheap when reserve
+ * is held, so can be called once per frame.  When marl scheduler is bound to
+ * calling thread, reserve is committed on background lane, so caller does not
+ * stall.
+ * @return true if reserve is restored by this call.
+ */
+WB_BASE_API bool RestoreEmergencyMemoryReserve() noexcept;
+
+/**
+ * @brief Low memory callback.  Should release memory, ex. drop caches or
+ * evict assets.  Called on thread which failed to allocate, so should not
+ * allocate or wait for locks held while allocating.
+ */
+using LowMemoryCallback = std::function<void()>;
+
+/**
+ * @brief Adds low memory callback.
+ * @param callback Callback.
+ * @return Callback id for RemoveLowMemoryCallback.
+ */
+[[nodiscard]] WB_BASE_API std::uint64_t AddLowMemoryCallback(
+    LowMemoryCallback callback) noexcept;
+
+/**
+ * @brief Removes low memory callback.
+ * @param id Callback id.
+ */
+WB_BASE_API void RemoveLowMemoryCallback(std::uint64_t id) noexcept;
+
+/**
+ * @brief Calls all low memory callbacks.
+ * @return Called callbacks count.
+ */
+WB_BASE_API std::size_t RunLowMemoryCallbacks() noexcept;
+
+}  // namespace wb::base::memory
+
+#endif  // !WB_BASE_MEMORY_LOW_MEMORY_H_
@@ -0,0 +1,134 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Low memory recovery: emergency memory reserve and low memory callbacks.
+
+#include "low_memory.h"
+//
+#include <chrono>
+#include <thread>
+
+#include "base/default_new_handler.h"
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/deps/marl/scheduler.h"
+#include "base/scoped_new_handler.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LowMemoryTest, EmergencyMemoryReserve) {
+  using namespace wb::base::memory;
+
+  EXPECT_FALSE(ReleaseEmergencyMemoryReserve());
+  EXPECT_FALSE(RestoreEmergencyMemoryReserve());
+
+  {
+    const ScopedEmergencyMemoryReserve reserve{1U << 20U};
+
+    // Nothing to restore while reserve is held.
+    EXPECT_FALSE(RestoreEmergencyMemoryReserve());
+
+    EXPECT_TRUE(ReleaseEmergencyMemoryReserve());
+    EXPECT_FALSE(ReleaseEmergencyMemoryReserve());
+
+    EXPECT_TRUE(RestoreEmergencyMemoryReserve());
+    EXPECT_FALSE(RestoreEmergencyMemoryReserve());
+
+    EXPECT_TRUE(ReleaseEmergencyMemoryReserve());
+  }
+
+  EXPECT_FALSE(ReleaseEmergencyMemoryReserve());
+  EXPECT_FALSE(RestoreEmergencyMemoryReserve());
+
+  {
+    const ScopedEmergencyMemoryReserve reserve{0};
+
+    EXPECT_FALSE(ReleaseEmergencyMemoryReserve());
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LowMemoryTest, LowMemoryCallbacks) {
+  using namespace wb::base::memory;
+
+  int first_calls_count{0}, second_calls_count{0};
+  const std::uint64_t first_id{
+      AddLowMemoryCallback([&first_calls_count]() { ++first_calls_count; })};
+  const std::uint64_t second_id{AddLowMemoryCallback(
+      [&second_calls_count]() { ++second_calls_count; })};
+  EXPECT_NE(first_id, second_id);
+
+  EXPECT_EQ(2U, RunLowMemoryCallbacks());
+  EXPECT_EQ(1, first_calls_count);
+  EXPECT_EQ(1, second_calls_count);
+
+  RemoveLowMemoryCallback(first_id);
+
+  EXPECT_EQ(1U, RunLowMemoryCallbacks());
+  EXPECT_EQ(1, first_calls_count);
+  EXPECT_EQ(2, second_calls_count);
+
+  RemoveLowMemoryCallback(second_id);
+
+  EXPECT_EQ(0U, RunLowMemoryCallbacks());
+
+  // Callbacks run without lock, so can remove themselves.
+  std::uint64_t self_removing_id{0};
+  self_removing_id = AddLowMemoryCallback(
+      [&self_removing_id]() { RemoveLowMemoryCallback(self_removing_id); });
+
+  EXPECT_EQ(1U, RunLowMemoryCallbacks());
+  EXPECT_EQ(0U, RunLowMemoryCallbacks());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LowMemoryTest, RestoreEmergencyMemoryReserveOnBackgroundLane) {
+  using namespace wb::base::memory;
+  using namespace std::chrono_literals;
+
+  marl::Scheduler scheduler{marl::Scheduler::Config{}.setWorkerThreadCount(2)};
+  scheduler.bind();
+
+  {
+    const ScopedEmergencyMemoryReserve reserve{1U << 20U};
+
+    EXPECT_TRUE(ReleaseEmergencyMemoryReserve());
+    EXPECT_FALSE(RestoreEmergencyMemoryReserve())
+        << "Should restore on background lane.";
+
+    // Held reserve is released again.
+    bool is_restored{false};
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (!is_restored && std::chrono::steady_clock::now() < deadline) {
+      is_restored = ReleaseEmergencyMemoryReserve();
+      std::this_thread::yield();
+    }
+    EXPECT_TRUE(is_restored);
+  }
+
+  scheduler.unbind();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(LowMemoryTest, DefaultNewFailureHandlerReleasesReserve) {
+  using namespace wb::base;
+  using namespace wb::base::memory;
+
+  const ScopedEmergencyMemoryReserve reserve{1U << 20U};
+
+  int calls_count{0};
+  const std::uint64_t id{
+      AddLowMemoryCallback([&calls_count]() { ++calls_count; })};
+
+  // Reserve release is not a retry, so handler returns even without retries.
+  ScopedNewHandler old_scoped_new_handler{
+      InstallGlobalScopedNewHandler(ScopedNewHandler{})};
+
+  DefaultNewFailureHandler();
+
+  EXPECT_EQ(1, calls_count);
+  EXPECT_FALSE(ReleaseEmergencyMemoryReserve());
+  EXPECT_TRUE(RestoreEmergencyMemoryReserve());
+
+  InstallGlobalScopedNewHandler(std::move(old_scoped_new_handler));
+  RemoveLowMemoryCallback(id);
+}
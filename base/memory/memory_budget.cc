@@ -0,0 +1,339 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Memory budgets per category.
+
+#include "memory_budget.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <stop_token>
+
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/mimalloc/mimalloc.h"
+#include "base/internals/scoped_new_handler_internal.h"
+#include "base/std2/filesystem_ext.h"
+#include "base/std2/thread_ext.h"
+
+namespace {
+
+/**
+ * @brief Formats limit.
+ * @param limit Limit.
+ * @return Limit or "unlimited".
+ */
+[[nodiscard]] std::string FormatLimit(std::size_t limit) noexcept {
+  return limit != 0 ? std::to_string(limit) : std::string{"unlimited"};
+}
+
+}  // namespace
+
+namespace wb::base::memory {
+
+[[nodiscard]] WB_BASE_API std::string_view GetMemoryCategoryName(
+    MemoryCategory category) noexcept {
+  switch (category) {
+    case MemoryCategory::kTextures:
+      return "textures";
+    case MemoryCategory::kSounds:
+      return "sounds";
+    case MemoryCategory::kWorld:
+      return "world";
+    case MemoryCategory::kScripts:
+      return "scripts";
+    case MemoryCategory::kUi:
+      return "ui";
+    case MemoryCategory::kLogging:
+      return "logging";
+    default:
+      G3DCHECK(false) << "Unknown memory category "
+                      << underlying_cast(category) << ".";
+      return "unknown";
+  }
+}
+
+MemoryBudgetTracker::MemoryBudgetTracker() noexcept
+    : categories_{}, callbacks_{}, next_callback_id_{1}, pad_{} {}
+
+MemoryBudgetTracker::~MemoryBudgetTracker() noexcept = default;
+
+void MemoryBudgetTracker::SetBudget(MemoryCategory category,
+                                    MemoryBudget budget) noexcept {
+  G3DCHECK(underlying_cast(category) < categories_.size());
+  G3DCHECK(budget.soft_limit == 0 || budget.hard_limit == 0 ||
+           budget.soft_limit <= budget.hard_limit)
+      << "Soft limit " << budget.soft_limit << " of "
+      << GetMemoryCategoryName(category) << " exceeds hard limit "
+      << budget.hard_limit << ".";
+
+  Category& state{categories_[underlying_cast(category)]};
+  state.soft_limit.store(budget.soft_limit, std::memory_order_relaxed);
+  state.hard_limit.store(budget.hard_limit, std::memory_order_relaxed);
+}
+
+[[nodiscard]] bool MemoryBudgetTracker::TryReserve(MemoryCategory category,
+                                                   std::size_t bytes) noexcept {
+  G3DCHECK(underlying_cast(category) < categories_.size());
+
+  Category& state{categories_[underlying_cast(category)]};
+  const std::size_t hard_limit{
+      state.hard_limit.load(std::memory_order_relaxed)};
+
+  std::size_t current_bytes{
+      state.current_bytes.load(std::memory_order_relaxed)};
+  std::size_t new_bytes;
+  do {
+    new_bytes = current_bytes + bytes;
+
+    if (hard_limit != 0 && new_bytes > hard_limit) [[unlikely]] {
+      state.hard_breaches_count.fetch_add(1, std::memory_order_relaxed);
+      NotifyBreach(category, MemoryBudgetBreach::kHard);
+      return false;
+    }
+  } while (!state.current_bytes.compare_exchange_weak(
+      current_bytes, new_bytes, std::memory_order_relaxed));
+
+  std::size_t peak_bytes{state.peak_bytes.load(std::memory_order_relaxed)};
+  while (new_bytes > peak_bytes &&
+         !state.peak_bytes.compare_exchange_weak(peak_bytes, new_bytes,
+                                                 std::memory_order_relaxed)) {
+  }
+
+  const std::size_t soft_limit{
+      state.soft_limit.load(std::memory_order_relaxed)};
+  // Notify only on crossing, not on each allocation above soft limit.
+  if (soft_limit != 0 && current_bytes <= soft_limit &&
+      new_bytes > soft_limit) [[unlikely]] {
+    state.soft_breaches_count.fetch_add(1, std::memory_order_relaxed);
+    NotifyBreach(category, MemoryBudgetBreach::kSoft);
+  }
+
+  return true;
+}
+
+[[nodiscard]] bool MemoryBudgetTracker::TryReserveWithRetries(
+    MemoryCategory category, std::size_t bytes) noexcept {
+  G3DCHECK(underlying_cast(category) < categories_.size());
+
+  const Category& state{categories_[underlying_cast(category)]};
+  const std::uint32_t max_retries_count{
+      internals::GetGlobalScopedNewHandlerMaxNewRetriesCount()};
+
+  std::size_t current_bytes{
+      state.current_bytes.load(std::memory_order_relaxed)};
+  std::uint32_t retries_count{0};
+  while (!TryReserve(category, bytes)) {
+    // Breach callbacks are done.  Nothing changes on retry if they released
+    // nothing.
+    const std::size_t left_bytes{
+        state.current_bytes.load(std::memory_order_relaxed)};
+    if (left_bytes >= current_bytes || retries_count++ > max_retries_count) {
+      return false;
+    }
+
+    current_bytes = left_bytes;
+  }
+
+  return true;
+}
+
+void MemoryBudgetTracker::Release(MemoryCategory category,
+                                  std::size_t bytes) noexcept {
+  G3DCHECK(underlying_cast(category) < categories_.size());
+
+  [[maybe_unused]] const std::size_t current_bytes{
+      categories_[underlying_cast(category)].current_bytes.fetch_sub(
+          bytes, std::memory_order_relaxed)};
+  G3DCHECK(current_bytes >= bytes)
+      << "Released " << bytes << " bytes of "
+      << GetMemoryCategoryName(category) << ", but only " << current_bytes
+      << " reserved.";
+}
+
+[[nodiscard]] MemoryCategoryUsage MemoryBudgetTracker::GetUsage(
+    MemoryCategory category) const noexcept {
+  G3DCHECK(underlying_cast(category) < categories_.size());
+
+  const Category& state{categories_[underlying_cast(category)]};
+  return {
+      .budget = {.soft_limit = state.soft_limit.load(std::memory_order_relaxed),
+                 .hard_limit =
+                     state.hard_limit.load(std::memory_order_relaxed)},
+      .current_bytes = state.current_bytes.load(std::memory_order_relaxed),
+      .peak_bytes = state.peak_bytes.load(std::memory_order_relaxed),
+      .soft_breaches_count =
+          state.soft_breaches_count.load(std::memory_order_relaxed),
+      .hard_breaches_count =
+          state.hard_breaches_count.load(std::memory_order_relaxed)};
+}
+
+[[nodiscard]] std::uint64_t MemoryBudgetTracker::AddBreachCallback(
+    MemoryBudgetBreachCallback callback) noexcept {
+  G3DCHECK(!!callback);
+
+  absl::MutexLock lock{&callbacks_mutex_};
+
+  const std::uint64_t id{next_callback_id_++};
+  callbacks_.emplace_back(id, std::move(callback));
+  return id;
+}
+
+void MemoryBudgetTracker::RemoveBreachCallback(std::uint64_t id) noexcept {
+  absl::MutexLock lock{&callbacks_mutex_};
+
+  [[maybe_unused]] const auto removed_count = std::erase_if(
+      callbacks_, [id](const auto& callback) { return callback.first == id; });
+  G3DCHECK(removed_count == 1) << "Unknown breach callback " << id << ".";
+}
+
+void MemoryBudgetTracker::LogReport() const noexcept {
+  for (std::size_t i{0}; i < kMemoryCategoriesCount; ++i) {
+    const auto category = static_cast<MemoryCategory>(i);
+    const MemoryCategoryUsage usage{GetUsage(category)};
+
+    G3LOG(INFO) << "Memory budget " << GetMemoryCategoryName(category) << ": "
+                << usage.current_bytes << " current bytes, "
+                << usage.peak_bytes << " peak bytes, "
+                << FormatLimit(usage.budget.soft_limit) << " soft / "
+                << FormatLimit(usage.budget.hard_limit) << " hard limit, "
+                << usage.soft_breaches_count << " soft / "
+                << usage.hard_breaches_count << " hard breaches.";
+  }
+}
+
+[[nodiscard]] std::string MemoryBudgetTracker::FormatJsonReport()
+    const noexcept {
+  std::string json{"{\"categories\":["};
+
+  for (std::size_t i{0}; i < kMemoryCategoriesCount; ++i) {
+    const auto category = static_cast<MemoryCategory>(i);
+    const MemoryCategoryUsage usage{GetUsage(category)};
+
+    if (i != 0) json += ',';
+
+    // Category names are identifiers, so need no escaping.
+    json += "{\"name\":\"";
+    json += GetMemoryCategoryName(category);
+    json += "\",\"current_bytes\":";
+    json += std::to_string(usage.current_bytes);
+    json += ",\"peak_bytes\":";
+    json += std::to_string(usage.peak_bytes);
+    json += ",\"soft_limit\":";
+    json += std::to_string(usage.budget.soft_limit);
+    json += ",\"hard_limit\":";
+    json += std::to_string(usage.budget.hard_limit);
+    json += ",\"soft_breaches_count\":";
+    json += std::to_string(usage.soft_breaches_count);
+    json += ",\"hard_breaches_count\":";
+    json += std::to_string(usage.hard_breaches_count);
+    json += '}';
+  }
+
+  json += "]}\n";
+  return json;
+}
+
+[[nodiscard]] std::error_code MemoryBudgetTracker::WriteJsonReport(
+    const std::filesystem::path& path) const noexcept {
+  return std2::filesystem::write_file_atomically(path, FormatJsonReport());
+}
+
+void MemoryBudgetTracker::NotifyBreach(MemoryCategory category,
+                                       MemoryBudgetBreach breach) noexcept {
+  std::vector<std::pair<std::uint64_t, MemoryBudgetBreachCallback>> callbacks;
+  {
+    absl::ReaderMutexLock lock{&callbacks_mutex_};
+    callbacks = callbacks_;
+  }
+
+  // Callbacks are called without lock, so they can release memory or change
+  // callbacks.
+  const MemoryCategoryUsage usage{GetUsage(category)};
+  for (const auto& [id, callback] : callbacks) {
+    callback(category, breach, usage);
+  }
+}
+
+[[nodiscard]] void* MemoryBudgetResource::do_allocate(std::size_t bytes,
+                                                      std::size_t alignment) {
+  if (!tracker_.TryReserveWithRetries(category_, bytes)) [[unlikely]] {
+    G3LOG(WARNING) << "Memory budget " << GetMemoryCategoryName(category_)
+                   << " hard limit is exceeded by " << bytes
+                   << " bytes allocation.";
+    throw std::bad_alloc{};
+  }
+
+  void* memory{::mi_malloc_aligned(bytes, alignment)};
+  if (!memory) [[unlikely]] {
+    tracker_.Release(category_, bytes);
+    throw std::bad_alloc{};
+  }
+
+  return memory;
+}
+
+void MemoryBudgetResource::do_deallocate(
+    void* memory, std::size_t bytes,
+    [[maybe_unused]] std::size_t alignment) noexcept {
+  ::mi_free(memory);
+
+  tracker_.Release(category_, bytes);
+}
+
+ScopedMemoryBudgetReporter::ScopedMemoryBudgetReporter(
+    const MemoryBudgetTracker& tracker, std::chrono::milliseconds interval,
+    std::filesystem::path json_path) noexcept
+    : tracker_{tracker}, json_path_{std::move(json_path)}, thread_{} {
+  if (interval.count() == 0) return;
+
+  thread_ = std::jthread{[this, interval](const std::stop_token& stop_token) {
+    [[maybe_unused]] const auto rc =
+        std2::this_thread::set_name("WB_MemBudget");
+    G3DCHECK(!rc) << "Unable to set memory budget thread name: "
+                  << rc.message();
+
+    std::mutex mutex;
+    std::condition_variable_any stopped;
+
+    std::unique_lock lock{mutex};
+    while (!stop_token.stop_requested()) {
+      // Nobody notifies, so wakes up on timeout or stop only.
+      (void)stopped.wait_for(lock, stop_token, interval, [] { return false; });
+      if (stop_token.stop_requested()) break;
+
+      Report();
+    }
+  }};
+}
+
+ScopedMemoryBudgetReporter::~ScopedMemoryBudgetReporter() noexcept {
+  if (thread_.joinable()) {
+    thread_.request_stop();
+    thread_.join();
+
+    Report();
+  }
+}
+
+void ScopedMemoryBudgetReporter::Report() const noexcept {
+  tracker_.LogReport();
+
+  if (!json_path_.empty()) {
+    const std::error_code rc{tracker_.WriteJsonReport(json_path_)};
+    G3LOG_IF(WARNING, !!rc)
+        << "Unable to write memory budget report " << json_path_ << ": "
+        << rc.message();
+  }
+}
+
+[[nodiscard]] WB_BASE_API MemoryBudgetTracker&
+GetMemoryBudgetTracker() noexcept {
+  // Never destroyed, as tracked memory can outlive static destructors.
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  static MemoryBudgetTracker& tracker{*new MemoryBudgetTracker};
+  return tracker;
+}
+
+}  // namespace wb::base::memory
@@ -0,0 +1,378 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Memory budgets per category.
+
+#ifndef WB_BASE_MEMORY_MEMORY_BUDGET_H_
+#define WB_BASE_MEMORY_MEMORY_BUDGET_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "base/config.h"
+#include "base/deps/abseil/base/thread_annotations.h"
+#include "base/deps/abseil/synchronization/mutex.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::memory {
+
+/**
+ * @brief Memory category tag.
+ */
+enum class MemoryCategory : std::uint8_t {
+  kTextures,
+  kSounds,
+  kWorld,
+  kScripts,
+  kUi,
+  kLogging,
+};
+
+/**
+ * @brief Memory categories count.
+ */
+inline constexpr std::size_t kMemoryCategoriesCount{
+    underlying_cast(MemoryCategory::kLogging) + 1U};
+
+/**
+ * @brief Gets memory category name.
+ * @param category Memory category.
+ * @return Memory category name.
+ */
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_CONST std::string_view
+GetMemoryCategoryName(MemoryCategory category) noexcept;
+
+/**
+ * @brief Memory budget.  0 limit means no limit.
+ */
+struct MemoryBudget {
+  /**
+   * @brief Bytes after which category is over budget, but allocations
+   * succeed.
+   */
+  std::size_t soft_limit;
+  /**
+   * @brief Bytes after which category allocations fail.
+   */
+  std::size_t hard_limit;
+};
+
+/**
+ * @brief Memory budget breach kind.
+ */
+enum class MemoryBudgetBreach : std::uint8_t {
+  /**
+   * @brief Soft limit crossed.
+   */
+  kSoft,
+  /**
+   * @brief Allocation would cross hard limit.
+   */
+  kHard,
+};
+
+/**
+ * @brief Memory category usage.
+ */
+struct MemoryCategoryUsage {
+  /**
+   * @brief Budget.
+   */
+  MemoryBudget budget;
+  /**
+   * @brief Current bytes.
+   */
+  std::size_t current_bytes;
+  /**
+   * @brief Peak bytes.
+   */
+  std::size_t peak_bytes;
+  /**
+   * @brief Soft limit crossings count.
+   */
+  std::size_t soft_breaches_count;
+  /**
+   * @brief Rejected by hard limit allocations count.
+   */
+  std::size_t hard_breaches_count;
+};
+
+/**
+ * @brief Memory budget breach callback.  Can release memory of category, ex.
+ * drop caches or evict assets.  Should not allocate from category.
+ */
+using MemoryBudgetBreachCallback = std::function<void(
+    MemoryCategory category, MemoryBudgetBreach breach,
+    const MemoryCategoryUsage& usage)>;
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Tracks memory usage per category against soft / hard budgets.
+   * Reserve / release are lock-free and can be called from any thread.
+   */
+  class WB_BASE_API MemoryBudgetTracker {
+   public:
+    /**
+     * @brief Creates tracker with no budgets.
+     */
+    MemoryBudgetTracker() noexcept;
+    ~MemoryBudgetTracker() noexcept;
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(MemoryBudgetTracker);
+
+    /**
+     * @brief Sets |category| budget.
+     * @param category Memory category.
+     * @param budget Memory budget.
+     */
+    void SetBudget(MemoryCategory category, MemoryBudget budget) noexcept;
+
+    /**
+     * @brief Reserves |bytes| in |category|.  Calls breach callbacks when soft
+     * limit is crossed or hard limit would be crossed.
+     * @param category Memory category.
+     * @param bytes Bytes count.
+     * @return true if reserved, false if hard limit would be crossed.
+     */
+    [[nodiscard]] bool TryReserve(MemoryCategory category,
+                                  std::size_t bytes) noexcept;
+
+    /**
+     * @brief Reserves |bytes| in |category| for allocation.  When hard limit
+     * is hit, but breach callbacks released category memory, retries up to
+     * once plus global new handler retries count
+     * (--attempts_to_retry_allocate_memory).
+     * @param category Memory category.
+     * @param bytes Bytes count.
+     * @return true if reserved, false if hard limit would be crossed.
+     */
+    [[nodiscard]] bool TryReserveWithRetries(MemoryCategory category,
+                                             std::size_t bytes) noexcept;
+
+    /**
+     * @brief Releases |bytes| reserved in |category|.
+     * @param category Memory category.
+     * @param bytes Bytes count.
+     */
+    void Release(MemoryCategory category, std::size_t bytes) noexcept;
+
+    /**
+     * @brief Gets |category| usage.
+     * @param category Memory category.
+     * @return Memory category usage.
+     */
+    [[nodiscard]] MemoryCategoryUsage GetUsage(
+        MemoryCategory category) const noexcept;
+
+    /**
+     * @brief Adds breach callback.
+     * @param callback Callback.
+     * @return Callback id for RemoveBreachCallback.
+     */
+    [[nodiscard]] std::uint64_t AddBreachCallback(
+        MemoryBudgetBreachCallback callback) noexcept;
+
+    /**
+     * @brief Removes breach callback.
+     * @param id Callback id.
+     */
+    void RemoveBreachCallback(std::uint64_t id) noexcept;
+
+    /**
+     * @brief Logs usage of all categories.
+     */
+    void LogReport() const noexcept;
+
+    /**
+     * @brief Formats usage of all categories as JSON.
+     * @return JSON.
+     */
+    [[nodiscard]] std::string FormatJsonReport() const noexcept;
+
+    /**
+     * @brief Writes JSON report to |path|.  Writes temporary file and renames
+     * it, so readers never see partial report.
+     * @param path Report path.
+     * @return Error code.
+     */
+    [[nodiscard]] std::error_code WriteJsonReport(
+        const std::filesystem::path& path) const noexcept;
+
+   private:
+    /**
+     * @brief Category state.
+     */
+    struct alignas(64) Category {
+      /**
+       * @brief Soft limit.
+       */
+      std::atomic_size_t soft_limit;
+      /**
+       * @brief Hard limit.
+       */
+      std::atomic_size_t hard_limit;
+      /**
+       * @brief Current bytes.
+       */
+      std::atomic_size_t current_bytes;
+      /**
+       * @brief Peak bytes.
+       */
+      std::atomic_size_t peak_bytes;
+      /**
+       * @brief Soft breaches count.
+       */
+      std::atomic_size_t soft_breaches_count;
+      /**
+       * @brief Hard breaches count.
+       */
+      std::atomic_size_t hard_breaches_count;
+
+      WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 16> pad_;
+    };
+
+    /**
+     * @brief Categories state, cache line each, so hot categories do not
+     * contend.
+     */
+    std::array<Category, kMemoryCategoriesCount> categories_;
+    /**
+     * @brief Serializes callbacks access.
+     */
+    mutable absl::Mutex callbacks_mutex_;
+    /**
+     * @brief Breach callbacks by id.
+     */
+    std::vector<std::pair<std::uint64_t, MemoryBudgetBreachCallback>>
+        callbacks_ ABSL_GUARDED_BY(callbacks_mutex_);
+    /**
+     * @brief Next callback id.
+     */
+    std::uint64_t next_callback_id_ ABSL_GUARDED_BY(callbacks_mutex_);
+
+    WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 24> pad_;
+
+    /**
+     * @brief Calls breach callbacks.
+     * @param category Memory category.
+     * @param breach Breach kind.
+     */
+    void NotifyBreach(MemoryCategory category,
+                      MemoryBudgetBreach breach) noexcept;
+  };
+
+  /**
+   * @brief Memory resource which accounts allocations in memory category.
+   * Allocates by mimalloc.  When hard budget is hit, breach callbacks can
+   * release memory, so allocation is retried while they do, see
+   * MemoryBudgetTracker::TryReserveWithRetries, then fails with
+   * std::bad_alloc.
+   */
+  class WB_BASE_API MemoryBudgetResource : public std::pmr::memory_resource {
+   public:
+    /**
+     * @brief Creates resource.
+     * @param tracker Memory budget tracker.
+     * @param category Memory category.
+     */
+    MemoryBudgetResource(MemoryBudgetTracker& tracker,
+                         MemoryCategory category) noexcept
+        : tracker_{tracker}, category_{category}, pad_{} {}
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(MemoryBudgetResource);
+
+   private:
+    /**
+     * @brief Memory budget tracker.
+     */
+    MemoryBudgetTracker& tracker_;
+    /**
+     * @brief Memory category.
+     */
+    const MemoryCategory category_;
+
+    WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 7> pad_;
+
+    [[nodiscard]] void* do_allocate(std::size_t bytes,
+                                    std::size_t alignment) override;
+
+    void do_deallocate(void* memory, std::size_t bytes,
+                       std::size_t alignment) noexcept override;
+
+    [[nodiscard]] bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  };
+
+  /**
+   * @brief Periodically logs memory budget report and writes JSON one.
+   */
+  class WB_BASE_API ScopedMemoryBudgetReporter {
+   public:
+    /**
+     * @brief Starts reporting thread.  No thread when |interval| is 0.
+     * @param tracker Memory budget tracker.
+     * @param interval Report interval.
+     * @param json_path JSON report path.  Empty means no JSON report.
+     */
+    ScopedMemoryBudgetReporter(const MemoryBudgetTracker& tracker,
+                               std::chrono::milliseconds interval,
+                               std::filesystem::path json_path) noexcept;
+
+    /**
+     * @brief Stops reporting thread and reports last time.
+     */
+    ~ScopedMemoryBudgetReporter() noexcept;
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ScopedMemoryBudgetReporter);
+
+   private:
+    /**
+     * @brief Memory budget tracker.
+     */
+    const MemoryBudgetTracker& tracker_;
+    /**
+     * @brief JSON report path.
+     */
+    const std::filesystem::path json_path_;
+    /**
+     * @brief Reporting thread.
+     */
+    std::jthread thread_;
+
+    /**
+     * @brief Logs and writes report.
+     */
+    void Report() const noexcept;
+  };
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+/**
+ * @brief Gets process wide memory budget tracker.
+ * @return Memory budget tracker.
+ */
+[[nodiscard]] WB_BASE_API MemoryBudgetTracker&
+GetMemoryBudgetTracker() noexcept;
+
+}  // namespace wb::base::memory
+
+#endif  // !WB_BASE_MEMORY_MEMORY_BUDGET_H_
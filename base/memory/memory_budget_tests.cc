@@ -0,0 +1,197 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Memory budgets per category.
+
+#include "memory_budget.h"
+//
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MemoryBudgetTest, GetMemoryCategoryName) {
+  using namespace wb::base::memory;
+
+  for (std::size_t i{0}; i < kMemoryCategoriesCount; ++i) {
+    EXPECT_FALSE(
+        GetMemoryCategoryName(static_cast<MemoryCategory>(i)).empty());
+  }
+
+  EXPECT_EQ("textures", GetMemoryCategoryName(MemoryCategory::kTextures));
+  EXPECT_EQ("ui", GetMemoryCategoryName(MemoryCategory::kUi));
+  EXPECT_EQ(&GetMemoryBudgetTracker(), &GetMemoryBudgetTracker());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MemoryBudgetTest, ReserveRelease) {
+  using namespace wb::base::memory;
+
+  MemoryBudgetTracker tracker;
+
+  // No budget, no limits.
+  EXPECT_TRUE(tracker.TryReserve(MemoryCategory::kSounds, 1U << 30U));
+  tracker.Release(MemoryCategory::kSounds, 1U << 30U);
+
+  tracker.SetBudget(MemoryCategory::kSounds,
+                    {.soft_limit = 100, .hard_limit = 200});
+
+  EXPECT_TRUE(tracker.TryReserve(MemoryCategory::kSounds, 150));
+  EXPECT_TRUE(tracker.TryReserve(MemoryCategory::kSounds, 50));
+  EXPECT_FALSE(tracker.TryReserve(MemoryCategory::kSounds, 1));
+
+  MemoryCategoryUsage usage{tracker.GetUsage(MemoryCategory::kSounds)};
+  EXPECT_EQ(100U, usage.budget.soft_limit);
+  EXPECT_EQ(200U, usage.budget.hard_limit);
+  EXPECT_EQ(200U, usage.current_bytes);
+  EXPECT_EQ(1U << 30U, usage.peak_bytes);
+  EXPECT_EQ(1U, usage.soft_breaches_count);
+  EXPECT_EQ(1U, usage.hard_breaches_count);
+
+  tracker.Release(MemoryCategory::kSounds, 200);
+
+  usage = tracker.GetUsage(MemoryCategory::kSounds);
+  EXPECT_EQ(0U, usage.current_bytes);
+  EXPECT_EQ(0U, tracker.GetUsage(MemoryCategory::kWorld).current_bytes);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MemoryBudgetTest, BreachCallbacks) {
+  using namespace wb::base::memory;
+
+  MemoryBudgetTracker tracker;
+  tracker.SetBudget(MemoryCategory::kScripts,
+                    {.soft_limit = 64, .hard_limit = 128});
+
+  std::vector<MemoryBudgetBreach> breaches;
+  const std::uint64_t id{tracker.AddBreachCallback(
+      [&breaches](MemoryCategory category, MemoryBudgetBreach breach,
+                  const MemoryCategoryUsage& usage) {
+        EXPECT_EQ(MemoryCategory::kScripts, category);
+        EXPECT_EQ(128U, usage.budget.hard_limit);
+        breaches.emplace_back(breach);
+      })};
+
+  EXPECT_TRUE(tracker.TryReserve(MemoryCategory::kScripts, 64));
+  EXPECT_TRUE(breaches.empty());
+
+  EXPECT_TRUE(tracker.TryReserve(MemoryCategory::kScripts, 32));
+  // Soft limit is reported once per crossing.
+  EXPECT_TRUE(tracker.TryReserve(MemoryCategory::kScripts, 16));
+  EXPECT_FALSE(tracker.TryReserve(MemoryCategory::kScripts, 32));
+
+  ASSERT_EQ(2U, breaches.size());
+  EXPECT_EQ(MemoryBudgetBreach::kSoft, breaches[0]);
+  EXPECT_EQ(MemoryBudgetBreach::kHard, breaches[1]);
+
+  tracker.RemoveBreachCallback(id);
+
+  EXPECT_FALSE(tracker.TryReserve(MemoryCategory::kScripts, 32));
+  EXPECT_EQ(2U, breaches.size());
+
+  tracker.Release(MemoryCategory::kScripts, 112);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MemoryBudgetTest, MemoryBudgetResource) {
+  using namespace wb::base::memory;
+
+  MemoryBudgetTracker tracker;
+  tracker.SetBudget(MemoryCategory::kTextures,
+                    {.soft_limit = 0, .hard_limit = 1024});
+
+  MemoryBudgetResource resource{tracker, MemoryCategory::kTextures};
+
+  {
+    std::pmr::vector<std::byte> texture{&resource};
+    texture.resize(1024);
+
+    EXPECT_EQ(1024U,
+              tracker.GetUsage(MemoryCategory::kTextures).current_bytes);
+    EXPECT_THROW(std::pmr::vector<std::byte>(1, std::byte{0}, &resource),
+                 std::bad_alloc);
+    // Nothing released, so no retries.
+    EXPECT_EQ(1U, tracker.GetUsage(MemoryCategory::kTextures)
+                      .hard_breaches_count);
+  }
+
+  EXPECT_EQ(0U, tracker.GetUsage(MemoryCategory::kTextures).current_bytes);
+
+  // Callback releases memory, so allocation is retried and succeeds.
+  auto* cache = static_cast<std::byte*>(resource.allocate(1024));
+  const std::uint64_t id{tracker.AddBreachCallback(
+      [&resource, &cache](MemoryCategory, MemoryBudgetBreach breach,
+                          const MemoryCategoryUsage&) {
+        if (breach == MemoryBudgetBreach::kHard && cache) {
+          resource.deallocate(cache, 1024);
+          cache = nullptr;
+        }
+      })};
+
+  void* memory{resource.allocate(512)};
+  EXPECT_NE(nullptr, memory);
+  EXPECT_EQ(nullptr, cache);
+  EXPECT_EQ(512U, tracker.GetUsage(MemoryCategory::kTextures).current_bytes);
+
+  resource.deallocate(memory, 512);
+  tracker.RemoveBreachCallback(id);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MemoryBudgetTest, WriteJsonReport) {
+  using namespace wb::base::memory;
+
+  MemoryBudgetTracker tracker;
+  tracker.SetBudget(MemoryCategory::kUi, {.soft_limit = 10, .hard_limit = 20});
+  ASSERT_TRUE(tracker.TryReserve(MemoryCategory::kUi, 15));
+
+  const std::string json{tracker.FormatJsonReport()};
+  EXPECT_NE(std::string::npos,
+            json.find("{\"name\":\"ui\",\"current_bytes\":15,\"peak_bytes\":"
+                      "15,\"soft_limit\":10,\"hard_limit\":20,"
+                      "\"soft_breaches_count\":1,\"hard_breaches_count\":0}"));
+
+  const std::filesystem::path path{std::filesystem::temp_directory_path() /
+                                   "wb_memory_budget_tests.json"};
+  ASSERT_FALSE(tracker.WriteJsonReport(path));
+
+  std::ifstream file{path, std::ios::binary};
+  const std::string content{std::istreambuf_iterator<char>{file},
+                            std::istreambuf_iterator<char>{}};
+  EXPECT_EQ(json, content);
+
+  file.close();
+  std::error_code rc;
+  std::filesystem::remove(path, rc);
+
+  tracker.Release(MemoryCategory::kUi, 15);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(MemoryBudgetTest, ScopedMemoryBudgetReporter) {
+  using namespace std::chrono_literals;
+  using namespace wb::base::memory;
+
+  MemoryBudgetTracker tracker;
+  const std::filesystem::path path{std::filesystem::temp_directory_path() /
+                                   "wb_memory_budget_reporter_tests.json"};
+  std::error_code rc;
+  std::filesystem::remove(path, rc);
+
+  {
+    const ScopedMemoryBudgetReporter reporter{tracker, 0ms, path};
+  }
+  EXPECT_FALSE(std::filesystem::exists(path));
+
+  {
+    const ScopedMemoryBudgetReporter reporter{tracker, 1ms, path};
+    std::this_thread::sleep_for(5ms);
+  }
+  EXPECT_TRUE(std::filesystem::exists(path));
+
+  std::filesystem::remove(path, rc);
+}
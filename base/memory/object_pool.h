@@ -0,0 +1,430 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Fixed size objects pool.
+
+#ifndef WB_BASE_MEMORY_OBJECT_POOL_H_
+#define WB_BASE_MEMORY_OBJECT_POOL_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "base/deps/abseil/base/thread_annotations.h"
+#include "base/deps/abseil/synchronization/mutex.h"
+#include "base/deps/g3log/g3log.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::memory {
+
+/**
+ * @brief Object pool statistics.
+ */
+struct ObjectPoolStats {
+  /**
+   * @brief Max objects count.
+   */
+  std::size_t capacity;
+  /**
+   * @brief Objects count allocated slabs can hold.
+   */
+  std::size_t slots_count;
+  /**
+   * @brief Allocated slabs count.
+   */
+  std::size_t slabs_count;
+  /**
+   * @brief Live objects count.
+   */
+  std::size_t live_count;
+  /**
+   * @brief Max live objects count.
+   */
+  std::size_t peak_count;
+  /**
+   * @brief Total allocations count.
+   */
+  std::size_t total_allocations;
+
+  /**
+   * @brief Share of allocated slots used by live objects, [0, 1].
+   */
+  [[nodiscard]] double GetUtilization() const noexcept {
+    return slots_count != 0 ? static_cast<double>(live_count) /
+                                  static_cast<double>(slots_count)
+                            : 0.0;
+  }
+};
+
+/**
+ * @brief Byte freed object slots are filled with when poisoning is on.
+ */
+inline constexpr std::byte kObjectPoolPoison{0xDD};
+
+/**
+ * @brief Pool of fixed size objects, ex. input events, entities, network
+ * packets or log records.  Objects live in page sized slabs allocated on
+ * demand and never returned till pool destruction, so churn does not
+ * fragment general purpose heap.
+ *
+ * Free slots form lock-free stack of slot indices with ABA tag, so
+ * allocation and deallocation can be called concurrently from any thread.
+ * Only slab allocation takes lock.
+ *
+ * With poisoning on freed slots are filled with kObjectPoolPoison and
+ * checked on reuse, which catches writes after free.
+ * @tparam T Object.
+ * @tparam kSlabBytes Slab size, power of 2.  Slabs are aligned on it.
+ */
+template <typename T, std::size_t kSlabBytes = 4096>
+class ObjectPool {
+  static_assert(std::has_single_bit(kSlabBytes), "Slab size is power of 2.");
+  static_assert(alignof(T) <= kSlabBytes, "Slab should be aligned for T.");
+
+ public:
+  /**
+   * @brief Bytes per object slot.
+   */
+  static constexpr std::size_t kSlotBytes{
+      (sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T)};
+  /**
+   * @brief Slab header bytes, slot aligned.
+   */
+  static constexpr std::size_t kHeaderBytes{
+      (sizeof(std::uint32_t) + alignof(T) - 1) / alignof(T) * alignof(T)};
+  /**
+   * @brief Object slots per slab.
+   */
+  static constexpr std::size_t kSlotsPerSlab{(kSlabBytes - kHeaderBytes) /
+                                             kSlotBytes};
+
+  static_assert(kSlotsPerSlab > 0, "Slab should hold at least one object.");
+
+  /**
+   * @brief Creates pool.  No memory is allocated for objects till first
+   * allocation.
+   * @param capacity Max objects count, rounded up to whole slab.
+   * @param should_poison Should poison freed slots?
+   */
+  explicit ObjectPool(std::uint32_t capacity,
+                      bool should_poison = WB_COMPILER_HAS_DEBUG != 0) noexcept
+      : slabs_count_{(std::size_t{capacity} + kSlotsPerSlab - 1) /
+                     kSlotsPerSlab},
+        capacity_{slabs_count_ * kSlotsPerSlab},
+        slabs_{std::make_unique<std::atomic<std::byte*>[]>(slabs_count_)},
+        next_{std::make_unique<std::atomic_uint32_t[]>(capacity_)},
+        head_{Pack(kNoSlot, 0)},
+        fresh_{0},
+        allocated_slabs_{0},
+        live_count_{0},
+        peak_count_{0},
+        total_allocations_{0},
+        slabs_mutex_{},
+        should_poison_{should_poison},
+        pad_{} {
+    G3CHECK(capacity_ < kNoSlot) << "Object pool capacity " << capacity_
+                                 << " is too large.";
+  }
+
+  /**
+   * @brief Frees slabs.  All objects should be deleted.
+   */
+  ~ObjectPool() noexcept {
+    G3DCHECK(live_count_.load(std::memory_order_relaxed) == 0)
+        << "Object pool destroyed with "
+        << live_count_.load(std::memory_order_relaxed) << " live objects.";
+
+    for (std::size_t i{0}; i < slabs_count_; ++i) {
+      std::byte* slab{slabs_[i].load(std::memory_order_relaxed)};
+      if (slab) ::operator delete(slab, std::align_val_t{kSlabBytes});
+    }
+  }
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ObjectPool);
+
+  /**
+   * @brief Allocates and constructs object.
+   * @tparam Args Object constructor arguments.
+   * @param args Object constructor arguments.
+   * @return Object or nullptr if pool is exhausted or out of memory.
+   */
+  template <typename... Args>
+  [[nodiscard]] T* New(Args&&... args) noexcept(
+      std::is_nothrow_constructible_v<T, Args...>) {
+    void* memory{Allocate()};
+    return memory ? ::new (memory) T(std::forward<Args>(args)...) : nullptr;
+  }
+
+  /**
+   * @brief Destroys and deallocates object.
+   * @param object Object from this pool or nullptr.
+   */
+  void Delete(T* object) noexcept {
+    if (!object) return;
+
+    object->~T();
+    Deallocate(object);
+  }
+
+  /**
+   * @brief Allocates uninitialized object slot.
+   * @return Slot or nullptr if pool is exhausted or out of memory.
+   */
+  [[nodiscard]] void* Allocate() noexcept {
+    std::uint32_t index{PopFree()};
+
+    if (index == kNoSlot) {
+      const std::uint64_t fresh{fresh_.fetch_add(1, std::memory_order_relaxed)};
+      if (fresh >= capacity_) [[unlikely]] {
+        return nullptr;
+      }
+
+      index = static_cast<std::uint32_t>(fresh);
+    }
+
+    std::byte* slot{GetSlot(index)};
+    if (!slot) [[unlikely]] {
+      // Slab allocation failed, so slot is free for retry.
+      PushFree(index);
+      return nullptr;
+    }
+
+    if (should_poison_) {
+      G3CHECK(std::all_of(slot, slot + kSlotBytes,
+                          [](std::byte b) { return b == kObjectPoolPoison; }))
+          << "Object pool slot " << index << " was written after free.";
+    }
+
+    const std::size_t live_count{
+        live_count_.fetch_add(1, std::memory_order_relaxed) + 1};
+    total_allocations_.fetch_add(1, std::memory_order_relaxed);
+
+    std::size_t peak_count{peak_count_.load(std::memory_order_relaxed)};
+    while (live_count > peak_count &&
+           !peak_count_.compare_exchange_weak(peak_count, live_count,
+                                              std::memory_order_relaxed)) {
+    }
+
+    return slot;
+  }
+
+  /**
+   * @brief Deallocates object slot.
+   * @param memory Slot from this pool.
+   */
+  void Deallocate(void* memory) noexcept {
+    auto* slot = static_cast<std::byte*>(memory);
+    std::byte* slab{reinterpret_cast<std::byte*>(
+        reinterpret_cast<std::uintptr_t>(slot) & ~(kSlabBytes - 1))};
+
+    std::uint32_t slab_index;
+    std::memcpy(&slab_index, slab, sizeof(slab_index));
+
+    G3DCHECK(slab_index < slabs_count_ &&
+             slabs_[slab_index].load(std::memory_order_relaxed) == slab)
+        << "Slot is not from this pool.";
+
+    const auto slot_offset = static_cast<std::size_t>(slot - slab);
+    G3DCHECK((slot_offset - kHeaderBytes) % kSlotBytes == 0)
+        << "Slot is misaligned.";
+
+    if (should_poison_) {
+      std::fill_n(slot, kSlotBytes, kObjectPoolPoison);
+    }
+
+    live_count_.fetch_sub(1, std::memory_order_relaxed);
+
+    PushFree(static_cast<std::uint32_t>(slab_index * kSlotsPerSlab +
+                                        (slot_offset - kHeaderBytes) /
+                                            kSlotBytes));
+  }
+
+  /**
+   * @brief Gets pool statistics.  Can be called concurrently with
+   * allocations.
+   */
+  [[nodiscard]] ObjectPoolStats GetStats() const noexcept {
+    const std::size_t slabs_count{
+        allocated_slabs_.load(std::memory_order_relaxed)};
+
+    return {.capacity = capacity_,
+            .slots_count = slabs_count * kSlotsPerSlab,
+            .slabs_count = slabs_count,
+            .live_count = live_count_.load(std::memory_order_relaxed),
+            .peak_count = peak_count_.load(std::memory_order_relaxed),
+            .total_allocations =
+                total_allocations_.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  /**
+   * @brief No slot marker.
+   */
+  static constexpr std::uint32_t kNoSlot{
+      std::numeric_limits<std::uint32_t>::max()};
+
+  /**
+   * @brief Max slabs count.
+   */
+  const std::size_t slabs_count_;
+  /**
+   * @brief Max objects count.
+   */
+  const std::size_t capacity_;
+  /**
+   * @brief Slabs by index or nullptr if not allocated yet.
+   */
+  base::un<std::atomic<std::byte*>[]> slabs_;
+  /**
+   * @brief Next free slot index by slot index.
+   */
+  base::un<std::atomic_uint32_t[]> next_;
+  /**
+   * @brief Free slots stack head: ABA tag in high bits, slot index in low.
+   */
+  std::atomic_uint64_t head_;
+  /**
+   * @brief Next never used slot index.
+   */
+  std::atomic_uint64_t fresh_;
+  /**
+   * @brief Allocated slabs count.
+   */
+  std::atomic_size_t allocated_slabs_;
+  /**
+   * @brief Live objects count.
+   */
+  std::atomic_size_t live_count_;
+  /**
+   * @brief Max live objects count.
+   */
+  std::atomic_size_t peak_count_;
+  /**
+   * @brief Total allocations count.
+   */
+  std::atomic_size_t total_allocations_;
+  /**
+   * @brief Serializes slabs allocation.
+   */
+  absl::Mutex slabs_mutex_;
+  /**
+   * @brief Should poison freed slots?
+   */
+  const bool should_poison_;
+
+  WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 7> pad_;
+
+  /**
+   * @brief Packs free stack head.
+   * @param index Slot index.
+   * @param tag ABA tag.
+   * @return Head.
+   */
+  [[nodiscard]] static constexpr std::uint64_t Pack(
+      std::uint32_t index, std::uint32_t tag) noexcept {
+    return (std::uint64_t{tag} << 32U) | index;
+  }
+
+  /**
+   * @brief Pops free slot index.
+   * @return Slot index or kNoSlot.
+   */
+  [[nodiscard]] std::uint32_t PopFree() noexcept {
+    std::uint64_t head{head_.load(std::memory_order_acquire)};
+
+    while (true) {
+      const auto index = static_cast<std::uint32_t>(head);
+      if (index == kNoSlot) return kNoSlot;
+
+      const std::uint32_t next{next_[index].load(std::memory_order_relaxed)};
+      const auto tag = static_cast<std::uint32_t>(head >> 32U);
+
+      if (head_.compare_exchange_weak(head, Pack(next, tag + 1),
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire)) {
+        return index;
+      }
+    }
+  }
+
+  /**
+   * @brief Pushes free slot index.
+   * @param index Slot index.
+   */
+  void PushFree(std::uint32_t index) noexcept {
+    std::uint64_t head{head_.load(std::memory_order_relaxed)};
+
+    do {
+      next_[index].store(static_cast<std::uint32_t>(head),
+                         std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(
+        head, Pack(index, static_cast<std::uint32_t>(head >> 32U) + 1),
+        std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  /**
+   * @brief Gets slot by index, allocating its slab if needed.
+   * @param index Slot index.
+   * @return Slot or nullptr if out of memory.
+   */
+  [[nodiscard]] std::byte* GetSlot(std::uint32_t index) noexcept {
+    const std::size_t slab_index{index / kSlotsPerSlab};
+    std::byte* slab{slabs_[slab_index].load(std::memory_order_acquire)};
+
+    if (!slab) [[unlikely]] {
+      slab = AllocateSlab(slab_index);
+      if (!slab) return nullptr;
+    }
+
+    return slab + kHeaderBytes + (index % kSlotsPerSlab) * kSlotBytes;
+  }
+
+  /**
+   * @brief Allocates slab if not allocated yet.
+   * @param slab_index Slab index.
+   * @return Slab or nullptr if out of memory.
+   */
+  [[nodiscard]] std::byte* AllocateSlab(std::size_t slab_index) noexcept {
+    absl::MutexLock lock{&slabs_mutex_};
+
+    std::byte* slab{slabs_[slab_index].load(std::memory_order_relaxed)};
+    if (slab) return slab;
+
+    // Throwing operator new would terminate in noexcept function.
+    slab = static_cast<std::byte*>(::operator new(
+        kSlabBytes, std::align_val_t{kSlabBytes}, std::nothrow));
+    if (!slab) [[unlikely]] {
+      G3LOG(WARNING) << "Unable to allocate " << kSlabBytes
+                     << " bytes for object pool slab " << slab_index << ".";
+      return nullptr;
+    }
+
+    const auto header = static_cast<std::uint32_t>(slab_index);
+    std::memcpy(slab, &header, sizeof(header));
+
+    if (should_poison_) {
+      std::fill_n(slab + kHeaderBytes, kSlabBytes - kHeaderBytes,
+                  kObjectPoolPoison);
+    }
+
+    slabs_[slab_index].store(slab, std::memory_order_release);
+    allocated_slabs_.fetch_add(1, std::memory_order_relaxed);
+
+    return slab;
+  }
+};
+
+}  // namespace wb::base::memory
+
+#endif  // !WB_BASE_MEMORY_OBJECT_POOL_H_
@@ -0,0 +1,186 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Fixed size objects pool.
+
+#include "object_pool.h"
+//
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/tests/g3log_death_utils.h"
+
+namespace {
+
+/**
+ * @brief Pooled object.
+ */
+struct Packet {
+  std::uint64_t id;
+  std::array<std::byte, 40> payload;
+};
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ObjectPoolTest, NewDelete) {
+  using namespace wb::base::memory;
+
+  using Pool = ObjectPool<Packet>;
+  Pool pool{100, false};
+
+  EXPECT_EQ(0U, pool.GetStats().slabs_count);
+
+  std::vector<Packet*> packets;
+  for (std::uint64_t i{0}; i < Pool::kSlotsPerSlab + 1; ++i) {
+    Packet* packet{pool.New(Packet{i, {}})};
+    ASSERT_NE(nullptr, packet);
+    EXPECT_EQ(0U, reinterpret_cast<std::uintptr_t>(packet) % alignof(Packet));
+    packets.push_back(packet);
+  }
+
+  for (std::uint64_t i{0}; i < packets.size(); ++i) {
+    EXPECT_EQ(i, packets[i]->id);
+  }
+
+  ObjectPoolStats stats{pool.GetStats()};
+  EXPECT_EQ(2U, stats.slabs_count);
+  EXPECT_EQ(2 * Pool::kSlotsPerSlab, stats.slots_count);
+  EXPECT_EQ(packets.size(), stats.live_count);
+  EXPECT_EQ(packets.size(), stats.peak_count);
+  EXPECT_GT(stats.GetUtilization(), 0.5);
+
+  // Freed slot is reused first.
+  Packet* last{packets.back()};
+  pool.Delete(last);
+  packets.pop_back();
+  EXPECT_EQ(last, pool.New());
+  pool.Delete(last);
+
+  for (Packet* packet : packets) pool.Delete(packet);
+  pool.Delete(nullptr);
+
+  stats = pool.GetStats();
+  EXPECT_EQ(0U, stats.live_count);
+  EXPECT_EQ(Pool::kSlotsPerSlab + 1, stats.peak_count);
+  EXPECT_EQ(Pool::kSlotsPerSlab + 2, stats.total_allocations);
+  EXPECT_EQ(2U, stats.slabs_count);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ObjectPoolTest, Exhausted) {
+  using namespace wb::base::memory;
+
+  using Pool = ObjectPool<std::uint64_t, 256>;
+  Pool pool{1, false};
+
+  EXPECT_EQ(Pool::kSlotsPerSlab, pool.GetStats().capacity);
+
+  std::vector<std::uint64_t*> values;
+  for (std::size_t i{0}; i < Pool::kSlotsPerSlab; ++i) {
+    values.push_back(pool.New(i));
+    ASSERT_NE(nullptr, values.back());
+  }
+
+  EXPECT_EQ(nullptr, pool.New(0U));
+  EXPECT_DOUBLE_EQ(1.0, pool.GetStats().GetUtilization());
+
+  pool.Delete(values.back());
+  values.pop_back();
+  EXPECT_NE(nullptr, values.emplace_back(pool.New(0U)));
+
+  for (auto* value : values) pool.Delete(value);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ObjectPoolTest, Poison) {
+  using namespace wb::base::memory;
+
+  ObjectPool<Packet> pool{16, true};
+
+  Packet* packet{pool.New()};
+  ASSERT_NE(nullptr, packet);
+  pool.Delete(packet);
+
+  const auto* bytes = reinterpret_cast<const std::byte*>(packet);
+  for (std::size_t i{0}; i < sizeof(Packet); ++i) {
+    ASSERT_EQ(kObjectPoolPoison, bytes[i]) << i;
+  }
+
+  packet = pool.New();
+  ASSERT_NE(nullptr, packet);
+  pool.Delete(packet);
+}
+
+#ifdef GTEST_HAS_DEATH_TEST
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ObjectPoolDeathTest, WriteAfterFreeTriggersTerminate) {
+  using namespace wb::base;
+  using namespace wb::base::memory;
+
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+
+  const auto triggerTerminate = []() {
+    ObjectPool<Packet> pool{16, true};
+
+    Packet* packet{pool.New()};
+    ASSERT_NE(nullptr, packet);
+    pool.Delete(packet);
+
+    // NOLINTNEXTLINE(clang-analyzer-unix.Malloc)
+    packet->id = 42;
+
+    [[maybe_unused]] Packet* reused{pool.New()};
+  };
+
+  const auto test_result = tests_internal::MakeG3LogCheckFailureDeathTestResult(
+      "was written after free");
+
+  EXPECT_EXIT(triggerTerminate(), test_result.exit_predicate,
+              test_result.message);
+}
+#endif
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ObjectPoolTest, Concurrent) {
+  using namespace wb::base::memory;
+
+  constexpr std::uint32_t kThreadsCount{8};
+  constexpr std::uint32_t kObjectsPerThread{256};
+
+  ObjectPool<Packet> pool{kThreadsCount * kObjectsPerThread, true};
+
+  std::vector<std::thread> threads;
+  for (std::uint32_t t{0}; t < kThreadsCount; ++t) {
+    const std::uint64_t first_id{t * kObjectsPerThread};
+
+    threads.emplace_back([&pool, first_id]() {
+      std::vector<Packet*> packets;
+
+      for (int round{0}; round < 50; ++round) {
+        for (std::uint32_t i{0}; i < kObjectsPerThread; ++i) {
+          Packet* packet{pool.New(Packet{first_id + i, {}})};
+          ASSERT_NE(nullptr, packet);
+          packets.push_back(packet);
+        }
+
+        for (std::uint32_t i{0}; i < kObjectsPerThread; ++i) {
+          ASSERT_EQ(first_id + i, packets[i]->id);
+          pool.Delete(packets[i]);
+        }
+
+        packets.clear();
+      }
+    });
+  }
+
+  for (auto& thread : threads) thread.join();
+
+  const ObjectPoolStats stats{pool.GetStats()};
+  EXPECT_EQ(0U, stats.live_count);
+  EXPECT_LE(stats.peak_count, kThreadsCount * kObjectsPerThread);
+  EXPECT_EQ(kThreadsCount * kObjectsPerThread * 50, stats.total_allocations);
+}
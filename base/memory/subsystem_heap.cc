@@ -0,0 +1,371 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Subsystem scoped mimalloc heaps.
+
+#include "subsystem_heap.h"
+
+#include <algorithm>
+#include <new>
+
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/mimalloc/mimalloc.h"
+#include "base/internals/large_pages_arena_internal.h"
+
+namespace {
+
+/**
+ * @brief Mimalloc heap of subsystem owned by thread.
+ */
+struct ThreadHeap {
+  /**
+   * @brief Heap or nullptr if not created yet.
+   */
+  mi_heap_t* heap;
+  /**
+   * @brief Regular heap used when large pages arena of heap is full or
+   * nullptr.
+   */
+  mi_heap_t* overflow_heap;
+  /**
+   * @brief Subsystem heap destructions count when heap was created.
+   */
+  std::size_t destructions_count;
+  /**
+   * @brief Bytes reserved in memory budget, but not allocated yet.
+   */
+  std::size_t budget_credit;
+};
+
+/**
+ * @brief Subsystem heaps of thread.
+ */
+struct ThreadHeaps {
+  ThreadHeaps() noexcept : heaps{} {}
+
+  /**
+   * @brief Deletes heaps on thread exit.  Live blocks migrate to default
+   * heap, so they stay valid.  Stale heaps are destroyed.
+   */
+  ~ThreadHeaps() noexcept;
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ThreadHeaps);
+
+  /**
+   * @brief Heaps by subsystem.
+   */
+  std::array<ThreadHeap, wb::base::memory::kSubsystemsCount> heaps;
+};
+
+/**
+ * @brief Subsystem heaps of current thread.
+ */
+thread_local ThreadHeaps thread_heaps;
+
+/**
+ * @brief Next thread counters shard index.
+ */
+std::atomic_size_t next_counters_shard_index{0};
+
+/**
+ * @brief Counters shard index of current thread.
+ */
+thread_local const std::size_t thread_counters_shard_index{
+    next_counters_shard_index.fetch_add(1, std::memory_order_relaxed)};
+
+/**
+ * @brief Destroys thread heap with all its memory.
+ * @param heap Thread heap.
+ */
+void DestroyThreadHeap(ThreadHeap& heap) noexcept {
+  if (heap.heap) ::mi_heap_destroy(heap.heap);
+  if (heap.overflow_heap) ::mi_heap_destroy(heap.overflow_heap);
+
+  heap.heap = nullptr;
+  heap.overflow_heap = nullptr;
+}
+
+ThreadHeaps::~ThreadHeaps() noexcept {
+  using namespace wb::base::memory;
+
+  for (std::size_t i{0}; i < heaps.size(); ++i) {
+    ThreadHeap& heap{heaps[i]};
+    const auto subsystem = static_cast<Subsystem>(i);
+
+    if (heap.budget_credit != 0) {
+      GetMemoryBudgetTracker().Release(GetSubsystemMemoryCategory(subsystem),
+                                       heap.budget_credit);
+      heap.budget_credit = 0;
+    }
+
+    if (!heap.heap) continue;
+
+    const SubsystemHeapStats stats{GetSubsystemHeap(subsystem).GetStats()};
+    if (stats.destructions_count != heap.destructions_count) {
+      DestroyThreadHeap(heap);
+    } else {
+      ::mi_heap_delete(heap.heap);
+      if (heap.overflow_heap) ::mi_heap_delete(heap.overflow_heap);
+    }
+  }
+}
+
+}  // namespace
+
+namespace wb::base::memory {
+
+[[nodiscard]] WB_BASE_API std::string_view GetSubsystemName(
+    Subsystem subsystem) noexcept {
+  switch (subsystem) {
+    case Subsystem::kIntl:
+      return "intl";
+    case Subsystem::kParsers:
+      return "parsers";
+    case Subsystem::kWorld:
+      return "world";
+    case Subsystem::kAssets:
+      return "assets";
+    case Subsystem::kLogging:
+      return "logging";
+    default:
+      G3DCHECK(false) << "Unknown subsystem "
+                      << underlying_cast(subsystem) << ".";
+      return "unknown";
+  }
+}
+
+[[nodiscard]] WB_BASE_API MemoryCategory
+GetSubsystemMemoryCategory(Subsystem subsystem) noexcept {
+  switch (subsystem) {
+    case Subsystem::kIntl:
+      // Localized strings are shown by UI.
+      return MemoryCategory::kUi;
+    case Subsystem::kParsers:
+      // Parsed key values are scripts data.
+      return MemoryCategory::kScripts;
+    case Subsystem::kWorld:
+      return MemoryCategory::kWorld;
+    case Subsystem::kAssets:
+      // Textures dominate assets memory.
+      return MemoryCategory::kTextures;
+    case Subsystem::kLogging:
+      return MemoryCategory::kLogging;
+    default:
+      G3DCHECK(false) << "Unknown subsystem "
+                      << underlying_cast(subsystem) << ".";
+      return MemoryCategory::kWorld;
+  }
+}
+
+SubsystemHeap::SubsystemHeap(Subsystem subsystem) noexcept
+    : destroyed_bytes_{0},
+      destroyed_usable_bytes_{0},
+      destroyed_allocations_{0},
+      peak_bytes_{0},
+      destructions_count_{0},
+      subsystem_{subsystem},
+      pad_{},
+      shards_{} {}
+
+[[nodiscard]] SubsystemHeapStats SubsystemHeap::GetStats() const noexcept {
+  std::size_t allocated_bytes{0}, deallocated_bytes{0},
+      allocated_usable_bytes{0}, deallocated_usable_bytes{0},
+      allocations_count{0}, deallocations_count{0};
+
+  // Deallocations are summed first and synchronize with allocations before
+  // them, so concurrent allocation and deallocation of the same block never
+  // make live values underflow.
+  for (const CountersShard& shard : shards_) {
+    deallocated_bytes +=
+        shard.deallocated_bytes.load(std::memory_order_relaxed);
+    deallocated_usable_bytes +=
+        shard.deallocated_usable_bytes.load(std::memory_order_relaxed);
+    deallocations_count +=
+        shard.deallocations_count.load(std::memory_order_relaxed);
+  }
+
+  deallocated_bytes += destroyed_bytes_.load(std::memory_order_relaxed);
+  deallocated_usable_bytes +=
+      destroyed_usable_bytes_.load(std::memory_order_relaxed);
+  deallocations_count +=
+      destroyed_allocations_.load(std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  for (const CountersShard& shard : shards_) {
+    allocated_bytes += shard.allocated_bytes.load(std::memory_order_relaxed);
+    allocated_usable_bytes +=
+        shard.allocated_usable_bytes.load(std::memory_order_relaxed);
+    allocations_count +=
+        shard.allocations_count.load(std::memory_order_relaxed);
+  }
+
+  const std::size_t live_bytes{
+      allocated_bytes - std::min(deallocated_bytes, allocated_bytes)};
+
+  std::size_t peak_bytes{peak_bytes_.load(std::memory_order_relaxed)};
+  while (live_bytes > peak_bytes &&
+         !peak_bytes_.compare_exchange_weak(peak_bytes, live_bytes,
+                                            std::memory_order_relaxed)) {
+  }
+
+  return {.live_bytes = live_bytes,
+          .usable_bytes =
+              allocated_usable_bytes -
+              std::min(deallocated_usable_bytes, allocated_usable_bytes),
+          .peak_bytes = std::max(peak_bytes, live_bytes),
+          .live_allocations =
+              allocations_count -
+              std::min(deallocations_count, allocations_count),
+          .total_allocations = allocations_count,
+          .destructions_count =
+              destructions_count_.load(std::memory_order_relaxed)};
+}
+
+void SubsystemHeap::Destroy() noexcept {
+  // Count everything live as freed, so counters stay monotonic.
+  const SubsystemHeapStats stats{GetStats()};
+
+  destroyed_bytes_.fetch_add(stats.live_bytes, std::memory_order_relaxed);
+  destroyed_usable_bytes_.fetch_add(stats.usable_bytes,
+                                    std::memory_order_relaxed);
+  destroyed_allocations_.fetch_add(stats.live_allocations,
+                                   std::memory_order_relaxed);
+  GetMemoryBudgetTracker().Release(GetSubsystemMemoryCategory(subsystem_),
+                                   stats.live_bytes);
+
+  destructions_count_.fetch_add(1, std::memory_order_acq_rel);
+
+  DestroyThreadHeap(thread_heaps.heaps[underlying_cast(subsystem_)]);
+}
+
+void SubsystemHeap::ReserveBudget(std::size_t& budget_credit,
+                                  std::size_t bytes) {
+  const MemoryCategory category{GetSubsystemMemoryCategory(subsystem_)};
+  const std::size_t reserve_bytes{
+      std::max(bytes - budget_credit, kSubsystemHeapBudgetBatchBytes)};
+
+  if (!GetMemoryBudgetTracker().TryReserveWithRetries(category,
+                                                      reserve_bytes)) {
+    G3LOG(WARNING) << "Memory budget " << GetMemoryCategoryName(category)
+                   << " hard limit is exceeded by "
+                   << GetSubsystemName(subsystem_) << " heap " << bytes
+                   << " bytes allocation.";
+    throw std::bad_alloc{};
+  }
+
+  budget_credit += reserve_bytes;
+}
+
+[[nodiscard]] SubsystemHeap::CountersShard&
+SubsystemHeap::GetThreadCountersShard() noexcept {
+  return shards_[thread_counters_shard_index % kCountersShardsCount];
+}
+
+[[nodiscard]] void* SubsystemHeap::do_allocate(std::size_t bytes,
+                                               std::size_t alignment) {
+  ThreadHeap& thread_heap{thread_heaps.heaps[underlying_cast(subsystem_)]};
+  const std::size_t destructions_count{
+      destructions_count_.load(std::memory_order_acquire)};
+
+  if (thread_heap.heap &&
+      thread_heap.destructions_count != destructions_count) [[unlikely]] {
+    // Heap was destroyed, but only owner thread can free its memory.
+    DestroyThreadHeap(thread_heap);
+  }
+
+  if (thread_heap.budget_credit < bytes) [[unlikely]] {
+    ReserveBudget(thread_heap.budget_credit, bytes);
+  }
+
+  if (!thread_heap.heap) [[unlikely]] {
+    // World data is hot, so keep it in large pages arena if any.
+    if (subsystem_ == Subsystem::kWorld) {
+      thread_heap.heap = internals::NewLargePagesArenaHeap();
+    }
+    if (!thread_heap.heap) thread_heap.heap = ::mi_heap_new();
+    thread_heap.destructions_count = destructions_count;
+
+    G3CHECK(thread_heap.heap != nullptr)
+        << "Unable to create " << GetSubsystemName(subsystem_) << " heap.";
+  }
+
+  void* memory{::mi_heap_malloc_aligned(thread_heap.heap, bytes, alignment)};
+  if (!memory) [[unlikely]] {
+    // Large pages arena heap fails when arena is full, so retry in regular
+    // heap.
+    if (!thread_heap.overflow_heap) thread_heap.overflow_heap = ::mi_heap_new();
+    if (thread_heap.overflow_heap) {
+      memory = ::mi_heap_malloc_aligned(thread_heap.overflow_heap, bytes,
+                                        alignment);
+    }
+
+    if (!memory) throw std::bad_alloc{};
+  }
+
+  thread_heap.budget_credit -= bytes;
+
+  CountersShard& shard{GetThreadCountersShard()};
+  shard.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  shard.allocated_usable_bytes.fetch_add(::mi_usable_size(memory),
+                                         std::memory_order_relaxed);
+  shard.allocations_count.fetch_add(1, std::memory_order_relaxed);
+
+  return memory;
+}
+
+void SubsystemHeap::do_deallocate(
+    void* memory, std::size_t bytes,
+    [[maybe_unused]] std::size_t alignment) noexcept {
+  // Keep batch of budget for next allocations, release the rest.
+  ThreadHeap& thread_heap{thread_heaps.heaps[underlying_cast(subsystem_)]};
+  thread_heap.budget_credit += bytes;
+  if (thread_heap.budget_credit > 2 * kSubsystemHeapBudgetBatchBytes)
+      [[unlikely]] {
+    GetMemoryBudgetTracker().Release(
+        GetSubsystemMemoryCategory(subsystem_),
+        thread_heap.budget_credit - kSubsystemHeapBudgetBatchBytes);
+    thread_heap.budget_credit = kSubsystemHeapBudgetBatchBytes;
+  }
+
+  CountersShard& shard{GetThreadCountersShard()};
+  shard.deallocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  shard.deallocated_usable_bytes.fetch_add(::mi_usable_size(memory),
+                                           std::memory_order_relaxed);
+  // Release, so stats reader which sees deallocation sees allocation, too.
+  shard.deallocations_count.fetch_add(1, std::memory_order_release);
+
+  ::mi_free(memory);
+}
+
+[[nodiscard]] WB_BASE_API SubsystemHeap& GetSubsystemHeap(
+    Subsystem subsystem) noexcept {
+  // Never destroyed, as subsystem memory can outlive static destructors.
+  static std::array<SubsystemHeap, kSubsystemsCount>& heaps{
+      // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+      *new std::array<SubsystemHeap, kSubsystemsCount>{
+          SubsystemHeap{Subsystem::kIntl}, SubsystemHeap{Subsystem::kParsers},
+          SubsystemHeap{Subsystem::kWorld}, SubsystemHeap{Subsystem::kAssets},
+          SubsystemHeap{Subsystem::kLogging}}};
+
+  G3DCHECK(underlying_cast(subsystem) < heaps.size());
+  return heaps[underlying_cast(subsystem)];
+}
+
+WB_BASE_API void LogSubsystemHeapsStats() noexcept {
+  for (std::size_t i{0}; i < kSubsystemsCount; ++i) {
+    const auto subsystem = static_cast<Subsystem>(i);
+    const SubsystemHeapStats stats{GetSubsystemHeap(subsystem).GetStats()};
+
+    G3LOG(INFO) << "Heap " << GetSubsystemName(subsystem) << ": "
+                << stats.live_bytes << " live bytes in "
+                << stats.live_allocations << " allocations, "
+                << stats.peak_bytes << " peak bytes, "
+                << stats.GetFragmentation() * 100.0 << "% fragmentation, "
+                << stats.total_allocations << " total allocations, "
+                << stats.destructions_count << " destructions.";
+  }
+}
+
+}  // namespace wb::base::memory
@@ -0,0 +1,265 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Subsystem scoped mimalloc heaps.
+
+#ifndef WB_BASE_MEMORY_SUBSYSTEM_HEAP_H_
+#define WB_BASE_MEMORY_SUBSYSTEM_HEAP_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+
+#include "base/config.h"
+#include "base/macroses.h"
+#include "base/memory/memory_budget.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::memory {
+
+/**
+ * @brief Subsystem which owns heap.
+ */
+enum class Subsystem : std::uint8_t {
+  kIntl,
+  kParsers,
+  kWorld,
+  kAssets,
+  kLogging,
+};
+
+/**
+ * @brief Subsystems count.
+ */
+inline constexpr std::size_t kSubsystemsCount{
+    underlying_cast(Subsystem::kLogging) + 1U};
+
+/**
+ * @brief Gets subsystem name.
+ * @param subsystem Subsystem.
+ * @return Subsystem name.
+ */
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_CONST std::string_view
+GetSubsystemName(Subsystem subsystem) noexcept;
+
+/**
+ * @brief Gets memory category subsystem heap allocations are accounted in.
+ * @param subsystem Subsystem.
+ * @return Memory category.
+ */
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_CONST MemoryCategory
+GetSubsystemMemoryCategory(Subsystem subsystem) noexcept;
+
+/**
+ * @brief Subsystem heap budget is reserved by threads in batches of this
+ * size, so allocations rarely touch shared budget counter.
+ */
+inline constexpr std::size_t kSubsystemHeapBudgetBatchBytes{64 * 1024};
+
+/**
+ * @brief Subsystem heap statistics.
+ */
+struct SubsystemHeapStats {
+  /**
+   * @brief Live bytes requested by subsystem.
+   */
+  std::size_t live_bytes;
+  /**
+   * @brief Live bytes actually reserved by heap for requests, includes size
+   * class rounding.
+   */
+  std::size_t usable_bytes;
+  /**
+   * @brief Max live bytes requested by subsystem, as seen by statistics reads
+   * and heap destructions.
+   */
+  std::size_t peak_bytes;
+  /**
+   * @brief Live allocations count.
+   */
+  std::size_t live_allocations;
+  /**
+   * @brief Total allocations count.
+   */
+  std::size_t total_allocations;
+  /**
+   * @brief Heap destructions count.
+   */
+  std::size_t destructions_count;
+
+  /**
+   * @brief Share of usable bytes lost to size class rounding, [0, 1].
+   */
+  [[nodiscard]] double GetFragmentation() const noexcept {
+    return usable_bytes != 0
+               ? 1.0 - static_cast<double>(live_bytes) /
+                           static_cast<double>(usable_bytes)
+               : 0.0;
+  }
+};
+
+/**
+ * @brief Memory resource over mimalloc heaps of one subsystem.  Mimalloc heap
+ * can allocate only on thread created it, so each thread gets own heap of
+ * subsystem on first allocation.  Memory can be deallocated on any thread.
+ * World heaps are placed in large pages arena when it is reserved.
+ *
+ * Allocations are accounted in memory budget of subsystem category, see
+ * GetSubsystemMemoryCategory.  Allocation which would cross category hard
+ * limit fails with std::bad_alloc.
+ *
+ * Destroy() frees all subsystem memory at once, ex. on level unload, without
+ * walking every allocation.
+ */
+class WB_BASE_API SubsystemHeap : public std::pmr::memory_resource {
+ public:
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(SubsystemHeap);
+
+  /**
+   * @brief Gets subsystem.
+   */
+  [[nodiscard]] Subsystem GetSubsystem() const noexcept { return subsystem_; }
+
+  /**
+   * @brief Gets heap statistics.  Sums counters shards, so is slower than
+   * allocation.  Can be called concurrently with allocations.
+   */
+  [[nodiscard]] SubsystemHeapStats GetStats() const noexcept;
+
+  /**
+   * @brief Frees all memory allocated from heap.  Memory must not be used or
+   * deallocated after.  Heap of calling thread is destroyed immediately, heaps
+   * of other threads are destroyed by their threads on next allocation.
+   */
+  void Destroy() noexcept;
+
+ private:
+  friend WB_BASE_API SubsystemHeap& GetSubsystemHeap(
+      Subsystem subsystem) noexcept;
+
+  /**
+   * @brief Allocation counters of some threads.  Counters only grow, so live
+   * values are differences of sums over shards and never underflow.
+   */
+  struct alignas(64) CountersShard {
+    /**
+     * @brief Allocated bytes requested.
+     */
+    std::atomic_size_t allocated_bytes;
+    /**
+     * @brief Deallocated bytes requested.
+     */
+    std::atomic_size_t deallocated_bytes;
+    /**
+     * @brief Allocated usable bytes.
+     */
+    std::atomic_size_t allocated_usable_bytes;
+    /**
+     * @brief Deallocated usable bytes.
+     */
+    std::atomic_size_t deallocated_usable_bytes;
+    /**
+     * @brief Allocations count.
+     */
+    std::atomic_size_t allocations_count;
+    /**
+     * @brief Deallocations count.
+     */
+    std::atomic_size_t deallocations_count;
+
+    WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 16> pad_;
+  };
+
+  /**
+   * @brief Counters shards count.  Threads are spread over shards, so
+   * allocating threads rarely share cache line.
+   */
+  static constexpr std::size_t kCountersShardsCount{16};
+
+  /**
+   * @brief Live bytes requested freed by destructions.
+   */
+  std::atomic_size_t destroyed_bytes_;
+  /**
+   * @brief Live usable bytes freed by destructions.
+   */
+  std::atomic_size_t destroyed_usable_bytes_;
+  /**
+   * @brief Live allocations freed by destructions.
+   */
+  std::atomic_size_t destroyed_allocations_;
+  /**
+   * @brief Max live bytes requested seen.
+   */
+  mutable std::atomic_size_t peak_bytes_;
+  /**
+   * @brief Destructions count.  Thread heaps created before last destruction
+   * are stale.
+   */
+  std::atomic_size_t destructions_count_;
+  /**
+   * @brief Subsystem.
+   */
+  const Subsystem subsystem_;
+
+  WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 15> pad_;
+
+  /**
+   * @brief Allocation counters, cache line each.
+   */
+  std::array<CountersShard, kCountersShardsCount> shards_;
+
+  /**
+   * @brief Creates subsystem heap.  One per subsystem, as thread heaps are
+   * indexed by subsystem.
+   * @param subsystem Subsystem.
+   */
+  explicit SubsystemHeap(Subsystem subsystem) noexcept;
+
+  /**
+   * @brief Reserves memory budget for allocation of |bytes| into thread
+   * budget credit.  Throws std::bad_alloc when category hard limit would be
+   * crossed.
+   * @param budget_credit Thread budget credit.
+   * @param bytes Allocation bytes count.
+   */
+  void ReserveBudget(std::size_t& budget_credit, std::size_t bytes);
+
+  /**
+   * @brief Gets counters shard of current thread.
+   * @return Counters shard.
+   */
+  [[nodiscard]] CountersShard& GetThreadCountersShard() noexcept;
+
+  [[nodiscard]] void* do_allocate(std::size_t bytes,
+                                  std::size_t alignment) override;
+
+  void do_deallocate(void* memory, std::size_t bytes,
+                     std::size_t alignment) noexcept override;
+
+  [[nodiscard]] bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+/**
+ * @brief Gets heap of |subsystem|.
+ * @param subsystem Subsystem.
+ * @return Subsystem heap.
+ */
+[[nodiscard]] WB_BASE_API SubsystemHeap& GetSubsystemHeap(
+    Subsystem subsystem) noexcept;
+
+/**
+ * @brief Logs statistics of all subsystem heaps.
+ */
+WB_BASE_API void LogSubsystemHeapsStats() noexcept;
+
+}  // namespace wb::base::memory
+
+#endif  // !WB_BASE_MEMORY_SUBSYSTEM_HEAP_H_
@@ -0,0 +1,179 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Subsystem scoped mimalloc heaps.
+
+#include "subsystem_heap.h"
+//
+#include <thread>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SubsystemHeapTest, GetSubsystemHeap) {
+  using namespace wb::base::memory;
+
+  for (std::size_t i{0}; i < kSubsystemsCount; ++i) {
+    const auto subsystem = static_cast<Subsystem>(i);
+    SubsystemHeap& heap{GetSubsystemHeap(subsystem)};
+
+    EXPECT_EQ(subsystem, heap.GetSubsystem());
+    EXPECT_EQ(&heap, &GetSubsystemHeap(subsystem));
+    EXPECT_FALSE(GetSubsystemName(subsystem).empty());
+  }
+
+  EXPECT_EQ("world", GetSubsystemName(Subsystem::kWorld));
+  EXPECT_TRUE(GetSubsystemHeap(Subsystem::kWorld)
+                  .is_equal(GetSubsystemHeap(Subsystem::kWorld)));
+  EXPECT_FALSE(GetSubsystemHeap(Subsystem::kWorld)
+                   .is_equal(GetSubsystemHeap(Subsystem::kIntl)));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SubsystemHeapTest, TracksUsage) {
+  using namespace wb::base::memory;
+
+  SubsystemHeap& heap{GetSubsystemHeap(Subsystem::kAssets)};
+  const SubsystemHeapStats initial{heap.GetStats()};
+
+  {
+    std::pmr::vector<int> values{&heap};
+    values.resize(100);
+
+    const SubsystemHeapStats stats{heap.GetStats()};
+    EXPECT_EQ(initial.live_bytes + 100 * sizeof(int), stats.live_bytes);
+    EXPECT_EQ(initial.live_allocations + 1, stats.live_allocations);
+    EXPECT_EQ(initial.total_allocations + 1, stats.total_allocations);
+    EXPECT_GE(stats.peak_bytes, stats.live_bytes);
+    EXPECT_GE(stats.GetFragmentation(), 0.0);
+    EXPECT_LE(stats.GetFragmentation(), 1.0);
+  }
+
+  const SubsystemHeapStats stats{heap.GetStats()};
+  EXPECT_EQ(initial.live_bytes, stats.live_bytes);
+  EXPECT_EQ(initial.usable_bytes, stats.usable_bytes);
+  EXPECT_EQ(initial.live_allocations, stats.live_allocations);
+  EXPECT_EQ(initial.total_allocations + 1, stats.total_allocations);
+  EXPECT_GE(stats.peak_bytes, 100 * sizeof(int));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SubsystemHeapTest, CrossThreadDeallocate) {
+  using namespace wb::base::memory;
+
+  SubsystemHeap& heap{GetSubsystemHeap(Subsystem::kParsers)};
+  const std::size_t live_bytes{heap.GetStats().live_bytes};
+
+  void* memory{nullptr};
+  std::thread thread{[&heap, &memory]() { memory = heap.allocate(64, 16); }};
+  thread.join();
+
+  ASSERT_NE(nullptr, memory);
+  EXPECT_EQ(live_bytes + 64U, heap.GetStats().live_bytes);
+
+  heap.deallocate(memory, 64, 16);
+  EXPECT_EQ(live_bytes, heap.GetStats().live_bytes);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SubsystemHeapTest, Destroy) {
+  using namespace wb::base::memory;
+
+  SubsystemHeap& heap{GetSubsystemHeap(Subsystem::kLogging)};
+  heap.Destroy();
+
+  const SubsystemHeapStats initial{heap.GetStats()};
+
+  for (int i{0}; i < 100; ++i) {
+    (void)heap.allocate(256, alignof(std::max_align_t));
+  }
+  EXPECT_EQ(100U * 256U, heap.GetStats().live_bytes);
+
+  heap.Destroy();
+
+  SubsystemHeapStats stats{heap.GetStats()};
+  EXPECT_EQ(0U, stats.live_bytes);
+  EXPECT_EQ(0U, stats.live_allocations);
+  EXPECT_GE(stats.peak_bytes, 100U * 256U);
+  EXPECT_EQ(initial.destructions_count + 1, stats.destructions_count);
+
+  // Heap is usable after destruction.
+  void* memory{heap.allocate(8, 8)};
+  ASSERT_NE(nullptr, memory);
+  heap.deallocate(memory, 8, 8);
+
+  stats = heap.GetStats();
+  EXPECT_EQ(0U, stats.live_bytes);
+  EXPECT_EQ(initial.total_allocations + 101U, stats.total_allocations);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SubsystemHeapTest, CountersSumOverThreads) {
+  using namespace wb::base::memory;
+
+  SubsystemHeap& heap{GetSubsystemHeap(Subsystem::kIntl)};
+  const SubsystemHeapStats initial{heap.GetStats()};
+
+  constexpr std::size_t kThreadsCount{4}, kAllocationsCount{100};
+
+  std::vector<std::vector<void*>> memories(kThreadsCount);
+  std::vector<std::thread> threads;
+  for (auto& thread_memories : memories) {
+    threads.emplace_back([&heap, &thread_memories]() {
+      for (std::size_t i{0}; i < kAllocationsCount; ++i) {
+        thread_memories.push_back(heap.allocate(32, 8));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  SubsystemHeapStats stats{heap.GetStats()};
+  EXPECT_EQ(initial.live_bytes + kThreadsCount * kAllocationsCount * 32U,
+            stats.live_bytes);
+  EXPECT_EQ(initial.live_allocations + kThreadsCount * kAllocationsCount,
+            stats.live_allocations);
+
+  // Deallocated on other thread shard.
+  for (auto& thread_memories : memories) {
+    for (void* memory : thread_memories) heap.deallocate(memory, 32, 8);
+  }
+
+  stats = heap.GetStats();
+  EXPECT_EQ(initial.live_bytes, stats.live_bytes);
+  EXPECT_EQ(initial.usable_bytes, stats.usable_bytes);
+  EXPECT_EQ(initial.live_allocations, stats.live_allocations);
+  EXPECT_EQ(initial.total_allocations + kThreadsCount * kAllocationsCount,
+            stats.total_allocations);
+  EXPECT_GE(stats.peak_bytes, kThreadsCount * kAllocationsCount * 32U);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SubsystemHeapTest, AccountedInMemoryBudget) {
+  using namespace wb::base::memory;
+
+  EXPECT_EQ(MemoryCategory::kWorld,
+            GetSubsystemMemoryCategory(Subsystem::kWorld));
+
+  MemoryBudgetTracker& tracker{GetMemoryBudgetTracker()};
+  SubsystemHeap& heap{GetSubsystemHeap(Subsystem::kAssets)};
+  const MemoryCategory category{
+      GetSubsystemMemoryCategory(heap.GetSubsystem())};
+
+  constexpr std::size_t kBytes{1U << 20U};
+  void* memory{heap.allocate(kBytes, 16)};
+  ASSERT_NE(nullptr, memory);
+
+  const std::size_t current_bytes{tracker.GetUsage(category).current_bytes};
+  EXPECT_GE(current_bytes, kBytes);
+
+  // Budget can't fit second allocation.
+  tracker.SetBudget(category, {.soft_limit = 0, .hard_limit = current_bytes});
+  EXPECT_THROW((void)heap.allocate(2 * kBytes, 16), std::bad_alloc);
+  tracker.SetBudget(category, {.soft_limit = 0, .hard_limit = 0});
+
+  heap.deallocate(memory, kBytes, 16);
+  EXPECT_LE(tracker.GetUsage(category).current_bytes,
+            current_bytes - kBytes + 2 * kSubsystemHeapBudgetBatchBytes);
+}
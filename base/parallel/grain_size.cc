@@ -0,0 +1,59 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Adaptive grain size of parallel algorithms.
+
+#include "grain_size.h"
+
+#include <algorithm>
+
+namespace wb::base::parallel {
+
+[[nodiscard]] std::size_t GrainSize::Get(
+    std::size_t items_count, std::size_t workers_count) const noexcept {
+  if (fixed_items_per_chunk_ != 0) return fixed_items_per_chunk_;
+
+  const std::uint64_t item_cost_ps{GetItemCostPs()};
+
+  if (item_cost_ps == 0) {
+    // Few chunks per worker balance load until cost is known.
+    const std::size_t chunks_count{std::max(workers_count, std::size_t{1}) *
+                                   8U};
+    return std::max(kInitialGrainSize, items_count / chunks_count);
+  }
+
+  constexpr std::uint64_t kTargetChunkTimePs{
+      static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              kTargetChunkTime)
+              .count()) *
+      1000U};
+
+  return static_cast<std::size_t>(
+      std::max(kTargetChunkTimePs / item_cost_ps, std::uint64_t{1}));
+}
+
+void GrainSize::Measure(std::size_t items_count,
+                        HighResolutionClockDuration run_time) noexcept {
+  if (items_count == 0 || fixed_items_per_chunk_ != 0) return;
+
+  const auto run_time_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(run_time).count();
+  // Too cheap to measure items still cost something.
+  const std::uint64_t sample_ps{std::max(
+      static_cast<std::uint64_t>(std::max(run_time_ns, std::int64_t{0})) *
+          1000U / items_count,
+      std::uint64_t{1})};
+
+  std::uint64_t item_cost_ps{item_cost_ps_.load(std::memory_order_relaxed)};
+  std::uint64_t new_item_cost_ps;
+  do {
+    // Smooth noise (preemption, cache misses) of single runs.
+    new_item_cost_ps =
+        item_cost_ps != 0 ? (item_cost_ps * 3U + sample_ps) / 4U : sample_ps;
+  } while (!item_cost_ps_.compare_exchange_weak(
+      item_cost_ps, new_item_cost_ps, std::memory_order_relaxed));
+}
+
+}  // namespace wb::base::parallel
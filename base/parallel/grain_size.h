@@ -0,0 +1,108 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Adaptive grain size of parallel algorithms.
+
+#ifndef WB_BASE_PARALLEL_GRAIN_SIZE_H_
+#define WB_BASE_PARALLEL_GRAIN_SIZE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "base/config.h"
+#include "base/high_resolution_clock.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::parallel {
+
+/**
+ * @brief Chunk run time grain size targets.  Long enough to amortize marl
+ * scheduling and wake up cost, short enough to balance load across workers.
+ */
+inline constexpr std::chrono::microseconds kTargetChunkTime{50};
+
+/**
+ * @brief Grain size when per item cost is not measured yet.
+ */
+inline constexpr std::size_t kInitialGrainSize{64};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Items per chunk adapted from measured per item cost, so chunks run
+   * about kTargetChunkTime, or fixed one.  Thread-safe.
+   */
+  class WB_BASE_API GrainSize {
+   public:
+    GrainSize() noexcept = default;
+    ~GrainSize() noexcept = default;
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(GrainSize);
+
+    /**
+     * @brief Creates grain size which does not adapt, ex. when items differ in
+     * cost a lot, so measured average is meaningless.
+     * @param items_per_chunk Items per chunk, at least 1.
+     * @return Fixed grain size.
+     */
+    [[nodiscard]] static GrainSize Fixed(std::size_t items_per_chunk) noexcept {
+      return GrainSize{std::max(items_per_chunk, std::size_t{1})};
+    }
+
+    /**
+     * @brief Gets items per chunk.
+     * @param items_count Items count.
+     * @param workers_count Workers count.
+     * @return Items per chunk, at least 1.  |items_count| or more means run
+     * serially.
+     */
+    [[nodiscard]] std::size_t Get(std::size_t items_count,
+                                  std::size_t workers_count) const noexcept;
+
+    /**
+     * @brief Adds per item cost sample.  Ignored by fixed grain size.
+     * @param items_count Processed items count.
+     * @param run_time Total run time of processed items.
+     */
+    void Measure(std::size_t items_count,
+                 HighResolutionClockDuration run_time) noexcept;
+
+    /**
+     * @brief Gets average per item cost.
+     * @return Per item cost in picoseconds, 0 when not measured yet.
+     */
+    [[nodiscard]] std::uint64_t GetItemCostPs() const noexcept {
+      return item_cost_ps_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /**
+     * @brief Exponential moving average of per item cost in picoseconds.  0
+     * when not measured yet.
+     */
+    std::atomic_uint64_t item_cost_ps_{0};
+    /**
+     * @brief Fixed items per chunk.  0 when adapted from item cost.
+     */
+    const std::size_t fixed_items_per_chunk_{0};
+
+    /**
+     * @brief Creates fixed grain size.
+     * @param fixed_items_per_chunk Items per chunk.
+     */
+    explicit GrainSize(std::size_t fixed_items_per_chunk) noexcept
+        : fixed_items_per_chunk_{fixed_items_per_chunk} {}
+  };
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+}  // namespace wb::base::parallel
+
+#endif  // !WB_BASE_PARALLEL_GRAIN_SIZE_H_
@@ -0,0 +1,81 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Adaptive grain size of parallel algorithms.
+
+#include "grain_size.h"
+//
+#include "base/deps/googletest/gtest/gtest.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(GrainSizeTest, InitialGrainSize) {
+  using namespace wb::base::parallel;
+
+  const GrainSize grain_size;
+
+  EXPECT_EQ(0U, grain_size.GetItemCostPs());
+  EXPECT_EQ(kInitialGrainSize, grain_size.Get(10, 4));
+  EXPECT_EQ(kInitialGrainSize, grain_size.Get(1000, 4));
+  // 8 chunks per worker.
+  EXPECT_EQ(1000U, grain_size.Get(32000, 4));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(GrainSizeTest, AdaptsToItemCost) {
+  using namespace wb::base::parallel;
+  using namespace std::chrono_literals;
+
+  GrainSize grain_size;
+
+  // 1us per item.
+  grain_size.Measure(100, 100us);
+  EXPECT_EQ(1'000'000U, grain_size.GetItemCostPs());
+  EXPECT_EQ(50U, grain_size.Get(1000, 4));
+
+  // Smoothed towards 5us per item.
+  grain_size.Measure(100, 500us);
+  EXPECT_EQ(2'000'000U, grain_size.GetItemCostPs());
+  EXPECT_EQ(25U, grain_size.Get(1000, 4));
+
+  // Very expensive items go one per chunk.
+  grain_size.Measure(1, 1s);
+  EXPECT_EQ(1U, grain_size.Get(1000, 4));
+
+  // Nothing measured.
+  const std::uint64_t item_cost_ps{grain_size.GetItemCostPs()};
+  grain_size.Measure(0, 1s);
+  EXPECT_EQ(item_cost_ps, grain_size.GetItemCostPs());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(GrainSizeTest, CheapItems) {
+  using namespace wb::base::parallel;
+  using namespace std::chrono_literals;
+
+  GrainSize grain_size;
+
+  // Too fast to measure.
+  grain_size.Measure(1000, 0ns);
+  EXPECT_EQ(1U, grain_size.GetItemCostPs());
+  EXPECT_EQ(50'000'000U, grain_size.Get(1000, 4));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(GrainSizeTest, Fixed) {
+  using namespace wb::base::parallel;
+  using namespace std::chrono_literals;
+
+  GrainSize grain_size{GrainSize::Fixed(3)};
+
+  EXPECT_EQ(3U, grain_size.Get(10, 4));
+  EXPECT_EQ(3U, grain_size.Get(32000, 4));
+
+  // Does not adapt.
+  grain_size.Measure(100, 100us);
+  EXPECT_EQ(0U, grain_size.GetItemCostPs());
+  EXPECT_EQ(3U, grain_size.Get(1000, 4));
+
+  // At least one item per chunk.
+  EXPECT_EQ(1U, GrainSize::Fixed(0).Get(1000, 4));
+}
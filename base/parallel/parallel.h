@@ -0,0 +1,394 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Parallel algorithms over the process-wide marl scheduler.
+
+#ifndef WB_BASE_PARALLEL_PARALLEL_H_
+#define WB_BASE_PARALLEL_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base/deps/marl/scheduler.h"
+#include "base/deps/marl/waitgroup.h"
+#include "base/high_resolution_clock.h"
+#include "base/parallel/grain_size.h"
+#include "base/task_lanes.h"
+
+namespace wb::base::parallel {
+
+namespace internal {
+
+/**
+ * @brief Items split into chunks.
+ */
+struct Chunks {
+  /**
+   * @brief Items per chunk.  Last chunk may have less.
+   */
+  std::size_t size;
+  /**
+   * @brief Chunks count.
+   */
+  std::size_t count;
+};
+
+/**
+ * @brief Gets workers count of the marl scheduler bound to the thread.
+ * @return Workers count, 0 when no scheduler is bound.
+ */
+[[nodiscard]] inline std::size_t GetWorkersCount() noexcept {
+  const ::marl::Scheduler* scheduler{::marl::Scheduler::get()};
+  return scheduler ? static_cast<std::size_t>(
+                         std::max(scheduler->config().workerThread.count, 0))
+                   : 0U;
+}
+
+/**
+ * @brief Gets grain size of call site.  Lambdas have unique types, so each
+ * call site adapts to own per item cost.
+ * @tparam Ts Call site types.
+ * @return Grain size.
+ */
+template <typename... Ts>
+[[nodiscard]] GrainSize& GetCallSiteGrainSize() noexcept {
+  static GrainSize grain_size;
+  return grain_size;
+}
+
+/**
+ * @brief Splits items into chunks.  Single chunk means run serially.
+ * @param items_count Items count.
+ * @param workers_count Workers count.
+ * @param grain_size Grain size.
+ * @return Chunks.
+ */
+[[nodiscard]] inline Chunks SplitIntoChunks(
+    std::size_t items_count, std::size_t workers_count,
+    const GrainSize& grain_size) noexcept {
+  if (items_count == 0) return {.size = 1, .count = 0};
+  if (workers_count == 0) return {.size = items_count, .count = 1};
+
+  const std::size_t size{
+      std::min(grain_size.Get(items_count, workers_count), items_count)};
+  return {.size = size, .count = (items_count + size - 1) / size};
+}
+
+/**
+ * @brief Runs |chunk_fn| for each chunk on calling thread and up to
+ * |workers_count| marl workers, which pick chunks one by one.  Blocks till all
+ * chunks are processed, but not till all helper tasks run: calling thread
+ * processes chunks itself when helpers do not get worker share, ex. in nested
+ * call on lane limited to one worker.
+ * @tparam ChunkFn (begin, end, chunk index) function.
+ * @param chunks Chunks.
+ * @param items_count Items count.
+ * @param workers_count Workers count.
+ * @param priority Priority of worker tasks.
+ * @param chunk_fn Thread-safe chunk function.
+ * @return Total run time of all chunks.
+ */
+template <typename ChunkFn>
+HighResolutionClockDuration RunChunks(Chunks chunks, std::size_t items_count,
+                                      std::size_t workers_count,
+                                      TaskPriority priority,
+                                      ChunkFn&& chunk_fn) {
+  /**
+   * @brief Chunks loop state.  Shared, as helpers may start after caller
+   * returned.
+   */
+  struct State {
+    std::atomic_size_t next_chunk{0};
+    std::atomic<HighResolutionClockDuration::rep> run_time_ticks{0};
+  };
+
+  const auto state = std::make_shared<State>();
+  const ::marl::WaitGroup chunks_done{static_cast<unsigned>(chunks.count)};
+
+  // Late helper takes no chunk, so never touches |chunk_fn| of returned
+  // caller.
+  const auto run = [chunks, items_count, state, chunks_done,
+                    fn = &chunk_fn]() {
+    std::size_t chunk;
+    while ((chunk = state->next_chunk.fetch_add(
+                1, std::memory_order_relaxed)) < chunks.count) {
+      const auto start_time = HighResolutionClock::now();
+
+      const std::size_t begin{chunk * chunks.size};
+      (*fn)(begin, std::min(begin + chunks.size, items_count), chunk);
+
+      state->run_time_ticks.fetch_add(
+          (HighResolutionClock::now() - start_time).count(),
+          std::memory_order_relaxed);
+      chunks_done.done();
+    }
+  };
+
+  // Calling thread takes chunks, too.
+  const std::size_t helpers_count{
+      chunks.count > 1 ? std::min(chunks.count - 1, workers_count) : 0U};
+  for (std::size_t i{0}; i < helpers_count; ++i) {
+    ScheduleTask(priority, run);
+  }
+
+  run();
+  chunks_done.wait();
+
+  return HighResolutionClockDuration{
+      state->run_time_ticks.load(std::memory_order_relaxed)};
+}
+
+}  // namespace internal
+
+/**
+ * @brief Calls |fn| for each element of |range| on the process-wide marl
+ * scheduler.  Small ranges and calls without bound scheduler run serially.
+ * Use std::views::iota for index loops.  Blocks till all elements are
+ * processed.
+ *
+ * Chunks run as |priority| tasks, see TaskLanes.  Frame work should use frame
+ * critical priority, loading and tools normal or background one.
+ * @tparam Range Random access range.
+ * @tparam Fn Element function.
+ * @param range Range.
+ * @param fn Thread-safe element function.
+ * @param grain_size Grain size.  Call site one by default.
+ * @param priority Priority of chunk tasks.
+ */
+template <std::ranges::random_access_range Range, typename Fn>
+  requires std::ranges::sized_range<Range>
+void ParallelFor(Range&& range, Fn&& fn,
+                 GrainSize& grain_size = internal::GetCallSiteGrainSize<
+                     std::remove_cvref_t<Range>, std::remove_cvref_t<Fn>>(),
+                 TaskPriority priority = TaskPriority::kNormal) {
+  using Difference = std::ranges::range_difference_t<Range>;
+
+  const auto first = std::ranges::begin(range);
+  const auto items_count = static_cast<std::size_t>(std::ranges::size(range));
+  const std::size_t workers_count{internal::GetWorkersCount()};
+  const internal::Chunks chunks{
+      internal::SplitIntoChunks(items_count, workers_count, grain_size)};
+
+  grain_size.Measure(
+      items_count,
+      internal::RunChunks(chunks, items_count, workers_count, priority,
+                          [&](std::size_t begin, std::size_t end, std::size_t) {
+                            for (std::size_t i{begin}; i < end; ++i) {
+                              fn(first[static_cast<Difference>(i)]);
+                            }
+                          }));
+}
+
+/**
+ * @brief Reduces transformed elements of |range| with |reduce| on the
+ * process-wide marl scheduler.  Chunk results are reduced in range order, so
+ * |reduce| should be associative, but may be not commutative.  Small ranges and
+ * calls without bound scheduler run serially.
+ *
+ * Chunks run as |priority| tasks, see TaskLanes.  Frame work should use frame
+ * critical priority, loading and tools normal or background one.
+ * @tparam Range Random access range.
+ * @tparam T Result.
+ * @tparam Reduce (T, T) -> T function.
+ * @tparam Transform (element) -> T function.
+ * @param range Range.
+ * @param identity Identity element of |reduce|, ex. 0 for sum.
+ * @param reduce Thread-safe reduce function.
+ * @param transform Thread-safe transform function.
+ * @param grain_size Grain size.  Call site one by default.
+ * @param priority Priority of chunk tasks.
+ * @return Reduced value.  |identity| for empty range.
+ */
+template <std::ranges::random_access_range Range, typename T, typename Reduce,
+          typename Transform = std::identity>
+  requires std::ranges::sized_range<Range>
+[[nodiscard]] T ParallelReduce(
+    Range&& range, T identity, Reduce reduce, Transform transform = {},
+    GrainSize& grain_size = internal::GetCallSiteGrainSize<
+        std::remove_cvref_t<Range>, T, Reduce, Transform>(),
+    TaskPriority priority = TaskPriority::kNormal) {
+  using Difference = std::ranges::range_difference_t<Range>;
+
+  const auto first = std::ranges::begin(range);
+  const auto items_count = static_cast<std::size_t>(std::ranges::size(range));
+  const std::size_t workers_count{internal::GetWorkersCount()};
+  const internal::Chunks chunks{
+      internal::SplitIntoChunks(items_count, workers_count, grain_size)};
+
+  std::vector<T> chunk_results(chunks.count, identity);
+
+  grain_size.Measure(
+      items_count,
+      internal::RunChunks(
+          chunks, items_count, workers_count, priority,
+          [&](std::size_t begin, std::size_t end, std::size_t chunk) {
+            T result{identity};
+            for (std::size_t i{begin}; i < end; ++i) {
+              result = reduce(std::move(result),
+                              transform(first[static_cast<Difference>(i)]));
+            }
+            chunk_results[chunk] = std::move(result);
+          }));
+
+  T result{std::move(identity)};
+  for (T& chunk_result : chunk_results) {
+    result = reduce(std::move(result), std::move(chunk_result));
+  }
+  return result;
+}
+
+/**
+ * @brief Sorts |range| on the process-wide marl scheduler: chunks are sorted in
+ * parallel, then merged pairwise in parallel rounds.  Not stable.  Small
+ * ranges and calls without bound scheduler are sorted serially.
+ *
+ * Chunks run as |priority| tasks, see TaskLanes.  Frame work should use frame
+ * critical priority, loading and tools normal or background one.
+ * @tparam Range Random access range.
+ * @tparam Compare Comparator.
+ * @tparam Projection Projection.
+ * @param range Range.
+ * @param compare Thread-safe comparator.
+ * @param projection Thread-safe projection.
+ * @param grain_size Grain size.  Call site one by default.
+ * @param priority Priority of chunk tasks.
+ */
+template <std::ranges::random_access_range Range,
+          typename Compare = std::ranges::less,
+          typename Projection = std::identity>
+  requires std::ranges::sized_range<Range> &&
+           std::sortable<std::ranges::iterator_t<Range>, Compare, Projection>
+void ParallelSort(Range&& range, Compare compare = {},
+                  Projection projection = {},
+                  GrainSize& grain_size = internal::GetCallSiteGrainSize<
+                      std::remove_cvref_t<Range>, Compare, Projection>(),
+                  TaskPriority priority = TaskPriority::kNormal) {
+  using Difference = std::ranges::range_difference_t<Range>;
+
+  const auto first = std::ranges::begin(range);
+  const auto items_count = static_cast<std::size_t>(std::ranges::size(range));
+  const std::size_t workers_count{internal::GetWorkersCount()};
+  const internal::Chunks chunks{
+      internal::SplitIntoChunks(items_count, workers_count, grain_size)};
+
+  const auto at = [&](std::size_t i) noexcept {
+    return first + static_cast<Difference>(i);
+  };
+
+  grain_size.Measure(
+      items_count,
+      internal::RunChunks(
+          chunks, items_count, workers_count, priority,
+          [&](std::size_t begin, std::size_t end, std::size_t) {
+            std::ranges::sort(at(begin), at(end), compare, projection);
+          }));
+
+  // Each round merges pairs of sorted runs into runs twice longer.
+  for (std::size_t run_size{chunks.size}; run_size < items_count;
+       run_size *= 2U) {
+    const std::size_t pairs_count{(items_count + 2U * run_size - 1) /
+                                  (2U * run_size)};
+
+    (void)internal::RunChunks(
+        {.size = 1, .count = pairs_count}, pairs_count, workers_count,
+        priority, [&](std::size_t pair, std::size_t, std::size_t) {
+          const std::size_t begin{pair * 2U * run_size};
+          const std::size_t middle{std::min(begin + run_size, items_count)};
+          const std::size_t end{std::min(middle + run_size, items_count)};
+
+          std::ranges::inplace_merge(at(begin), at(middle), at(end), compare,
+                                     projection);
+        });
+  }
+}
+
+/**
+ * @brief Inclusive scan (prefix sums) of |in| into |out| on the process-wide
+ * marl scheduler: chunk totals are reduced in parallel, scanned serially, then
+ * chunks are scanned in parallel from their offsets.  |out| may be |in| for in
+ * place scan.  Small ranges and calls without bound scheduler run serially.
+ *
+ * Chunks run as |priority| tasks, see TaskLanes.  Frame work should use frame
+ * critical priority, loading and tools normal or background one.
+ * @tparam InRange Random access input range.
+ * @tparam OutRange Random access output range.
+ * @tparam T Result.
+ * @tparam Scan (T, element) -> T and (T, T) -> T function.
+ * @param in Input range.
+ * @param out Output range.  Should have at least |in| size.
+ * @param identity Identity element of |scan|, ex. 0 for sum.
+ * @param scan Thread-safe associative scan function.
+ * @param grain_size Grain size.  Call site one by default.
+ * @param priority Priority of chunk tasks.
+ */
+template <std::ranges::random_access_range InRange,
+          std::ranges::random_access_range OutRange, typename T, typename Scan>
+  requires std::ranges::sized_range<InRange> &&
+           std::ranges::sized_range<OutRange>
+void ParallelScan(InRange&& in, OutRange&& out, T identity, Scan scan,
+                  GrainSize& grain_size = internal::GetCallSiteGrainSize<
+                      std::remove_cvref_t<InRange>,
+                      std::remove_cvref_t<OutRange>, T, Scan>(),
+                  TaskPriority priority = TaskPriority::kNormal) {
+  using InDifference = std::ranges::range_difference_t<InRange>;
+  using OutDifference = std::ranges::range_difference_t<OutRange>;
+
+  const auto in_first = std::ranges::begin(in);
+  const auto out_first = std::ranges::begin(out);
+  const auto items_count = static_cast<std::size_t>(std::ranges::size(in));
+  const std::size_t workers_count{internal::GetWorkersCount()};
+  const internal::Chunks chunks{
+      internal::SplitIntoChunks(items_count, workers_count, grain_size)};
+
+  // Chunk offsets, totals of all previous chunks.
+  std::vector<T> chunk_offsets(chunks.count, identity);
+  HighResolutionClockDuration run_time{};
+
+  if (chunks.count > 1) {
+    // Last chunk total is not needed.
+    const internal::Chunks totals_chunks{.size = chunks.size,
+                                         .count = chunks.count - 1};
+
+    run_time += internal::RunChunks(
+        totals_chunks, items_count, workers_count, priority,
+        [&](std::size_t begin, std::size_t end, std::size_t chunk) {
+          T total{identity};
+          for (std::size_t i{begin}; i < end; ++i) {
+            total = scan(std::move(total),
+                         in_first[static_cast<InDifference>(i)]);
+          }
+          chunk_offsets[chunk + 1] = std::move(total);
+        });
+
+    for (std::size_t chunk{2}; chunk < chunks.count; ++chunk) {
+      chunk_offsets[chunk] =
+          scan(chunk_offsets[chunk - 1], std::move(chunk_offsets[chunk]));
+    }
+  }
+
+  run_time += internal::RunChunks(
+      chunks, items_count, workers_count, priority,
+      [&](std::size_t begin, std::size_t end, std::size_t chunk) {
+        T value{chunk_offsets[chunk]};
+        for (std::size_t i{begin}; i < end; ++i) {
+          value =
+              scan(std::move(value), in_first[static_cast<InDifference>(i)]);
+          out_first[static_cast<OutDifference>(i)] = value;
+        }
+      });
+
+  grain_size.Measure(items_count, run_time);
+}
+
+}  // namespace wb::base::parallel
+
+#endif  // !WB_BASE_PARALLEL_PARALLEL_H_
@@ -0,0 +1,222 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Parallel algorithms over the process-wide marl scheduler.
+
+#include "parallel.h"
+//
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/deps/marl/scheduler.h"
+
+namespace {
+
+/**
+ * @brief Binds marl scheduler with 4 workers to the thread in scope.
+ */
+class ScopedTestScheduler {
+ public:
+  ScopedTestScheduler() noexcept
+      : scheduler_{marl::Scheduler::Config{}.setWorkerThreadCount(4)} {
+    scheduler_.bind();
+  }
+
+  ~ScopedTestScheduler() noexcept { scheduler_.unbind(); }
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ScopedTestScheduler);
+
+ private:
+  marl::Scheduler scheduler_;
+};
+
+/**
+ * @brief Makes shuffled 0..count-1 integers.
+ * @param count Integers count.
+ * @return Shuffled integers.
+ */
+[[nodiscard]] std::vector<int> MakeShuffledInts(int count) {
+  std::vector<int> ints(static_cast<std::size_t>(count));
+  std::iota(ints.begin(), ints.end(), 0);
+
+  std::mt19937 random{42};
+  std::ranges::shuffle(ints, random);
+  return ints;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ParallelTest, ParallelForWithoutScheduler) {
+  using namespace wb::base::parallel;
+
+  std::vector<int> ints(1000, 1);
+  // Chunks of 1 item, so parallel path runs even for small inputs.
+  GrainSize grain_size{GrainSize::Fixed(1)};
+
+  // No scheduler bound, runs serially.
+  ParallelFor(ints, [](int& i) { i *= 2; }, grain_size);
+
+  EXPECT_EQ(std::vector<int>(1000, 2), ints);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ParallelTest, ParallelFor) {
+  using namespace wb::base::parallel;
+
+  const ScopedTestScheduler scoped_scheduler;
+
+  std::vector<int> ints(1000, 1);
+  GrainSize grain_size{GrainSize::Fixed(1)};
+
+  ParallelFor(ints, [](int& i) { i *= 2; }, grain_size);
+  EXPECT_EQ(std::vector<int>(1000, 2), ints);
+
+  // Loading work on background lane.
+  ParallelFor(
+      ints, [](int& i) { i *= 2; }, grain_size,
+      wb::base::TaskPriority::kBackground);
+  EXPECT_EQ(std::vector<int>(1000, 4), ints);
+
+  // Index loop with call site grain size.
+  std::vector<std::atomic_int> visits(1000);
+  ParallelFor(std::views::iota(std::size_t{0}, visits.size()),
+              [&](std::size_t i) { visits[i].fetch_add(1); });
+  for (const auto& visit : visits) {
+    EXPECT_EQ(1, visit.load());
+  }
+
+  ParallelFor(std::vector<int>{}, [](int) { FAIL(); });
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ParallelTest, NestedParallelForOnSingleWorkerLane) {
+  using namespace wb::base;
+  using namespace wb::base::parallel;
+  using namespace std::chrono_literals;
+
+  const ScopedTestScheduler scoped_scheduler;
+
+  TaskLanes lanes{4, TaskLaneShares{.normal_workers = 0,
+                                    .background_workers = 1}};
+  lanes.Bind();
+
+  std::vector<int> ints(100, 1);
+  std::atomic_bool is_done{false};
+
+  // Outer task holds the only background worker share, so helpers of nested
+  // loop can't start till it is done.
+  ScheduleTask(TaskPriority::kBackground, [&]() {
+      GrainSize grain_size{GrainSize::Fixed(1)};
+
+    ParallelFor(
+        ints, [](int& i) { i *= 2; }, grain_size, TaskPriority::kBackground);
+
+    is_done.store(true, std::memory_order_release);
+  });
+
+  const auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (!is_done.load(std::memory_order_acquire) &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+
+  EXPECT_TRUE(is_done.load(std::memory_order_acquire));
+  EXPECT_EQ(std::vector<int>(100, 2), ints);
+
+  TaskLanes::Unbind();
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ParallelTest, ParallelReduce) {
+  using namespace wb::base::parallel;
+
+  const ScopedTestScheduler scoped_scheduler;
+
+  GrainSize grain_size{GrainSize::Fixed(1)};
+
+  const std::vector<int> ints{MakeShuffledInts(1000)};
+  EXPECT_EQ(499500, ParallelReduce(ints, 0, std::plus<>{}, std::identity{},
+                                   grain_size));
+
+  EXPECT_EQ(std::int64_t{332'833'500},
+            ParallelReduce(
+                ints, std::int64_t{0}, std::plus<>{},
+                [](int i) { return std::int64_t{i} * std::int64_t{i}; },
+                grain_size));
+
+  // Not commutative reduce keeps range order.
+  const std::vector<std::string> letters{"a", "b", "c", "d", "e", "f", "g"};
+  EXPECT_EQ("abcdefg", ParallelReduce(letters, std::string{}, std::plus<>{},
+                                      std::identity{}, grain_size));
+
+  EXPECT_EQ(7, ParallelReduce(std::vector<int>{}, 7, std::plus<>{}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ParallelTest, ParallelSort) {
+  using namespace wb::base::parallel;
+
+  const ScopedTestScheduler scoped_scheduler;
+
+  for (const int count : {0, 1, 2, 7, 1000, 1001}) {
+    GrainSize grain_size;
+    // Runs of 3 items take several odd sized merge rounds.
+    grain_size.Measure(3, kTargetChunkTime);
+
+    std::vector<int> ints{MakeShuffledInts(count)};
+    std::vector<int> expected{ints};
+    std::ranges::sort(expected);
+
+    ParallelSort(ints, std::ranges::less{}, std::identity{}, grain_size);
+    EXPECT_EQ(expected, ints) << count;
+  }
+
+  std::vector<int> ints{MakeShuffledInts(1000)};
+  ParallelSort(ints, std::ranges::greater{});
+  EXPECT_TRUE(std::ranges::is_sorted(ints, std::ranges::greater{}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ParallelTest, ParallelScan) {
+  using namespace wb::base::parallel;
+
+  const ScopedTestScheduler scoped_scheduler;
+
+  GrainSize grain_size;
+  // Chunks of 3 items.
+  grain_size.Measure(3, kTargetChunkTime);
+
+  const std::vector<int> ints{MakeShuffledInts(1000)};
+  std::vector<int> expected(ints.size());
+  std::inclusive_scan(ints.begin(), ints.end(), expected.begin());
+
+  std::vector<int> sums(ints.size());
+  ParallelScan(ints, sums, 0, std::plus<>{}, grain_size);
+  EXPECT_EQ(expected, sums);
+
+  // In place.
+  std::vector<int> in_place{ints};
+  ParallelScan(in_place, in_place, 0, std::plus<>{}, grain_size);
+  EXPECT_EQ(expected, in_place);
+
+  // Not commutative scan keeps range order.
+  const std::vector<std::string> letters{"a", "b", "c", "d", "e"};
+  std::vector<std::string> prefixes(letters.size());
+  ParallelScan(letters, prefixes, std::string{}, std::plus<>{}, grain_size);
+  EXPECT_EQ((std::vector<std::string>{"a", "ab", "abc", "abcd", "abcde"}),
+            prefixes);
+
+  std::vector<int> empty;
+  ParallelScan(empty, empty, 0, std::plus<>{});
+  EXPECT_TRUE(empty.empty());
+}
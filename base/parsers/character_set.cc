@@ -0,0 +1,34 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Defines set of characters useful for parsers.
+
+#include "character_set.h"
+
+#include "base/parsers/text_scanners.h"
+
+namespace {
+
+/**
+ * @brief Best instruction set for classifiers.  Zero initialized (scalar) till
+ * dynamic initialization.
+ */
+const wb::base::parsers::internal::ScanIsa kBestClassifyIsa{
+    wb::base::parsers::internal::GetBestScanIsa()};
+
+}  // namespace
+
+namespace wb::base::parsers {
+
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::uint32_t
+CharacterSet::Classify16(const char* chars) const noexcept {
+  return internal::Classify16(*this, chars, kBestClassifyIsa);
+}
+
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::uint32_t
+CharacterSet::Classify32(const char* chars) const noexcept {
+  return internal::Classify32(*this, chars, kBestClassifyIsa);
+}
+
+}  // namespace wb::base::parsers
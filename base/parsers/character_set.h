@@ -7,35 +7,54 @@
 #ifndef WB_BASE_PARSERS_CHARACTER_SET_H_
 #define WB_BASE_PARSERS_CHARACTER_SET_H_
 
-#include <limits>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string_view>
 
+#include "base/config.h"
+#include "build/compiler_config.h"
+
 namespace wb::base::parsers {
 
 /**
- * @brief Character set.  Used for parsers configuration.
+ * @brief Character set.  Used for parsers configuration.  256-bit bitmap, so
+ * fits half of cache line and can be used as nibble shuffle lookup tables to
+ * classify 16 / 32 chars at a time.
  */
-struct CharacterSet {
+class alignas(32) CharacterSet {
+ public:
   using char_type = unsigned char;
 
-  // +1 for [0, max()] range.
-  bool set[std::numeric_limits<char_type>::max() + 1];
+  /**
+   * @brief Bitmap size in bytes.
+   */
+  static constexpr std::size_t kBitmapSize{32};
+
+  /**
+   * @brief Bitmap.  Byte |lo| has bit |hi| set for char 0x<hi><lo> when |hi| <
+   * 8, byte 16 + |lo| has bit |hi| - 8 set for char 0x<hi><lo> when |hi| >= 8.
+   * Both halves are pshufb lookup tables indexed by char low nibble.
+   */
+  using Bitmap = std::array<std::uint8_t, kBitmapSize>;
 
   /**
    * @brief Creates empty character set.
    * @return nothing.
    */
-  constexpr CharacterSet() noexcept : set{false, false} {}
+  constexpr CharacterSet() noexcept : bitmap_{} {}
 
   /**
    * @brief Creates character set from |char_set|.
-   * @param char_set
-   * @return
+   * @param char_set Characters to put in set.
+   * @return nothing.
    */
   explicit constexpr CharacterSet(std::string_view char_set) noexcept
       : CharacterSet{} {
     for (auto ch : char_set) {
-      set[static_cast<char_type>(ch)] = true;
+      const auto code = static_cast<char_type>(ch);
+      bitmap_[BitmapIndex(code)] |=
+          static_cast<std::uint8_t>(1U << ((code >> 4U) & 7U));
     }
   }
 
@@ -45,10 +64,51 @@ struct CharacterSet {
    * @return true if |ch| belongs to character set, false otherwise.
    */
   [[nodiscard]] constexpr bool HasChar(const char ch) const noexcept {
-    return set[static_cast<char_type>(ch)];
+    const auto code = static_cast<char_type>(ch);
+    return ((bitmap_[BitmapIndex(code)] >> ((code >> 4U) & 7U)) & 1U) != 0;
+  }
+
+  /**
+   * @brief Gets character set bitmap.
+   * @return Bitmap.
+   */
+  [[nodiscard]] constexpr const Bitmap& GetBitmap() const noexcept {
+    return bitmap_;
+  }
+
+  /**
+   * @brief Classifies 16 chars at |chars| at once.
+   * @param chars Chars to classify.  Should have at least 16 chars.
+   * @return Mask with bit i set if chars[i] belongs to character set.
+   */
+  [[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::uint32_t Classify16(
+      const char* chars) const noexcept;
+
+  /**
+   * @brief Classifies 32 chars at |chars| at once.
+   * @param chars Chars to classify.  Should have at least 32 chars.
+   * @return Mask with bit i set if chars[i] belongs to character set.
+   */
+  [[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::uint32_t Classify32(
+      const char* chars) const noexcept;
+
+ private:
+  /**
+   * @brief Bitmap.
+   */
+  Bitmap bitmap_;
+
+  /**
+   * @brief Gets bitmap byte index for char |code|.
+   * @param code Char code.
+   * @return Bitmap byte index.
+   */
+  [[nodiscard]] static constexpr std::size_t BitmapIndex(
+      char_type code) noexcept {
+    return (code >= 0x80U ? 16U : 0U) + (code & 0x0FU);
   }
 };
 
 }  // namespace wb::base::parsers
 
-#endif  // !WB_BASE_PARSERS_CHARACTER_SET_H_
\ No newline at end of file
+#endif  // !WB_BASE_PARSERS_CHARACTER_SET_H_
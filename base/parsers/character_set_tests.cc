@@ -6,6 +6,9 @@
 
 #include "character_set.h"
 //
+#include <limits>
+#include <string>
+//
 #include "base/deps/googletest/gtest/gtest.h"
 
 // NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
@@ -14,8 +17,13 @@ GTEST_TEST(CharacterSetTest, DefaultConstructor) {
 
   constexpr CharacterSet set;
 
-  for (auto &&ch : set.set) {
-    EXPECT_FALSE(ch);
+  for (auto &&byte : set.GetBitmap()) {
+    EXPECT_EQ(0U, byte);
+  }
+
+  for (int code{std::numeric_limits<CharacterSet::char_type>::min()};
+       code <= std::numeric_limits<CharacterSet::char_type>::max(); ++code) {
+    EXPECT_FALSE(set.HasChar(static_cast<char>(code)));
   }
 }
 
@@ -23,24 +31,18 @@ GTEST_TEST(CharacterSetTest, DefaultConstructor) {
 GTEST_TEST(CharacterSetTest, SetConstructor) {
   using namespace wb::base::parsers;
 
-  constexpr CharacterSet set{"123"};
-
-  size_t idx{0};
-  for (auto &&ch : set.set) {
-    if (idx == static_cast<CharacterSet::char_type>('1') ||
-        idx == static_cast<CharacterSet::char_type>('2') ||
-        idx == static_cast<CharacterSet::char_type>('3')) {
-      EXPECT_TRUE(ch) << "Char '"
-                      << static_cast<char>(
-                             static_cast<CharacterSet::char_type>(idx))
-                      << " should be in set.";
+  constexpr CharacterSet set{"123\x80\xFF"};
+
+  for (int code{std::numeric_limits<CharacterSet::char_type>::min()};
+       code <= std::numeric_limits<CharacterSet::char_type>::max(); ++code) {
+    const auto ch = static_cast<char>(code);
+
+    if (ch == '1' || ch == '2' || ch == '3' || ch == '\x80' || ch == '\xFF') {
+      EXPECT_TRUE(set.HasChar(ch)) << "Char " << code << " should be in set.";
     } else {
-      EXPECT_FALSE(ch) << "Char '"
-                       << static_cast<char>(
-                              static_cast<CharacterSet::char_type>(idx))
-                       << " should not be in set.";
+      EXPECT_FALSE(set.HasChar(ch))
+          << "Char " << code << " should not be in set.";
     }
-    ++idx;
   }
 }
 
@@ -62,4 +64,31 @@ GTEST_TEST(CharacterSetTest, HasChar) {
   static_assert(!set.HasChar('1'));
   static_assert(!set.HasChar('\\'));
   static_assert(!set.HasChar('\n'));
-}
\ No newline at end of file
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CharacterSetTest, BitmapSize) {
+  using namespace wb::base::parsers;
+
+  static_assert(sizeof(CharacterSet) == 32);
+  static_assert(alignof(CharacterSet) == 32);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CharacterSetTest, Classify) {
+  using namespace wb::base::parsers;
+
+  constexpr CharacterSet set{"{}()\x80\xFF"};
+
+  const std::string chars{"a{b}(c)d\x80\x7F\xFF\x01  xy{{}}z\xFF\x80  ()01234"};
+  ASSERT_EQ(32U, chars.size());
+
+  std::uint32_t expected{0};
+  for (std::size_t i{0}; i < chars.size(); ++i) {
+    expected |= static_cast<std::uint32_t>(set.HasChar(chars[i])) << i;
+  }
+
+  EXPECT_EQ(expected & 0xFFFFU, set.Classify16(chars.data()));
+  EXPECT_EQ(expected >> 16U, set.Classify16(chars.data() + 16));
+  EXPECT_EQ(expected, set.Classify32(chars.data()));
+}
@@ -0,0 +1,528 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Compiled (binary) KeyValues.
+
+#include "compiled_key_values.h"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "base/std2/filesystem_ext.h"
+
+namespace {
+
+using namespace wb::base::parsers::kv::internal;
+
+/**
+ * @brief Sections with at least this children count get hashed index.  Same
+ * as in KeyValuesDocument.
+ */
+constexpr std::uint32_t kIndexedChildrenCount{8};
+
+/**
+ * @brief Combines hashes.
+ * @param seed Hash to combine with.
+ * @param hash Hash.
+ * @return Combined hash.
+ */
+[[nodiscard]] constexpr std::uint64_t CombineHash(std::uint64_t seed,
+                                                  std::uint64_t hash) noexcept {
+  return seed ^ (hash + 0x9E3779B97F4A7C15ULL + (seed << 6U) + (seed >> 2U));
+}
+
+/**
+ * @brief Hashes |string| with ContentHash.
+ * @param string String.
+ * @return Hash.
+ */
+[[nodiscard]] std::uint64_t StringHash(std::string_view string) noexcept {
+  return wb::base::parsers::kv::ContentHash(
+      std::as_bytes(std::span{string.data(), string.size()}));
+}
+
+/**
+ * @brief Hashes file |path| content.
+ * @param path File path.
+ * @return Hash or nullopt if file can't be read.
+ */
+[[nodiscard]] std::optional<std::uint64_t> FileHash(
+    const std::filesystem::path& path) noexcept {
+  const auto file = wb::base::ScopedMemoryMappedFile::New(path);
+  if (!file.has_value()) return std::nullopt;
+
+  return wb::base::parsers::kv::ContentHash(file->data());
+}
+
+/**
+ * @brief Hashes source |content| with parse |options|, which affect result.
+ * @param content Source content.
+ * @param options Parse options.
+ * @return Source hash.
+ */
+[[nodiscard]] std::uint64_t SourceHash(
+    std::span<const std::byte> content,
+    const wb::base::parsers::kv::KeyValuesOptions& options) noexcept {
+  std::uint64_t hash{wb::base::parsers::kv::ContentHash(content)};
+
+  for (std::string_view condition : options.conditions) {
+    hash = CombineHash(hash, wb::base::parsers::kv::KeyHash(condition));
+  }
+
+  return CombineHash(hash,
+                     StringHash(options.include_directory.generic_string()));
+}
+
+/**
+ * @brief Checks [offset, offset + size) is in [0, limit).
+ * @param offset Offset.
+ * @param size Size.
+ * @param limit Limit.
+ * @return true if in range.
+ */
+[[nodiscard]] constexpr bool IsInRange(std::uint64_t offset, std::uint64_t size,
+                                       std::uint64_t limit) noexcept {
+  return offset <= limit && size <= limit - offset;
+}
+
+/**
+ * @brief Checks |node| references are valid.
+ * @param header Header.
+ * @param index Node index.
+ * @return true if valid.
+ */
+[[nodiscard]] bool IsValidNode(const CompiledHeader* header,
+                               std::uint32_t index) noexcept {
+  const CompiledNode& node{GetNodes(header)[index]};
+
+  if (node.key >= header->keys_count || node.is_section > 1 ||
+      !IsInRange(node.value_offset, node.value_size, header->strings_size)) {
+    return false;
+  }
+
+  // Children are always after parent, so tree has no cycles.
+  if (node.first_child > header->nodes_count ||
+      !IsInRange(node.first_child, node.children_count, header->nodes_count) ||
+      (node.children_count != 0 && node.first_child <= index)) {
+    return false;
+  }
+
+  if (node.index_offset == kCompiledNone) return true;
+
+  const std::uint64_t capacity{std::uint64_t{node.index_mask} + 1};
+  // Index should have empty slots, or lookup never ends.
+  if (!std::has_single_bit(capacity) || capacity <= node.children_count ||
+      !IsInRange(node.index_offset, capacity, header->indices_count)) {
+    return false;
+  }
+
+  const std::uint32_t* slots{GetIndices(header) + node.index_offset};
+  for (std::uint64_t i{0}; i < capacity; ++i) {
+    if (slots[i] != kCompiledNone &&
+        (slots[i] < node.first_child ||
+         slots[i] - node.first_child >= node.children_count)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Formats |hash| as hex.
+ * @param hash Hash.
+ * @return Hex string.
+ */
+[[nodiscard]] std::string ToHex(std::uint64_t hash) {
+  std::array<char, 16> buffer{};
+  const auto [end, rc] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), hash, 16);
+  G3DCHECK(rc == std::errc{});
+  return {buffer.data(), end};
+}
+
+/**
+ * @brief Writes |bytes| to cache file |path|.  Writes to temporary file first
+ * and renames it, so concurrent readers never see partial file.
+ * @param path Cache file path.
+ * @param bytes Bytes.
+ */
+void WriteCacheFile(const std::filesystem::path& path,
+                    std::span<const std::byte> bytes) noexcept {
+  std::error_code rc;
+  std::filesystem::create_directories(path.parent_path(), rc);
+
+  rc = wb::base::std2::filesystem::write_file_atomically(
+      path,
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      std::string_view{reinterpret_cast<const char*>(bytes.data()),
+                       bytes.size()});
+  G3DLOG_IF(WARNING, !!rc) << "Unable to write KeyValues cache file " << path
+                           << ": " << rc.message();
+}
+
+}  // namespace
+
+namespace wb::base::parsers::kv {
+
+[[nodiscard]] WB_BASE_API std::uint64_t ContentHash(
+    std::span<const std::byte> bytes) noexcept {
+  constexpr std::uint64_t kPrime1{0x9E3779B185EBCA87ULL};
+  constexpr std::uint64_t kPrime2{0xC2B2AE3D27D4EB4FULL};
+
+  std::uint64_t hash{kPrime1 ^ (bytes.size() * kPrime2)};
+
+  const auto mix = [&hash](std::uint64_t word) noexcept {
+    hash = std::rotl(hash ^ (word * kPrime2), 31) * kPrime1;
+  };
+
+  std::size_t i{0};
+  for (; i + sizeof(std::uint64_t) <= bytes.size();
+       i += sizeof(std::uint64_t)) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes.data() + i, sizeof(word));
+    mix(word);
+  }
+
+  if (i < bytes.size()) {
+    std::uint64_t word{0};
+    std::memcpy(&word, bytes.data() + i, bytes.size() - i);
+    mix(word);
+  }
+
+  // Final avalanche.
+  hash ^= hash >> 33U;
+  hash *= kPrime2;
+  hash ^= hash >> 29U;
+  hash *= kPrime1;
+  hash ^= hash >> 32U;
+  return hash;
+}
+
+[[nodiscard]] WB_BASE_API std::optional<CompiledKeyValue>
+CompiledKeyValue::FindChild(std::string_view key) const noexcept {
+  const std::uint64_t hash{KeyHash(key)};
+  const internal::CompiledNode* nodes{internal::GetNodes(header_)};
+  const internal::CompiledKey* keys{internal::GetKeys(header_)};
+
+  const auto is_match = [&](const internal::CompiledNode& node) noexcept {
+    const internal::CompiledKey& child_key{keys[node.key]};
+    return child_key.hash == hash &&
+           KeyEquals({internal::GetStrings(header_) + child_key.text_offset,
+                      child_key.text_size},
+                     key);
+  };
+
+  if (node_->index_offset != internal::kCompiledNone) {
+    const std::uint32_t* slots{internal::GetIndices(header_) +
+                               node_->index_offset};
+    auto slot = static_cast<std::uint32_t>(hash & node_->index_mask);
+
+    while (slots[slot] != internal::kCompiledNone) {
+      const internal::CompiledNode& child{nodes[slots[slot]]};
+      if (is_match(child)) return CompiledKeyValue{header_, &child};
+
+      slot = (slot + 1) & node_->index_mask;
+    }
+
+    return std::nullopt;
+  }
+
+  const internal::CompiledNode* first{nodes + node_->first_child};
+  const internal::CompiledNode* last{first + node_->children_count};
+
+  for (const internal::CompiledNode* child{first}; child != last; ++child) {
+    if (is_match(*child)) return CompiledKeyValue{header_, child};
+  }
+
+  return std::nullopt;
+}
+
+[[nodiscard]] std2::result<CompiledKeyValues> CompiledKeyValues::FromBytes(
+    std::span<const std::byte> bytes) noexcept {
+  using namespace internal;
+
+  const auto invalid = []() noexcept {
+    return std2::result<CompiledKeyValues>{
+        std::unexpect, std::make_error_code(std::errc::illegal_byte_sequence)};
+  };
+
+  if (bytes.size() < sizeof(CompiledHeader) ||
+      std::bit_cast<std::uintptr_t>(bytes.data()) % alignof(CompiledHeader) !=
+          0) {
+    return invalid();
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto* header = reinterpret_cast<const CompiledHeader*>(bytes.data());
+
+  if (header->magic != kCompiledMagic ||
+      header->format_version != kCompiledFormatVersion ||
+      header->total_size != bytes.size() || header->nodes_count == 0) {
+    return invalid();
+  }
+
+  const std::uint64_t expected_size{
+      sizeof(CompiledHeader) +
+      std::uint64_t{header->nodes_count} * sizeof(CompiledNode) +
+      std::uint64_t{header->keys_count} * sizeof(CompiledKey) +
+      std::uint64_t{header->dependencies_count} * sizeof(CompiledDependency) +
+      std::uint64_t{header->indices_count} * sizeof(std::uint32_t) +
+      header->strings_size};
+  if (expected_size != header->total_size) return invalid();
+
+  for (std::uint32_t i{0}; i < header->nodes_count; ++i) {
+    if (!IsValidNode(header, i)) return invalid();
+  }
+
+  const CompiledKey* keys{GetKeys(header)};
+  for (std::uint32_t i{0}; i < header->keys_count; ++i) {
+    if (!IsInRange(keys[i].text_offset, keys[i].text_size,
+                   header->strings_size)) {
+      return invalid();
+    }
+  }
+
+  const CompiledDependency* dependencies{GetDependencies(header)};
+  for (std::uint32_t i{0}; i < header->dependencies_count; ++i) {
+    if (!IsInRange(dependencies[i].path_offset, dependencies[i].path_size,
+                   header->strings_size)) {
+      return invalid();
+    }
+  }
+
+  return CompiledKeyValues{header};
+}
+
+[[nodiscard]] WB_BASE_API std2::result<std::vector<std::byte>>
+CompileKeyValues(const KeyValuesDocument& document, std::uint64_t source_hash,
+                 std::uint64_t tool_version_hash) noexcept {
+  using namespace internal;
+
+  std::vector<CompiledNode> nodes;
+  std::vector<CompiledKey> keys;
+  std::vector<CompiledDependency> dependencies;
+  std::vector<std::uint32_t> indices;
+  std::string strings;
+
+  std::unordered_map<const KeyName*, std::uint32_t> key_indices;
+
+  const auto add_string = [&strings](std::string_view string) {
+    const std::size_t offset{strings.size()};
+    strings.append(string);
+    return static_cast<std::uint32_t>(offset);
+  };
+
+  const auto add_node = [&](const KeyValue& key_value) {
+    const auto [it, is_inserted] = key_indices.emplace(
+        key_value.GetKeyName(), static_cast<std::uint32_t>(keys.size()));
+    if (is_inserted) {
+      const KeyName& key{*key_value.GetKeyName()};
+      keys.push_back({key.hash, add_string(key.text),
+                      static_cast<std::uint32_t>(key.text.size())});
+    }
+
+    const std::string_view value{key_value.GetValue()};
+    nodes.push_back({it->second, key_value.IsSection() ? 1U : 0U,
+                     add_string(value),
+                     static_cast<std::uint32_t>(value.size()), 0, 0,
+                     kCompiledNone, 0});
+  };
+
+  // Breadth first, so children of each node are contiguous.
+  std::vector<const KeyValue*> sources{&document.GetRoot()};
+  add_node(document.GetRoot());
+
+  for (std::size_t i{0}; i < sources.size(); ++i) {
+    const auto first_child = static_cast<std::uint32_t>(nodes.size());
+    const std::uint32_t children_count{sources[i]->GetChildrenCount()};
+
+    for (const KeyValue& child : *sources[i]) {
+      sources.push_back(&child);
+      add_node(child);
+    }
+
+    CompiledNode& node{nodes[i]};
+    node.first_child = first_child;
+    node.children_count = children_count;
+
+    if (children_count < kIndexedChildrenCount) continue;
+
+    const std::uint32_t capacity{std::bit_ceil(children_count * 2U)};
+    const std::uint32_t mask{capacity - 1};
+    const std::size_t index_offset{indices.size()};
+
+    indices.resize(index_offset + capacity, kCompiledNone);
+    std::uint32_t* slots{indices.data() + index_offset};
+
+    for (std::uint32_t child{first_child}; child < first_child + children_count;
+         ++child) {
+      auto slot =
+          static_cast<std::uint32_t>(keys[nodes[child].key].hash & mask);
+
+      // First key wins, as in linear search.
+      while (slots[slot] != kCompiledNone &&
+             nodes[slots[slot]].key != nodes[child].key) {
+        slot = (slot + 1) & mask;
+      }
+
+      if (slots[slot] == kCompiledNone) slots[slot] = child;
+    }
+
+    node.index_offset = static_cast<std::uint32_t>(index_offset);
+    node.index_mask = mask;
+  }
+
+  for (const auto& path : document.GetIncludedFiles()) {
+    const std::string path_string{path.string()};
+
+    // Unreadable dependency never matches, so cache is always rebuilt.
+    dependencies.push_back({FileHash(path).value_or(0), add_string(path_string),
+                            static_cast<std::uint32_t>(path_string.size())});
+  }
+
+  constexpr std::uint64_t kMaxSize{0xFFFFFFFFULL};
+  if (strings.size() > kMaxSize || nodes.size() > kMaxSize ||
+      indices.size() > kMaxSize) [[unlikely]] {
+    return std2::result<std::vector<std::byte>>{
+        std::unexpect, std::make_error_code(std::errc::file_too_large)};
+  }
+
+  const CompiledHeader header{
+      kCompiledMagic,
+      kCompiledFormatVersion,
+      source_hash,
+      tool_version_hash,
+      sizeof(CompiledHeader) + nodes.size() * sizeof(CompiledNode) +
+          keys.size() * sizeof(CompiledKey) +
+          dependencies.size() * sizeof(CompiledDependency) +
+          indices.size() * sizeof(std::uint32_t) + strings.size(),
+      static_cast<std::uint32_t>(nodes.size()),
+      static_cast<std::uint32_t>(keys.size()),
+      static_cast<std::uint32_t>(dependencies.size()),
+      static_cast<std::uint32_t>(indices.size()),
+      static_cast<std::uint32_t>(strings.size()),
+      0};
+
+  std::vector<std::byte> bytes(static_cast<std::size_t>(header.total_size));
+  std::byte* out{bytes.data()};
+
+  const auto write = [&out](const void* data, std::size_t size) noexcept {
+    if (size != 0) std::memcpy(out, data, size);
+    out += size;
+  };
+
+  write(&header, sizeof(header));
+  write(nodes.data(), nodes.size() * sizeof(CompiledNode));
+  write(keys.data(), keys.size() * sizeof(CompiledKey));
+  write(dependencies.data(), dependencies.size() * sizeof(CompiledDependency));
+  write(indices.data(), indices.size() * sizeof(std::uint32_t));
+  write(strings.data(), strings.size());
+
+  G3DCHECK(out == bytes.data() + bytes.size());
+
+  return bytes;
+}
+
+CompiledKeyValuesFile::CompiledKeyValuesFile(
+    std::variant<ScopedMemoryMappedFile, std::vector<std::byte>> bytes,
+    CompiledKeyValues key_values) noexcept
+    : bytes_{std::move(bytes)}, key_values_{key_values} {}
+
+CompiledKeyValuesFile::CompiledKeyValuesFile(CompiledKeyValuesFile&&) noexcept =
+    default;
+CompiledKeyValuesFile& CompiledKeyValuesFile::operator=(
+    CompiledKeyValuesFile&&) noexcept = default;
+
+CompiledKeyValuesFile::~CompiledKeyValuesFile() noexcept = default;
+
+[[nodiscard]] std::expected<CompiledKeyValuesFile, KeyValuesError>
+CompiledKeyValuesFile::Load(
+    const std::filesystem::path& path, const KeyValuesOptions& options,
+    const KeyValuesCacheOptions& cache_options) noexcept {
+  const auto source = ScopedMemoryMappedFile::New(path);
+  if (!source.has_value()) {
+    return std::unexpected{KeyValuesError{
+        path.string(), st::TextPosition{1, 1},
+        "Unable to open file: " + source.error().message()}};
+  }
+
+  const KeyValuesOptions file_options{
+      options.conditions, options.include_directory.empty()
+                              ? path.parent_path()
+                              : options.include_directory};
+  const std::uint64_t source_hash{SourceHash(source->data(), file_options)};
+  const std::uint64_t tool_version_hash{
+      StringHash(cache_options.tool_version)};
+
+  std::filesystem::path cache_path;
+
+  if (!cache_options.cache_directory.empty()) {
+    // Name by source hash, so same sources share cache and new tool version
+    // overwrites old cache.
+    cache_path = cache_options.cache_directory / (ToHex(source_hash) + ".kvc");
+
+    auto cache = ScopedMemoryMappedFile::New(cache_path);
+    if (cache.has_value()) {
+      const auto key_values = CompiledKeyValues::FromBytes(cache->data());
+
+      bool is_valid{key_values.has_value() &&
+                    key_values->GetSourceHash() == source_hash &&
+                    key_values->GetToolVersionHash() == tool_version_hash};
+
+      for (std::uint32_t i{0};
+           is_valid && i < key_values->GetDependenciesCount(); ++i) {
+        const CompiledKeyValuesDependency dependency{
+            key_values->GetDependency(i)};
+
+        is_valid = FileHash(std::filesystem::path{dependency.path}) ==
+                   dependency.content_hash;
+      }
+
+      if (is_valid) {
+        return CompiledKeyValuesFile{std::move(*cache), *key_values};
+      }
+    }
+  }
+
+  auto document = KeyValuesDocument::Parse(st::AsStringView(source->data()),
+                                           path.string(), file_options);
+  if (!document.has_value()) {
+    return std::unexpected{std::move(document.error())};
+  }
+
+  auto bytes = CompileKeyValues(*document, source_hash, tool_version_hash);
+  if (!bytes.has_value()) {
+    return std::unexpected{KeyValuesError{
+        path.string(), st::TextPosition{1, 1},
+        "Unable to compile file: " + bytes.error().message()}};
+  }
+
+  if (!cache_path.empty()) WriteCacheFile(cache_path, *bytes);
+
+  const auto key_values = CompiledKeyValues::FromBytes(*bytes);
+  G3CHECK(key_values.has_value());
+
+  return CompiledKeyValuesFile{std::move(*bytes), *key_values};
+}
+
+[[nodiscard]] std2::result<CompiledKeyValuesFile>
+CompiledKeyValuesFile::FromDocument(
+    const KeyValuesDocument& document) noexcept {
+  auto bytes = CompileKeyValues(document, 0, 0);
+  if (!bytes.has_value()) {
+    return std2::result<CompiledKeyValuesFile>{std::unexpect, bytes.error()};
+  }
+
+  const auto key_values = CompiledKeyValues::FromBytes(*bytes);
+  G3CHECK(key_values.has_value());
+
+  return CompiledKeyValuesFile{std::move(*bytes), *key_values};
+}
+
+}  // namespace wb::base::parsers::kv
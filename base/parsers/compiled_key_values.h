@@ -0,0 +1,595 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Compiled (binary) KeyValues.  Flat relocatable layout which is read in place
+// from memory mapped cache files, so warm loads do not tokenize text at all.
+//
+// Layout (native endianness, all offsets are relative):
+//   CompiledHeader
+//   CompiledNode[nodes_count]           // Root first, children contiguous.
+//   CompiledKey[keys_count]             // Interned keys.
+//   CompiledDependency[dependencies_count]  // #include / #base files.
+//   uint32_t[indices_count]             // Large sections children indices.
+//   char[strings_size]                  // Keys, values and paths.
+
+#ifndef WB_BASE_PARSERS_COMPILED_KEY_VALUES_H_
+#define WB_BASE_PARSERS_COMPILED_KEY_VALUES_H_
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "base/config.h"
+#include "base/deps/g3log/g3log.h"
+#include "base/macroses.h"
+#include "base/parsers/key_values.h"
+#include "base/scoped_memory_mapped_file.h"
+#include "base/std2/system_error_ext.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::parsers::kv {
+
+namespace internal {
+
+/**
+ * @brief Compiled KeyValues magic, 'WBKV'.
+ */
+constexpr std::uint32_t kCompiledMagic{0x564B4257U};
+/**
+ * @brief Compiled KeyValues format version.  Bump on any layout change.
+ */
+constexpr std::uint32_t kCompiledFormatVersion{1U};
+/**
+ * @brief No node / index.
+ */
+constexpr std::uint32_t kCompiledNone{0xFFFFFFFFU};
+
+/**
+ * @brief Compiled KeyValues header.
+ */
+struct CompiledHeader {
+  std::uint32_t magic;
+  std::uint32_t format_version;
+  /**
+   * @brief Hash of source content and parse options.
+   */
+  std::uint64_t source_hash;
+  /**
+   * @brief Hash of tool version which compiled KeyValues.
+   */
+  std::uint64_t tool_version_hash;
+  /**
+   * @brief Total size in bytes, including header.
+   */
+  std::uint64_t total_size;
+  std::uint32_t nodes_count;
+  std::uint32_t keys_count;
+  std::uint32_t dependencies_count;
+  std::uint32_t indices_count;
+  std::uint32_t strings_size;
+  std::uint32_t reserved;
+};
+
+/**
+ * @brief Compiled key value.
+ */
+struct CompiledNode {
+  /**
+   * @brief Key index.
+   */
+  std::uint32_t key;
+  /**
+   * @brief Is section?
+   */
+  std::uint32_t is_section;
+  std::uint32_t value_offset;
+  std::uint32_t value_size;
+  /**
+   * @brief First child node.  Children are contiguous and always after parent.
+   */
+  std::uint32_t first_child;
+  std::uint32_t children_count;
+  /**
+   * @brief Children index offset or kCompiledNone for small sections.
+   */
+  std::uint32_t index_offset;
+  std::uint32_t index_mask;
+};
+
+/**
+ * @brief Compiled interned key.
+ */
+struct CompiledKey {
+  /**
+   * @brief KeyHash of text.
+   */
+  std::uint64_t hash;
+  std::uint32_t text_offset;
+  std::uint32_t text_size;
+};
+
+/**
+ * @brief Compiled dependency (#include / #base file).
+ */
+struct CompiledDependency {
+  /**
+   * @brief File content hash at compile time.
+   */
+  std::uint64_t content_hash;
+  std::uint32_t path_offset;
+  std::uint32_t path_size;
+};
+
+static_assert(sizeof(CompiledHeader) == 56);
+static_assert(sizeof(CompiledNode) == 32);
+static_assert(sizeof(CompiledKey) == 16);
+static_assert(sizeof(CompiledDependency) == 16);
+
+// Sections are at fixed offsets computed from counts, so views need only
+// header address.
+// NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+
+/**
+ * @brief Gets section of type T at |offset| bytes from header.
+ * @param header Header.
+ * @param offset Section offset in bytes.
+ * @return Section.
+ */
+template <typename T>
+[[nodiscard]] inline const T* GetSection(const CompiledHeader* header,
+                                         std::size_t offset) noexcept {
+  return reinterpret_cast<const T*>(
+      reinterpret_cast<const std::byte*>(header) + offset);
+}
+
+/**
+ * @brief Gets nodes.
+ * @param header Header.
+ * @return Nodes.
+ */
+[[nodiscard]] inline const CompiledNode* GetNodes(
+    const CompiledHeader* header) noexcept {
+  return GetSection<CompiledNode>(header, sizeof(CompiledHeader));
+}
+
+/**
+ * @brief Gets keys.
+ * @param header Header.
+ * @return Keys.
+ */
+[[nodiscard]] inline const CompiledKey* GetKeys(
+    const CompiledHeader* header) noexcept {
+  return GetSection<CompiledKey>(
+      header, sizeof(CompiledHeader) +
+                  sizeof(CompiledNode) * std::size_t{header->nodes_count});
+}
+
+/**
+ * @brief Gets dependencies.
+ * @param header Header.
+ * @return Dependencies.
+ */
+[[nodiscard]] inline const CompiledDependency* GetDependencies(
+    const CompiledHeader* header) noexcept {
+  return GetSection<CompiledDependency>(
+      header, sizeof(CompiledHeader) +
+                  sizeof(CompiledNode) * std::size_t{header->nodes_count} +
+                  sizeof(CompiledKey) * std::size_t{header->keys_count});
+}
+
+/**
+ * @brief Gets children indices.
+ * @param header Header.
+ * @return Children indices.
+ */
+[[nodiscard]] inline const std::uint32_t* GetIndices(
+    const CompiledHeader* header) noexcept {
+  return GetSection<std::uint32_t>(
+      header,
+      sizeof(CompiledHeader) +
+          sizeof(CompiledNode) * std::size_t{header->nodes_count} +
+          sizeof(CompiledKey) * std::size_t{header->keys_count} +
+          sizeof(CompiledDependency) *
+              std::size_t{header->dependencies_count});
+}
+
+/**
+ * @brief Gets strings.
+ * @param header Header.
+ * @return Strings.
+ */
+[[nodiscard]] inline const char* GetStrings(
+    const CompiledHeader* header) noexcept {
+  return reinterpret_cast<const char*>(GetIndices(header) +
+                                       header->indices_count);
+}
+
+// NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+
+}  // namespace internal
+
+/**
+ * @brief Hashes |bytes|.  Stable across runs and platforms with same
+ * endianness, so usable as cache key.  Not cryptographic.
+ * @param bytes Bytes.
+ * @return Hash.
+ */
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_PURE std::uint64_t ContentHash(
+    std::span<const std::byte> bytes) noexcept;
+
+/**
+ * @brief View of compiled key value.  Cheap to copy.
+ */
+class CompiledKeyValue {
+ public:
+  /**
+   * @brief Gets key.
+   * @return Key.
+   */
+  [[nodiscard]] std::string_view GetKey() const noexcept {
+    const internal::CompiledKey& key{internal::GetKeys(header_)[node_->key]};
+    return {internal::GetStrings(header_) + key.text_offset, key.text_size};
+  }
+
+  /**
+   * @brief Gets value.  Empty for sections.
+   * @return Value.
+   */
+  [[nodiscard]] std::string_view GetValue() const noexcept {
+    return {internal::GetStrings(header_) + node_->value_offset,
+            node_->value_size};
+  }
+
+  /**
+   * @brief Parses value as number.
+   * @tparam T Number type.
+   * @return Number or nullopt if value is not a number.
+   */
+  template <typename T>
+    requires std::is_arithmetic_v<T>
+  [[nodiscard]] WB_ATTRIBUTE_PURE std::optional<T> GetValueAs()
+      const noexcept {
+    const std::string_view value{GetValue()};
+
+    T number{};
+    const auto [end, rc] =
+        std::from_chars(value.data(), value.data() + value.size(), number);
+    if (rc != std::errc{} || end != value.data() + value.size()) {
+      return std::nullopt;
+    }
+    return number;
+  }
+
+  /**
+   * @brief Is key section with child keys ({ ... })?
+   * @return true if section.
+   */
+  [[nodiscard]] bool IsSection() const noexcept {
+    return node_->is_section != 0;
+  }
+
+  /**
+   * @brief Gets child keys count.
+   * @return Child keys count.
+   */
+  [[nodiscard]] std::uint32_t GetChildrenCount() const noexcept {
+    return node_->children_count;
+  }
+
+  /**
+   * @brief Finds first child with |key|.  Uses hashed index for large
+   * sections.
+   * @param key Key.
+   * @return Child or nullopt.
+   */
+  [[nodiscard]] WB_BASE_API WB_ATTRIBUTE_PURE std::optional<CompiledKeyValue>
+  FindChild(std::string_view key) const noexcept;
+
+  /**
+   * @brief Child keys iterator.
+   */
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = CompiledKeyValue;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = CompiledKeyValue;
+
+    Iterator() noexcept : header_{nullptr}, node_{nullptr} {}
+    Iterator(const internal::CompiledHeader* header,
+             const internal::CompiledNode* node) noexcept
+        : header_{header}, node_{node} {}
+
+    [[nodiscard]] reference operator*() const noexcept {
+      return CompiledKeyValue{header_, node_};
+    }
+
+    Iterator& operator++() noexcept {
+      ++node_;
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      Iterator it{*this};
+      ++*this;
+      return it;
+    }
+
+    [[nodiscard]] bool operator==(const Iterator& it) const noexcept {
+      return node_ == it.node_;
+    }
+
+   private:
+    /**
+     * @brief Compiled KeyValues header.
+     */
+    const internal::CompiledHeader* header_;
+    /**
+     * @brief Current node.
+     */
+    const internal::CompiledNode* node_;
+  };
+
+  /**
+   * @brief Gets first child iterator.
+   * @return Iterator.
+   */
+  [[nodiscard]] Iterator begin() const noexcept {
+    return Iterator{header_, internal::GetNodes(header_) + node_->first_child};
+  }
+
+  /**
+   * @brief Gets after last child iterator.
+   * @return Iterator.
+   */
+  [[nodiscard]] Iterator end() const noexcept {
+    return Iterator{header_, internal::GetNodes(header_) +
+                                 node_->first_child + node_->children_count};
+  }
+
+ private:
+  friend class CompiledKeyValues;
+
+  /**
+   * @brief Compiled KeyValues header.  Bytes address, so view does not depend
+   * on owner address.
+   */
+  const internal::CompiledHeader* header_;
+  /**
+   * @brief Node.
+   */
+  const internal::CompiledNode* node_;
+
+  /**
+   * @brief Creates key value view.
+   * @param header Compiled KeyValues header.
+   * @param node Node.
+   * @return nothing.
+   */
+  CompiledKeyValue(const internal::CompiledHeader* header,
+                   const internal::CompiledNode* node) noexcept
+      : header_{header}, node_{node} {}
+};
+
+/**
+ * @brief Compiled KeyValues dependency.
+ */
+struct CompiledKeyValuesDependency {
+  /**
+   * @brief File path.
+   */
+  std::string_view path;
+  /**
+   * @brief File content hash at compile time.
+   */
+  std::uint64_t content_hash;
+};
+
+/**
+ * @brief Validated view of compiled KeyValues bytes.  Does not own bytes.
+ */
+class WB_BASE_API CompiledKeyValues {
+ public:
+  /**
+   * @brief Validates |bytes| and creates view over them.  All offsets are
+   * checked once here, so accessors are not checked.
+   * @param bytes Compiled bytes, 8 bytes aligned.  Should outlive view.
+   * @return View or std::errc::illegal_byte_sequence when bytes are not valid
+   * compiled KeyValues.
+   */
+  [[nodiscard]] WB_ATTRIBUTE_PURE static std2::result<CompiledKeyValues>
+  FromBytes(std::span<const std::byte> bytes) noexcept;
+
+  /**
+   * @brief Gets root.  Root is section with top-level keys.
+   * @return Root.
+   */
+  [[nodiscard]] CompiledKeyValue GetRoot() const noexcept {
+    return CompiledKeyValue{header_, internal::GetNodes(header_)};
+  }
+
+  /**
+   * @brief Gets hash of source content and parse options.
+   * @return Source hash.
+   */
+  [[nodiscard]] std::uint64_t GetSourceHash() const noexcept {
+    return header_->source_hash;
+  }
+
+  /**
+   * @brief Gets hash of tool version which compiled KeyValues.
+   * @return Tool version hash.
+   */
+  [[nodiscard]] std::uint64_t GetToolVersionHash() const noexcept {
+    return header_->tool_version_hash;
+  }
+
+  /**
+   * @brief Gets #include / #base files count.
+   * @return Dependencies count.
+   */
+  [[nodiscard]] std::uint32_t GetDependenciesCount() const noexcept {
+    return header_->dependencies_count;
+  }
+
+  /**
+   * @brief Gets #include / #base file.
+   * @param index Dependency index.
+   * @return Dependency.
+   */
+  [[nodiscard]] CompiledKeyValuesDependency GetDependency(
+      std::uint32_t index) const noexcept {
+    G3DCHECK(index < header_->dependencies_count);
+
+    const internal::CompiledDependency& dependency{
+        internal::GetDependencies(header_)[index]};
+    return {{internal::GetStrings(header_) + dependency.path_offset,
+             dependency.path_size},
+            dependency.content_hash};
+  }
+
+  /**
+   * @brief Gets compiled bytes.
+   * @return Bytes.
+   */
+  [[nodiscard]] std::span<const std::byte> GetBytes() const noexcept {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<const std::byte*>(header_),
+            static_cast<std::size_t>(header_->total_size)};
+  }
+
+ private:
+  /**
+   * @brief Header.  Sections follow it.
+   */
+  const internal::CompiledHeader* header_;
+
+  /**
+   * @brief Creates view.
+   * @param header Validated header.
+   * @return nothing.
+   */
+  explicit CompiledKeyValues(const internal::CompiledHeader* header) noexcept
+      : header_{header} {}
+};
+
+/**
+ * @brief Compiles |document|.
+ * @param document Document.
+ * @param source_hash Hash of source content and parse options.
+ * @param tool_version_hash Hash of tool version.
+ * @return Compiled bytes or std::errc::file_too_large when document is larger
+ * than 4GiB.
+ */
+[[nodiscard]] WB_BASE_API std2::result<std::vector<std::byte>>
+CompileKeyValues(const KeyValuesDocument& document, std::uint64_t source_hash,
+                 std::uint64_t tool_version_hash) noexcept;
+
+/**
+ * @brief Compiled KeyValues cache options.
+ */
+struct KeyValuesCacheOptions {
+  /**
+   * @brief Cache directory.  Empty to disable cache.
+   */
+  std::filesystem::path cache_directory;
+  /**
+   * @brief Tool version.  Cache compiled by other version is ignored.
+   */
+  std::string_view tool_version;
+};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Compiled KeyValues which own their bytes.  Bytes are either memory
+   * mapped cache file or compiled in memory.
+   */
+  class WB_BASE_API CompiledKeyValuesFile {
+   public:
+    /**
+     * @brief Loads KeyValues file |path|.  When cache has compiled file with
+     * the same source hash, tool version and unchanged #include / #base
+     * files, it is memory mapped without parsing.  Otherwise file is parsed,
+     * compiled and written to cache.
+     * @param path KeyValues file path.
+     * @param options Parse options.
+     * @param cache_options Cache options.
+     * @return Compiled KeyValues or parse error.
+     */
+    [[nodiscard]] static std::expected<CompiledKeyValuesFile, KeyValuesError>
+    Load(const std::filesystem::path& path, const KeyValuesOptions& options,
+         const KeyValuesCacheOptions& cache_options) noexcept;
+
+    /**
+     * @brief Compiles |document| in memory.
+     * @param document Document.
+     * @return Compiled KeyValues or std::errc::file_too_large.
+     */
+    [[nodiscard]] static std2::result<CompiledKeyValuesFile> FromDocument(
+        const KeyValuesDocument& document) noexcept;
+
+    CompiledKeyValuesFile(CompiledKeyValuesFile&&) noexcept;
+    CompiledKeyValuesFile& operator=(CompiledKeyValuesFile&&) noexcept;
+
+    WB_NO_COPY_CTOR_AND_ASSIGNMENT(CompiledKeyValuesFile);
+
+    ~CompiledKeyValuesFile() noexcept;
+
+    /**
+     * @brief Gets compiled KeyValues.
+     * @return Compiled KeyValues.
+     */
+    [[nodiscard]] const CompiledKeyValues& GetKeyValues() const noexcept {
+      return key_values_;
+    }
+
+    /**
+     * @brief Was loaded from cache?
+     * @return true if memory mapped from cache.
+     */
+    [[nodiscard]] bool IsFromCache() const noexcept {
+      return std::holds_alternative<ScopedMemoryMappedFile>(bytes_);
+    }
+
+   private:
+    /**
+     * @brief Memory mapped cache file or bytes compiled in memory.  Both keep
+     * bytes address on move, so view stays valid.
+     */
+    std::variant<ScopedMemoryMappedFile, std::vector<std::byte>> bytes_;
+    /**
+     * @brief View over bytes.
+     */
+    CompiledKeyValues key_values_;
+
+    /**
+     * @brief Creates compiled KeyValues file.
+     * @param bytes Bytes.
+     * @param key_values View over bytes.
+     * @return nothing.
+     */
+    CompiledKeyValuesFile(
+        std::variant<ScopedMemoryMappedFile, std::vector<std::byte>> bytes,
+        CompiledKeyValues key_values) noexcept;
+  };
+
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+}  // namespace wb::base::parsers::kv
+
+#endif  // !WB_BASE_PARSERS_COMPILED_KEY_VALUES_H_
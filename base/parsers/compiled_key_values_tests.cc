@@ -0,0 +1,218 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Compiled (binary) KeyValues.
+
+#include "compiled_key_values.h"
+//
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+namespace {
+
+/**
+ * @brief Writes |content| to |path|.
+ * @param path Path.
+ * @param content Content.
+ */
+void WriteFile(const std::filesystem::path& path, std::string_view content) {
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file << content;
+}
+
+/**
+ * @brief Compiles |content|.
+ * @param content KeyValues text.
+ * @return Compiled bytes.
+ */
+[[nodiscard]] std::vector<std::byte> Compile(std::string_view content) {
+  using namespace wb::base::parsers::kv;
+
+  const auto document = KeyValuesDocument::Parse(content, "test", {});
+  EXPECT_TRUE(document.has_value());
+
+  auto bytes = CompileKeyValues(*document, 1, 2);
+  EXPECT_TRUE(bytes.has_value());
+
+  return std::move(bytes).value();
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CompiledKeyValuesTest, ContentHash) {
+  using namespace wb::base::parsers::kv;
+
+  const auto hash = [](std::string_view string) {
+    return ContentHash(std::as_bytes(std::span{string.data(), string.size()}));
+  };
+
+  EXPECT_EQ(hash("key value"), hash("key value"));
+  EXPECT_NE(hash("key value"), hash("key valuf"));
+  EXPECT_NE(hash(""), hash(std::string_view{"\0", 1}));
+  EXPECT_NE(hash("0123456789abcdef"), hash("0123456789abcdeg"));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CompiledKeyValuesTest, MatchesDocument) {
+  using namespace wb::base::parsers::kv;
+
+  std::string content{
+      "Game { title \"Half-Life 2\" FileSystem { SteamAppId 220 } "
+      "empty {} }\nlarge {"};
+  for (int i{0}; i < 50; ++i) {
+    content += " key" + std::to_string(i) + " " + std::to_string(i);
+  }
+  content += " KEY7 duplicate }";
+
+  const std::vector<std::byte> bytes{Compile(content)};
+  const auto key_values = CompiledKeyValues::FromBytes(bytes);
+  ASSERT_TRUE(key_values.has_value()) << key_values.error().message();
+
+  EXPECT_EQ(1U, key_values->GetSourceHash());
+  EXPECT_EQ(2U, key_values->GetToolVersionHash());
+  EXPECT_EQ(bytes.size(), key_values->GetBytes().size());
+
+  const CompiledKeyValue root{key_values->GetRoot()};
+  EXPECT_TRUE(root.IsSection());
+  ASSERT_EQ(2U, root.GetChildrenCount());
+
+  const auto game = root.FindChild("GAME");
+  ASSERT_TRUE(game.has_value());
+  EXPECT_EQ("Game", game->GetKey());
+  EXPECT_EQ("Half-Life 2", game->FindChild("title")->GetValue());
+  EXPECT_EQ(220, game->FindChild("filesystem")
+                     ->FindChild("SteamAppId")
+                     ->GetValueAs<int>());
+  EXPECT_EQ(0U, game->FindChild("empty")->GetChildrenCount());
+  EXPECT_FALSE(game->FindChild("missing").has_value());
+
+  std::array<std::string_view, 3> keys{"title", "FileSystem", "empty"};
+  std::size_t i{0};
+  for (const CompiledKeyValue child : *game) {
+    ASSERT_LT(i, keys.size());
+    EXPECT_EQ(keys[i++], child.GetKey());
+  }
+  EXPECT_EQ(keys.size(), i);
+
+  const auto large = root.FindChild("large");
+  ASSERT_TRUE(large.has_value());
+  EXPECT_EQ(51U, large->GetChildrenCount());
+
+  for (int j{0}; j < 50; ++j) {
+    const auto child = large->FindChild("Key" + std::to_string(j));
+    ASSERT_TRUE(child.has_value()) << j;
+    EXPECT_EQ(j, child->GetValueAs<int>());
+  }
+  // First key wins.
+  EXPECT_EQ("7", large->FindChild("key7")->GetValue());
+  EXPECT_FALSE(large->FindChild("key50").has_value());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CompiledKeyValuesTest, RejectsInvalidBytes) {
+  using namespace wb::base::parsers::kv;
+  using namespace wb::base::parsers::kv::internal;
+
+  const std::vector<std::byte> bytes{Compile("a { b c d e }")};
+  ASSERT_TRUE(CompiledKeyValues::FromBytes(bytes).has_value());
+
+  // Truncated.
+  EXPECT_FALSE(CompiledKeyValues::FromBytes(
+                   std::span{bytes}.first(bytes.size() - 1))
+                   .has_value());
+  EXPECT_FALSE(CompiledKeyValues::FromBytes(
+                   std::span{bytes}.first(sizeof(CompiledHeader) - 1))
+                   .has_value());
+
+  const auto corrupt = [&bytes](std::size_t offset, std::uint32_t value) {
+    std::vector<std::byte> corrupted{bytes};
+    const auto value_bytes = std::as_bytes(std::span{&value, 1});
+    std::ranges::copy(value_bytes, corrupted.begin() +
+                                       static_cast<std::ptrdiff_t>(offset));
+    return CompiledKeyValues::FromBytes(corrupted).has_value();
+  };
+
+  // Magic, format version.
+  EXPECT_FALSE(corrupt(0, 0));
+  EXPECT_FALSE(corrupt(4, kCompiledFormatVersion + 1));
+
+  // Root key, first child pointing to root itself.
+  constexpr std::size_t kRoot{sizeof(CompiledHeader)};
+  EXPECT_FALSE(corrupt(kRoot + offsetof(CompiledNode, key), 1000));
+  EXPECT_FALSE(corrupt(kRoot + offsetof(CompiledNode, first_child), 0));
+  EXPECT_FALSE(corrupt(kRoot + offsetof(CompiledNode, value_size), 100000));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(CompiledKeyValuesTest, LoadUsesCache) {
+  using namespace wb::base::parsers::kv;
+
+  const std::filesystem::path directory{
+      std::filesystem::temp_directory_path() / "wb_compiled_key_values_tests"};
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+
+  const std::filesystem::path source{directory / "main.txt"};
+  WriteFile(directory / "base.txt", "from_base 1");
+  WriteFile(source, "#base base.txt\nkey value");
+
+  KeyValuesCacheOptions cache_options{directory / "cache", "1.0.0"};
+
+  const auto load = [&]() {
+    auto file = CompiledKeyValuesFile::Load(source, {}, cache_options);
+    EXPECT_TRUE(file.has_value());
+    return std::move(file).value();
+  };
+
+  {
+    const auto cold = load();
+    EXPECT_FALSE(cold.IsFromCache());
+    EXPECT_EQ("value",
+              cold.GetKeyValues().GetRoot().FindChild("key")->GetValue());
+  }
+
+  {
+    const auto warm = load();
+    EXPECT_TRUE(warm.IsFromCache());
+    EXPECT_EQ("value",
+              warm.GetKeyValues().GetRoot().FindChild("key")->GetValue());
+    EXPECT_EQ("1",
+              warm.GetKeyValues().GetRoot().FindChild("from_base")->GetValue());
+    EXPECT_EQ(1U, warm.GetKeyValues().GetDependenciesCount());
+  }
+
+  // Changed dependency.
+  WriteFile(directory / "base.txt", "from_base 2");
+  EXPECT_FALSE(load().IsFromCache());
+  EXPECT_TRUE(load().IsFromCache());
+
+  // Changed source.
+  WriteFile(source, "#base base.txt\nkey other");
+  {
+    const auto changed = load();
+    EXPECT_FALSE(changed.IsFromCache());
+    EXPECT_EQ("other",
+              changed.GetKeyValues().GetRoot().FindChild("key")->GetValue());
+  }
+
+  // Changed tool version.
+  cache_options.tool_version = "1.0.1";
+  EXPECT_FALSE(load().IsFromCache());
+  EXPECT_TRUE(load().IsFromCache());
+
+  // No cache.
+  cache_options.cache_directory.clear();
+  EXPECT_FALSE(load().IsFromCache());
+
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,714 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// KeyValues (KV1) text format parser.
+
+#include "key_values.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "base/scoped_memory_mapped_file.h"
+
+namespace {
+
+/**
+ * @brief Sections with at least this children count get hashed index.
+ */
+constexpr std::uint32_t kIndexedChildrenCount{8};
+
+/**
+ * @brief Max #include / #base nesting.  Cycles are rejected on their own, so
+ * guards against runaway include chains only.
+ */
+constexpr std::size_t kMaxIncludeDepth{16};
+
+/**
+ * @brief KeyValues break chars.
+ */
+constexpr wb::base::parsers::CharacterSet kBreaks{"{}"};
+
+/**
+ * @brief Is |token| unquoted |text|?
+ * @param token Token.
+ * @param text Text.
+ * @return true if token is unquoted |text|.
+ */
+[[nodiscard]] bool IsUnquoted(const wb::base::parsers::st::StreamToken& token,
+                              std::string_view text) noexcept {
+  return !token.is_quoted && token.value == text;
+}
+
+/**
+ * @brief Is |token| condition, like [$WIN32]?
+ * @param token Token.
+ * @return true if condition.
+ */
+[[nodiscard]] bool IsCondition(
+    const wb::base::parsers::st::StreamToken& token) noexcept {
+  return !token.is_quoted && token.value.size() >= 2 &&
+         token.value.front() == '[' && token.value.back() == ']';
+}
+
+/**
+ * @brief Is single condition term, like $WIN32 or !$WIN32, true?
+ * @param term Term.
+ * @param conditions Defined conditions.
+ * @return true / false or nullopt if term is invalid.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE std::optional<bool> EvaluateTerm(
+    std::string_view term, std::span<const std::string_view> conditions) {
+  const bool is_negated{term.starts_with('!')};
+  if (is_negated) term.remove_prefix(1);
+
+  if (term.size() < 2 || term.front() != '$') return std::nullopt;
+
+  term.remove_prefix(1);
+
+  const bool is_defined{std::ranges::any_of(
+      conditions, [term](std::string_view condition) {
+        return wb::base::parsers::kv::KeyEquals(condition, term);
+      })};
+  return is_defined != is_negated;
+}
+
+/**
+ * @brief Evaluates condition, like [$WIN32||!$X360&&$GAMECONSOLE].
+ * @param condition Condition.
+ * @param conditions Defined conditions.
+ * @return true / false or nullopt if condition is invalid.
+ */
+[[nodiscard]] std::optional<bool> EvaluateCondition(
+    std::string_view condition, std::span<const std::string_view> conditions) {
+  // Strip [].
+  condition = condition.substr(1, condition.size() - 2);
+
+  bool result{false};
+
+  while (true) {
+    const std::size_t or_index{condition.find("||")};
+    std::string_view conjunction{condition.substr(0, or_index)};
+
+    bool conjunction_result{true};
+    while (true) {
+      const std::size_t and_index{conjunction.find("&&")};
+      const auto term =
+          EvaluateTerm(conjunction.substr(0, and_index), conditions);
+      if (!term.has_value()) return std::nullopt;
+
+      conjunction_result = conjunction_result && *term;
+
+      if (and_index == std::string_view::npos) break;
+      conjunction.remove_prefix(and_index + 2);
+    }
+
+    result = result || conjunction_result;
+
+    if (or_index == std::string_view::npos) break;
+    condition.remove_prefix(or_index + 2);
+  }
+
+  return result;
+}
+
+}  // namespace
+
+namespace wb::base::parsers::kv {
+
+namespace internal {
+
+/**
+ * @brief Builds KeyValues document tree.
+ */
+class KeyValuesBuilder {
+ public:
+  /**
+   * @brief Creates builder.
+   * @param document Document to build.
+   * @param options Parse options.
+   * @return nothing.
+   */
+  KeyValuesBuilder(KeyValuesDocument& document,
+                   const KeyValuesOptions& options) noexcept
+      : document_{document}, options_{options}, include_stack_{} {}
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(KeyValuesBuilder);
+
+  /**
+   * @brief Builds document from |content|.
+   * @param content Content.
+   * @param source_name Source name for errors.
+   * @param options Parse options.
+   * @param source_path Source file path.  Empty when content is not file.
+   * @return Document or parse error.
+   */
+  [[nodiscard]] static std::expected<KeyValuesDocument, KeyValuesError> Build(
+      std::string_view content, std::string_view source_name,
+      const KeyValuesOptions& options,
+      const std::filesystem::path& source_path) {
+    // Keys, values and nodes usually take less than source text.
+    KeyValuesDocument document{std::max(content.size(), std::size_t{4096})};
+    KeyValuesBuilder builder{document, options};
+
+    builder.CreateRoot();
+
+    // Source file including itself is a cycle too.
+    if (!source_path.empty()) {
+      builder.include_stack_.push_back(GetCanonicalPath(source_path));
+    }
+
+    auto rc = builder.Parse(content, source_name, options.include_directory,
+                            *document.root_, 0);
+    if (!rc.has_value()) {
+      return std::unexpected{std::move(rc.error())};
+    }
+
+    builder.BuildIndices(*document.root_);
+
+    return document;
+  }
+
+  /**
+   * @brief Creates document root.
+   */
+  void CreateRoot() {
+    document_.root_ = NewKeyValue(Intern(std::string_view{}), {}, true);
+  }
+
+  /**
+   * @brief Parses |content| into |root| section.
+   * @param content Content.
+   * @param source_name Source name for errors.
+   * @param include_directory Directory to resolve relative includes.
+   * @param root Section to add top-level keys to.
+   * @param depth Include depth.
+   * @return Error, if any.
+   */
+  [[nodiscard]] std::expected<void, KeyValuesError> Parse(
+      std::string_view content, std::string_view source_name,
+      const std::filesystem::path& include_directory, KeyValue& root,
+      std::size_t depth) {
+    st::TokenStream tokens{content, kBreaks};
+    std::optional<st::StreamToken> lookahead;
+
+    const auto next_token = [&]() {
+      if (lookahead.has_value()) {
+        return std::exchange(lookahead, std::nullopt);
+      }
+      return tokens.Next();
+    };
+    const auto error = [&](std::string message) {
+      return std::expected<void, KeyValuesError>{
+          std::unexpect, std::string{source_name}, tokens.GetTokenPosition(),
+          std::move(message)};
+    };
+
+    std::vector<OpenSection> sections;
+    sections.push_back({&root, LastChild(root), true, {}});
+
+    std::vector<std::filesystem::path> bases;
+
+    while (true) {
+      const auto key = next_token();
+      if (!key.has_value()) {
+        if (sections.size() > 1) {
+          return error("'}' expected, but end of file found.");
+        }
+        break;
+      }
+
+      if (IsUnquoted(*key, "}")) {
+        if (sections.size() == 1) return error("Unexpected '}'.");
+
+        sections.pop_back();
+        continue;
+      }
+
+      if (IsUnquoted(*key, "{")) return error("Key expected, but '{' found.");
+
+      if (sections.size() == 1 &&
+          (IsUnquoted(*key, "#include") || IsUnquoted(*key, "#base"))) {
+        const bool is_base{key->value == "#base"};
+        const auto path = next_token();
+        if (!path.has_value() || IsUnquoted(*path, "{") ||
+            IsUnquoted(*path, "}")) {
+          return error("File path expected after '" + std::string{key->value} +
+                       "'.");
+        }
+
+        if (depth >= kMaxIncludeDepth) {
+          return error("Too deep #include / #base nesting.");
+        }
+
+        std::filesystem::path include_path{include_directory /
+                                           std::string{path->value}};
+        // Cycle would include files again and again till max depth, so
+        // reject it right away.
+        if (auto cycle = FindIncludeCycle(include_path)) {
+          return error(std::move(*cycle));
+        }
+
+        if (is_base) {
+          // Base keys are defaults, so merge them after own keys.
+          bases.emplace_back(std::move(include_path));
+          continue;
+        }
+
+        auto rc = Include(include_path, false, root, depth);
+        if (!rc.has_value()) return rc;
+
+        sections.front().last_child = LastChild(root);
+        continue;
+      }
+
+      auto value = next_token();
+      if (!value.has_value()) {
+        return error("Value or '{' expected for key '" +
+                     std::string{key->value} + "', but end of file found.");
+      }
+
+      bool is_enabled{sections.back().is_enabled};
+
+      if (IsCondition(*value)) {
+        const auto condition =
+            EvaluateCondition(value->value, options_.conditions);
+        if (!condition.has_value()) {
+          return error("Invalid condition '" + std::string{value->value} +
+                       "'.");
+        }
+
+        is_enabled = is_enabled && *condition;
+
+        value = next_token();
+        if (!value.has_value()) {
+          return error("'{' expected after condition for key '" +
+                       std::string{key->value} + "'.");
+        }
+      }
+
+      if (IsUnquoted(*value, "}")) {
+        return error("Value or '{' expected for key '" +
+                     std::string{key->value} + "', but '}' found.");
+      }
+
+      if (IsUnquoted(*value, "{")) {
+        KeyValue* section{NewKeyValue(Intern(key->value), {}, true)};
+        if (is_enabled) AppendChild(sections.back(), section);
+
+        sections.push_back({section, nullptr, is_enabled, {}});
+        continue;
+      }
+
+      // Value may be followed by condition.
+      const auto maybe_condition = next_token();
+      if (maybe_condition.has_value() && IsCondition(*maybe_condition)) {
+        const auto condition =
+            EvaluateCondition(maybe_condition->value, options_.conditions);
+        if (!condition.has_value()) {
+          return error("Invalid condition '" +
+                       std::string{maybe_condition->value} + "'.");
+        }
+
+        is_enabled = is_enabled && *condition;
+      } else {
+        lookahead = maybe_condition;
+      }
+
+      if (is_enabled) {
+        AppendChild(sections.back(),
+                    NewKeyValue(Intern(key->value), CopyString(value->value),
+                                false));
+      }
+    }
+
+    for (const auto& base : bases) {
+      auto rc = Include(base, true, root, depth);
+      if (!rc.has_value()) return rc;
+    }
+
+    return {};
+  }
+
+  /**
+   * @brief Builds hashed children indices for large sections.
+   * @param key_value Key value to build indices for.
+   */
+  void BuildIndices(KeyValue& key_value) {
+    for (KeyValue* child{key_value.first_child_}; child != nullptr;
+         child = child->next_sibling_) {
+      BuildIndices(*child);
+    }
+
+    if (key_value.children_count_ < kIndexedChildrenCount) return;
+
+    const std::uint32_t capacity{
+        std::bit_ceil(key_value.children_count_ * 2U)};
+    auto** index = static_cast<const KeyValue**>(
+        Allocate(capacity * sizeof(KeyValue*), alignof(KeyValue*)));
+    std::fill_n(index, capacity, nullptr);
+
+    const std::uint32_t mask{capacity - 1};
+
+    for (const KeyValue* child{key_value.first_child_}; child != nullptr;
+         child = child->next_sibling_) {
+      auto slot = static_cast<std::uint32_t>(child->key_->hash & mask);
+
+      // First key wins, as in linear search.
+      while (index[slot] != nullptr && index[slot]->key_ != child->key_) {
+        slot = (slot + 1) & mask;
+      }
+
+      if (index[slot] == nullptr) index[slot] = child;
+    }
+
+    key_value.children_index_ = index;
+    key_value.children_index_mask_ = mask;
+  }
+
+ private:
+  /**
+   * @brief Section being parsed.
+   */
+  struct OpenSection {
+    /**
+     * @brief Section.
+     */
+    KeyValue* section;
+    /**
+     * @brief Last child to append next one after.
+     */
+    KeyValue* last_child;
+    /**
+     * @brief Are section keys enabled by conditions?
+     */
+    bool is_enabled;
+
+    WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 7> pad_;
+  };
+
+  /**
+   * @brief Document.
+   */
+  KeyValuesDocument& document_;
+  /**
+   * @brief Parse options.
+   */
+  const KeyValuesOptions& options_;
+  /**
+   * @brief Canonical paths of files being parsed, from root to innermost one.
+   */
+  std::vector<std::filesystem::path> include_stack_;
+
+  /**
+   * @brief Gets canonical |path|, so different spellings of the same file
+   * match.
+   * @param path Path.
+   * @return Canonical path, or normalized absolute one on error.
+   */
+  [[nodiscard]] static std::filesystem::path GetCanonicalPath(
+      const std::filesystem::path& path) {
+    std::error_code rc;
+    auto canonical_path = std::filesystem::weakly_canonical(path, rc);
+    if (!rc) return canonical_path;
+
+    auto absolute_path = std::filesystem::absolute(path, rc);
+    return (!rc ? absolute_path : path).lexically_normal();
+  }
+
+  /**
+   * @brief Finds include cycle which |path| include makes.
+   * @param path Path to include.
+   * @return Cycle error message naming include chain, or nullopt if no
+   * cycle.
+   */
+  [[nodiscard]] std::optional<std::string> FindIncludeCycle(
+      const std::filesystem::path& path) const {
+    const std::filesystem::path canonical_path{GetCanonicalPath(path)};
+
+    const auto it = std::ranges::find(include_stack_, canonical_path);
+    if (it == include_stack_.end()) return std::nullopt;
+
+    std::string chain{"#include / #base cycle: "};
+    for (auto file = it; file != include_stack_.end(); ++file) {
+      chain += file->string();
+      chain += " -> ";
+    }
+    chain += canonical_path.string();
+    chain += '.';
+    return chain;
+  }
+
+  /**
+   * @brief Allocates |size| bytes in document arena.
+   * @param size Size.
+   * @param alignment Alignment.
+   * @return Memory.
+   */
+  [[nodiscard]] void* Allocate(std::size_t size, std::size_t alignment) {
+    document_.arena_bytes_ += size;
+    return document_.arena_->allocate(size, alignment);
+  }
+
+  /**
+   * @brief Copies |string| to document arena.
+   * @param string String.
+   * @return Copied string.
+   */
+  [[nodiscard]] std::string_view CopyString(std::string_view string) {
+    if (string.empty()) return {};
+
+    auto* copy = static_cast<char*>(Allocate(string.size(), alignof(char)));
+    std::memcpy(copy, string.data(), string.size());
+    return {copy, string.size()};
+  }
+
+  /**
+   * @brief Interns |key|.
+   * @param key Key.
+   * @return Interned key name.
+   */
+  [[nodiscard]] const KeyName* Intern(std::string_view key) {
+    auto& key_names = *document_.key_names_;
+
+    const auto it = key_names.find(key);
+    if (it != key_names.end()) return it->second;
+
+    const std::string_view text{CopyString(key)};
+    auto* key_name = new (Allocate(sizeof(KeyName), alignof(KeyName)))
+        KeyName{text, KeyHash(text)};
+
+    key_names.emplace(text, key_name);
+    return key_name;
+  }
+
+  /**
+   * @brief Creates key value in document arena.
+   * @param key Key name.
+   * @param value Value.
+   * @param is_section Is section?
+   * @return Key value.
+   */
+  [[nodiscard]] KeyValue* NewKeyValue(const KeyName* key,
+                                      std::string_view value,
+                                      bool is_section) {
+    return new (Allocate(sizeof(KeyValue), alignof(KeyValue)))
+        KeyValue{key, value, is_section};
+  }
+
+  /**
+   * @brief Appends |child| to |section|.
+   * @param section Section.
+   * @param child Child.
+   */
+  static void AppendChild(OpenSection& section, KeyValue* child) noexcept {
+    child->next_sibling_ = nullptr;
+
+    if (section.last_child != nullptr) {
+      section.last_child->next_sibling_ = child;
+    } else {
+      section.section->first_child_ = child;
+    }
+
+    section.last_child = child;
+    ++section.section->children_count_;
+  }
+
+  /**
+   * @brief Gets last child of |section|.
+   * @param section Section.
+   * @return Last child or nullptr.
+   */
+  [[nodiscard]] WB_ATTRIBUTE_PURE static KeyValue* LastChild(
+      KeyValue& section) noexcept {
+    KeyValue* last{section.first_child_};
+    while (last != nullptr && last->next_sibling_ != nullptr) {
+      last = last->next_sibling_;
+    }
+    return last;
+  }
+
+  /**
+   * @brief Merges |base| children into |section|.  Existing keys win, sections
+   * are merged recursively.
+   * @param base Base section.
+   * @param section Section.
+   */
+  static void Merge(KeyValue& base, KeyValue& section) noexcept {
+    OpenSection open_section{&section, LastChild(section), true, {}};
+
+    KeyValue* child{base.first_child_};
+    while (child != nullptr) {
+      KeyValue* next_child{child->next_sibling_};
+
+      KeyValue* existing{const_cast<KeyValue*>(section.FindChild(child->key_))};
+      if (existing == nullptr) {
+        AppendChild(open_section, child);
+      } else if (existing->is_section_ && child->is_section_) {
+        Merge(*child, *existing);
+      }
+
+      child = next_child;
+    }
+  }
+
+  /**
+   * @brief Parses file |path| and includes it into |root|.
+   * @param path File path.
+   * @param is_base Is #base, otherwise #include.
+   * @param root Root.
+   * @param depth Include depth.
+   * @return Error, if any.
+   */
+  [[nodiscard]] std::expected<void, KeyValuesError> Include(
+      const std::filesystem::path& path, bool is_base, KeyValue& root,
+      std::size_t depth) {
+    const auto file = ScopedMemoryMappedFile::New(path);
+    if (!file.has_value()) {
+      return std::expected<void, KeyValuesError>{
+          std::unexpect, path.string(), st::TextPosition{1, 1},
+          "Unable to open included file: " + file.error().message()};
+    }
+
+    KeyValue* included{NewKeyValue(root.key_, {}, true)};
+
+    include_stack_.push_back(GetCanonicalPath(path));
+    auto rc = Parse(st::AsStringView(file->data()), path.string(),
+                    path.parent_path(), *included, depth + 1);
+    include_stack_.pop_back();
+    if (!rc.has_value()) return rc;
+
+    document_.included_files_.push_back(path);
+
+    if (is_base) {
+      Merge(*included, root);
+    } else {
+      OpenSection open_section{&root, LastChild(root), true, {}};
+
+      KeyValue* child{included->first_child_};
+      while (child != nullptr) {
+        KeyValue* next_child{child->next_sibling_};
+        AppendChild(open_section, child);
+        child = next_child;
+      }
+    }
+
+    return {};
+  }
+};
+
+}  // namespace internal
+
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_PURE const KeyValue*
+KeyValue::FindChild(
+    std::string_view key) const noexcept {
+  const std::uint64_t hash{KeyHash(key)};
+
+  if (children_index_ != nullptr) {
+    auto slot = static_cast<std::uint32_t>(hash & children_index_mask_);
+
+    while (const KeyValue* child{children_index_[slot]}) {
+      if (child->key_->hash == hash && KeyEquals(child->key_->text, key)) {
+        return child;
+      }
+
+      slot = (slot + 1) & children_index_mask_;
+    }
+
+    return nullptr;
+  }
+
+  for (const KeyValue* child{first_child_}; child != nullptr;
+       child = child->next_sibling_) {
+    if (child->key_->hash == hash && KeyEquals(child->key_->text, key)) {
+      return child;
+    }
+  }
+
+  return nullptr;
+}
+
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_PURE const KeyValue*
+KeyValue::FindChild(
+    const KeyName* key) const noexcept {
+  if (children_index_ != nullptr) {
+    auto slot = static_cast<std::uint32_t>(key->hash & children_index_mask_);
+
+    while (const KeyValue* child{children_index_[slot]}) {
+      if (child->key_ == key) return child;
+
+      slot = (slot + 1) & children_index_mask_;
+    }
+
+    return nullptr;
+  }
+
+  for (const KeyValue* child{first_child_}; child != nullptr;
+       child = child->next_sibling_) {
+    if (child->key_ == key) return child;
+  }
+
+  return nullptr;
+}
+
+KeyValuesDocument::KeyValuesDocument(std::size_t arena_initial_size) noexcept
+    : arena_{std::make_unique<std::pmr::monotonic_buffer_resource>(
+          arena_initial_size)},
+      key_names_{std::make_unique<KeyNames>(arena_.get())},
+      included_files_{},
+      root_{nullptr},
+      arena_bytes_{0} {}
+
+KeyValuesDocument::KeyValuesDocument(KeyValuesDocument&&) noexcept = default;
+KeyValuesDocument& KeyValuesDocument::operator=(
+    KeyValuesDocument&& other) noexcept {
+  // Key names live in arena, so release them before arena.
+  key_names_ = std::move(other.key_names_);
+  arena_ = std::move(other.arena_);
+  included_files_ = std::move(other.included_files_);
+  root_ = std::exchange(other.root_, nullptr);
+  arena_bytes_ = std::exchange(other.arena_bytes_, 0);
+  return *this;
+}
+
+KeyValuesDocument::~KeyValuesDocument() noexcept = default;
+
+[[nodiscard]] std::expected<KeyValuesDocument, KeyValuesError>
+KeyValuesDocument::Parse(std::string_view content,
+                         std::string_view source_name,
+                         const KeyValuesOptions& options) noexcept {
+  return internal::KeyValuesBuilder::Build(content, source_name, options, {});
+}
+
+[[nodiscard]] std::expected<KeyValuesDocument, KeyValuesError>
+KeyValuesDocument::ParseFile(const std::filesystem::path& path,
+                             const KeyValuesOptions& options) noexcept {
+  const auto file = ScopedMemoryMappedFile::New(path);
+  if (!file.has_value()) {
+    return std::unexpected{KeyValuesError{
+        path.string(), st::TextPosition{1, 1},
+        "Unable to open file: " + file.error().message()}};
+  }
+
+  if (options.include_directory.empty()) {
+    KeyValuesOptions file_options{options.conditions, path.parent_path()};
+    return internal::KeyValuesBuilder::Build(st::AsStringView(file->data()),
+                                             path.string(), file_options, path);
+  }
+
+  return internal::KeyValuesBuilder::Build(st::AsStringView(file->data()),
+                                           path.string(), options, path);
+}
+
+[[nodiscard]] WB_ATTRIBUTE_PURE const KeyName*
+KeyValuesDocument::FindKeyName(
+    std::string_view key) const noexcept {
+  const auto it = key_names_->find(key);
+  return it != key_names_->end() ? it->second : nullptr;
+}
+
+}  // namespace wb::base::parsers::kv
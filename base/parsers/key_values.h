@@ -0,0 +1,458 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// KeyValues (KV1) text format parser.  Parses into compact tree allocated in
+// document bump arena, with interned keys and hashed children lookup.
+//
+// Syntax:
+//   "key" "value" [$CONDITION]
+//   "key" [$CONDITION] { "nested_key" "value" }
+//   #include "file.txt"  // Appends file top-level keys.
+//   #base "file.txt"     // Merges file top-level keys, existing keys win.
+//
+// Keys are case-insensitive.  Quotes are optional for tokens without
+// whitespaces and braces.  Conditions are [$NAME], [!$NAME] joined with || and
+// &&, || has lower precedence.
+
+#ifndef WB_BASE_PARSERS_KEY_VALUES_H_
+#define WB_BASE_PARSERS_KEY_VALUES_H_
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "base/config.h"
+#include "base/macroses.h"
+#include "base/parsers/token_stream.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::parsers::kv {
+
+/**
+ * @brief Converts ASCII |ch| to lower case.
+ * @param ch Char.
+ * @return Lower case char.
+ */
+[[nodiscard]] WB_ATTRIBUTE_CONST constexpr char ToLowerAscii(char ch) noexcept {
+  return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+/**
+ * @brief Case-insensitive key hash (FNV-1a over ASCII lower case chars).
+ * @param key Key.
+ * @return Hash.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE constexpr std::uint64_t KeyHash(
+    std::string_view key) noexcept {
+  std::uint64_t hash{0xcbf29ce484222325ULL};
+  for (char ch : key) {
+    hash = (hash ^ static_cast<unsigned char>(ToLowerAscii(ch))) *
+           0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Case-insensitive key equality.
+ * @param left Left key.
+ * @param right Right key.
+ * @return true if keys are equal ignoring ASCII case.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE constexpr bool KeyEquals(
+    std::string_view left, std::string_view right) noexcept {
+  if (left.size() != right.size()) return false;
+
+  for (std::size_t i{0}; i < left.size(); ++i) {
+    if (ToLowerAscii(left[i]) != ToLowerAscii(right[i])) return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Case-insensitive key hasher for hash containers.
+ */
+struct KeyHasher {
+  [[nodiscard]] std::size_t operator()(std::string_view key) const noexcept {
+    return KeyHash(key);
+  }
+};
+
+/**
+ * @brief Case-insensitive key comparer for hash containers.
+ */
+struct KeyComparer {
+  [[nodiscard]] bool operator()(std::string_view left,
+                                std::string_view right) const noexcept {
+    return KeyEquals(left, right);
+  }
+};
+
+/**
+ * @brief Interned key name.  Same keys in document share single key name, so
+ * keys can be compared by pointer.
+ */
+struct KeyName {
+  /**
+   * @brief Key text, as first met in document.
+   */
+  std::string_view text;
+  /**
+   * @brief KeyHash of text.
+   */
+  std::uint64_t hash;
+};
+
+class KeyValuesDocument;
+
+namespace internal {
+
+class KeyValuesBuilder;
+
+}  // namespace internal
+
+/**
+ * @brief Key with value or with child keys.  Lives in document arena.
+ */
+class KeyValue {
+ public:
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(KeyValue);
+
+  /**
+   * @brief Gets key.
+   * @return Key.
+   */
+  [[nodiscard]] std::string_view GetKey() const noexcept {
+    return key_->text;
+  }
+
+  /**
+   * @brief Gets interned key name.
+   * @return Key name.
+   */
+  [[nodiscard]] const KeyName* GetKeyName() const noexcept { return key_; }
+
+  /**
+   * @brief Gets value.  Empty for sections.
+   * @return Value.
+   */
+  [[nodiscard]] std::string_view GetValue() const noexcept { return value_; }
+
+  /**
+   * @brief Parses value as number.
+   * @tparam T Number type.
+   * @return Number or nullopt if value is not a number.
+   */
+  template <typename T>
+    requires std::is_arithmetic_v<T>
+  [[nodiscard]] WB_ATTRIBUTE_PURE std::optional<T> GetValueAs()
+      const noexcept {
+    T number{};
+    const auto [end, rc] = std::from_chars(
+        value_.data(), value_.data() + value_.size(), number);
+    if (rc != std::errc{} || end != value_.data() + value_.size()) {
+      return std::nullopt;
+    }
+    return number;
+  }
+
+  /**
+   * @brief Is key section with child keys ({ ... })?
+   * @return true if section.
+   */
+  [[nodiscard]] bool IsSection() const noexcept { return is_section_; }
+
+  /**
+   * @brief Gets child keys count.
+   * @return Child keys count.
+   */
+  [[nodiscard]] std::uint32_t GetChildrenCount() const noexcept {
+    return children_count_;
+  }
+
+  /**
+   * @brief Finds first child with |key|.  Uses hashed index for large
+   * sections.
+   * @param key Key.
+   * @return Child or nullptr.
+   */
+  [[nodiscard]] WB_BASE_API WB_ATTRIBUTE_PURE const KeyValue* FindChild(
+      std::string_view key) const noexcept;
+
+  /**
+   * @brief Finds first child with interned |key|.  Compares keys by pointer.
+   * @param key Interned key from same document.
+   * @return Child or nullptr.
+   */
+  [[nodiscard]] WB_BASE_API WB_ATTRIBUTE_PURE const KeyValue* FindChild(
+      const KeyName* key) const noexcept;
+
+  /**
+   * @brief Child keys iterator.
+   */
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = KeyValue;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const KeyValue*;
+    using reference = const KeyValue&;
+
+    Iterator() noexcept : key_value_{nullptr} {}
+    explicit Iterator(const KeyValue* key_value) noexcept
+        : key_value_{key_value} {}
+
+    [[nodiscard]] reference operator*() const noexcept { return *key_value_; }
+    [[nodiscard]] pointer operator->() const noexcept { return key_value_; }
+
+    Iterator& operator++() noexcept {
+      key_value_ = key_value_->next_sibling_;
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      Iterator it{*this};
+      ++*this;
+      return it;
+    }
+
+    [[nodiscard]] bool operator==(const Iterator&) const noexcept = default;
+
+   private:
+    /**
+     * @brief Current key.
+     */
+    const KeyValue* key_value_;
+  };
+
+  /**
+   * @brief Gets first child iterator.
+   * @return Iterator.
+   */
+  [[nodiscard]] Iterator begin() const noexcept {
+    return Iterator{first_child_};
+  }
+
+  /**
+   * @brief Gets after last child iterator.
+   * @return Iterator.
+   */
+  [[nodiscard]] Iterator end() const noexcept { return Iterator{}; }
+
+ private:
+  friend class internal::KeyValuesBuilder;
+
+  /**
+   * @brief Key name.
+   */
+  const KeyName* key_;
+  /**
+   * @brief Value.
+   */
+  std::string_view value_;
+  /**
+   * @brief First child key.
+   */
+  KeyValue* first_child_;
+  /**
+   * @brief Next sibling key.
+   */
+  KeyValue* next_sibling_;
+  /**
+   * @brief Open addressing children index by key hash.  nullptr for small
+   * sections, they are scanned linearly.
+   */
+  const KeyValue** children_index_;
+  /**
+   * @brief Children count.
+   */
+  std::uint32_t children_count_;
+  /**
+   * @brief Children index mask (capacity - 1).
+   */
+  std::uint32_t children_index_mask_;
+  /**
+   * @brief Is key section?
+   */
+  bool is_section_;
+
+  WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 7> pad_;
+
+  /**
+   * @brief Creates key value.
+   * @param key Key name.
+   * @param value Value.
+   * @param is_section Is section?
+   * @return nothing.
+   */
+  KeyValue(const KeyName* key, std::string_view value,
+           bool is_section) noexcept
+      : key_{key},
+        value_{value},
+        first_child_{nullptr},
+        next_sibling_{nullptr},
+        children_index_{nullptr},
+        children_count_{0},
+        children_index_mask_{0},
+        is_section_{is_section},
+        pad_{} {}
+
+  ~KeyValue() noexcept = default;
+};
+
+/**
+ * @brief KeyValues parse error.
+ */
+struct KeyValuesError {
+  /**
+   * @brief File or source name.
+   */
+  std::string source_name;
+  /**
+   * @brief Error position.
+   */
+  st::TextPosition position;
+  /**
+   * @brief Error message.
+   */
+  std::string message;
+};
+
+/**
+ * @brief KeyValues parse options.
+ */
+struct KeyValuesOptions {
+  /**
+   * @brief Defined conditions, without $, like WIN32, POSIX.  Case-insensitive.
+   */
+  std::span<const std::string_view> conditions;
+  /**
+   * @brief Directory to resolve relative #include / #base paths.  Directory of
+   * parsed file by default.
+   */
+  std::filesystem::path include_directory;
+};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Parsed KeyValues document.  Owns arena with all keys and values.
+   */
+  class WB_BASE_API KeyValuesDocument {
+   public:
+    /**
+     * @brief Parses KeyValues document from |content|.
+     * @param content Content.  Can be released after parse.
+     * @param source_name Source name for errors.
+     * @param options Parse options.
+     * @return Document or parse error.
+     */
+    [[nodiscard]] static std::expected<KeyValuesDocument, KeyValuesError>
+    Parse(std::string_view content, std::string_view source_name,
+          const KeyValuesOptions& options) noexcept;
+
+    /**
+     * @brief Parses KeyValues document from memory mapped file |path|.
+     * @param path File path.
+     * @param options Parse options.
+     * @return Document or parse error.
+     */
+    [[nodiscard]] static std::expected<KeyValuesDocument, KeyValuesError>
+    ParseFile(const std::filesystem::path& path,
+              const KeyValuesOptions& options) noexcept;
+
+    KeyValuesDocument(KeyValuesDocument&&) noexcept;
+    KeyValuesDocument& operator=(KeyValuesDocument&&) noexcept;
+
+    WB_NO_COPY_CTOR_AND_ASSIGNMENT(KeyValuesDocument);
+
+    ~KeyValuesDocument() noexcept;
+
+    /**
+     * @brief Gets root.  Root is section with top-level keys.
+     * @return Root.
+     */
+    [[nodiscard]] const KeyValue& GetRoot() const noexcept { return *root_; }
+
+    /**
+     * @brief Finds interned key name.
+     * @param key Key.
+     * @return Key name or nullptr if no such key in document.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE const KeyName* FindKeyName(
+        std::string_view key) const noexcept;
+
+    /**
+     * @brief Gets bytes allocated in arena.
+     * @return Arena bytes.
+     */
+    [[nodiscard]] std::size_t GetArenaBytes() const noexcept {
+      return arena_bytes_;
+    }
+
+    /**
+     * @brief Gets files included by #include / #base, in include order.
+     * @return Included files.
+     */
+    [[nodiscard]] std::span<const std::filesystem::path> GetIncludedFiles()
+        const noexcept {
+      return included_files_;
+    }
+
+   private:
+    friend class internal::KeyValuesBuilder;
+
+    using KeyNames =
+        std::pmr::unordered_map<std::string_view, const KeyName*, KeyHasher,
+                                KeyComparer>;
+
+    /**
+     * @brief Arena.  Heap allocated so document is movable.
+     */
+    un<std::pmr::monotonic_buffer_resource> arena_;
+    /**
+     * @brief Interned key names.
+     */
+    un<KeyNames> key_names_;
+    /**
+     * @brief Files included by #include / #base.
+     */
+    std::vector<std::filesystem::path> included_files_;
+    /**
+     * @brief Root.
+     */
+    KeyValue* root_;
+    /**
+     * @brief Bytes allocated in arena.
+     */
+    std::size_t arena_bytes_;
+
+    /**
+     * @brief Creates empty document.
+     * @param arena_initial_size Arena first block size.
+     * @return nothing.
+     */
+    explicit KeyValuesDocument(std::size_t arena_initial_size) noexcept;
+  };
+
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+}  // namespace wb::base::parsers::kv
+
+#endif  // !WB_BASE_PARSERS_KEY_VALUES_H_
@@ -0,0 +1,121 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Store of compiled KeyValues files, indexed by asset relative path.
+
+#include "key_values_store.h"
+
+#include <algorithm>
+
+namespace wb::base::parsers::kv {
+
+[[nodiscard]] WB_BASE_API bool MatchesGlob(std::string_view glob,
+                                           std::string_view path) noexcept {
+  while (!glob.empty()) {
+    const char ch{glob.front()};
+
+    if (ch == '*') {
+      if (glob.starts_with("**")) {
+        glob.remove_prefix(2);
+
+        // "**/" matches no directories, too.
+        if (glob.starts_with('/') && MatchesGlob(glob.substr(1), path)) {
+          return true;
+        }
+
+        for (std::size_t i{0}; i <= path.size(); ++i) {
+          if (MatchesGlob(glob, path.substr(i))) return true;
+        }
+
+        return false;
+      }
+
+      glob.remove_prefix(1);
+
+      for (std::size_t i{0};; ++i) {
+        if (MatchesGlob(glob, path.substr(i))) return true;
+        if (i == path.size() || path[i] == '/') return false;
+      }
+    }
+
+    if (path.empty()) return false;
+
+    if (ch == '?') {
+      if (path.front() == '/') return false;
+    } else if (ToLowerAscii(ch) != ToLowerAscii(path.front())) {
+      return false;
+    }
+
+    glob.remove_prefix(1);
+    path.remove_prefix(1);
+  }
+
+  return path.empty();
+}
+
+[[nodiscard]] WB_BASE_API std2::result<std::vector<std::string>>
+FindFilesByGlob(const std::filesystem::path& root,
+                std::span<const std::string_view> globs) noexcept {
+  using std2::result;
+
+  std::vector<std::string> files;
+  std::error_code rc;
+
+  std::filesystem::recursive_directory_iterator it{
+      root, std::filesystem::directory_options::skip_permission_denied, rc};
+
+  for (; !rc && it != std::filesystem::recursive_directory_iterator{};
+       it.increment(rc)) {
+    if (!it->is_regular_file(rc) || rc) continue;
+
+    std::string path{it->path().lexically_relative(root).generic_string()};
+
+    if (std::ranges::any_of(globs, [&path](std::string_view glob) {
+          return MatchesGlob(glob, path);
+        })) {
+      files.emplace_back(std::move(path));
+    }
+  }
+
+  if (rc) [[unlikely]] {
+    return result<std::vector<std::string>>{std::unexpect, rc};
+  }
+
+  std::ranges::sort(files);
+  return files;
+}
+
+KeyValuesStore::KeyValuesStore() noexcept = default;
+
+KeyValuesStore::KeyValuesStore(std::vector<KeyValuesFile> files) noexcept
+    : files_{std::move(files)} {
+  std::ranges::sort(files_, {}, &KeyValuesFile::path);
+
+  index_.reserve(files_.size());
+  for (std::size_t i{0}; i < files_.size(); ++i) {
+    index_.emplace(files_[i].path, i);
+  }
+}
+
+KeyValuesStore::KeyValuesStore(KeyValuesStore&&) noexcept = default;
+KeyValuesStore& KeyValuesStore::operator=(KeyValuesStore&&) noexcept = default;
+
+KeyValuesStore::~KeyValuesStore() noexcept = default;
+
+[[nodiscard]] const CompiledKeyValues* KeyValuesStore::Find(
+    std::string_view path) const noexcept {
+  const auto it = index_.find(path);
+  return it != index_.end() ? &files_[it->second].file.GetKeyValues()
+                            : nullptr;
+}
+
+[[nodiscard]] std::size_t KeyValuesStore::GetCompiledBytes() const noexcept {
+  std::size_t compiled_bytes{0};
+  for (const auto& file : files_) {
+    compiled_bytes += file.file.GetKeyValues().GetBytes().size();
+  }
+  return compiled_bytes;
+}
+
+}  // namespace wb::base::parsers::kv
@@ -0,0 +1,137 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Store of compiled KeyValues files, indexed by asset relative path.
+
+#ifndef WB_BASE_PARSERS_KEY_VALUES_STORE_H_
+#define WB_BASE_PARSERS_KEY_VALUES_STORE_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "base/config.h"
+#include "base/macroses.h"
+#include "base/parsers/compiled_key_values.h"
+#include "base/parsers/key_values.h"
+#include "base/std2/system_error_ext.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::parsers::kv {
+
+/**
+ * @brief Checks |path| matches |glob|.  Case-insensitive, as asset paths are.
+ * '?' matches any char except '/', '*' matches any chars except '/', '**'
+ * matches any chars including '/', and '**' followed by '/' matches zero or
+ * more directories.
+ * @param glob Glob, like "**.vmt".
+ * @param path Generic path ('/' separators).
+ * @return true if |path| matches |glob|.
+ */
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_PURE bool MatchesGlob(
+    std::string_view glob, std::string_view path) noexcept;
+
+/**
+ * @brief Finds regular files under |root| which relative paths match any of
+ * |globs|.
+ * @param root Root directory.
+ * @param globs Globs.
+ * @return Generic relative paths sorted ordinally, so order does not depend on
+ * file system.
+ */
+[[nodiscard]] WB_BASE_API std2::result<std::vector<std::string>>
+FindFilesByGlob(const std::filesystem::path& root,
+                std::span<const std::string_view> globs) noexcept;
+
+/**
+ * @brief Compiled KeyValues file.
+ */
+struct KeyValuesFile {
+  /**
+   * @brief Generic path relative to assets root.
+   */
+  std::string path;
+  /**
+   * @brief Compiled KeyValues.
+   */
+  CompiledKeyValuesFile file;
+};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Immutable store of compiled KeyValues files with case-insensitive
+   * path index.  Files are ordered by path, so store is the same regardless of
+   * order files were parsed in.
+   */
+  class WB_BASE_API KeyValuesStore {
+   public:
+    /**
+     * @brief Creates empty store.
+     * @return nothing.
+     */
+    KeyValuesStore() noexcept;
+
+    /**
+     * @brief Creates store from |files|.  When paths differ only by case,
+     * first one in ordinal order wins lookups.
+     * @param files Files in any order.
+     * @return nothing.
+     */
+    explicit KeyValuesStore(std::vector<KeyValuesFile> files) noexcept;
+
+    KeyValuesStore(KeyValuesStore&&) noexcept;
+    KeyValuesStore& operator=(KeyValuesStore&&) noexcept;
+
+    WB_NO_COPY_CTOR_AND_ASSIGNMENT(KeyValuesStore);
+
+    ~KeyValuesStore() noexcept;
+
+    /**
+     * @brief Finds KeyValues by asset relative |path|.
+     * @param path Generic relative path, like "scripts/weapons.txt".
+     * @return KeyValues or nullptr.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE const CompiledKeyValues* Find(
+        std::string_view path) const noexcept;
+
+    /**
+     * @brief Gets files ordered by path.
+     * @return Files.
+     */
+    [[nodiscard]] std::span<const KeyValuesFile> GetFiles() const noexcept {
+      return files_;
+    }
+
+    /**
+     * @brief Gets compiled bytes of all files.
+     * @return Compiled bytes.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE std::size_t GetCompiledBytes()
+        const noexcept;
+
+   private:
+    /**
+     * @brief Files ordered by path.
+     */
+    std::vector<KeyValuesFile> files_;
+    /**
+     * @brief Path to file index.  Keys point to files_ paths.
+     */
+    std::unordered_map<std::string_view, std::size_t, KeyHasher, KeyComparer>
+        index_;
+  };
+
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+}  // namespace wb::base::parsers::kv
+
+#endif  // !WB_BASE_PARSERS_KEY_VALUES_STORE_H_
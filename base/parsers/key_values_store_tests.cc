@@ -0,0 +1,110 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Store of compiled KeyValues files, indexed by asset relative path.
+
+#include "key_values_store.h"
+//
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesStoreTest, MatchesGlob) {
+  using namespace wb::base::parsers::kv;
+
+  EXPECT_TRUE(MatchesGlob("", ""));
+  EXPECT_TRUE(MatchesGlob("*", "file.txt"));
+  EXPECT_FALSE(MatchesGlob("*", "dir/file.txt"));
+  EXPECT_TRUE(MatchesGlob("*.TXT", "file.txt"));
+  EXPECT_FALSE(MatchesGlob("*.txt", "file.vmt"));
+  EXPECT_TRUE(MatchesGlob("file?.txt", "file1.txt"));
+  EXPECT_FALSE(MatchesGlob("dir?file.txt", "dir/file.txt"));
+  EXPECT_TRUE(MatchesGlob("scripts/*.txt", "scripts/weapons.txt"));
+  EXPECT_FALSE(MatchesGlob("scripts/*.txt", "scripts/npc/combine.txt"));
+  EXPECT_TRUE(MatchesGlob("scripts/**/*.txt", "scripts/weapons.txt"));
+  EXPECT_TRUE(MatchesGlob("scripts/**/*.txt", "scripts/npc/combine.txt"));
+  EXPECT_TRUE(MatchesGlob("scripts/**/*.txt", "Scripts/a/b/c/d.txt"));
+  EXPECT_FALSE(MatchesGlob("scripts/**/*.txt", "materials/a.txt"));
+  EXPECT_TRUE(MatchesGlob("**.vmt", "materials/brick/wall.vmt"));
+  EXPECT_FALSE(MatchesGlob("**.vmt", "materials/brick/wall.vtf"));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesStoreTest, FindFilesByGlob) {
+  using namespace wb::base::parsers::kv;
+
+  const std::filesystem::path root{std::filesystem::temp_directory_path() /
+                                   "wb_key_values_store_tests"};
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root / "scripts" / "npc");
+  std::filesystem::create_directories(root / "materials");
+
+  for (const auto* path : {"scripts/npc/b.txt", "scripts/a.txt",
+                           "scripts/c.res", "materials/wall.vmt"}) {
+    std::ofstream{root / path} << "key value";
+  }
+
+  constexpr std::array<std::string_view, 2> kGlobs{"scripts/**/*.txt",
+                                                   "**.vmt"};
+  const auto files = FindFilesByGlob(root, kGlobs);
+  ASSERT_TRUE(files.has_value()) << files.error().message();
+
+  const std::vector<std::string> expected{
+      "materials/wall.vmt", "scripts/a.txt", "scripts/npc/b.txt"};
+  EXPECT_EQ(expected, *files);
+
+  EXPECT_FALSE(FindFilesByGlob(root / "missing", kGlobs).has_value());
+
+  std::filesystem::remove_all(root);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesStoreTest, StoreIsOrderedAndIndexed) {
+  using namespace wb::base::parsers::kv;
+
+  std::vector<KeyValuesFile> files;
+  for (std::string_view path : {"scripts/b.txt", "Scripts/A.txt",
+                                "scripts/a.txt"}) {
+    auto document =
+        KeyValuesDocument::Parse(std::string{"path \""} + std::string{path} +
+                                     "\"",
+                                 path, {});
+    ASSERT_TRUE(document.has_value());
+
+    auto file = CompiledKeyValuesFile::FromDocument(*document);
+    ASSERT_TRUE(file.has_value());
+
+    files.push_back({std::string{path}, std::move(*file)});
+  }
+
+  const KeyValuesStore empty;
+  EXPECT_TRUE(empty.GetFiles().empty());
+  EXPECT_EQ(nullptr, empty.Find("scripts/a.txt"));
+
+  KeyValuesStore moved{std::move(files)};
+  const KeyValuesStore store{std::move(moved)};
+
+  ASSERT_EQ(3U, store.GetFiles().size());
+  EXPECT_EQ("Scripts/A.txt", store.GetFiles()[0].path);
+  EXPECT_EQ("scripts/a.txt", store.GetFiles()[1].path);
+  EXPECT_EQ("scripts/b.txt", store.GetFiles()[2].path);
+
+  // First one in ordinal order wins.
+  const CompiledKeyValues* a{store.Find("SCRIPTS/a.TXT")};
+  ASSERT_NE(nullptr, a);
+  EXPECT_EQ("Scripts/A.txt", a->GetRoot().FindChild("path")->GetValue());
+
+  const CompiledKeyValues* b{store.Find("scripts/b.txt")};
+  ASSERT_NE(nullptr, b);
+  EXPECT_EQ("scripts/b.txt", b->GetRoot().FindChild("path")->GetValue());
+
+  EXPECT_EQ(nullptr, store.Find("scripts/c.txt"));
+  EXPECT_GT(store.GetCompiledBytes(), 0U);
+}
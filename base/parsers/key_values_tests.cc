@@ -0,0 +1,257 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// KeyValues (KV1) text format parser.
+
+#include "key_values.h"
+//
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+namespace {
+
+/**
+ * @brief Parses |content| and expects success.
+ * @param content Content.
+ * @param options Options.
+ * @return Document.
+ */
+[[nodiscard]] wb::base::parsers::kv::KeyValuesDocument ParseOk(
+    std::string_view content,
+    const wb::base::parsers::kv::KeyValuesOptions& options = {}) {
+  auto document =
+      wb::base::parsers::kv::KeyValuesDocument::Parse(content, "test", options);
+  EXPECT_TRUE(document.has_value())
+      << (document.has_value() ? std::string{} : document.error().message);
+  return std::move(document).value();
+}
+
+/**
+ * @brief Writes |content| to |path|.
+ * @param path Path.
+ * @param content Content.
+ */
+void WriteFile(const std::filesystem::path& path, std::string_view content) {
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file << content;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesTest, ParseNestedSections) {
+  using namespace wb::base::parsers::kv;
+
+  const auto document = ParseOk(
+      "\"Game\"\n"
+      "{\n"
+      "  // Comment.\n"
+      "  title \"Half-Life 2\"\n"
+      "  \"FileSystem\" { \"SteamAppId\" \"220\" }\n"
+      "  empty {}\n"
+      "}\n"
+      "second value");
+
+  const KeyValue& root{document.GetRoot()};
+  ASSERT_EQ(2U, root.GetChildrenCount());
+
+  const KeyValue* game{root.FindChild("Game")};
+  ASSERT_NE(nullptr, game);
+  EXPECT_TRUE(game->IsSection());
+  EXPECT_EQ(3U, game->GetChildrenCount());
+  EXPECT_EQ("Half-Life 2", game->FindChild("title")->GetValue());
+
+  const KeyValue* file_system{game->FindChild("FileSystem")};
+  ASSERT_NE(nullptr, file_system);
+  EXPECT_EQ(220, file_system->FindChild("SteamAppId")->GetValueAs<int>());
+
+  const KeyValue* empty{game->FindChild("empty")};
+  ASSERT_NE(nullptr, empty);
+  EXPECT_TRUE(empty->IsSection());
+  EXPECT_EQ(0U, empty->GetChildrenCount());
+
+  EXPECT_EQ("value", root.FindChild("second")->GetValue());
+  EXPECT_EQ(nullptr, root.FindChild("third"));
+  EXPECT_GT(document.GetArenaBytes(), 0U);
+
+  std::array<std::string_view, 3> keys{"title", "FileSystem", "empty"};
+  std::size_t i{0};
+  for (const KeyValue& child : *game) {
+    ASSERT_LT(i, keys.size());
+    EXPECT_EQ(keys[i++], child.GetKey());
+  }
+  EXPECT_EQ(keys.size(), i);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesTest, KeysAreCaseInsensitiveAndInterned) {
+  using namespace wb::base::parsers::kv;
+
+  const auto document =
+      ParseOk("A { Name 1 } B { NAME 2 name 3 } Value 1.5 Bad 1x");
+
+  const KeyValue& root{document.GetRoot()};
+  const KeyName* name{document.FindKeyName("nAmE")};
+  ASSERT_NE(nullptr, name);
+  EXPECT_EQ("Name", name->text);
+  EXPECT_EQ(nullptr, document.FindKeyName("missing"));
+
+  EXPECT_EQ(name, root.FindChild("a")->begin()->GetKeyName());
+  // First key wins.
+  EXPECT_EQ("2", root.FindChild("b")->FindChild(name)->GetValue());
+  EXPECT_EQ("2", root.FindChild("B")->FindChild("name")->GetValue());
+
+  EXPECT_EQ(1.5, root.FindChild("value")->GetValueAs<double>());
+  EXPECT_EQ(std::nullopt, root.FindChild("bad")->GetValueAs<int>());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesTest, LargeSectionsUseIndex) {
+  using namespace wb::base::parsers::kv;
+
+  std::string content{"root {"};
+  for (int i{0}; i < 100; ++i) {
+    content += " key" + std::to_string(i) + " " + std::to_string(i * 2);
+  }
+  content += " KEY7 duplicate }";
+
+  const auto document = ParseOk(content);
+  const KeyValue* root{document.GetRoot().FindChild("root")};
+  ASSERT_NE(nullptr, root);
+  EXPECT_EQ(101U, root->GetChildrenCount());
+
+  for (int i{0}; i < 100; ++i) {
+    const std::string key{"Key" + std::to_string(i)};
+
+    const KeyValue* child{root->FindChild(key)};
+    ASSERT_NE(nullptr, child) << key;
+    EXPECT_EQ(i * 2, child->GetValueAs<int>());
+
+    EXPECT_EQ(child, root->FindChild(document.FindKeyName(key)));
+  }
+
+  EXPECT_EQ(nullptr, root->FindChild("key100"));
+  EXPECT_EQ("14", root->FindChild("key7")->GetValue());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesTest, Conditions) {
+  using namespace wb::base::parsers::kv;
+
+  constexpr std::array<std::string_view, 2> kConditions{"WIN32", "dx11"};
+
+  const auto document = ParseOk(
+      "win \"1\" [$WIN32]\n"
+      "posix \"1\" [$POSIX]\n"
+      "not_posix \"1\" [!$POSIX]\n"
+      "or \"1\" [$POSIX||$DX11]\n"
+      "and \"1\" [$WIN32&&$POSIX]\n"
+      "section [$POSIX] { nested 1 }\n"
+      "section [$WIN32] { nested 2 }\n",
+      KeyValuesOptions{kConditions, {}});
+
+  const KeyValue& root{document.GetRoot()};
+  EXPECT_NE(nullptr, root.FindChild("win"));
+  EXPECT_EQ(nullptr, root.FindChild("posix"));
+  EXPECT_NE(nullptr, root.FindChild("not_posix"));
+  EXPECT_NE(nullptr, root.FindChild("or"));
+  EXPECT_EQ(nullptr, root.FindChild("and"));
+  EXPECT_EQ("2", root.FindChild("section")->FindChild("nested")->GetValue());
+  EXPECT_EQ(4U, root.GetChildrenCount());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesTest, ErrorPositions) {
+  using namespace wb::base::parsers::kv;
+  using namespace wb::base::parsers::st;
+
+  struct ErrorCase {
+    std::string_view content;
+    TextPosition position;
+  };
+
+  constexpr std::array<ErrorCase, 5> kCases{
+      ErrorCase{"a {\n  b c\n", TextPosition{2, 5}},
+      ErrorCase{"a 1\n}", TextPosition{2, 1}},
+      ErrorCase{"a 1\n  {", TextPosition{2, 3}},
+      ErrorCase{"a { b }", TextPosition{1, 7}},
+      ErrorCase{"a 1 [WIN32]", TextPosition{1, 5}}};
+
+  for (const auto& error_case : kCases) {
+    const auto document =
+        KeyValuesDocument::Parse(error_case.content, "source.txt", {});
+
+    ASSERT_FALSE(document.has_value()) << error_case.content;
+    EXPECT_EQ("source.txt", document.error().source_name);
+    EXPECT_EQ(error_case.position, document.error().position)
+        << error_case.content << ": " << document.error().message;
+    EXPECT_FALSE(document.error().message.empty());
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(KeyValuesTest, IncludeAndBase) {
+  using namespace wb::base::parsers::kv;
+
+  const std::filesystem::path directory{
+      std::filesystem::temp_directory_path() / "wb_key_values_tests"};
+  std::filesystem::create_directories(directory);
+
+  WriteFile(directory / "included.txt", "included 1");
+  WriteFile(directory / "base.txt",
+            "section { from_base 1 overridden base } only_base 2");
+  WriteFile(directory / "main.txt",
+            "#include included.txt\n"
+            "#base \"base.txt\"\n"
+            "section { overridden main }\n");
+  WriteFile(directory / "cycle.txt", "#include cycle.txt");
+
+  const auto document =
+      KeyValuesDocument::ParseFile(directory / "main.txt", {});
+  ASSERT_TRUE(document.has_value()) << document.error().message;
+
+  const KeyValue& root{document->GetRoot()};
+  EXPECT_EQ("1", root.FindChild("included")->GetValue());
+  EXPECT_EQ("2", root.FindChild("only_base")->GetValue());
+
+  const KeyValue* section{root.FindChild("section")};
+  ASSERT_NE(nullptr, section);
+  EXPECT_EQ("main", section->FindChild("overridden")->GetValue());
+  EXPECT_EQ("1", section->FindChild("from_base")->GetValue());
+  EXPECT_EQ(3U, root.GetChildrenCount());
+
+  const auto self_cycle =
+      KeyValuesDocument::ParseFile(directory / "cycle.txt", {});
+  ASSERT_FALSE(self_cycle.has_value());
+  EXPECT_NE(std::string::npos, self_cycle.error().message.find("cycle"))
+      << self_cycle.error().message;
+
+  // Cycle is rejected on first re-entry, whatever path spelling.
+  WriteFile(directory / "cycle_a.txt", "a 1\n#base \"./cycle_b.txt\"");
+  WriteFile(directory / "cycle_b.txt", "b 2\n#include ../wb_key_values_tests/"
+                                      "cycle_a.txt");
+
+  const auto cycle =
+      KeyValuesDocument::ParseFile(directory / "cycle_a.txt", {});
+  ASSERT_FALSE(cycle.has_value());
+  EXPECT_EQ((directory / "./cycle_b.txt").string(), cycle.error().source_name);
+  EXPECT_EQ((wb::base::parsers::st::TextPosition{2, 10}),
+            cycle.error().position);
+  EXPECT_NE(std::string::npos, cycle.error().message.find(
+                                   "cycle_a.txt -> " +
+                                   std::filesystem::weakly_canonical(
+                                       directory / "cycle_b.txt")
+                                       .string() +
+                                   " -> "))
+      << cycle.error().message;
+  EXPECT_FALSE(
+      KeyValuesDocument::ParseFile(directory / "missing.txt", {}).has_value());
+
+  std::filesystem::remove_all(directory);
+}
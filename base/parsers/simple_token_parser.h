@@ -51,6 +51,7 @@
 #ifndef WB_BASE_PARSERS_SIMPLE_TOKEN_PARSER_H_
 #define WB_BASE_PARSERS_SIMPLE_TOKEN_PARSER_H_
 
+#include <cstddef>
 #include <ostream>
 #include <string>
 #include <string_view>
@@ -60,6 +61,7 @@
 #endif
 
 #include "base/parsers/character_set.h"
+#include "base/parsers/text_scanners.h"
 
 namespace wb::base::parsers::st {
 
@@ -109,15 +111,12 @@ struct ParsedToken {
             .current_token = std::string_view{}};
   }
 
-  size_t i{0};
-  char c{'\0'};
+  std::size_t i{0};
 
   // Skip white spaces and comments.
   do {
     // Skip white spaces.
-    while (i < data.size() && (c = data[i]) <= ' ') {
-      i++;
-    }
+    i = SkipWhitespaces(data, i);
 
     if (i == data.size()) {
       // End of string is found, no token.
@@ -126,62 +125,43 @@ struct ParsedToken {
     }
 
     // Skip // comments.
-    if (c == '/' && i + 1 < data.size() && data[i + 1] == '/') {
-      while (i < data.size() && data[i] != '\n') {
-        i++;
-      }
+    if (data[i] == '/' && i + 1 < data.size() && data[i + 1] == '/') {
+      i = FindChar(data, i + 2, '\n');
     } else {
       break;
     }
   } while (true);
 
   constexpr auto next_token = [](const std::string_view& d,
-                                 size_t idx) noexcept -> std::string_view {
+                                 std::size_t idx) noexcept -> std::string_view {
     return idx < d.size() ? d.substr(idx, d.size() - idx) : std::string_view{};
   };
 
+  const std::size_t token_start_idx{i};
+  const char c{data[i]};
+
   // Quoted token is extracted from quotes.
   if (c == '\"') {
-    i++;
-
-    const size_t token_start_idx{i};
-
-    while (true) {
-      if (i < data.size()) {
-        c = data[i++];
-      } else {
-        return {
-            .next_token = std::string_view{},
-            .current_token = data.substr(token_start_idx, i - token_start_idx)};
-      }
-
-      if (c == '\"') {
-        return {.next_token = next_token(data, i),
-                .current_token =
-                    data.substr(token_start_idx, i - 1 - token_start_idx)};
-      }
+    const std::size_t quote_end_idx{FindChar(data, token_start_idx + 1, '\"')};
+
+    if (quote_end_idx == data.size()) {
+      return {.next_token = std::string_view{},
+              .current_token = data.substr(token_start_idx + 1)};
     }
+
+    return {.next_token = next_token(data, quote_end_idx + 1),
+            .current_token = data.substr(token_start_idx + 1,
+                                         quote_end_idx - token_start_idx - 1)};
   }
 
   // Parse single break character.
   if (breaks.HasChar(c)) {
-    const size_t token_start_idx{i};
-    return {.next_token = next_token(data, i + 1),
+    return {.next_token = next_token(data, token_start_idx + 1),
             .current_token = data.substr(token_start_idx, 1)};
   }
 
-  const size_t token_start_idx{i};
-
   // Parse word.
-  do {
-    if (++i < data.size()) {
-      c = data[i];
-    } else {
-      break;
-    }
-
-    if (breaks.HasChar(c)) break;
-  } while (c > ' ');
+  i = FindWordEnd(data, token_start_idx + 1, breaks);
 
   return {.next_token = next_token(data, i),
           .current_token = data.substr(token_start_idx, i - token_start_idx)};
@@ -0,0 +1,392 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Vectorized text scanners for parsers.
+
+#include "text_scanners.h"
+
+#include <bit>
+#include <limits>
+
+#include "build/build_config.h"
+#include "build/compiler_config.h"
+
+#ifdef WB_ARCH_CPU_X86_64
+#include <immintrin.h>
+
+#ifdef WB_COMPILER_MSVC
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+using wb::base::parsers::CharacterSet;
+using wb::base::parsers::internal::FindWordEndScalar;
+using wb::base::parsers::internal::ScanIsa;
+using wb::base::parsers::internal::SkipWhitespacesScalar;
+
+/**
+ * @brief Classifies |count| chars at |chars| char by char.
+ * @param set Character set.
+ * @param chars Chars.
+ * @param count Chars count, <= 32.
+ * @return Mask with bit i set if chars[i] belongs to |set|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE std::uint32_t ClassifyScalar(
+    const CharacterSet& set, const char* chars, unsigned count) noexcept {
+  std::uint32_t mask{0};
+  for (unsigned i{0}; i < count; ++i) {
+    mask |= static_cast<std::uint32_t>(set.HasChar(chars[i])) << i;
+  }
+  return mask;
+}
+
+#ifdef WB_ARCH_CPU_X86_64
+// Vector compares are signed, as char <= ' ' in scalar path.
+static_assert(std::numeric_limits<char>::is_signed,
+              "Vector scanners expect signed char, or results will differ "
+              "from scalar ones for chars >= 0x80.");
+
+/**
+ * @brief Character set bitmap halves as nibble shuffle lookup tables.
+ */
+struct CharacterSetTables {
+  /**
+   * @brief Bits for chars 0x00-0x7F, indexed by low nibble.
+   */
+  __m128i low_rows;
+  /**
+   * @brief Bits for chars 0x80-0xFF, indexed by low nibble.
+   */
+  __m128i high_rows;
+};
+
+/**
+ * @brief Loads |set| bitmap as lookup tables.
+ * @param set Character set.
+ * @return Lookup tables.
+ */
+[[nodiscard]] WB_ATTRIBUTE_FORCEINLINE inline CharacterSetTables LoadTables(
+    const CharacterSet& set) noexcept {
+  // Character set is 32 bytes aligned.
+  const auto* bitmap =
+      reinterpret_cast<const __m128i*>(set.GetBitmap().data());
+  return {_mm_load_si128(bitmap), _mm_load_si128(bitmap + 1)};
+}
+
+/**
+ * @brief Classifies 16 chars by nibble shuffle lookups: low nibble selects
+ * bitmap byte, high nibble selects bit in it.
+ * @param chars Chars.
+ * @param tables Character set lookup tables.
+ * @return 0xFF for chars from set, 0x00 otherwise.
+ */
+[[nodiscard]] WB_ATTRIBUTE_FORCEINLINE WB_ATTRIBUTE_TARGET("ssse3") inline
+    __m128i ClassifySsse3(__m128i chars,
+                          const CharacterSetTables& tables) noexcept {
+  // pshufb yields zero for indices with high bit set, so each half of the
+  // bitmap answers only for its own chars.
+  const __m128i rows{_mm_or_si128(
+      _mm_shuffle_epi8(tables.low_rows, chars),
+      _mm_shuffle_epi8(tables.high_rows,
+                       _mm_xor_si128(chars, _mm_set1_epi8(-128))))};
+  const __m128i high_nibbles{
+      _mm_and_si128(_mm_srli_epi16(chars, 4), _mm_set1_epi8(0x0F))};
+  const __m128i bits{_mm_shuffle_epi8(
+      _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64,
+                    -128),
+      high_nibbles)};
+
+  return _mm_cmpeq_epi8(_mm_and_si128(rows, bits), bits);
+}
+
+/**
+ * @brief Classifies 32 chars by nibble shuffle lookups.
+ * @param chars Chars.
+ * @param tables Character set lookup tables.
+ * @return 0xFF for chars from set, 0x00 otherwise.
+ */
+[[nodiscard]] WB_ATTRIBUTE_FORCEINLINE WB_ATTRIBUTE_TARGET("avx2") inline
+    __m256i ClassifyAvx2(__m256i chars,
+                         const CharacterSetTables& tables) noexcept {
+  // Shuffles are per 128-bit lane, so duplicate tables in both lanes.
+  const __m256i rows{_mm256_or_si256(
+      _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(tables.low_rows), chars),
+      _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(tables.high_rows),
+                          _mm256_xor_si256(chars, _mm256_set1_epi8(-128))))};
+  const __m256i high_nibbles{_mm256_and_si256(_mm256_srli_epi16(chars, 4),
+                                              _mm256_set1_epi8(0x0F))};
+  const __m256i bits{_mm256_shuffle_epi8(
+      _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64,
+                       -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32,
+                       64, -128),
+      high_nibbles)};
+
+  return _mm256_cmpeq_epi8(_mm256_and_si256(rows, bits), bits);
+}
+
+/**
+ * @brief Skips whitespaces 16 chars at a time.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE std::size_t SkipWhitespacesSsse3(
+    std::string_view data, std::size_t index) noexcept {
+  // Only SSE2 is needed here.
+  const __m128i spaces{_mm_set1_epi8(' ')};
+
+  while (index + 16 <= data.size()) {
+    const __m128i chars{_mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data.data() + index))};
+    const auto non_spaces = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(chars, spaces)));
+
+    if (non_spaces != 0) {
+      return index + static_cast<unsigned>(std::countr_zero(non_spaces));
+    }
+
+    index += 16;
+  }
+
+  return SkipWhitespacesScalar(data, index);
+}
+
+/**
+ * @brief Finds word end 16 chars at a time.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_ATTRIBUTE_TARGET("ssse3") std::size_t
+    FindWordEndSsse3(std::string_view data, std::size_t index,
+                     const CharacterSet& breaks) noexcept {
+  const CharacterSetTables tables{LoadTables(breaks)};
+  const __m128i after_space{_mm_set1_epi8(' ' + 1)};
+
+  while (index + 16 <= data.size()) {
+    const __m128i chars{_mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data.data() + index))};
+    const __m128i word_ends{_mm_or_si128(_mm_cmpgt_epi8(after_space, chars),
+                                         ClassifySsse3(chars, tables))};
+    const auto word_ends_mask =
+        static_cast<unsigned>(_mm_movemask_epi8(word_ends));
+
+    if (word_ends_mask != 0) {
+      return index + static_cast<unsigned>(std::countr_zero(word_ends_mask));
+    }
+
+    index += 16;
+  }
+
+  return FindWordEndScalar(data, index, breaks);
+}
+
+/**
+ * @brief Skips whitespaces 32 chars at a time.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_ATTRIBUTE_TARGET("avx2") std::size_t
+    SkipWhitespacesAvx2(std::string_view data, std::size_t index) noexcept {
+  const __m256i spaces{_mm256_set1_epi8(' ')};
+
+  while (index + 32 <= data.size()) {
+    const __m256i chars{_mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data.data() + index))};
+    const auto non_spaces = static_cast<std::uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpgt_epi8(chars, spaces)));
+
+    if (non_spaces != 0) {
+      return index + static_cast<unsigned>(std::countr_zero(non_spaces));
+    }
+
+    index += 32;
+  }
+
+  // Tail is less than 32 chars.
+  return SkipWhitespacesSsse3(data, index);
+}
+
+/**
+ * @brief Finds word end 32 chars at a time.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_ATTRIBUTE_TARGET("avx2") std::size_t
+    FindWordEndAvx2(std::string_view data, std::size_t index,
+                    const CharacterSet& breaks) noexcept {
+  const CharacterSetTables tables{LoadTables(breaks)};
+  const __m256i after_space{_mm256_set1_epi8(' ' + 1)};
+
+  while (index + 32 <= data.size()) {
+    const __m256i chars{_mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data.data() + index))};
+    const __m256i word_ends{
+        _mm256_or_si256(_mm256_cmpgt_epi8(after_space, chars),
+                        ClassifyAvx2(chars, tables))};
+    const auto word_ends_mask =
+        static_cast<std::uint32_t>(_mm256_movemask_epi8(word_ends));
+
+    if (word_ends_mask != 0) {
+      return index + static_cast<unsigned>(std::countr_zero(word_ends_mask));
+    }
+
+    index += 32;
+  }
+
+  // Tail is less than 32 chars.
+  return FindWordEndSsse3(data, index, breaks);
+}
+
+/**
+ * @brief Classifies 16 chars at |chars|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_ATTRIBUTE_TARGET("ssse3") std::uint32_t
+    Classify16Ssse3(const CharacterSet& set, const char* chars) noexcept {
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(ClassifySsse3(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars)),
+      LoadTables(set))));
+}
+
+/**
+ * @brief Classifies 32 chars at |chars|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_ATTRIBUTE_TARGET("avx2") std::uint32_t
+    Classify32Avx2(const CharacterSet& set, const char* chars) noexcept {
+  return static_cast<std::uint32_t>(_mm256_movemask_epi8(ClassifyAvx2(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars)),
+      LoadTables(set))));
+}
+
+/**
+ * @brief Does CPU support |isa| and OS saves its registers?
+ * @param isa Instruction set to check.
+ * @return true if |isa| can be used.
+ */
+[[nodiscard]] bool HasIsa(ScanIsa isa) noexcept {
+#ifdef WB_COMPILER_MSVC
+  int registers[4];
+
+  __cpuid(registers, 0);
+  const int max_leaf{registers[0]};
+
+  __cpuid(registers, 1);
+  // SSSE3.
+  if ((registers[2] & (1 << 9)) == 0) return false;
+  if (isa == ScanIsa::kSsse3) return true;
+
+  // OS saves YMM registers on context switch?
+  constexpr int kOsXsaveAndAvx{(1 << 27) | (1 << 28)};
+  if (max_leaf < 7 || (registers[2] & kOsXsaveAndAvx) != kOsXsaveAndAvx ||
+      (_xgetbv(0) & 0x6U) != 0x6U) {
+    return false;
+  }
+
+  __cpuidex(registers, 7, 0);
+  return (registers[1] & (1 << 5)) != 0;
+#else
+  // Checks OS support too.
+  __builtin_cpu_init();
+  return isa == ScanIsa::kSsse3 ? __builtin_cpu_supports("ssse3")
+                                : __builtin_cpu_supports("avx2");
+#endif
+}
+#endif  // WB_ARCH_CPU_X86_64
+
+/**
+ * @brief Best instruction set for scanners.  Zero initialized (scalar) till
+ * dynamic initialization, so scanners used by other static initializers are
+ * still correct.
+ */
+const ScanIsa kBestScanIsa{wb::base::parsers::internal::GetBestScanIsa()};
+
+}  // namespace
+
+namespace wb::base::parsers::internal {
+
+[[nodiscard]] WB_BASE_API ScanIsa GetBestScanIsa() noexcept {
+#ifdef WB_ARCH_CPU_X86_64
+  if (HasIsa(ScanIsa::kAvx2)) return ScanIsa::kAvx2;
+  if (HasIsa(ScanIsa::kSsse3)) return ScanIsa::kSsse3;
+#endif
+  return ScanIsa::kScalar;
+}
+
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::size_t SkipWhitespaces(
+    std::string_view data, std::size_t index, ScanIsa isa) noexcept {
+  switch (isa) {
+#ifdef WB_ARCH_CPU_X86_64
+    case ScanIsa::kAvx2:
+      return SkipWhitespacesAvx2(data, index);
+    case ScanIsa::kSsse3:
+      return SkipWhitespacesSsse3(data, index);
+#else
+    case ScanIsa::kAvx2:
+    case ScanIsa::kSsse3:
+#endif
+    case ScanIsa::kScalar:
+    default:
+      return SkipWhitespacesScalar(data, index);
+  }
+}
+
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::size_t SkipWhitespaces(
+    std::string_view data, std::size_t index) noexcept {
+  return SkipWhitespaces(data, index, kBestScanIsa);
+}
+
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::size_t FindWordEnd(
+    std::string_view data, std::size_t index, const CharacterSet& breaks,
+    ScanIsa isa) noexcept {
+  switch (isa) {
+#ifdef WB_ARCH_CPU_X86_64
+    case ScanIsa::kAvx2:
+      return FindWordEndAvx2(data, index, breaks);
+    case ScanIsa::kSsse3:
+      return FindWordEndSsse3(data, index, breaks);
+#else
+    case ScanIsa::kAvx2:
+    case ScanIsa::kSsse3:
+#endif
+    case ScanIsa::kScalar:
+    default:
+      return FindWordEndScalar(data, index, breaks);
+  }
+}
+
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::size_t FindWordEnd(
+    std::string_view data, std::size_t index,
+    const CharacterSet& breaks) noexcept {
+  return FindWordEnd(data, index, breaks, kBestScanIsa);
+}
+
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::uint32_t Classify16(
+    const CharacterSet& set, const char* chars, ScanIsa isa) noexcept {
+  switch (isa) {
+#ifdef WB_ARCH_CPU_X86_64
+    case ScanIsa::kAvx2:
+    case ScanIsa::kSsse3:
+      return Classify16Ssse3(set, chars);
+#else
+    case ScanIsa::kAvx2:
+    case ScanIsa::kSsse3:
+#endif
+    case ScanIsa::kScalar:
+    default:
+      return ClassifyScalar(set, chars, 16);
+  }
+}
+
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::uint32_t Classify32(
+    const CharacterSet& set, const char* chars, ScanIsa isa) noexcept {
+  switch (isa) {
+#ifdef WB_ARCH_CPU_X86_64
+    case ScanIsa::kAvx2:
+      return Classify32Avx2(set, chars);
+    case ScanIsa::kSsse3:
+      return Classify16Ssse3(set, chars) |
+             (Classify16Ssse3(set, chars + 16) << 16U);
+#else
+    case ScanIsa::kAvx2:
+    case ScanIsa::kSsse3:
+#endif
+    case ScanIsa::kScalar:
+    default:
+      return ClassifyScalar(set, chars, 32);
+  }
+}
+
+}  // namespace wb::base::parsers::internal
@@ -0,0 +1,192 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Vectorized text scanners for parsers.  Scan 16 (SSSE3) or 32 (AVX2) chars at
+// a time at runtime, fall back to scalar scan in constant expressions and on
+// other architectures.  Results are identical for all paths.
+
+#ifndef WB_BASE_PARSERS_TEXT_SCANNERS_H_
+#define WB_BASE_PARSERS_TEXT_SCANNERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "base/config.h"
+#include "build/compiler_config.h"
+#include "base/parsers/character_set.h"
+
+namespace wb::base::parsers {
+
+namespace internal {
+
+/**
+ * @brief Instruction set used by text scanners.
+ */
+enum class ScanIsa : std::uint8_t {
+  /**
+   * @brief Char by char.
+   */
+  kScalar = 0,
+  /**
+   * @brief 16 chars at a time.
+   */
+  kSsse3 = 1,
+  /**
+   * @brief 32 chars at a time.
+   */
+  kAvx2 = 2
+};
+
+/**
+ * @brief Gets best instruction set supported by CPU and OS.
+ * @return Instruction set.
+ */
+[[nodiscard]] WB_BASE_API ScanIsa GetBestScanIsa() noexcept;
+
+/**
+ * @brief Skips chars <= ' ' from |index| char by char.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @return Index of first char > ' ' or |data.size()|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE constexpr std::size_t SkipWhitespacesScalar(
+    std::string_view data, std::size_t index) noexcept {
+  while (index < data.size() && data[index] <= ' ') {
+    ++index;
+  }
+  return index;
+}
+
+/**
+ * @brief Finds word end from |index| char by char.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @param breaks Word break chars.
+ * @return Index of first char <= ' ' or from |breaks|, or |data.size()|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE constexpr std::size_t FindWordEndScalar(
+    std::string_view data, std::size_t index,
+    const CharacterSet& breaks) noexcept {
+  while (index < data.size() && data[index] > ' ' &&
+         !breaks.HasChar(data[index])) {
+    ++index;
+  }
+  return index;
+}
+
+/**
+ * @brief Skips chars <= ' ' from |index| using |isa|.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @param isa Instruction set to use.  Should be supported by CPU.
+ * @return Index of first char > ' ' or |data.size()|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::size_t SkipWhitespaces(
+    std::string_view data, std::size_t index, ScanIsa isa) noexcept;
+
+/**
+ * @brief Skips chars <= ' ' from |index| using best instruction set.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @return Index of first char > ' ' or |data.size()|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::size_t SkipWhitespaces(
+    std::string_view data, std::size_t index) noexcept;
+
+/**
+ * @brief Finds word end from |index| using |isa|.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @param breaks Word break chars.
+ * @param isa Instruction set to use.  Should be supported by CPU.
+ * @return Index of first char <= ' ' or from |breaks|, or |data.size()|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::size_t FindWordEnd(
+    std::string_view data, std::size_t index, const CharacterSet& breaks,
+    ScanIsa isa) noexcept;
+
+/**
+ * @brief Finds word end from |index| using best instruction set.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @param breaks Word break chars.
+ * @return Index of first char <= ' ' or from |breaks|, or |data.size()|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::size_t FindWordEnd(
+    std::string_view data, std::size_t index,
+    const CharacterSet& breaks) noexcept;
+
+/**
+ * @brief Classifies 16 chars at |chars| using |isa|.
+ * @param set Character set.
+ * @param chars Chars to classify.  Should have at least 16 chars.
+ * @param isa Instruction set to use.  Should be supported by CPU.
+ * @return Mask with bit i set if chars[i] belongs to |set|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::uint32_t Classify16(
+    const CharacterSet& set, const char* chars, ScanIsa isa) noexcept;
+
+/**
+ * @brief Classifies 32 chars at |chars| using |isa|.
+ * @param set Character set.
+ * @param chars Chars to classify.  Should have at least 32 chars.
+ * @param isa Instruction set to use.  Should be supported by CPU.
+ * @return Mask with bit i set if chars[i] belongs to |set|.
+ */
+[[nodiscard]] WB_ATTRIBUTE_PURE WB_BASE_API std::uint32_t Classify32(
+    const CharacterSet& set, const char* chars, ScanIsa isa) noexcept;
+
+}  // namespace internal
+
+/**
+ * @brief Skips whitespaces (chars <= ' ') from |index|.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @return Index of first non-whitespace char or |data.size()|.
+ */
+[[nodiscard]] constexpr std::size_t SkipWhitespaces(
+    std::string_view data, std::size_t index) noexcept {
+  if consteval {
+    return internal::SkipWhitespacesScalar(data, index);
+  } else {
+    return internal::SkipWhitespaces(data, index);
+  }
+}
+
+/**
+ * @brief Finds word end from |index|.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @param breaks Word break chars.
+ * @return Index of first whitespace (char <= ' ') or char from |breaks|, or
+ * |data.size()|.
+ */
+[[nodiscard]] constexpr std::size_t FindWordEnd(
+    std::string_view data, std::size_t index,
+    const CharacterSet& breaks) noexcept {
+  if consteval {
+    return internal::FindWordEndScalar(data, index, breaks);
+  } else {
+    return internal::FindWordEnd(data, index, breaks);
+  }
+}
+
+/**
+ * @brief Finds |ch| from |index|.  memchr is vectorized by C runtime.
+ * @param data Data to scan.
+ * @param index Index to start scan from.
+ * @param ch Char to find.
+ * @return Index of |ch| or |data.size()|.
+ */
+[[nodiscard]] constexpr std::size_t FindChar(std::string_view data,
+                                             std::size_t index,
+                                             char ch) noexcept {
+  const std::size_t found{data.find(ch, index)};
+  return found != std::string_view::npos ? found : data.size();
+}
+
+}  // namespace wb::base::parsers
+
+#endif  // !WB_BASE_PARSERS_TEXT_SCANNERS_H_
@@ -0,0 +1,193 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Vectorized text scanners for parsers.
+
+#include "text_scanners.h"
+//
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+//
+#include "base/deps/googletest/gtest/gtest.h"
+
+namespace {
+
+/**
+ * @brief Gets instruction sets supported by CPU.
+ * @return Instruction sets.
+ */
+[[nodiscard]] std::vector<wb::base::parsers::internal::ScanIsa>
+GetSupportedScanIsas() {
+  using wb::base::parsers::internal::GetBestScanIsa;
+  using wb::base::parsers::internal::ScanIsa;
+
+  std::vector<ScanIsa> isas{ScanIsa::kScalar};
+  for (auto isa : {ScanIsa::kSsse3, ScanIsa::kAvx2}) {
+    if (isa <= GetBestScanIsa()) isas.push_back(isa);
+  }
+  return isas;
+}
+
+/**
+ * @brief Makes random text of |size| chars from |alphabet|.
+ * @param size Text size.
+ * @param alphabet Chars to use.
+ * @param engine Random engine.
+ * @return Text.
+ */
+[[nodiscard]] std::string MakeRandomText(std::size_t size,
+                                         std::string_view alphabet,
+                                         std::mt19937& engine) {
+  std::uniform_int_distribution<std::size_t> distribution{
+      0, alphabet.size() - 1};
+
+  std::string text(size, '\0');
+  for (auto& ch : text) {
+    ch = alphabet[distribution(engine)];
+  }
+  return text;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TextScannersTest, SkipWhitespacesConstexpr) {
+  using namespace wb::base::parsers;
+
+  static_assert(SkipWhitespaces("", 0) == 0);
+  static_assert(SkipWhitespaces("a", 0) == 0);
+  static_assert(SkipWhitespaces(" \t\r\na", 0) == 4);
+  static_assert(SkipWhitespaces("  ", 0) == 2);
+  static_assert(SkipWhitespaces("a  b", 1) == 3);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TextScannersTest, FindWordEndConstexpr) {
+  using namespace wb::base::parsers;
+
+  constexpr CharacterSet breaks{"{}"};
+
+  static_assert(FindWordEnd("", 0, breaks) == 0);
+  static_assert(FindWordEnd("abc", 0, breaks) == 3);
+  static_assert(FindWordEnd("abc def", 0, breaks) == 3);
+  static_assert(FindWordEnd("abc{def", 0, breaks) == 3);
+  static_assert(FindWordEnd("abc\ndef", 1, breaks) == 3);
+  static_assert(FindWordEnd(" abc", 0, breaks) == 0);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TextScannersTest, FindCharConstexpr) {
+  using namespace wb::base::parsers;
+
+  static_assert(FindChar("", 0, 'a') == 0);
+  static_assert(FindChar("abc", 0, 'c') == 2);
+  static_assert(FindChar("abc", 0, 'd') == 3);
+  static_assert(FindChar("abca", 1, 'a') == 3);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TextScannersTest, AllIsasMatchScalarOnEdgeCases) {
+  using namespace wb::base::parsers;
+  using namespace wb::base::parsers::internal;
+
+  constexpr CharacterSet breaks{"{}()\""};
+
+  // Sizes around vector widths and chars >= 0x80, which are whitespaces for
+  // signed char.
+  for (std::size_t size :
+       {0U, 1U, 15U, 16U, 17U, 31U, 32U, 33U, 63U, 64U, 65U}) {
+    for (std::size_t position{0}; position <= size; ++position) {
+      for (char marker : {'a', ' ', '\n', '\x80', '\xFF', '{', '\x7F'}) {
+        std::string spaces(size, ' ');
+        std::string letters(size, 'x');
+        if (position < size) {
+          spaces[position] = marker;
+          letters[position] = marker;
+        }
+
+        for (ScanIsa isa : GetSupportedScanIsas()) {
+          for (std::size_t index : {std::size_t{0}, position / 2, position}) {
+            EXPECT_EQ(SkipWhitespacesScalar(spaces, index),
+                      SkipWhitespaces(spaces, index, isa))
+                << "ISA " << static_cast<int>(isa) << ", size " << size
+                << ", position " << position << ", index " << index;
+            EXPECT_EQ(FindWordEndScalar(letters, index, breaks),
+                      FindWordEnd(letters, index, breaks, isa))
+                << "ISA " << static_cast<int>(isa) << ", size " << size
+                << ", position " << position << ", index " << index;
+          }
+        }
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TextScannersTest, AllIsasMatchScalarOnRandomText) {
+  using namespace wb::base::parsers;
+  using namespace wb::base::parsers::internal;
+
+  constexpr CharacterSet breaks{"{}()'"};
+  constexpr std::array<std::string_view, 3> alphabets{
+      // Mostly words.
+      "abcdefghijklmnopqrstuvwxyz0123456789_ {}",
+      // Mostly whitespaces.
+      " \t\r\n     a{",
+      // Any bytes.
+      "\x01\x1F !\"'(){}AZaz~\x7F\x80\x9F\xA0\xC3\xFF"};
+
+  std::mt19937 engine{42};
+
+  for (std::string_view alphabet : alphabets) {
+    for (std::size_t iteration{0}; iteration < 256; ++iteration) {
+      const std::string text{MakeRandomText(iteration, alphabet, engine)};
+
+      for (ScanIsa isa : GetSupportedScanIsas()) {
+        for (std::size_t index{0}; index <= text.size(); ++index) {
+          ASSERT_EQ(SkipWhitespacesScalar(text, index),
+                    SkipWhitespaces(text, index, isa))
+              << "ISA " << static_cast<int>(isa) << ", text '" << text
+              << "', index " << index;
+          ASSERT_EQ(FindWordEndScalar(text, index, breaks),
+                    FindWordEnd(text, index, breaks, isa))
+              << "ISA " << static_cast<int>(isa) << ", text '" << text
+              << "', index " << index;
+        }
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TextScannersTest, AllIsasClassifySameAsHasChar) {
+  using namespace wb::base::parsers;
+  using namespace wb::base::parsers::internal;
+
+  std::mt19937 engine{42};
+  std::string all_chars(256, '\0');
+  for (std::size_t i{0}; i < all_chars.size(); ++i) {
+    all_chars[i] = static_cast<char>(i);
+  }
+
+  for (std::size_t iteration{0}; iteration < 64; ++iteration) {
+    const std::string set_chars{MakeRandomText(iteration, all_chars, engine)};
+    const CharacterSet set{set_chars};
+    const std::string text{MakeRandomText(32, all_chars, engine)};
+
+    std::uint32_t expected{0};
+    for (std::size_t i{0}; i < text.size(); ++i) {
+      expected |= static_cast<std::uint32_t>(set.HasChar(text[i])) << i;
+    }
+
+    for (ScanIsa isa : GetSupportedScanIsas()) {
+      EXPECT_EQ(expected & 0xFFFFU, Classify16(set, text.data(), isa))
+          << "ISA " << static_cast<int>(isa);
+      EXPECT_EQ(expected, Classify32(set, text.data(), isa))
+          << "ISA " << static_cast<int>(isa);
+    }
+  }
+}
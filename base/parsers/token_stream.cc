@@ -0,0 +1,236 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Streaming tokenizer for simple token syntax (see simple_token_parser.h).
+
+#include "token_stream.h"
+
+#include <algorithm>
+
+#include "base/deps/g3log/g3log.h"
+#include "base/parsers/text_scanners.h"
+
+namespace wb::base::parsers::st {
+
+TokenStream::TokenStream(std::string_view data,
+                         const CharacterSet& breaks) noexcept
+    : breaks_{breaks},
+      reader_{std::nullopt},
+      chunk_{data},
+      index_{0},
+      token_start_{0},
+      chunk_offset_{0},
+      mark_{.offset = 0, .line = 1, .line_start = 0},
+      carry_{},
+      token_offset_{0},
+      token_position_{std::nullopt},
+      last_token_offset_{0},
+      last_token_position_{std::nullopt},
+      state_{State::kBetweenTokens} {}
+
+TokenStream::TokenStream(ChunkReader reader,
+                         const CharacterSet& breaks) noexcept
+    : TokenStream{std::string_view{}, breaks} {
+  reader_.emplace(reader);
+}
+
+[[nodiscard]] std::optional<StreamToken> TokenStream::Next() noexcept {
+  while (true) {
+    if (index_ == chunk_.size() && !ReadChunk()) {
+      return FinishStream();
+    }
+
+    switch (state_) {
+      case State::kBetweenTokens: {
+        index_ = SkipWhitespaces(chunk_, index_);
+        if (index_ == chunk_.size()) continue;
+
+        StartToken(index_);
+
+        const char ch{chunk_[index_]};
+        if (ch == '/') {
+          if (index_ + 1 == chunk_.size()) {
+            // Comment or token, next chunk will tell.
+            state_ = State::kSlash;
+            ++index_;
+            continue;
+          }
+
+          if (chunk_[index_ + 1] == '/') {
+            state_ = State::kComment;
+            index_ += 2;
+            continue;
+          }
+        }
+
+        if (ch == '\"') {
+          state_ = State::kQuoted;
+          token_start_ = ++index_;
+          continue;
+        }
+
+        if (breaks_.HasChar(ch)) {
+          ++index_;
+          return CompleteToken(index_);
+        }
+
+        state_ = State::kWord;
+        ++index_;
+        continue;
+      }
+
+      case State::kComment:
+        index_ = FindChar(chunk_, index_, '\n');
+        if (index_ != chunk_.size()) state_ = State::kBetweenTokens;
+        continue;
+
+      case State::kSlash:
+        // '/' is in carry buffer, new chunk starts at 0.
+        if (chunk_[index_] == '/') {
+          state_ = State::kComment;
+          ++index_;
+          continue;
+        }
+
+        if (breaks_.HasChar('/')) {
+          return CompleteToken(index_);
+        }
+
+        state_ = State::kWord;
+        continue;
+
+      case State::kWord: {
+        const std::size_t end{FindWordEnd(chunk_, index_, breaks_)};
+        index_ = end;
+
+        if (end == chunk_.size()) continue;
+
+        return CompleteToken(end);
+      }
+
+      case State::kQuoted: {
+        const std::size_t end{FindChar(chunk_, index_, '\"')};
+        index_ = end;
+
+        if (end == chunk_.size()) continue;
+
+        // Skip closing quote.
+        ++index_;
+        return CompleteToken(end);
+      }
+
+      default:
+        G3LOG(FATAL) << "Unknown token stream state "
+                     << static_cast<int>(state_);
+        return std::nullopt;
+    }
+  }
+}
+
+[[nodiscard]] TextPosition TokenStream::GetTokenPosition() const noexcept {
+  return last_token_position_.has_value()
+             ? *last_token_position_
+             : ComputePosition(last_token_offset_);
+}
+
+[[nodiscard]] TextPosition TokenStream::ComputePosition(
+    std::uint64_t offset) const noexcept {
+  G3DCHECK(offset >= mark_.offset);
+  G3DCHECK(mark_.offset >= chunk_offset_);
+
+  // Only not counted yet part of current chunk.
+  const std::uint64_t begin{mark_.offset - chunk_offset_};
+  const std::uint64_t end{
+      std::min<std::uint64_t>(chunk_.size(), offset - chunk_offset_)};
+  const std::string_view counted{chunk_.substr(begin, end - begin)};
+
+  mark_.line += static_cast<std::uint64_t>(
+      std::count(counted.begin(), counted.end(), '\n'));
+
+  const std::size_t last_new_line{counted.rfind('\n')};
+  if (last_new_line != std::string_view::npos) {
+    mark_.line_start = chunk_offset_ + begin + last_new_line + 1;
+  }
+
+  mark_.offset = offset;
+
+  return {mark_.line, offset - mark_.line_start + 1};
+}
+
+[[nodiscard]] bool TokenStream::ReadChunk() noexcept {
+  if (!reader_.has_value()) return false;
+
+  // Chunk will be gone, so keep what is needed from it.  Offsets are in
+  // ascending order, as mark only moves forward.
+  if (!last_token_position_.has_value() &&
+      last_token_offset_ >= mark_.offset) {
+    last_token_position_ = ComputePosition(last_token_offset_);
+  }
+
+  if (state_ == State::kWord || state_ == State::kQuoted ||
+      state_ == State::kSlash) {
+    if (!IsTokenCarried()) {
+      token_position_ = ComputePosition(token_offset_);
+      carry_.assign(chunk_.substr(token_start_));
+    } else {
+      carry_.append(chunk_);
+    }
+  }
+
+  // Count rest of chunk.
+  (void)ComputePosition(chunk_offset_ + chunk_.size());
+
+  chunk_offset_ += chunk_.size();
+  chunk_ = (*reader_)();
+  index_ = 0;
+  token_start_ = 0;
+
+  if (chunk_.empty()) {
+    // Never read after the end of stream.
+    reader_.reset();
+    return false;
+  }
+
+  return true;
+}
+
+[[nodiscard]] std::optional<StreamToken> TokenStream::FinishStream() noexcept {
+  switch (state_) {
+    case State::kSlash:
+    case State::kWord:
+    case State::kQuoted:
+      // Unterminated quoted token is rest of stream, as in ParseToken.
+      return CompleteToken(chunk_.size());
+    case State::kBetweenTokens:
+    case State::kComment:
+    default:
+      return std::nullopt;
+  }
+}
+
+void TokenStream::StartToken(std::size_t index) noexcept {
+  token_start_ = index;
+  token_offset_ = chunk_offset_ + index;
+  token_position_.reset();
+}
+
+[[nodiscard]] StreamToken TokenStream::CompleteToken(std::size_t end) noexcept {
+  const bool is_quoted{state_ == State::kQuoted};
+  state_ = State::kBetweenTokens;
+
+  last_token_offset_ = token_offset_;
+  last_token_position_ = token_position_;
+
+  if (!IsTokenCarried()) {
+    return {chunk_.substr(token_start_, end - token_start_), token_offset_,
+            is_quoted, {}};
+  }
+
+  // Token crosses chunk boundary, so assemble it.
+  token_position_.reset();
+  carry_.append(chunk_.substr(0, end));
+  return {carry_, last_token_offset_, is_quoted, {}};
+}
+
+}  // namespace wb::base::parsers::st
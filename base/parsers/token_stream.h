@@ -0,0 +1,361 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Streaming tokenizer for simple token syntax (see simple_token_parser.h).
+// Runs over memory mapped files or chunked streams without copying token bytes.
+
+#ifndef WB_BASE_PARSERS_TOKEN_STREAM_H_
+#define WB_BASE_PARSERS_TOKEN_STREAM_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "base/config.h"
+#include "base/deps/abseil/functional/function_ref.h"
+#include "base/macroses.h"
+#include "base/parsers/character_set.h"
+#include "build/compiler_config.h"
+
+namespace wb::base::parsers::st {
+
+/**
+ * @brief Position in text.
+ */
+struct TextPosition {
+  /**
+   * @brief Line, 1-based.
+   */
+  std::uint64_t line;
+  /**
+   * @brief Column in bytes, 1-based.
+   */
+  std::uint64_t column;
+};
+
+/**
+ * @brief Operator == for TextPosition.
+ * @param l Left.
+ * @param r Right.
+ * @return true if equals, false otherwise.
+ */
+[[nodiscard]] constexpr bool operator==(const TextPosition& l,
+                                        const TextPosition& r) noexcept {
+  return l.line == r.line && l.column == r.column;
+}
+
+/**
+ * @brief Token from stream.
+ */
+struct StreamToken {
+  /**
+   * @brief Token value.  Without quotes for quoted tokens.
+   */
+  std::string_view value;
+  /**
+   * @brief Offset of token first char (or opening quote) in stream.
+   */
+  std::uint64_t offset;
+  /**
+   * @brief Is token quoted?  Quoted token is never break char or directive.
+   */
+  bool is_quoted;
+  WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 7> pad_;
+};
+
+/**
+ * @brief Reads next chunk of stream.  Returns empty chunk at the end of
+ * stream.  Chunk should be valid till next read.
+ */
+using ChunkReader = absl::FunctionRef<std::string_view()>;
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // absl::FunctionRef / std::string are used only by inline members.
+  WB_MSVC_DISABLE_WARNING(4251)
+  WB_GCC_BEGIN_WARNING_OVERRIDE_SCOPE()
+    // Character set is 32 bytes aligned, padding is ok.
+    WB_GCC_DISABLE_PADDED_WARNING()
+
+    /**
+     * @brief Streaming tokenizer.  Produces same tokens as sequential
+     * ParseToken calls, but keeps quoted strings, comments and words state
+     * across chunk boundaries.
+     *
+     * Token values point directly to input.  Only tokens which cross chunk
+     * boundary are assembled in internal buffer.  Token is valid till next
+     * token is read (or till input is alive for single view stream).
+     *
+     * Line and column are computed only on request, by counting new lines
+     * from the last computed position (mark), so each byte is counted once at
+     * most.  Chunked streams count rest of chunk before it is gone.
+     *
+     * Usage with memory mapped file:
+     *
+     *   auto file = ScopedMemoryMappedFile::New(path);
+     *   TokenStream tokens{AsStringView(file->data()), breaks};
+     *   for (const StreamToken& token : tokens) { ... }
+     */
+    class WB_BASE_API TokenStream {
+     public:
+      /**
+       * @brief Creates token stream over single |data| view, like memory
+       * mapped file.
+       * @param data Data.  Should outlive stream and tokens.
+       * @param breaks Break characters.
+       * @return nothing.
+       */
+      TokenStream(std::string_view data, const CharacterSet& breaks) noexcept;
+
+      /**
+       * @brief Creates token stream over chunks from |reader|.
+       * @param reader Chunk reader.  Should outlive stream.
+       * @param breaks Break characters.
+       * @return nothing.
+       */
+      TokenStream(ChunkReader reader, const CharacterSet& breaks) noexcept;
+
+      WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(TokenStream);
+
+      /**
+       * @brief Reads next token.
+       * @return Token or nullopt at the end of stream.
+       */
+      [[nodiscard]] std::optional<StreamToken> Next() noexcept;
+
+      /**
+       * @brief Computes position of last read token first char.  Intended
+       * for error reporting, so counts new lines since the last computed
+       * position.
+       * @return Token position.
+       */
+      [[nodiscard]] TextPosition GetTokenPosition() const noexcept;
+
+      /**
+       * @brief Input iterator over tokens.
+       */
+      class Iterator {
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = StreamToken;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const StreamToken*;
+        using reference = const StreamToken&;
+
+        /**
+         * @brief Creates end iterator.
+         * @return nothing.
+         */
+        Iterator() noexcept : stream_{nullptr}, token_{} {}
+
+        /**
+         * @brief Creates iterator and reads first token from |stream|.
+         * @param stream Token stream.
+         * @return nothing.
+         */
+        explicit Iterator(TokenStream* stream) noexcept
+            : stream_{stream}, token_{stream->Next()} {}
+
+        [[nodiscard]] reference operator*() const noexcept { return *token_; }
+        [[nodiscard]] pointer operator->() const noexcept { return &*token_; }
+
+        Iterator& operator++() noexcept {
+          token_ = stream_->Next();
+          return *this;
+        }
+
+        void operator++(int) noexcept { ++*this; }
+
+        [[nodiscard]] bool operator==(std::default_sentinel_t) const noexcept {
+          return !token_.has_value();
+        }
+
+       private:
+        /**
+         * @brief Token stream.
+         */
+        TokenStream* stream_;
+        /**
+         * @brief Current token.
+         */
+        std::optional<StreamToken> token_;
+      };
+
+      /**
+       * @brief Reads first token.  Stream is single pass.
+       * @return Iterator.
+       */
+      [[nodiscard]] Iterator begin() noexcept { return Iterator{this}; }
+
+      /**
+       * @brief End of stream.
+       * @return Sentinel.
+       */
+      [[nodiscard]] std::default_sentinel_t end() const noexcept {
+        return std::default_sentinel;
+      }
+
+     private:
+      /**
+       * @brief Scan state at chunk boundary.
+       */
+      enum class State : std::uint8_t {
+        /**
+         * @brief Between tokens.
+         */
+        kBetweenTokens,
+        /**
+         * @brief Inside // comment.
+         */
+        kComment,
+        /**
+         * @brief Single '/' is at the end of previous chunk, it can start
+         * comment or token.
+         */
+        kSlash,
+        /**
+         * @brief Inside word.
+         */
+        kWord,
+        /**
+         * @brief Inside quoted string.
+         */
+        kQuoted
+      };
+
+      /**
+       * @brief Last computed line position.
+       */
+      struct LineMark {
+        /**
+         * @brief Offset in stream new lines are counted till.
+         */
+        std::uint64_t offset;
+        /**
+         * @brief Line of |offset|, 1-based.
+         */
+        std::uint64_t line;
+        /**
+         * @brief Offset of |line| start in stream.
+         */
+        std::uint64_t line_start;
+      };
+
+      /**
+       * @brief Break characters.
+       */
+      const CharacterSet breaks_;
+      /**
+       * @brief Chunk reader.  Absent for single view stream.
+       */
+      std::optional<ChunkReader> reader_;
+      /**
+       * @brief Current chunk.
+       */
+      std::string_view chunk_;
+      /**
+       * @brief Current position in chunk.
+       */
+      std::size_t index_;
+      /**
+       * @brief Current token start in chunk, if token started in it.
+       */
+      std::size_t token_start_;
+      /**
+       * @brief Current chunk offset in stream.
+       */
+      std::uint64_t chunk_offset_;
+      /**
+       * @brief Last computed line position.  Only moves forward, >= current
+       * chunk offset.
+       */
+      mutable LineMark mark_;
+      /**
+       * @brief Token parts from previous chunks.
+       */
+      std::string carry_;
+      /**
+       * @brief Pending token offset in stream.
+       */
+      std::uint64_t token_offset_;
+      /**
+       * @brief Pending token position, when token started in previous chunk.
+       */
+      std::optional<TextPosition> token_position_;
+      /**
+       * @brief Last read token offset in stream.
+       */
+      std::uint64_t last_token_offset_;
+      /**
+       * @brief Last read token position, when token chunk is gone.
+       */
+      std::optional<TextPosition> last_token_position_;
+      /**
+       * @brief Scan state.
+       */
+      State state_;
+
+      /**
+       * @brief Computes position of |offset| by counting new lines from mark
+       * and moves mark to |offset|.
+       * @param offset Offset in stream, >= mark offset.
+       * @return Position.
+       */
+      [[nodiscard]] TextPosition ComputePosition(
+          std::uint64_t offset) const noexcept;
+
+      /**
+       * @brief Reads next chunk.
+       * @return true if chunk is read, false at the end of stream.
+       */
+      [[nodiscard]] bool ReadChunk() noexcept;
+
+      /**
+       * @brief Completes token at the end of stream.
+       * @return Token or nullopt if no pending token.
+       */
+      [[nodiscard]] std::optional<StreamToken> FinishStream() noexcept;
+
+      /**
+       * @brief Starts pending token at |index| in current chunk.
+       * @param index Token start.
+       */
+      void StartToken(std::size_t index) noexcept;
+
+      /**
+       * @brief Completes pending token which ends at |end| in current chunk.
+       * @param end Token end in current chunk.
+       * @return Token.
+       */
+      [[nodiscard]] StreamToken CompleteToken(std::size_t end) noexcept;
+
+      /**
+       * @brief Is pending token started in previous chunk?
+       * @return true if token parts are in carry buffer.
+       */
+      [[nodiscard]] bool IsTokenCarried() const noexcept {
+        return token_position_.has_value();
+      }
+    };
+
+  WB_GCC_END_WARNING_OVERRIDE_SCOPE()
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+/**
+ * @brief Views bytes as chars.  Useful for memory mapped files.
+ * @param bytes Bytes.
+ * @return Chars.
+ */
+[[nodiscard]] inline std::string_view AsStringView(
+    std::span<const std::byte> bytes) noexcept {
+  return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+}  // namespace wb::base::parsers::st
+
+#endif  // !WB_BASE_PARSERS_TOKEN_STREAM_H_
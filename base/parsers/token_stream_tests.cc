@@ -0,0 +1,233 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Streaming tokenizer for simple token syntax.
+
+#include "token_stream.h"
+//
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/parsers/simple_token_parser.h"
+
+namespace {
+
+/**
+ * @brief Parses all tokens from |data| with ParseToken.
+ * @param data Data.
+ * @param breaks Break chars.
+ * @return Tokens.
+ */
+[[nodiscard]] std::vector<std::string> ParseAllTokens(
+    std::string_view data, const wb::base::parsers::CharacterSet& breaks) {
+  std::vector<std::string> tokens;
+
+  while (true) {
+    const auto parsed = wb::base::parsers::st::ParseToken(data, breaks);
+    if (parsed.current_token.empty() && parsed.next_token.empty()) {
+      // Empty quoted token "" still has to be kept.
+      const std::string_view rest{
+          data.substr(std::min(data.size(), data.find_first_not_of(
+                                                " \t\r\n")))};
+      if (!rest.starts_with('\"')) break;
+    }
+
+    tokens.emplace_back(parsed.current_token);
+    if (parsed.next_token.empty()) break;
+
+    data = parsed.next_token;
+  }
+
+  return tokens;
+}
+
+/**
+ * @brief Reads all tokens from |stream|.
+ * @param stream Token stream.
+ * @return Tokens.
+ */
+[[nodiscard]] std::vector<std::string> ReadAllTokens(
+    wb::base::parsers::st::TokenStream& stream) {
+  std::vector<std::string> tokens;
+  for (const auto& token : stream) {
+    tokens.emplace_back(token.value);
+  }
+  return tokens;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TokenStreamTest, SingleViewMatchesParseToken) {
+  using namespace wb::base::parsers;
+  using namespace wb::base::parsers::st;
+
+  constexpr CharacterSet breaks{"{}()'"};
+  constexpr std::array<std::string_view, 12> inputs{
+      "",
+      "   ",
+      "abc",
+      "abc def\n\tghi",
+      "{a}(b)'c'",
+      "// comment only",
+      "// comment\nvalue // tail\nnext",
+      "\"quoted value\" after",
+      "\"unterminated quote",
+      "/",
+      "a/b /c / d",
+      "\"{\"\"}\"{}\xFF\x80word"};
+
+  for (std::string_view input : inputs) {
+    TokenStream stream{input, breaks};
+
+    EXPECT_EQ(ParseAllTokens(input, breaks), ReadAllTokens(stream))
+        << "Input: " << input;
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TokenStreamTest, ChunksMatchSingleView) {
+  using namespace wb::base::parsers;
+  using namespace wb::base::parsers::st;
+
+  constexpr CharacterSet breaks{"{}()/"};
+  constexpr std::string_view kInput{
+      "\"Game\"\n"
+      "{\n"
+      "  // Comment with \"quotes\" and {braces}.\n"
+      "  \"title\"   \"Half-Life 2: Episode Two\"\n"
+      "  key value/with/slashes // comment / split\n"
+      "  nested { inner \"\" } word_at_end\"unterminated\n"
+      "}\n"
+      "/"};
+
+  TokenStream single{kInput, breaks};
+  const std::vector<std::string> expected{ReadAllTokens(single)};
+
+  ASSERT_FALSE(expected.empty());
+
+  for (std::size_t chunk_size{1}; chunk_size <= kInput.size(); ++chunk_size) {
+    std::size_t offset{0};
+    const auto reader = [&]() {
+      const std::string_view chunk{kInput.substr(
+          std::min(offset, kInput.size()), chunk_size)};
+      offset += chunk_size;
+      return chunk;
+    };
+
+    TokenStream chunked{reader, breaks};
+
+    EXPECT_EQ(expected, ReadAllTokens(chunked))
+        << "Chunk size: " << chunk_size;
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TokenStreamTest, TokensPointToInput) {
+  using namespace wb::base::parsers;
+  using namespace wb::base::parsers::st;
+
+  constexpr CharacterSet breaks{"{}"};
+  constexpr std::string_view kInput{"key {\"value\"}"};
+
+  TokenStream stream{kInput, breaks};
+
+  for (const StreamToken& token : stream) {
+    EXPECT_GE(token.value.data(), kInput.data());
+    EXPECT_LE(token.value.data() + token.value.size(),
+              kInput.data() + kInput.size());
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TokenStreamTest, GetTokenPosition) {
+  using namespace wb::base::parsers;
+  using namespace wb::base::parsers::st;
+
+  constexpr CharacterSet breaks{"{}"};
+  constexpr std::string_view kInput{"first\n  {second\n\n // c\n   \"third\""};
+  constexpr std::array<TextPosition, 4> kPositions{
+      TextPosition{1, 1}, TextPosition{2, 3}, TextPosition{2, 4},
+      TextPosition{5, 4}};
+
+  for (std::size_t chunk_size : {kInput.size(), std::size_t{1},
+                                 std::size_t{3}, std::size_t{7}}) {
+    std::size_t offset{0};
+    const auto reader = [&]() {
+      const std::string_view chunk{kInput.substr(
+          std::min(offset, kInput.size()), chunk_size)};
+      offset += chunk_size;
+      return chunk;
+    };
+
+    TokenStream stream{reader, breaks};
+
+    for (const TextPosition& position : kPositions) {
+      const auto token = stream.Next();
+
+      ASSERT_TRUE(token.has_value()) << "Chunk size: " << chunk_size;
+
+      const TextPosition actual{stream.GetTokenPosition()};
+      EXPECT_EQ(position.line, actual.line) << "Chunk size: " << chunk_size;
+      EXPECT_EQ(position.column, actual.column)
+          << "Chunk size: " << chunk_size;
+    }
+
+    EXPECT_FALSE(stream.Next().has_value());
+
+    // Still last token position.
+    const TextPosition last{stream.GetTokenPosition()};
+    EXPECT_EQ(kPositions.back().line, last.line);
+    EXPECT_EQ(kPositions.back().column, last.column);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TokenStreamTest, GetTokenPositionOnDemand) {
+  using namespace wb::base::parsers;
+  using namespace wb::base::parsers::st;
+
+  constexpr CharacterSet breaks{"{}"};
+  constexpr std::string_view kInput{"a\n b\n\n  c {\nd\n  \"e\n f\" g"};
+
+  // Position of only some tokens is requested.
+  const auto check = [](TokenStream& stream) {
+    std::size_t index{0};
+    for (const StreamToken& token : stream) {
+      if (token.value == "c") {
+        EXPECT_EQ((TextPosition{4, 3}), stream.GetTokenPosition());
+      } else if (token.value == "e\n f") {
+        EXPECT_EQ((TextPosition{6, 3}), stream.GetTokenPosition());
+      }
+      ++index;
+    }
+
+    EXPECT_EQ(7U, index);
+    EXPECT_EQ((TextPosition{7, 5}), stream.GetTokenPosition());
+  };
+
+  {
+    TokenStream stream{kInput, breaks};
+    check(stream);
+  }
+
+  for (std::size_t chunk_size : {std::size_t{1}, std::size_t{2},
+                                 std::size_t{5}}) {
+    SCOPED_TRACE(chunk_size);
+
+    std::size_t offset{0};
+    const auto reader = [&]() {
+      const std::string_view chunk{kInput.substr(
+          std::min(offset, kInput.size()), chunk_size)};
+      offset += chunk_size;
+      return chunk;
+    };
+
+    TokenStream stream{reader, breaks};
+    check(stream);
+  }
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Read-only memory mapped file.
+
+#include "scoped_memory_mapped_file.h"
+
+#include "base/deps/abseil/cleanup/cleanup.h"
+#include "base/deps/g3log/g3log.h"
+#include "build/build_config.h"
+
+#ifdef WB_OS_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/posix/system_error_ext.h"
+#endif
+
+#ifdef WB_OS_WIN
+#include "base/win/unique_handle.h"
+#include "base/win/windows_light.h"
+#endif
+
+namespace wb::base {
+
+#ifdef WB_OS_WIN
+[[nodiscard]] std2::result<ScopedMemoryMappedFile> ScopedMemoryMappedFile::New(
+    const std::filesystem::path &path) noexcept {
+  const win::unique_handle file{::CreateFileW(
+      path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr)};
+  if (!file) [[unlikely]] {
+    return std2::result<ScopedMemoryMappedFile>{
+        std::unexpect, std2::system_last_error_code()};
+  }
+
+  LARGE_INTEGER file_size;
+  if (!::GetFileSizeEx(file.get(), &file_size)) [[unlikely]] {
+    return std2::result<ScopedMemoryMappedFile>{
+        std::unexpect, std2::system_last_error_code()};
+  }
+
+  // Empty files can't be mapped.
+  if (file_size.QuadPart == 0) {
+    return ScopedMemoryMappedFile{nullptr, 0};
+  }
+
+  // View keeps mapping alive, so no need to store file & mapping handles.
+  const win::unique_handle mapping{::CreateFileMappingW(
+      file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr)};
+  if (!mapping) [[unlikely]] {
+    return std2::result<ScopedMemoryMappedFile>{
+        std::unexpect, std2::system_last_error_code()};
+  }
+
+  const void *view{::MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0)};
+  if (!view) [[unlikely]] {
+    return std2::result<ScopedMemoryMappedFile>{
+        std::unexpect, std2::system_last_error_code()};
+  }
+
+  return ScopedMemoryMappedFile{static_cast<const std::byte *>(view),
+                                static_cast<std::size_t>(file_size.QuadPart)};
+}
+
+ScopedMemoryMappedFile::~ScopedMemoryMappedFile() noexcept {
+  if (data_) {
+    const std::error_code rc{::UnmapViewOfFile(data_)
+                                 ? std2::ok_code
+                                 : std2::system_last_error_code()};
+    G3PCHECK_E(!rc, rc) << "Unable to unmap file view.";
+  }
+}
+#elif defined(WB_OS_POSIX)
+[[nodiscard]] std2::result<ScopedMemoryMappedFile> ScopedMemoryMappedFile::New(
+    const std::filesystem::path &path) noexcept {
+  const int descriptor{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (descriptor < 0) [[unlikely]] {
+    return std2::result<ScopedMemoryMappedFile>{
+        std::unexpect, std2::system_last_error_code()};
+  }
+
+  // Mapping keeps file alive, so no need to store descriptor.
+  const absl::Cleanup descriptor_closer{[descriptor]() noexcept {
+    const std::error_code rc{posix::get_error(::close(descriptor))};
+    G3PCHECK_E(!rc, rc) << "Unable to close mapped file descriptor.";
+  }};
+
+  struct stat file_stat;
+  if (const std::error_code rc{posix::get_error(::fstat(descriptor, &file_stat))};
+      rc) [[unlikely]] {
+    return std2::result<ScopedMemoryMappedFile>{std::unexpect, rc};
+  }
+
+  // Empty files can't be mapped.
+  if (file_stat.st_size == 0) {
+    return ScopedMemoryMappedFile{nullptr, 0};
+  }
+
+  const auto size = static_cast<std::size_t>(file_stat.st_size);
+  const void *memory{
+      ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0)};
+  if (memory == MAP_FAILED) [[unlikely]] {
+    return std2::result<ScopedMemoryMappedFile>{
+        std::unexpect, std2::system_last_error_code()};
+  }
+
+  return ScopedMemoryMappedFile{static_cast<const std::byte *>(memory), size};
+}
+
+ScopedMemoryMappedFile::~ScopedMemoryMappedFile() noexcept {
+  if (data_) {
+    const std::error_code rc{posix::get_error(
+        ::munmap(const_cast<std::byte *>(data_), size_))};
+    G3PCHECK_E(!rc, rc) << "Unable to unmap file.";
+  }
+}
+#else
+#error "Please define ScopedMemoryMappedFile for your platform."
+#endif
+
+}  // namespace wb::base
@@ -0,0 +1,80 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Read-only memory mapped file.
+
+#ifndef WB_BASE_SCOPED_MEMORY_MAPPED_FILE_H_
+#define WB_BASE_SCOPED_MEMORY_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <utility>  // std::swap
+
+#include "base/config.h"
+#include "base/macroses.h"
+#include "base/std2/system_error_ext.h"
+
+namespace wb::base {
+
+/**
+ * @brief Maps whole file into process address space for reading.  Mapping is
+ * shared with OS page cache, so no heap is used and pages are loaded on demand.
+ */
+class WB_BASE_API ScopedMemoryMappedFile {
+ public:
+  /**
+   * @brief Maps file |path| for reading.
+   * @param path File path.
+   * @return Memory mapped file.
+   */
+  [[nodiscard]] static std2::result<ScopedMemoryMappedFile> New(
+      const std::filesystem::path &path) noexcept;
+
+  ScopedMemoryMappedFile(ScopedMemoryMappedFile &&f) noexcept
+      : data_{f.data_}, size_{f.size_} {
+    f.data_ = nullptr;
+    f.size_ = 0;
+  }
+  ScopedMemoryMappedFile &operator=(ScopedMemoryMappedFile &&f) noexcept {
+    std::swap(data_, f.data_);
+    std::swap(size_, f.size_);
+    return *this;
+  }
+
+  WB_NO_COPY_CTOR_AND_ASSIGNMENT(ScopedMemoryMappedFile);
+
+  ~ScopedMemoryMappedFile() noexcept;
+
+  /**
+   * @brief Gets mapped file bytes.  Page aligned.
+   * @return Mapped file bytes.
+   */
+  [[nodiscard]] std::span<const std::byte> data() const noexcept {
+    return {data_, size_};
+  }
+
+ private:
+  /**
+   * @brief Mapped file start.
+   */
+  const std::byte *data_;
+  /**
+   * @brief Mapped file size.
+   */
+  std::size_t size_;
+
+  /**
+   * @brief Creates memory mapped file.
+   * @param data Mapped file start.
+   * @param size Mapped file size.
+   * @return nothing.
+   */
+  ScopedMemoryMappedFile(const std::byte *data, std::size_t size) noexcept
+      : data_{data}, size_{size} {}
+};
+
+}  // namespace wb::base
+
+#endif  // !WB_BASE_SCOPED_MEMORY_MAPPED_FILE_H_
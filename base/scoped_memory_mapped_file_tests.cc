@@ -0,0 +1,87 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Read-only memory mapped file.
+
+#include "scoped_memory_mapped_file.h"
+//
+#include <fstream>
+#include <string_view>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+namespace {
+
+/**
+ * @brief Creates file |name| in temp directory with |content| and removes it
+ * on scope exit.
+ */
+class ScopedTempFile {
+ public:
+  ScopedTempFile(std::string_view name, std::string_view content) noexcept
+      : path_{std::filesystem::temp_directory_path() / name} {
+    std::ofstream file{path_, std::ios::binary | std::ios::trunc};
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+  }
+
+  ~ScopedTempFile() noexcept {
+    std::error_code rc;
+    std::filesystem::remove(path_, rc);
+  }
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ScopedTempFile);
+
+  [[nodiscard]] const std::filesystem::path &path() const noexcept {
+    return path_;
+  }
+
+ private:
+  const std::filesystem::path path_;
+};
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ScopedMemoryMappedFileTest, NewMissedFile) {
+  using namespace wb::base;
+
+  const auto file = ScopedMemoryMappedFile::New(
+      std::filesystem::temp_directory_path() / "wb-missed-mapped-file.bin");
+
+  ASSERT_FALSE(file.has_value());
+  EXPECT_NE(std2::ok_code, file.error());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ScopedMemoryMappedFileTest, NewEmptyFile) {
+  using namespace wb::base;
+
+  const ScopedTempFile temp_file{"wb-empty-mapped-file.bin", ""};
+  const auto file = ScopedMemoryMappedFile::New(temp_file.path());
+
+  ASSERT_TRUE(file.has_value());
+  EXPECT_TRUE(file->data().empty());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ScopedMemoryMappedFileTest, NewFile) {
+  using namespace wb::base;
+
+  constexpr std::string_view kContent{"WhiteBox\0mapped file", 20};
+  const ScopedTempFile temp_file{"wb-mapped-file.bin", kContent};
+  auto file = ScopedMemoryMappedFile::New(temp_file.path());
+
+  ASSERT_TRUE(file.has_value());
+
+  const auto data = file->data();
+  ASSERT_EQ(kContent.size(), data.size());
+  EXPECT_EQ(kContent, std::string_view(reinterpret_cast<const char *>(
+                                           data.data()),
+                                       data.size()));
+
+  const ScopedMemoryMappedFile moved_file{std::move(*file)};
+
+  EXPECT_EQ(data.data(), moved_file.data().data());
+  EXPECT_EQ(data.size(), moved_file.data().size());
+}
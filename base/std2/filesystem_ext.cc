@@ -17,11 +17,35 @@
 #include "base/win/windows_light.h"
 #endif
 
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
 #include "base/std2/string_view_ext.h"
 #include "base/std2/system_error_ext.h"
 
 namespace {
 
+/**
+ * @brief Gets temporary file suffix unique per process and thread, so
+ * concurrent writers of the same file do not write into the same temporary
+ * one.
+ * @return Temporary file suffix.
+ */
+[[nodiscard]] std::string GetTemporaryFileSuffix() {
+#ifdef WB_OS_WIN
+  const auto process_id = ::GetCurrentProcessId();
+#else
+  const auto process_id = ::getpid();
+#endif
+
+  return "." + std::to_string(process_id) + "." +
+         std::to_string(
+             std::hash<std::thread::id>{}(std::this_thread::get_id())) +
+         ".tmp";
+}
+
 #ifdef WB_OS_POSIX
 /**
  * Gets path to invoking executable.
@@ -109,6 +133,37 @@ get_executable_directory() noexcept {
 #endif
 }
 
+/**
+ * @brief Writes |content| to temporary file and renames it to |path|, so
+ * readers never see partially written file.
+ * @param path File path.
+ * @param content File content.
+ * @return Error code.
+ */
+[[nodiscard]] WB_BASE_API std::error_code write_file_atomically(
+    const std::filesystem::path &path, std::string_view content) noexcept {
+  std::filesystem::path temporary_path{path};
+  temporary_path += GetTemporaryFileSuffix();
+
+  std::error_code rc;
+  {
+    std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    if (!file) {
+      file.close();
+      std::filesystem::remove(temporary_path, rc);
+      return std::make_error_code(std::errc::io_error);
+    }
+  }
+
+  std::filesystem::rename(temporary_path, path, rc);
+  if (rc) {
+    std::error_code remove_rc;
+    std::filesystem::remove(temporary_path, remove_rc);
+  }
+  return rc;
+}
+
 #ifdef WB_OS_WIN
 /**
  * @brief Extract short exe name from command line.
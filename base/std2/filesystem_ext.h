@@ -10,6 +10,7 @@
 #include <filesystem>
 #include <optional>
 #include <string_view>
+#include <system_error>
 
 #include "base/config.h"
 #include "base/std2/system_error_ext.h"
@@ -24,6 +25,17 @@ namespace wb::base::std2::filesystem {
 [[nodiscard]] WB_BASE_API result<std::filesystem::path>
 get_executable_directory() noexcept;
 
+/**
+ * @brief Writes |content| to temporary file and renames it to |path|, so
+ * readers never see partially written file.  Temporary file is unique per
+ * process and thread, so concurrent writers do not corrupt each other.
+ * @param path File path.
+ * @param content File content.
+ * @return Error code.
+ */
+[[nodiscard]] WB_BASE_API std::error_code write_file_atomically(
+    const std::filesystem::path &path, std::string_view content) noexcept;
+
 #ifdef WB_OS_WIN
 /**
  * @brief Extract short exe name from command line.
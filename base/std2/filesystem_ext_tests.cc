@@ -6,6 +6,12 @@
 
 #include "filesystem_ext.h"
 //
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "base/deps/g3log/g3log.h"
 #include "base/macroses.h"
 //
@@ -81,6 +87,74 @@ GTEST_TEST(FilesystemExtTest, get_executable_directory) {
       << "Test current path: " << binary_path << "\n";
 }
 
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FilesystemExtTest, write_file_atomically) {
+  const std::filesystem::path path{std::filesystem::temp_directory_path() /
+                                   "wb_write_file_atomically_tests.txt"};
+
+  EXPECT_EQ(std::error_code{}, filesystem::write_file_atomically(path, "1"));
+  EXPECT_EQ(std::error_code{}, filesystem::write_file_atomically(path, "23"));
+
+  {
+    std::ifstream file{path, std::ios::binary};
+    const std::string content{std::istreambuf_iterator<char>{file},
+                              std::istreambuf_iterator<char>{}};
+    EXPECT_EQ("23", content);
+  }
+
+  // No temporary files left.
+  const std::string temporary_prefix{path.filename().string() + "."};
+  for (const auto &entry : std::filesystem::directory_iterator{
+           std::filesystem::temp_directory_path()}) {
+    EXPECT_FALSE(entry.path().filename().string().starts_with(
+        temporary_prefix))
+        << entry.path();
+  }
+
+  std::error_code rc;
+  std::filesystem::remove(path, rc);
+
+  EXPECT_NE(std::error_code{},
+            filesystem::write_file_atomically(
+                path / "no_such_directory" / "file.txt", "1"));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(FilesystemExtTest, write_file_atomically_concurrently) {
+  const std::filesystem::path path{
+      std::filesystem::temp_directory_path() /
+      "wb_write_file_atomically_concurrently_tests.txt"};
+
+  constexpr std::size_t kWritersCount{4};
+  // Large enough for writes to overlap.
+  constexpr std::size_t kContentSize{1U << 20U};
+
+  std::vector<std::jthread> writers;
+  writers.reserve(kWritersCount);
+  for (std::size_t i{0}; i < kWritersCount; ++i) {
+    writers.emplace_back([&path, i]() {
+      const std::string content(kContentSize, static_cast<char>('a' + i));
+      for (int j{0}; j < 8; ++j) {
+        EXPECT_EQ(std::error_code{},
+                  filesystem::write_file_atomically(path, content));
+      }
+    });
+  }
+  writers.clear();
+
+  {
+    std::ifstream file{path, std::ios::binary};
+    const std::string content{std::istreambuf_iterator<char>{file},
+                              std::istreambuf_iterator<char>{}};
+    ASSERT_EQ(kContentSize, content.size());
+    // Content of one writer, not mix of them.
+    EXPECT_EQ(std::string(kContentSize, content.front()), content);
+  }
+
+  std::error_code rc;
+  std::filesystem::remove(path, rc);
+}
+
 #ifdef WB_OS_WIN
 // NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
 GTEST_TEST(FilesystemExtTests, get_short_exe_name_from_command_line) {
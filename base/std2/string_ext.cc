@@ -39,7 +39,7 @@ namespace wb::base::std2 {
   return result;
 }
 
-[[nodiscard]] WB_BASE_API std::wstring UTF8ToWide(const std::string &source) {
+[[nodiscard]] WB_BASE_API std::wstring UTF8ToWide(std::string_view source) {
   if (source.empty()) return std::wstring{};
 
   if (source.size() > static_cast<size_t>(std::numeric_limits<int>::max())) {
@@ -48,10 +48,10 @@ namespace wb::base::std2 {
   }
 
   const int size{::MultiByteToWideChar(
-      CP_UTF8, 0, &source[0], static_cast<int>(source.size()), nullptr, 0)};
+      CP_UTF8, 0, source.data(), static_cast<int>(source.size()), nullptr, 0)};
   G3DCHECK(size > 0);
   std::wstring result(static_cast<size_t>(size), L'\0');
-  if (::MultiByteToWideChar(CP_UTF8, 0, &source[0],
+  if (::MultiByteToWideChar(CP_UTF8, 0, source.data(),
                             static_cast<int>(source.size()), &result[0],
                             size) != size) {
     G3DLOG(FATAL) << "MultiByteToWideChar failed.";
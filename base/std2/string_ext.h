@@ -8,6 +8,7 @@
 #define WB_BASE_STD2_STRING_EXT_H_
 
 #include <string>
+#include <string_view>
 
 #include "base/config.h"
 #include "build/build_config.h"
@@ -27,7 +28,7 @@ namespace wb::base::std2 {
  * @param in ANSI string.
  * @return Wide string.
  */
-[[nodiscard]] WB_BASE_API std::wstring UTF8ToWide(const std::string &in);
+[[nodiscard]] WB_BASE_API std::wstring UTF8ToWide(std::string_view in);
 #endif
 
 /**
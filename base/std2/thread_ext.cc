@@ -25,6 +25,9 @@ extern "C" WB_ATTRIBUTE_DLL_IMPORT HRESULT __stdcall SetThreadDescription(
     _In_ HANDLE thread, _In_ const wchar_t* description);
 #elif defined(WB_OS_POSIX)
 #include <pthread.h>
+#ifdef WB_OS_LINUX
+#include <sched.h>
+#endif
 #endif
 
 namespace wb::base::std2 {
@@ -119,6 +122,30 @@ WB_GCC_END_WARNING_OVERRIDE_SCOPE()
 #endif
 }
 
+/**
+ * @brief Pins current thread to logical CPUs.  Linux only.
+ * @param cpus Logical CPU indices.
+ * @return Error code.
+ */
+[[nodiscard]] WB_BASE_API std::error_code set_affinity(
+    [[maybe_unused]] std::span<const std::uint32_t> cpus) noexcept {
+#ifdef WB_OS_LINUX
+  if (cpus.empty()) return std2::system_last_error_code(EINVAL);
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const std::uint32_t cpu : cpus) {
+    if (cpu >= CPU_SETSIZE) return std2::system_last_error_code(EINVAL);
+    CPU_SET(cpu, &cpu_set);
+  }
+
+  return std2::system_last_error_code(
+      ::pthread_setaffinity_np(get_handle(), sizeof(cpu_set), &cpu_set));
+#else
+  return std2::posix_last_error_code(ENOSYS);
+#endif
+}
+
 }  // namespace this_thread
 
 }  // namespace wb::base::std2
@@ -7,6 +7,8 @@
 #ifndef WB_BASE_STD2_THREAD_EXT_H_
 #define WB_BASE_STD2_THREAD_EXT_H_
 
+#include <cstdint>
+#include <span>
 #include <string>
 #include <thread>
 
@@ -64,6 +66,14 @@ WB_GCC_END_WARNING_OVERRIDE_SCOPE()
 [[nodiscard]] WB_BASE_API std::error_code set_name(
     const native_thread_name &thread_name) noexcept;
 
+/**
+ * @brief Pins current thread to logical CPUs.  Linux only.
+ * @param cpus Logical CPU indices.
+ * @return Error code.
+ */
+[[nodiscard]] WB_BASE_API std::error_code set_affinity(
+    std::span<const std::uint32_t> cpus) noexcept;
+
 /**
  * @brief Scoped thread name.
  */
@@ -10,6 +10,10 @@
 #include "base/win/windows_light.h"
 #endif
 
+#ifdef WB_OS_LINUX
+#include <sched.h>
+#endif
+
 #include "base/deps/googletest/gtest/gtest.h"
 
 using namespace wb::base;
@@ -55,6 +59,23 @@ GTEST_TEST(ThreadExtTest, this_thread_set_name) {
   EXPECT_EQ(actual_thread_name, expected_thread_name);
 }
 
+#ifdef WB_OS_LINUX
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ThreadExtTest, this_thread_set_affinity) {
+  EXPECT_NE(std2::ok_code, std2::this_thread::set_affinity({}));
+
+  // Pin other thread, so test runner thread stays free.
+  std::thread thread{[] {
+    const auto cpu = static_cast<std::uint32_t>(::sched_getcpu());
+
+    EXPECT_EQ(std2::ok_code,
+              std2::this_thread::set_affinity(std::span{&cpu, 1}));
+    EXPECT_EQ(cpu, static_cast<std::uint32_t>(::sched_getcpu()));
+  }};
+  thread.join();
+}
+#endif
+
 // NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
 GTEST_TEST(ThreadExtTest, this_thread_ScopedThreadNameScope) {
   const std2::native_thread_name expected_thread_name{"ScopedName"};
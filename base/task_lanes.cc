@@ -0,0 +1,381 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Task priority lanes over the marl scheduler.
+
+#include "task_lanes.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <thread>
+
+#include "base/deps/abseil/base/thread_annotations.h"
+#include "base/deps/abseil/synchronization/mutex.h"
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/marl/scheduler.h"
+
+namespace {
+
+/**
+ * @brief Process-wide lanes.
+ */
+std::atomic<wb::base::TaskLanes*> process_task_lanes{nullptr};
+
+}  // namespace
+
+namespace wb::base {
+
+/**
+ * @brief Task lanes implementation.
+ */
+class TaskLanes::Impl final {
+ public:
+  Impl(std::uint32_t workers_count, TaskLaneShares shares) noexcept {
+    const std::uint32_t workers{std::max(workers_count, 1U)};
+
+    absl::MutexLock lock{&mutex_};
+    // Frame critical lane is unlimited.
+    GetLane(TaskPriority::kNormal).max_running_count =
+        shares.normal_workers != 0 ? std::min(shares.normal_workers, workers)
+                                   : workers;
+    GetLane(TaskPriority::kBackground).max_running_count =
+        shares.background_workers != 0
+            ? std::min(shares.background_workers, workers)
+            : std::max(workers / 4U, 1U);
+  }
+
+  ~Impl() noexcept {
+    // Limited tasks may schedule frame critical ones and vice versa.
+    while (true) {
+      WaitFrameCriticalCompleted();
+
+      mutex_.LockWhen(absl::Condition{this, &Impl::IsIdle});
+      mutex_.Unlock();
+
+      if (IsFrameCriticalCompleted()) break;
+    }
+  }
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(Impl);
+
+  void Schedule(TaskPriority priority, std::function<void()> task) {
+    if (priority == TaskPriority::kFrameCritical) {
+      // Lock-free, so frame critical tasks never wait for lanes mutex.
+      frame_critical_.scheduled_count.fetch_add(1, std::memory_order_relaxed);
+      frame_critical_.running_count.fetch_add(1, std::memory_order_seq_cst);
+
+      ::marl::schedule([this, t = std::move(task)]() {
+        t();
+        CompleteFrameCritical();
+      });
+      return;
+    }
+
+    absl::MutexLock lock{&mutex_};
+    Lane& lane{GetLane(priority)};
+
+    ++lane.scheduled_count;
+    lane.pending.emplace_back(std::move(task));
+    StartPending(priority);
+  }
+
+  [[nodiscard]] TaskLaneStats GetStats(TaskPriority priority) const noexcept {
+    if (priority == TaskPriority::kFrameCritical) {
+      // Completed before scheduled, so completed <= scheduled.
+      const std::uint64_t completed_count{
+          frame_critical_.completed_count.load(std::memory_order_acquire)};
+
+      return TaskLaneStats{
+          .scheduled_count = frame_critical_.scheduled_count.load(
+              std::memory_order_relaxed),
+          .completed_count = completed_count,
+          .pending_count = 0,
+          .running_count =
+              frame_critical_.running_count.load(std::memory_order_relaxed),
+          .max_running_count = 0};
+    }
+
+    absl::MutexLock lock{&mutex_};
+    const Lane& lane{GetLane(priority)};
+
+    return TaskLaneStats{
+        .scheduled_count = lane.scheduled_count,
+        .completed_count = lane.completed_count,
+        .pending_count = static_cast<std::uint32_t>(lane.pending.size()),
+        .running_count = lane.running_count,
+        .max_running_count = lane.max_running_count};
+  }
+
+ private:
+  /**
+   * @brief Frame critical lane state.  Lock-free, as tasks go straight to
+   * marl.
+   */
+  struct FrameCriticalLane {
+    /**
+     * @brief Scheduled tasks count.
+     */
+    std::atomic_uint64_t scheduled_count{0};
+    /**
+     * @brief Completed tasks count.  Incremented last, so lanes can be
+     * destroyed when all scheduled tasks are completed.
+     */
+    std::atomic_uint64_t completed_count{0};
+    /**
+     * @brief Tasks handed to marl and not completed yet.
+     */
+    std::atomic_uint32_t running_count{0};
+    /**
+     * @brief Whether background tasks are pending as frame critical work is in
+     * flight, so should be started when frame critical work is done.
+     */
+    std::atomic_bool has_held_background{false};
+    WB_ATTRIBUTE_UNUSED_FIELD std::byte
+        pad_[sizeof(std::uint32_t) - sizeof(std::atomic_bool)] = {};
+  };
+
+  /**
+   * @brief Lane state.
+   */
+  struct Lane {
+    /**
+     * @brief Tasks waiting for a free worker share.
+     */
+    std::deque<std::function<void()>> pending;
+    /**
+     * @brief Scheduled tasks count.
+     */
+    std::uint64_t scheduled_count{0};
+    /**
+     * @brief Completed tasks count.
+     */
+    std::uint64_t completed_count{0};
+    /**
+     * @brief Tasks handed to marl and not completed yet.
+     */
+    std::uint32_t running_count{0};
+    /**
+     * @brief Max tasks handed to marl at once.  0 means unlimited.
+     */
+    std::uint32_t max_running_count{0};
+  };
+
+  FrameCriticalLane frame_critical_;
+  mutable absl::Mutex mutex_;
+  // Frame critical one is unused, see |frame_critical_|.
+  std::array<Lane, kTaskPrioritiesCount> lanes_ ABSL_GUARDED_BY(mutex_);
+
+  [[nodiscard]] Lane& GetLane(TaskPriority priority) noexcept
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return lanes_[underlying_cast(priority)];
+  }
+
+  [[nodiscard]] const Lane& GetLane(TaskPriority priority) const noexcept
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return lanes_[underlying_cast(priority)];
+  }
+
+  [[nodiscard]] bool IsIdle() const noexcept
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return std::ranges::all_of(lanes_, [](const Lane& lane) noexcept {
+      return lane.pending.empty() && lane.running_count == 0;
+    });
+  }
+
+  [[nodiscard]] bool IsFrameCriticalCompleted() const noexcept {
+    // Completed before scheduled, so completed <= scheduled.
+    const std::uint64_t completed_count{
+        frame_critical_.completed_count.load(std::memory_order_acquire)};
+    return completed_count ==
+           frame_critical_.scheduled_count.load(std::memory_order_relaxed);
+  }
+
+  void WaitFrameCriticalCompleted() const noexcept {
+    // Shutdown only, so just yield.
+    while (!IsFrameCriticalCompleted()) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Background tasks keep one worker while frame critical work is in
+   * flight, so they do not occupy more workers frame waits for, but never
+   * starve.
+   * @return Max lane tasks handed to marl now.  0 means unlimited.
+   */
+  [[nodiscard]] std::uint32_t GetRunningLimit(TaskPriority priority) const
+      noexcept ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    const Lane& lane{GetLane(priority)};
+
+    if (priority == TaskPriority::kBackground &&
+        frame_critical_.running_count.load(std::memory_order_seq_cst) != 0) {
+      return kMinBackgroundRunningCount;
+    }
+
+    return lane.max_running_count;
+  }
+
+  [[nodiscard]] bool CanStart(TaskPriority priority) const noexcept
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    const Lane& lane{GetLane(priority)};
+    if (lane.pending.empty()) return false;
+
+    const std::uint32_t limit{GetRunningLimit(priority)};
+    return limit == 0 || lane.running_count < limit;
+  }
+
+  /**
+   * @brief Checks whether pending lane task can be started, and if not only
+   * because frame critical work is in flight, holds background lane till the
+   * work is done.
+   * @param priority Lane priority.
+   * @return true if pending task can be started.
+   */
+  [[nodiscard]] bool CanStartOrHold(TaskPriority priority) noexcept
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    if (CanStart(priority)) return true;
+
+    const Lane& lane{GetLane(priority)};
+    if (priority != TaskPriority::kBackground || lane.pending.empty() ||
+        lane.running_count >= lane.max_running_count) {
+      return false;
+    }
+
+    // Recheck after publishing hold, so either we or the last frame critical
+    // task start pending ones.
+    frame_critical_.has_held_background.store(true, std::memory_order_seq_cst);
+    return CanStart(priority);
+  }
+
+  /**
+   * @brief Hands pending lane tasks to marl while lane has free worker shares.
+   * Marl is called under lock, so lanes can't be destroyed before all task
+   * state changes are done.
+   * @param priority Lane priority.
+   */
+  void StartPending(TaskPriority priority)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    Lane& lane{GetLane(priority)};
+
+    while (CanStartOrHold(priority)) {
+      std::function<void()> task{std::move(lane.pending.front())};
+      lane.pending.pop_front();
+      ++lane.running_count;
+
+      // Index, not priority, so lambda has no padding.
+      ::marl::schedule([this, index = std::size_t{underlying_cast(priority)},
+                        t = std::move(task)]() mutable {
+        RunLimited(static_cast<TaskPriority>(index), std::move(t));
+      });
+    }
+  }
+
+  /**
+   * @brief Runs limited lane task, then pending ones while lane can start
+   * them, so worker share is not returned to marl between tasks.
+   * @param priority Lane priority.
+   * @param task Task.
+   */
+  void RunLimited(TaskPriority priority, std::function<void()> task) {
+    while (true) {
+      task();
+
+      absl::MutexLock lock{&mutex_};
+      Lane& lane{GetLane(priority)};
+
+      ++lane.completed_count;
+      --lane.running_count;
+
+      if (!CanStartOrHold(priority)) return;
+
+      ++lane.running_count;
+      task = std::move(lane.pending.front());
+      lane.pending.pop_front();
+    }
+  }
+
+  /**
+   * @brief Completes frame critical task and starts held background ones when
+   * no frame critical work is left.  Locks only in the latter case.
+   */
+  void CompleteFrameCritical() noexcept {
+    if (frame_critical_.running_count.fetch_sub(1, std::memory_order_seq_cst) ==
+            1 &&
+        frame_critical_.has_held_background.exchange(
+            false, std::memory_order_seq_cst)) {
+      absl::MutexLock lock{&mutex_};
+      StartPending(TaskPriority::kBackground);
+    }
+
+    // Last, lanes may be destroyed after it.
+    frame_critical_.completed_count.fetch_add(1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Background workers share kept while frame critical work is in
+   * flight.
+   */
+  static constexpr std::uint32_t kMinBackgroundRunningCount{1};
+};
+
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_CONST std::string_view
+GetTaskPriorityName(TaskPriority priority) noexcept {
+  switch (priority) {
+    case TaskPriority::kFrameCritical:
+      return "frame critical";
+    case TaskPriority::kNormal:
+      return "normal";
+    case TaskPriority::kBackground:
+      return "background";
+    default:
+      return "unknown";
+  }
+}
+
+TaskLanes::TaskLanes(std::uint32_t workers_count,
+                     TaskLaneShares shares) noexcept
+    : impl_{std::make_unique<Impl>(workers_count, shares)} {}
+
+TaskLanes::~TaskLanes() noexcept {
+  G3DCHECK(Get() != this) << "Task lanes should be unbound before destruction.";
+}
+
+void TaskLanes::Schedule(TaskPriority priority, std::function<void()> task) {
+  impl_->Schedule(priority, std::move(task));
+}
+
+[[nodiscard]] TaskLaneStats TaskLanes::GetStats(
+    TaskPriority priority) const noexcept {
+  return impl_->GetStats(priority);
+}
+
+void TaskLanes::Bind() noexcept {
+  TaskLanes* expected{nullptr};
+  [[maybe_unused]] const bool is_bound{
+      process_task_lanes.compare_exchange_strong(expected, this,
+                                                 std::memory_order_acq_rel)};
+  G3DCHECK(is_bound) << "Only one task lanes can be bound at a time.";
+}
+
+void TaskLanes::Unbind() noexcept {
+  process_task_lanes.store(nullptr, std::memory_order_release);
+}
+
+[[nodiscard]] TaskLanes* TaskLanes::Get() noexcept {
+  return process_task_lanes.load(std::memory_order_acquire);
+}
+
+WB_BASE_API void ScheduleTask(TaskPriority priority,
+                              std::function<void()> task) {
+  if (TaskLanes* lanes{TaskLanes::Get()}) {
+    lanes->Schedule(priority, std::move(task));
+    return;
+  }
+
+  ::marl::schedule(std::move(task));
+}
+
+}  // namespace wb::base
@@ -0,0 +1,178 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Task priority lanes over the marl scheduler.
+
+#ifndef WB_BASE_TASK_LANES_H_
+#define WB_BASE_TASK_LANES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+#include "base/config.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+
+namespace wb::base {
+
+/**
+ * @brief Task priority (lane).
+ */
+enum class TaskPriority : std::uint8_t {
+  /**
+   * @brief Work current frame waits for, ex. simulation, culling, output.
+   * Never queued or locked, goes straight to marl.
+   */
+  kFrameCritical,
+  /**
+   * @brief Work which should be done soon, but frame does not wait for it.
+   */
+  kNormal,
+  /**
+   * @brief Work which can be delayed, ex. asset streaming, decompression,
+   * telemetry writes.  Runs on one worker only while frame critical work is
+   * in flight, so never starves, and on its full share otherwise.
+   */
+  kBackground,
+};
+
+/**
+ * @brief Task priorities count.
+ */
+constexpr std::size_t kTaskPrioritiesCount{3};
+
+/**
+ * @brief Gets task priority name.
+ * @param priority Task priority.
+ * @return Task priority name.
+ */
+[[nodiscard]] WB_BASE_API WB_ATTRIBUTE_CONST std::string_view
+GetTaskPriorityName(TaskPriority priority) noexcept;
+
+/**
+ * @brief Worker shares of limited lanes.
+ */
+struct TaskLaneShares {
+  /**
+   * @brief Max workers running normal tasks at once.  0 means all workers.
+   */
+  std::uint32_t normal_workers;
+  /**
+   * @brief Max workers running background tasks at once.  0 means quarter of
+   * workers, but at least one.
+   */
+  std::uint32_t background_workers;
+};
+
+/**
+ * @brief Task lane statistics.
+ */
+struct TaskLaneStats {
+  /**
+   * @brief Scheduled tasks count.
+   */
+  std::uint64_t scheduled_count;
+  /**
+   * @brief Completed tasks count.
+   */
+  std::uint64_t completed_count;
+  /**
+   * @brief Tasks waiting for a free worker share.
+   */
+  std::uint32_t pending_count;
+  /**
+   * @brief Tasks running (or handed to marl) now.
+   */
+  std::uint32_t running_count;
+  /**
+   * @brief Max workers running lane tasks at once.  0 means unlimited.
+   */
+  std::uint32_t max_running_count;
+  WB_ATTRIBUTE_UNUSED_FIELD std::byte pad_[sizeof(std::uint32_t)] = {};
+};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Priority lanes over the marl scheduler.  Marl runs tasks in FIFO
+   * order, so lanes keep limited (normal, background) tasks out of marl
+   * queues until the lane has a free worker share.  Frame critical tasks never
+   * wait behind more than |background_workers| background ones this way.
+   *
+   * Tasks of limited lanes must not wait for tasks of the same lane, and frame
+   * critical tasks must not wait for background ones, as it deadlocks.
+   * Parallel algorithms wait for chunks, not for their helper tasks, so can be
+   * called from any lane.
+   */
+  class WB_BASE_API TaskLanes {
+   public:
+    /**
+     * @brief Creates task lanes.  Marl scheduler should be bound to threads
+     * which schedule tasks.
+     * @param workers_count Marl worker threads count.
+     * @param shares Worker shares of limited lanes.
+     */
+    TaskLanes(std::uint32_t workers_count, TaskLaneShares shares) noexcept;
+
+    /**
+     * @brief Waits until all scheduled tasks are completed.
+     */
+    ~TaskLanes() noexcept;
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(TaskLanes);
+
+    /**
+     * @brief Schedules task in lane.
+     * @param priority Task priority.
+     * @param task Task.
+     */
+    void Schedule(TaskPriority priority, std::function<void()> task);
+
+    /**
+     * @brief Gets lane statistics.
+     * @param priority Task priority.
+     * @return Lane statistics.
+     */
+    [[nodiscard]] TaskLaneStats GetStats(TaskPriority priority) const noexcept;
+
+    /**
+     * @brief Binds lanes as process-wide ones, used by ScheduleTask.
+     */
+    void Bind() noexcept;
+
+    /**
+     * @brief Unbinds process-wide lanes.
+     */
+    static void Unbind() noexcept;
+
+    /**
+     * @brief Gets process-wide lanes.
+     * @return Lanes or nullptr when none bound.
+     */
+    [[nodiscard]] static TaskLanes* Get() noexcept;
+
+   private:
+    class Impl;
+
+    un<Impl> impl_;
+  };
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+/**
+ * @brief Schedules task in process-wide lane.  Task goes straight to marl when
+ * no lanes are bound.  Marl scheduler should be bound to calling thread.
+ * @param priority Task priority.
+ * @param task Task.
+ */
+WB_BASE_API void ScheduleTask(TaskPriority priority,
+                              std::function<void()> task);
+
+}  // namespace wb::base
+
+#endif  // !WB_BASE_TASK_LANES_H_
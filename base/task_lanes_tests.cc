@@ -0,0 +1,152 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Task priority lanes over the marl scheduler.
+
+#include "task_lanes.h"
+//
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/deps/marl/scheduler.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TaskLanesTest, GetTaskPriorityName) {
+  using namespace wb::base;
+
+  EXPECT_EQ("frame critical",
+            GetTaskPriorityName(TaskPriority::kFrameCritical));
+  EXPECT_EQ("normal", GetTaskPriorityName(TaskPriority::kNormal));
+  EXPECT_EQ("background", GetTaskPriorityName(TaskPriority::kBackground));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TaskLanesTest, WorkerShares) {
+  using namespace wb::base;
+
+  {
+    const TaskLanes lanes{8, {.normal_workers = 0, .background_workers = 0}};
+
+    EXPECT_EQ(0U, lanes.GetStats(TaskPriority::kFrameCritical)
+                      .max_running_count);
+    EXPECT_EQ(8U, lanes.GetStats(TaskPriority::kNormal).max_running_count);
+    EXPECT_EQ(2U, lanes.GetStats(TaskPriority::kBackground).max_running_count);
+  }
+
+  {
+    const TaskLanes lanes{2, {.normal_workers = 1, .background_workers = 3}};
+
+    EXPECT_EQ(1U, lanes.GetStats(TaskPriority::kNormal).max_running_count);
+    EXPECT_EQ(2U, lanes.GetStats(TaskPriority::kBackground).max_running_count);
+  }
+
+  {
+    const TaskLanes lanes{1, {.normal_workers = 0, .background_workers = 0}};
+
+    EXPECT_EQ(1U, lanes.GetStats(TaskPriority::kBackground).max_running_count);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TaskLanesTest, BackgroundLaneIsLimited) {
+  using namespace wb::base;
+
+  marl::Scheduler scheduler{marl::Scheduler::Config{}.setWorkerThreadCount(4)};
+  scheduler.bind();
+
+  std::atomic_uint32_t running{0}, max_running{0}, completed{0};
+
+  {
+    TaskLanes lanes{4, {.normal_workers = 0, .background_workers = 1}};
+    lanes.Bind();
+
+    for (int i{0}; i < 8; ++i) {
+      ScheduleTask(TaskPriority::kBackground, [&]() {
+        const std::uint32_t now_running{running.fetch_add(1) + 1};
+        std::uint32_t max{max_running.load()};
+        while (max < now_running &&
+               !max_running.compare_exchange_weak(max, now_running)) {
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{2});
+
+        running.fetch_sub(1);
+        completed.fetch_add(1);
+      });
+    }
+
+    TaskLanes::Unbind();
+    // Waits for all tasks.
+  }
+
+  scheduler.unbind();
+
+  EXPECT_EQ(8U, completed.load());
+  EXPECT_EQ(1U, max_running.load());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(TaskLanesTest, BackgroundKeepsMinShareDuringFrameCritical) {
+  using namespace wb::base;
+
+  marl::Scheduler scheduler{marl::Scheduler::Config{}.setWorkerThreadCount(4)};
+  scheduler.bind();
+
+  constexpr std::uint32_t kBackgroundCount{8};
+
+  std::atomic_bool is_frame_done{false};
+  std::atomic_uint32_t running{0}, max_running{0}, completed{0};
+  std::uint32_t completed_during_frame{0}, max_running_during_frame{0};
+
+  {
+    TaskLanes lanes{4, {.normal_workers = 0, .background_workers = 2}};
+
+    lanes.Schedule(TaskPriority::kFrameCritical, [&]() {
+      while (!is_frame_done.load()) std::this_thread::yield();
+    });
+
+    const TaskLaneStats frame{lanes.GetStats(TaskPriority::kFrameCritical)};
+    EXPECT_EQ(1U, frame.scheduled_count);
+    EXPECT_EQ(0U, frame.pending_count);
+    EXPECT_EQ(0U, frame.max_running_count);
+
+    for (std::uint32_t i{0}; i < kBackgroundCount; ++i) {
+      lanes.Schedule(TaskPriority::kBackground, [&]() {
+        const std::uint32_t now_running{running.fetch_add(1) + 1};
+        std::uint32_t max{max_running.load()};
+        while (max < now_running &&
+               !max_running.compare_exchange_weak(max, now_running)) {
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{2});
+
+        running.fetch_sub(1);
+        completed.fetch_add(1);
+      });
+    }
+
+    // Background is not starved by frame critical work.
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (completed.load() < kBackgroundCount / 2 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+
+    completed_during_frame = completed.load();
+    max_running_during_frame = max_running.load();
+
+    is_frame_done.store(true);
+    // Waits for all tasks.
+  }
+
+  scheduler.unbind();
+
+  EXPECT_GE(completed_during_frame, kBackgroundCount / 2);
+  EXPECT_EQ(1U, max_running_during_frame);
+  EXPECT_EQ(kBackgroundCount, completed.load());
+}
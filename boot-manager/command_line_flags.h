@@ -10,6 +10,7 @@
 #include <cstddef>  // std::byte
 #include <vector>
 
+#include "base/cpu_topology.h"
 #include "build/build_config.h"
 #include "build/compiler_config.h"
 
@@ -35,6 +36,18 @@ struct CommandLineFlags {
    */
   std::uint32_t attempts_to_retry_allocate_memory;
 
+  /**
+   * @brief Max workers running normal priority tasks at once.  0 means all
+   * workers.
+   */
+  std::uint32_t normal_lane_workers;
+
+  /**
+   * @brief Max workers running background tasks at once.  0 means quarter of
+   * workers, but at least one.
+   */
+  std::uint32_t background_lane_workers;
+
 #ifdef WB_OS_WIN
   /**
    * @brief Changes minimal resolution (ms) of the Windows periodic timer.
@@ -58,6 +71,23 @@ struct CommandLineFlags {
    */
   std::uint16_t main_window_height;
 
+  /**
+   * @brief How many frames kernel pipelines: 1 serializes simulation and
+   * output, 2 overlaps simulation of frame N+1 with output of frame N.
+   */
+  std::uint8_t frame_pipeline_depth;
+
+  /**
+   * @brief How to place marl worker threads on CPUs.
+   */
+  wb::base::WorkerPinning worker_pinning;
+
+  /**
+   * @brief Should reserve physical core for the main thread, so workers do not
+   * use it.
+   */
+  bool should_reserve_main_thread_core;
+
   /**
    * @brief Insecure.  Allow to load NOT SIGNED module targets.  There is no
    * guarantee unsigned module doing nothing harmful.  Use at your own risk, ex.
@@ -74,11 +104,15 @@ struct CommandLineFlags {
 
 #if defined(WB_COMPILER_GCC) || defined(WB_COMPILER_CLANG)
   WB_ATTRIBUTE_UNUSED_FIELD std::byte
-      pad_[sizeof(char *) - sizeof(insecure_allow_unsigned_module_target) -
+      pad_[2 * sizeof(int) - sizeof(frame_pipeline_depth) -
+           sizeof(worker_pinning) - sizeof(should_reserve_main_thread_core) -
+           sizeof(insecure_allow_unsigned_module_target) -
            sizeof(should_dump_heap_allocator_statistics_on_exit)] = {};
 #else
   WB_ATTRIBUTE_UNUSED_FIELD std::byte
-      pad_[sizeof(int) - sizeof(insecure_allow_unsigned_module_target) -
+      pad_[sizeof(char *) + sizeof(int) - sizeof(frame_pipeline_depth) -
+           sizeof(worker_pinning) - sizeof(should_reserve_main_thread_core) -
+           sizeof(insecure_allow_unsigned_module_target) -
            sizeof(should_dump_heap_allocator_statistics_on_exit)] = {};
 #endif
 };
@@ -0,0 +1,69 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Parallel batch loading of compiled KeyValues asset files.
+
+#include "key_values_batch.h"
+
+#include <expected>
+#include <optional>
+#include <ranges>
+
+#include "base/parallel/parallel.h"
+
+namespace wb::boot_manager {
+
+[[nodiscard]] base::std2::result<KeyValuesBatch> ParseKeyValuesBatch(
+    const std::filesystem::path& assets_path,
+    std::span<const std::string_view> globs,
+    const base::parsers::kv::KeyValuesOptions& options,
+    const base::parsers::kv::KeyValuesCacheOptions& cache_options) noexcept {
+  using namespace wb::base;
+  using namespace wb::base::parsers::kv;
+
+  auto paths = FindFilesByGlob(assets_path, globs);
+  if (!paths.has_value()) [[unlikely]] {
+    return std2::result<KeyValuesBatch>{std::unexpect, paths.error()};
+  }
+
+  // Each task owns its own slot, so no synchronization is needed.
+  std::vector<
+      std::optional<std::expected<CompiledKeyValuesFile, KeyValuesError>>>
+      results(paths->size());
+
+  // Files differ in size a lot, so each one is own task to balance load.
+  parallel::GrainSize grain_size{parallel::GrainSize::Fixed(1)};
+
+  // Loading is not frame work, so keep it out of frame critical lane.
+  parallel::ParallelFor(
+      std::views::iota(std::size_t{0}, paths->size()),
+      [&](std::size_t i) {
+        results[i].emplace(CompiledKeyValuesFile::Load(
+            assets_path / (*paths)[i], options, cache_options));
+      },
+      grain_size, TaskPriority::kNormal);
+
+  std::vector<KeyValuesFile> files;
+  files.reserve(paths->size());
+
+  KeyValuesBatch batch{{}, {}, 0};
+
+  // Merge in path order.
+  for (std::size_t i{0}; i < paths->size(); ++i) {
+    auto& result = *results[i];
+
+    if (result.has_value()) [[likely]] {
+      if (result->IsFromCache()) ++batch.cache_hits;
+
+      files.push_back({std::move((*paths)[i]), std::move(*result)});
+    } else {
+      batch.errors.emplace_back(std::move(result.error()));
+    }
+  }
+
+  batch.store = KeyValuesStore{std::move(files)};
+  return batch;
+}
+
+}  // namespace wb::boot_manager
@@ -0,0 +1,62 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Parallel batch loading of compiled KeyValues asset files.
+
+#ifndef WB_BOOT_MANAGER_KEY_VALUES_BATCH_H_
+#define WB_BOOT_MANAGER_KEY_VALUES_BATCH_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "base/parsers/compiled_key_values.h"
+#include "base/parsers/key_values.h"
+#include "base/parsers/key_values_store.h"
+#include "base/std2/system_error_ext.h"
+
+namespace wb::boot_manager {
+
+/**
+ * @brief Batch load result.
+ */
+struct KeyValuesBatch {
+  /**
+   * @brief Successfully loaded files.
+   */
+  base::parsers::kv::KeyValuesStore store;
+  /**
+   * @brief Errors of files failed to parse, ordered by file path.
+   */
+  std::vector<base::parsers::kv::KeyValuesError> errors;
+  /**
+   * @brief Count of files loaded from compiled cache.
+   */
+  std::size_t cache_hits;
+};
+
+/**
+ * @brief Loads all files under |assets_path| which match any of |globs|.
+ * Each file is loaded as separate normal priority task on the current marl
+ * scheduler, or serially when no scheduler is bound.  Results are merged in
+ * file path order, so they do not depend on scheduling.  Files with valid
+ * compiled cache are not parsed at all.
+ * @param assets_path Assets root.
+ * @param globs Globs relative to assets root, see MatchesGlob.
+ * @param options Parse options.  #include / #base are resolved relative to
+ * including file when include directory is empty.
+ * @param cache_options Compiled cache options.
+ * @return Batch result or error when assets directory can't be enumerated.
+ */
+[[nodiscard]] base::std2::result<KeyValuesBatch> ParseKeyValuesBatch(
+    const std::filesystem::path& assets_path,
+    std::span<const std::string_view> globs,
+    const base::parsers::kv::KeyValuesOptions& options,
+    const base::parsers::kv::KeyValuesCacheOptions& cache_options) noexcept;
+
+}  // namespace wb::boot_manager
+
+#endif  // !WB_BOOT_MANAGER_KEY_VALUES_BATCH_H_
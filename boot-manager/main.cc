@@ -6,9 +6,12 @@
 
 #include "main.h"
 
+#include <array>
+#include <chrono>
 #include <filesystem>
 
 #include "app_version_config.h"
+#include "base/cpu_topology.h"
 #include "base/deps/abseil/cleanup/cleanup.h"
 #include "base/deps/g3log/g3log.h"
 #include "base/deps/marl/scheduler.h"
@@ -19,14 +22,16 @@
 #include "base/scoped_shared_library.h"
 #include "base/std2/filesystem_ext.h"
 #include "base/std2/system_error_ext.h"
+#include "base/std2/thread_ext.h"
+#include "base/task_lanes.h"
 #include "build/build_config.h"
+#include "key_values_batch.h"
 #include "kernel/main.h"
 #include "ui/fatal_dialog.h"
 
 #ifdef WB_OS_WIN
 #include "base/deps/abseil/cleanup/cleanup.h"
 #include "base/scoped_app_instance_manager.h"
-#include "base/std2/thread_ext.h"
 #include "base/win/dll_load_utils.h"
 #include "base/win/error_handling/scoped_process_pure_call_handler.h"
 #include "base/win/error_handling/scoped_thread_invalid_parameter_handler.h"
@@ -160,14 +165,83 @@ void DumpSystemInformation(std::string_view app_description,
 #endif
 }
 
+/**
+ * @brief Loads KeyValues scripts and materials from assets in parallel.
+ * Compiled files are cached in temporary directory, so next runs skip parsing
+ * of unchanged files.  Requires marl scheduler bound to the thread.
+ * @param assets_path Assets path.
+ * @return Store with compiled files.  Files which failed to parse are logged
+ * and skipped.
+ */
+[[nodiscard]] wb::base::parsers::kv::KeyValuesStore PreloadKeyValues(
+    const std::string& assets_path) noexcept {
+  using namespace wb::base::parsers::kv;
+
+  constexpr std::array<std::string_view, 2> kGlobs{"scripts/**.txt",
+                                                   "materials/**.vmt"};
+  // Conditions are for [$WIN32] like KeyValues keys.
+  constexpr auto kConditions = std::to_array<std::string_view>({
+#ifdef WB_OS_WIN
+      "WINDOWS", "WIN32"
+#elif defined(WB_OS_MACOS)
+      "POSIX", "OSX"
+#elif defined(WB_OS_LINUX)
+      "POSIX", "LINUX"
+#else
+      "POSIX"
+#endif
+  });
+
+  std::error_code rc;
+  std::filesystem::path cache_directory{
+      std::filesystem::temp_directory_path(rc)};
+  if (!rc) [[likely]] {
+    cache_directory /= "whitebox";
+    cache_directory /= "kv_cache";
+  } else {
+    G3PLOG_E(WARNING, rc) << "Can't get temporary directory, KeyValues "
+                             "compiled cache is disabled.";
+    cache_directory.clear();
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  auto batch = wb::boot_manager::ParseKeyValuesBatch(
+      assets_path, kGlobs, {kConditions, {}},
+      {cache_directory, WB_PRODUCT_FILEVERSION_INFO_STRING});
+  if (!batch.has_value()) [[unlikely]] {
+    G3PLOG_E(WARNING, batch.error())
+        << "Can't enumerate KeyValues files in assets '" << assets_path
+        << "', continue without them.";
+    return KeyValuesStore{};
+  }
+
+  for (const auto& error : batch->errors) {
+    G3LOG(WARNING) << error.source_name << "(" << error.position.line << ","
+                   << error.position.column << "): " << error.message;
+  }
+
+  G3LOG(INFO) << "Loaded " << batch->store.GetFiles().size()
+              << " KeyValues files (" << batch->cache_hits << " cached, "
+              << batch->errors.size() << " failed) using "
+              << batch->store.GetCompiledBytes() << " compiled bytes in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << "ms.";
+
+  return std::move(batch->store);
+}
+
 /**
  * @brief Load and run kernel.
  * @param boot_manager_args Boot manager args.
- * @param intl Localization lookup.
+ * @param key_values Preloaded KeyValues.
  * @return App exit code.
  */
 int KernelStartup(
-    const wb::boot_manager::BootManagerArgs& boot_manager_args) noexcept {
+    const wb::boot_manager::BootManagerArgs& boot_manager_args,
+    const wb::base::parsers::kv::KeyValuesStore& key_values) noexcept {
   using namespace wb::base;
 
   const auto app_path_result = std2::filesystem::get_executable_directory();
@@ -224,11 +298,12 @@ int KernelStartup(
           {boot_manager_args.app_description, boot_manager_args.instance,
            boot_manager_args.show_window_flags, boot_manager_args.main_icon_id,
            boot_manager_args.small_icon_id,
-           boot_manager_args.command_line_flags, boot_manager_args.intl});
+           boot_manager_args.command_line_flags, boot_manager_args.intl,
+           key_values});
 #else
       return (*kernel_main)({boot_manager_args.app_description,
                              boot_manager_args.command_line_flags,
-                             boot_manager_args.intl});
+                             boot_manager_args.intl, key_values});
 #endif
     }
 
@@ -443,18 +518,32 @@ extern "C" [[nodiscard]] WB_BOOT_MANAGER_API int BootManagerMain(
   }
 #endif
 
-  const unsigned logical_cores_num{marl::Thread::numLogicalCPUs()};
-  const marl::Scheduler::Config all_cores_config =
+  const CommandLineFlags &command_line_flags{
+      boot_manager_args.command_line_flags};
+  const CpuTopology cpu_topology{
+      QueryCpuTopology(marl::Thread::numLogicalCPUs())};
+  // Place workers by physical cores / L3 cache groups, so they do not share
+  // cores with SMT siblings or main thread and do not migrate across CCXs.
+  const WorkerPlacement worker_placement{PlanWorkerPlacement(
+      cpu_topology, command_line_flags.worker_pinning,
+      command_line_flags.should_reserve_main_thread_core)};
+
+  marl::Scheduler::Config scheduler_config =
       marl::Scheduler::Config()
-          // Use all logical cores.
-          .setWorkerThreadCount(static_cast<int>(logical_cores_num))
+          .setWorkerThreadCount(
+              static_cast<int>(worker_placement.worker_cpus.size()))
           // Setup all required thread state stuff.
           .setWorkerThreadStatefulInitializer(
               deps::marl::make_thread_start_state);
+  if (auto worker_affinity_policy =
+          deps::marl::make_worker_affinity_policy(worker_placement)) {
+    scheduler_config.setWorkerThreadAffinityPolicy(
+        std::move(worker_affinity_policy));
+  }
 
   // Create a marl scheduler and bind it to the main thread so we can call
   // marl::schedule()
-  marl::Scheduler process_wide_scheduler{all_cores_config};
+  marl::Scheduler process_wide_scheduler{scheduler_config};
   process_wide_scheduler.bind();
 
   // Need to unbind scheduler from main thread.  Forgetting to unbind will
@@ -462,8 +551,50 @@ extern "C" [[nodiscard]] WB_BOOT_MANAGER_API int BootManagerMain(
   const absl::Cleanup unbind_scheduler{
       [&]() noexcept { process_wide_scheduler.unbind(); }};
 
-  G3LOG(INFO) << "Marl CPU scheduler using " << logical_cores_num
-              << " logical cores.";
+  // Keep background work (streaming, decompression) out of marl queues, so it
+  // never takes workers frame critical work needs.
+  TaskLanes process_task_lanes{
+      static_cast<std::uint32_t>(worker_placement.worker_cpus.size()),
+      TaskLaneShares{
+          .normal_workers = command_line_flags.normal_lane_workers,
+          .background_workers = command_line_flags.background_lane_workers}};
+  process_task_lanes.Bind();
+
+  // Unbind before lanes wait for tasks on destruction.
+  const absl::Cleanup unbind_task_lanes{[]() noexcept { TaskLanes::Unbind(); }};
+
+  G3LOG(INFO) << "Marl CPU scheduler using "
+              << worker_placement.worker_cpus.size() << " workers ("
+              << GetWorkerPinningName(command_line_flags.worker_pinning)
+              << " pinning"
+              << (!worker_placement.main_thread_cpus.empty()
+                      ? ", main thread core reserved"
+                      : "")
+              << ") on " << cpu_topology.cpus.size() << " logical CPUs, "
+              << cpu_topology.GetCoresCount() << " physical cores, "
+              << cpu_topology.GetCacheGroupsCount() << " L3 cache groups, "
+              << cpu_topology.GetNumaNodesCount() << " NUMA nodes.";
+  G3LOG(INFO) << "Task lanes limit normal tasks to "
+              << process_task_lanes.GetStats(TaskPriority::kNormal)
+                     .max_running_count
+              << " workers, background tasks to "
+              << process_task_lanes.GetStats(TaskPriority::kBackground)
+                     .max_running_count
+              << " workers.";
+
+  // Scripts and materials are parsed on all cores before kernel needs them.
+  const auto key_values =
+      PreloadKeyValues(boot_manager_args.command_line_flags.assets_path);
+
+  // Threads inherit affinity of the thread which creates them, so pin main
+  // thread only after workers started.  Otherwise workers not pinned by policy
+  // would share reserved core with main thread.
+  if (!worker_placement.main_thread_cpus.empty()) {
+    G3PLOGE2_IF(WARNING, std2::this_thread::set_affinity(
+                             worker_placement.main_thread_cpus))
+        << "Can't pin main thread to reserved core, workers still do not "
+           "use it.";
+  }
 
-  return KernelStartup(boot_manager_args);
+  return KernelStartup(boot_manager_args, key_values);
 }
\ No newline at end of file
@@ -664,6 +664,13 @@
  */
 #define WB_ATTRIBUTE_HOT __attribute__((hot))
 
+/*
+ * @brief The target attribute is used to specify that a function is to be
+ * compiled with different target options than specified on the command line.
+ * Used for instruction set specific code paths selected at runtime.
+ */
+#define WB_ATTRIBUTE_TARGET(target_isa) __attribute__((target(target_isa)))
+
 /*
  * @brief The weak attribute causes a declaration of an external symbol to be
  * emitted as a weak symbol rather than a global.  This is primarily useful in
@@ -852,6 +859,11 @@
  */
 #define WB_ATTRIBUTE_HOT
 
+/*
+ * @brief Do nothing.  MSVC allows any instruction set intrinsics anyway.
+ */
+#define WB_ATTRIBUTE_TARGET(target_isa)
+
 /*
  * @brief Do nothing.
  */
@@ -0,0 +1,185 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox job graph: jobs with read / write dependencies executed on marl.
+
+#include "kernel/jobs/job_graph.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/marl/scheduler.h"
+#include "base/deps/marl/waitgroup.h"
+#include "base/task_lanes.h"
+
+namespace {
+
+/**
+ * @brief Marks absent job.
+ */
+constexpr wb::kernel::jobs::JobId kNoJob{0xFFFFFFFFU};
+
+/**
+ * @brief Adds |dependency| to |dependencies| once.
+ * @param dependencies Dependencies.
+ * @param dependency Dependency.
+ */
+void AddDependency(std::vector<wb::kernel::jobs::JobId> &dependencies,
+                   wb::kernel::jobs::JobId dependency) noexcept {
+  if (dependency != kNoJob &&
+      std::ranges::find(dependencies, dependency) == dependencies.end()) {
+    dependencies.push_back(dependency);
+  }
+}
+
+}  // namespace
+
+namespace wb::kernel::jobs {
+
+JobGraph::JobGraph() noexcept
+    : jobs_{},
+      accesses_{},
+      pending_dependencies_{},
+      start_time_{},
+      is_built_{false},
+      pad_{} {}
+
+JobGraph::~JobGraph() noexcept = default;
+
+JobId JobGraph::AddJob(std::string_view name,
+                       std::span<const JobResource> reads,
+                       std::span<const JobResource> writes,
+                       std::function<void()> run) noexcept {
+  G3DCHECK(!is_built_) << "Job graph is already built.";
+
+  const auto id = static_cast<JobId>(jobs_.size());
+  std::vector<JobId> dependencies;
+
+  // Read after write.
+  for (const JobResource resource : reads) {
+    auto [it, is_inserted] =
+        accesses_.try_emplace(resource, ResourceAccess{{}, kNoJob, {}});
+
+    AddDependency(dependencies, it->second.writer);
+    it->second.readers.push_back(id);
+  }
+
+  // Write after write and write after read.
+  for (const JobResource resource : writes) {
+    auto [it, is_inserted] =
+        accesses_.try_emplace(resource, ResourceAccess{{}, kNoJob, {}});
+    ResourceAccess &access{it->second};
+
+    AddDependency(dependencies, access.writer);
+    for (const JobId reader : access.readers) {
+      if (reader != id) AddDependency(dependencies, reader);
+    }
+
+    access.readers.clear();
+    access.writer = id;
+  }
+
+  std::ranges::sort(dependencies);
+  for (const JobId dependency : dependencies) {
+    jobs_[dependency].dependents.push_back(id);
+  }
+
+  jobs_.push_back({std::string{name}, std::move(run), std::move(dependencies),
+                   {}, {}, {}});
+  return id;
+}
+
+void JobGraph::Build() noexcept {
+  G3DCHECK(!is_built_) << "Job graph is already built.";
+
+  accesses_.clear();
+  pending_dependencies_ =
+      std::make_unique<std::atomic<std::uint32_t>[]>(jobs_.size());
+  is_built_ = true;
+}
+
+void JobGraph::Execute() noexcept {
+  G3DCHECK(is_built_) << "Job graph should be built before execution.";
+
+  start_time_ = base::HighResolutionClock::now();
+
+  if (!::marl::Scheduler::get() || jobs_.size() <= 1) {
+    // Add order is topological order.
+    for (Job &job : jobs_) RunJob(job, nullptr);
+    return;
+  }
+
+  for (JobId id{0}; id < jobs_.size(); ++id) {
+    pending_dependencies_[id].store(
+        static_cast<std::uint32_t>(jobs_[id].dependencies.size()),
+        std::memory_order_relaxed);
+  }
+
+  ::marl::WaitGroup done{static_cast<unsigned>(jobs_.size())};
+
+  for (Job &job : jobs_) {
+    if (job.dependencies.empty()) {
+      base::ScheduleTask(base::TaskPriority::kFrameCritical,
+                         [done, this, &job]() mutable { RunJob(job, &done); });
+    }
+  }
+
+  done.wait();
+}
+
+void JobGraph::RunJob(Job &job, ::marl::WaitGroup *done) noexcept {
+  job.start_time = base::HighResolutionClock::now();
+  job.run();
+  job.end_time = base::HighResolutionClock::now();
+
+  if (!done) return;
+
+  for (const JobId dependent : job.dependents) {
+    // Last finished dependency schedules dependent.
+    if (pending_dependencies_[dependent].fetch_sub(
+            1, std::memory_order_acq_rel) == 1) {
+      base::ScheduleTask(
+          base::TaskPriority::kFrameCritical,
+          [wait_group = *done, this, &next = jobs_[dependent]]() mutable {
+            RunJob(next, &wait_group);
+          });
+    }
+  }
+
+  done->done();
+}
+
+[[nodiscard]] JobGraphTrace JobGraph::GetTrace() const noexcept {
+  JobGraphTrace trace{{}, {}};
+  if (jobs_.empty()) return trace;
+
+  // Job which finished last gated graph completion.
+  const auto last = std::ranges::max_element(jobs_, {}, &Job::end_time);
+  trace.total_time = last->end_time - start_time_;
+
+  auto id = static_cast<JobId>(last - jobs_.begin());
+  while (id != kNoJob) {
+    const Job &job{jobs_[id]};
+
+    // Dependency which finished last gated job start.
+    JobId gate{kNoJob};
+    auto ready_time = start_time_;
+    for (const JobId dependency : job.dependencies) {
+      if (jobs_[dependency].end_time >= ready_time) {
+        ready_time = jobs_[dependency].end_time;
+        gate = dependency;
+      }
+    }
+
+    trace.critical_path.push_back(
+        {job.name, job.start_time - ready_time, job.end_time - job.start_time});
+    id = gate;
+  }
+
+  std::ranges::reverse(trace.critical_path);
+  return trace;
+}
+
+}  // namespace wb::kernel::jobs
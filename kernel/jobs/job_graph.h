@@ -0,0 +1,226 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox job graph: jobs with read / write dependencies executed on marl.
+
+#ifndef WB_KERNEL_JOBS_JOB_GRAPH_H_
+#define WB_KERNEL_JOBS_JOB_GRAPH_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "base/high_resolution_clock.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+#include "kernel/config.h"
+
+namespace marl {
+class WaitGroup;
+}  // namespace marl
+
+namespace wb::kernel::jobs {
+
+/**
+ * @brief Job id, index in graph.
+ */
+using JobId = std::uint32_t;
+
+/**
+ * @brief Resource job reads or writes.  Meaning is up to graph owner.
+ */
+using JobResource = std::uint32_t;
+
+/**
+ * @brief Job on critical path of graph execution.
+ */
+struct CriticalPathJob {
+  /**
+   * @brief Job name.
+   */
+  std::string_view name;
+  /**
+   * @brief Time between all dependencies done and job start, scheduling
+   * overhead.
+   */
+  base::HighResolutionClockDuration wait_time;
+  /**
+   * @brief Job run time.
+   */
+  base::HighResolutionClockDuration run_time;
+};
+
+/**
+ * @brief Trace of last graph execution.
+ */
+struct JobGraphTrace {
+  /**
+   * @brief Whole graph execution time.
+   */
+  base::HighResolutionClockDuration total_time;
+  /**
+   * @brief Chain of jobs which gated graph completion, first to last.
+   */
+  std::vector<CriticalPathJob> critical_path;
+};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Graph of jobs built once and executed many times, ex. every frame.
+   * Dependencies are derived from declared resources in job add order: job
+   * runs after the last writer of each resource it reads or writes, and after
+   * all readers of each resource it writes since its last writer.  So graph
+   * behaves as if jobs ran serially in add order, but independent jobs run in
+   * parallel on marl.
+   */
+  class WB_WHITEBOX_KERNEL_API JobGraph {
+   public:
+    /**
+     * @brief Creates empty graph.
+     */
+    JobGraph() noexcept;
+    ~JobGraph() noexcept;
+
+    WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(JobGraph);
+
+    /**
+     * @brief Adds job.  Should be called before Build.
+     * @param name Job name for tracing.
+     * @param reads Resources job reads.
+     * @param writes Resources job writes.
+     * @param run Job function.
+     * @return Job id.
+     */
+    JobId AddJob(std::string_view name, std::span<const JobResource> reads,
+                 std::span<const JobResource> writes,
+                 std::function<void()> run) noexcept;
+
+    /**
+     * @brief Finishes graph building.  No jobs can be added after.
+     */
+    void Build() noexcept;
+
+    /**
+     * @brief Executes all jobs and waits for them.  Runs jobs serially in add
+     * order when no marl scheduler is bound to the thread.
+     */
+    void Execute() noexcept;
+
+    /**
+     * @brief Jobs count.
+     */
+    [[nodiscard]] std::size_t GetJobsCount() const noexcept {
+      return jobs_.size();
+    }
+
+    /**
+     * @brief Job dependencies.
+     * @param id Job id.
+     */
+    [[nodiscard]] std::span<const JobId> GetDependencies(
+        JobId id) const noexcept {
+      return jobs_[id].dependencies;
+    }
+
+    /**
+     * @brief Gets trace of last execution.
+     * @return Trace.
+     */
+    [[nodiscard]] JobGraphTrace GetTrace() const noexcept;
+
+   private:
+    /**
+     * @brief Job.
+     */
+    struct Job {
+      /**
+       * @brief Name.
+       */
+      std::string name;
+      /**
+       * @brief Function.
+       */
+      std::function<void()> run;
+      /**
+       * @brief Jobs this job waits for.
+       */
+      std::vector<JobId> dependencies;
+      /**
+       * @brief Jobs waiting for this job.
+       */
+      std::vector<JobId> dependents;
+      /**
+       * @brief Last execution start time.
+       */
+      base::HighResolutionClock::time_point start_time;
+      /**
+       * @brief Last execution end time.
+       */
+      base::HighResolutionClock::time_point end_time;
+    };
+
+    /**
+     * @brief Who accessed resource last.
+     */
+    struct ResourceAccess {
+      /**
+       * @brief Jobs which read resource since last write.
+       */
+      std::vector<JobId> readers;
+      /**
+       * @brief Last writer.
+       */
+      JobId writer;
+
+      WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 4> pad_;
+    };
+
+    /**
+     * @brief Jobs in add order, which is topological order, too.
+     */
+    std::vector<Job> jobs_;
+    /**
+     * @brief Resource accesses, only while building.
+     */
+    std::unordered_map<JobResource, ResourceAccess> accesses_;
+    /**
+     * @brief Not done dependencies count per job during execution.
+     */
+    base::un<std::atomic<std::uint32_t>[]> pending_dependencies_;
+    /**
+     * @brief Last execution start time.
+     */
+    base::HighResolutionClock::time_point start_time_;
+    /**
+     * @brief Is graph built?
+     */
+    bool is_built_;
+
+    WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 7> pad_;
+
+    /**
+     * @brief Runs job, then schedules dependents which became ready.
+     * @param job Job.
+     * @param done Signaled when job is done.  When nullptr, dependents are not
+     * scheduled, caller runs jobs itself.
+     */
+    void RunJob(Job &job, ::marl::WaitGroup *done) noexcept;
+  };
+
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+}  // namespace wb::kernel::jobs
+
+#endif  // !WB_KERNEL_JOBS_JOB_GRAPH_H_
@@ -0,0 +1,248 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox job graph: jobs with read / write dependencies executed on marl.
+
+#include "job_graph.h"
+//
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/deps/marl/scheduler.h"
+
+namespace {
+
+/**
+ * @brief Binds marl scheduler with 4 workers to the thread in scope.
+ */
+class ScopedTestScheduler {
+ public:
+  ScopedTestScheduler() noexcept
+      : scheduler_{marl::Scheduler::Config{}.setWorkerThreadCount(4)} {
+    scheduler_.bind();
+  }
+
+  ~ScopedTestScheduler() noexcept { scheduler_.unbind(); }
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(ScopedTestScheduler);
+
+ private:
+  marl::Scheduler scheduler_;
+};
+
+/**
+ * @brief Jobs run order, thread-safe.
+ */
+class RunOrder {
+ public:
+  RunOrder() noexcept = default;
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(RunOrder);
+
+  /**
+   * @brief Makes job function which records its |name| when run.
+   * @param name Job name.
+   * @return Job function.
+   */
+  [[nodiscard]] std::function<void()> Record(std::string name) {
+    return [this, job_name = std::move(name)]() {
+      const std::scoped_lock lock{mutex_};
+      names_.push_back(job_name);
+    };
+  }
+
+  /**
+   * @brief Gets position of job |name| in run order.
+   * @param name Job name.
+   * @return Position.
+   */
+  [[nodiscard]] std::size_t GetPosition(const std::string &name) const {
+    const std::scoped_lock lock{mutex_};
+    return static_cast<std::size_t>(std::ranges::find(names_, name) -
+                                    names_.begin());
+  }
+
+  /**
+   * @brief Gets run jobs count.
+   */
+  [[nodiscard]] std::size_t GetSize() const {
+    const std::scoped_lock lock{mutex_};
+    return names_.size();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<std::string> names_;
+};
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(JobGraphTest, EmptyGraph) {
+  using namespace wb::kernel::jobs;
+
+  const ScopedTestScheduler scoped_scheduler;
+
+  JobGraph graph;
+  graph.Build();
+
+  EXPECT_EQ(0U, graph.GetJobsCount());
+
+  graph.Execute();
+  graph.Execute();
+
+  const JobGraphTrace trace{graph.GetTrace()};
+  EXPECT_TRUE(trace.critical_path.empty());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(JobGraphTest, DependenciesFromConflictingAccess) {
+  using namespace wb::kernel::jobs;
+
+  constexpr JobResource kPositions{1}, kVelocities{2};
+
+  JobGraph graph;
+  const JobId integrate{
+      graph.AddJob("Integrate", std::array{kVelocities},
+                   std::array{kPositions}, [] {})};
+  const JobId render{
+      graph.AddJob("Render", std::array{kPositions}, {}, [] {})};
+  const JobId audio{graph.AddJob("Audio", std::array{kPositions}, {}, [] {})};
+  const JobId physics{graph.AddJob("Physics", std::array{kPositions},
+                                   std::array{kPositions, kVelocities},
+                                   [] {})};
+  graph.Build();
+
+  EXPECT_EQ(4U, graph.GetJobsCount());
+  EXPECT_TRUE(graph.GetDependencies(integrate).empty());
+  // Read after write.
+  EXPECT_EQ(std::vector<JobId>{integrate},
+            std::vector<JobId>(graph.GetDependencies(render).begin(),
+                               graph.GetDependencies(render).end()));
+  EXPECT_EQ(std::vector<JobId>{integrate},
+            std::vector<JobId>(graph.GetDependencies(audio).begin(),
+                               graph.GetDependencies(audio).end()));
+  // Write after write, write after read.  Job own read does not make it depend
+  // on itself.
+  EXPECT_EQ((std::vector<JobId>{integrate, render, audio}),
+            std::vector<JobId>(graph.GetDependencies(physics).begin(),
+                               graph.GetDependencies(physics).end()));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(JobGraphTest, NoCyclesByConstruction) {
+  using namespace wb::kernel::jobs;
+
+  constexpr JobResource kA{1}, kB{2};
+
+  // Jobs which would form cycle a -> b -> a if dependencies were symmetric.
+  JobGraph graph;
+  graph.AddJob("ReadAWriteB", std::array{kA}, std::array{kB}, [] {});
+  graph.AddJob("ReadBWriteA", std::array{kB}, std::array{kA}, [] {});
+  graph.AddJob("WriteAB", {}, std::array{kA, kB}, [] {});
+  graph.AddJob("ReadWriteA", std::array{kA}, std::array{kA}, [] {});
+  graph.Build();
+
+  // Jobs depend only on jobs added before, so graph is acyclic.
+  for (JobId id{0}; id < graph.GetJobsCount(); ++id) {
+    for (const JobId dependency : graph.GetDependencies(id)) {
+      EXPECT_LT(dependency, id) << id;
+    }
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(JobGraphTest, ConflictingAccessOrdering) {
+  using namespace wb::kernel::jobs;
+
+  constexpr JobResource kState{1};
+
+  for (const bool has_scheduler : {false, true}) {
+    std::optional<ScopedTestScheduler> scoped_scheduler;
+    if (has_scheduler) scoped_scheduler.emplace();
+
+    RunOrder order;
+
+    JobGraph graph;
+    graph.AddJob("Write1", {}, std::array{kState}, order.Record("Write1"));
+    graph.AddJob("Read1", std::array{kState}, {}, order.Record("Read1"));
+    graph.AddJob("Read2", std::array{kState}, {}, order.Record("Read2"));
+    graph.AddJob("Write2", {}, std::array{kState}, order.Record("Write2"));
+    graph.AddJob("Read3", std::array{kState}, {}, order.Record("Read3"));
+    graph.Build();
+
+    graph.Execute();
+
+    ASSERT_EQ(5U, order.GetSize()) << has_scheduler;
+    EXPECT_LT(order.GetPosition("Write1"), order.GetPosition("Read1"));
+    EXPECT_LT(order.GetPosition("Write1"), order.GetPosition("Read2"));
+    EXPECT_LT(order.GetPosition("Read1"), order.GetPosition("Write2"));
+    EXPECT_LT(order.GetPosition("Read2"), order.GetPosition("Write2"));
+    EXPECT_LT(order.GetPosition("Write2"), order.GetPosition("Read3"));
+
+    const JobGraphTrace trace{graph.GetTrace()};
+    ASSERT_EQ(4U, trace.critical_path.size()) << has_scheduler;
+    EXPECT_EQ("Write1", trace.critical_path.front().name);
+    EXPECT_EQ("Write2", trace.critical_path[2].name);
+    EXPECT_EQ("Read3", trace.critical_path.back().name);
+  }
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(JobGraphTest, DisjointReadsRunInParallel) {
+  using namespace wb::kernel::jobs;
+  using namespace std::chrono_literals;
+
+  constexpr JobResource kState{1};
+  constexpr int kReadersCount{3};
+
+  const ScopedTestScheduler scoped_scheduler;
+
+  std::atomic_int started_readers_count{0};
+  std::atomic_int met_readers_count{0};
+
+  // Each reader waits till all readers started, which can happen only when
+  // they run at the same time.
+  const auto reader = [&]() {
+    started_readers_count.fetch_add(1);
+
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (started_readers_count.load() < kReadersCount &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+
+    if (started_readers_count.load() == kReadersCount) {
+      met_readers_count.fetch_add(1);
+    }
+  };
+
+  JobGraph graph;
+  graph.AddJob("Write", {}, std::array{kState}, [] {});
+  for (int i{0}; i < kReadersCount; ++i) {
+    graph.AddJob("Read" + std::to_string(i), std::array{kState}, {}, reader);
+  }
+  graph.Build();
+
+  graph.Execute();
+
+  EXPECT_EQ(kReadersCount, met_readers_count.load());
+
+  // Graph executes many times.
+  started_readers_count.store(0);
+  met_readers_count.store(0);
+
+  graph.Execute();
+
+  EXPECT_EQ(kReadersCount, met_readers_count.load());
+}
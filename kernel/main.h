@@ -12,6 +12,7 @@
 
 #include "base/deps/g3log/g3log.h"
 #include "base/intl/lookup_with_fallback.h"
+#include "base/parsers/key_values_store.h"
 #include "boot-manager/command_line_flags.h"
 #include "build/build_config.h"
 #include "config.h"
@@ -33,23 +34,27 @@ struct KernelArgs {
   KernelArgs(std::string_view app_description_, HINSTANCE instance_,
              int show_window_flags_, int main_icon_id_, int small_icon_id_,
              const wb::boot_manager::CommandLineFlags &command_line_flags_,
-             const base::intl::LookupWithFallback &intl_) noexcept
+             const base::intl::LookupWithFallback &intl_,
+             const base::parsers::kv::KeyValuesStore &key_values_) noexcept
       : app_description{app_description_},
         instance{instance_},
         show_window_flags{show_window_flags_},
         main_icon_id{main_icon_id_},
         small_icon_id{small_icon_id_},
         command_line_flags{command_line_flags_},
-        intl{intl_} {
+        intl{intl_},
+        key_values{key_values_} {
     G3DCHECK(!!instance_);
   }
 #else
   KernelArgs(std::string_view app_description_,
              const wb::boot_manager::CommandLineFlags &command_line_flags_,
-             const base::intl::LookupWithFallback &intl_) noexcept
+             const base::intl::LookupWithFallback &intl_,
+             const base::parsers::kv::KeyValuesStore &key_values_) noexcept
       : app_description{app_description_},
         command_line_flags{command_line_flags_},
-        intl{intl_} {}
+        intl{intl_},
+        key_values{key_values_} {}
 #endif
 
   /**
@@ -89,6 +94,11 @@ struct KernelArgs {
    */
   const base::intl::LookupWithFallback &intl;
 
+  /**
+   * @brief KeyValues scripts and materials preloaded from assets.
+   */
+  const base::parsers::kv::KeyValuesStore &key_values;
+
   WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(KernelArgs);
 };
 
@@ -12,6 +12,10 @@ WB_GCC_BEGIN_WARNING_OVERRIDE_SCOPE()
   WB_GCC_DISABLE_NULL_DEREFERENCE_WARNING()
 #include <chrono>
 WB_GCC_END_WARNING_OVERRIDE_SCOPE()
+#include <array>
+#include <cstddef>
+#include <cmath>
+#include <optional>
 #include <thread>
 
 #include "main.h"
@@ -23,22 +27,261 @@ WB_GCC_END_WARNING_OVERRIDE_SCOPE()
 #include "base/deps/sdl/version.h"
 #include "base/deps/sdl/window.h"
 #include "base/deps/sdl_image/sdl_image.h"
+#include "base/high_resolution_clock.h"
 #include "base/intl/l18n.h"
 #include "build/static_settings_config.h"
+#include "kernel/input/input_queue.h"
+#include "kernel/main_simulate_step.h"
 #include "kernel/main_window_posix.h"
 #include "ui/fatal_dialog.h"
 
 namespace {
 
+/**
+ * @brief Make codes (scan code set 1) of SDL_SCANCODE_A..SDL_SCANCODE_Z.
+ */
+constexpr std::array<unsigned short, 26> kLetterMakeCodes{
+    0x1E, 0x30, 0x2E, 0x20, 0x12, 0x21, 0x22, 0x23, 0x17,
+    0x24, 0x25, 0x26, 0x32, 0x31, 0x18, 0x19, 0x10, 0x13,
+    0x1F, 0x14, 0x16, 0x2F, 0x11, 0x2D, 0x15, 0x2C};
+
+/**
+ * @brief Makes keyboard input from SDL key event.  SDL scan codes are USB HID
+ * usages, while keyboard input uses scan code set 1 make codes as Windows raw
+ * input does, so map keys apps use.
+ * @param key SDL key event.
+ * @return Keyboard input or std::nullopt when key is not mapped.
+ */
+[[nodiscard]] std::optional<wb::hal::hid::KeyboardInput> MakeKeyboardInput(
+    const SDL_KeyboardEvent& key) noexcept {
+  using namespace wb::hal::hid;
+
+  // Offset of scan code in [first, last] range.
+  const auto offset = [scancode = key.scancode](SDL_Scancode first) noexcept {
+    return static_cast<std::size_t>(scancode) -
+           static_cast<std::size_t>(first);
+  };
+
+  unsigned short make_code{0};
+  bool has_e0_prefix{false};
+
+  if (key.scancode >= SDL_SCANCODE_A && key.scancode <= SDL_SCANCODE_Z) {
+    make_code = kLetterMakeCodes[offset(SDL_SCANCODE_A)];
+  } else if (key.scancode >= SDL_SCANCODE_1 &&
+             key.scancode <= SDL_SCANCODE_0) {
+    // 1..9, 0 go in a row both in SDL and set 1.
+    make_code = static_cast<unsigned short>(0x02U + offset(SDL_SCANCODE_1));
+  } else if (key.scancode >= SDL_SCANCODE_F1 &&
+             key.scancode <= SDL_SCANCODE_F10) {
+    make_code = static_cast<unsigned short>(0x3BU + offset(SDL_SCANCODE_F1));
+  } else {
+    // Not all scan codes are mapped, so switch over int.
+    switch (static_cast<int>(key.scancode)) {
+      case SDL_SCANCODE_RETURN:
+        make_code = 0x1C;
+        break;
+      case SDL_SCANCODE_ESCAPE:
+        make_code = 0x01;
+        break;
+      case SDL_SCANCODE_BACKSPACE:
+        make_code = 0x0E;
+        break;
+      case SDL_SCANCODE_TAB:
+        make_code = 0x0F;
+        break;
+      case SDL_SCANCODE_SPACE:
+        make_code = 0x39;
+        break;
+      case SDL_SCANCODE_F11:
+        make_code = 0x57;
+        break;
+      case SDL_SCANCODE_F12:
+        make_code = 0x58;
+        break;
+      case SDL_SCANCODE_LCTRL:
+        make_code = 0x1D;
+        break;
+      case SDL_SCANCODE_LSHIFT:
+        make_code = 0x2A;
+        break;
+      case SDL_SCANCODE_LALT:
+        make_code = 0x38;
+        break;
+      case SDL_SCANCODE_RSHIFT:
+        make_code = 0x36;
+        break;
+      case SDL_SCANCODE_RCTRL:
+        make_code = 0x1D;
+        has_e0_prefix = true;
+        break;
+      case SDL_SCANCODE_RALT:
+        make_code = 0x38;
+        has_e0_prefix = true;
+        break;
+      case SDL_SCANCODE_UP:
+        make_code = 0x48;
+        has_e0_prefix = true;
+        break;
+      case SDL_SCANCODE_LEFT:
+        make_code = 0x4B;
+        has_e0_prefix = true;
+        break;
+      case SDL_SCANCODE_RIGHT:
+        make_code = 0x4D;
+        has_e0_prefix = true;
+        break;
+      case SDL_SCANCODE_DOWN:
+        make_code = 0x50;
+        has_e0_prefix = true;
+        break;
+      default:
+        return std::nullopt;
+    }
+  }
+
+  KeyboardKeyFlags key_flags{key.down ? KeyboardKeyFlags::kDown
+                                      : KeyboardKeyFlags::kUp};
+  if (has_e0_prefix) key_flags = key_flags | KeyboardKeyFlags::kE0Prefix;
+
+  return KeyboardInput{.make_code = make_code,
+                       .key_flags = key_flags,
+                       .reserved = 0};
+}
+
+/**
+ * @brief Makes mouse input.  Mouse input is always relative, as Windows raw
+ * input one.
+ * @param button_flags Button transition state.
+ * @param button_data Wheel distance.
+ * @param last_x Relative motion along x axis.
+ * @param last_y Relative motion along y axis.
+ * @return Mouse input.
+ */
+[[nodiscard]] constexpr wb::hal::hid::MouseInput MakeMouseInput(
+    wb::hal::hid::MouseButtonTransitionState button_flags, float button_data,
+    long last_x, long last_y) noexcept {
+  return wb::hal::hid::MouseInput{
+      .mouse_state = wb::hal::hid::MouseStateFlags::kMoveRelative,
+      .button_flags = button_flags,
+      .button_data = button_data,
+      .last_x = last_x,
+      .last_y = last_y};
+}
+
+/**
+ * @brief Gets mouse button transition state from SDL button event.
+ * @param button SDL button event.
+ * @return Mouse button transition state.
+ */
+[[nodiscard]] wb::hal::hid::MouseButtonTransitionState GetButtonTransition(
+    const SDL_MouseButtonEvent& button) noexcept {
+  using wb::hal::hid::MouseButtonTransitionState;
+
+  switch (button.button) {
+    case SDL_BUTTON_LEFT:
+      return button.down ? MouseButtonTransitionState::kLeftButtonDown
+                         : MouseButtonTransitionState::kLeftButtonUp;
+    case SDL_BUTTON_RIGHT:
+      return button.down ? MouseButtonTransitionState::kRightButtonDown
+                         : MouseButtonTransitionState::kRightButtonUp;
+    case SDL_BUTTON_MIDDLE:
+      return button.down ? MouseButtonTransitionState::kMiddleButtonDown
+                         : MouseButtonTransitionState::kMiddleButtonUp;
+    case SDL_BUTTON_X1:
+      return button.down ? MouseButtonTransitionState::kXButton1Down
+                         : MouseButtonTransitionState::kXButton1Up;
+    case SDL_BUTTON_X2:
+      return button.down ? MouseButtonTransitionState::kXButton2Down
+                         : MouseButtonTransitionState::kXButton2Up;
+    default:
+      return MouseButtonTransitionState::kNone;
+  }
+}
+
+/**
+ * @brief Feeds SDL mouse and keyboard event into input queues.
+ * @param event SDL event.
+ * @param mouse_input_queue Mouse input queue.
+ * @param keyboard_input_queue Keyboard input queue.
+ */
+void FeedInput(
+    const SDL_Event& event,
+    wb::kernel::input::InputQueue<wb::hal::hid::MouseInput>& mouse_input_queue,
+    wb::kernel::input::InputQueue<wb::hal::hid::KeyboardInput>&
+        keyboard_input_queue) noexcept {
+  using namespace wb::hal::hid;
+
+  const auto time = wb::base::HighResolutionClock::now();
+
+  switch (event.type) {
+    case SDL_EVENT_MOUSE_MOTION:
+      mouse_input_queue.Emplace(
+          time, MakeMouseInput(MouseButtonTransitionState::kNone, 0.0F,
+                               std::lround(event.motion.xrel),
+                               std::lround(event.motion.yrel)));
+      break;
+
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP: {
+      const MouseButtonTransitionState transition{
+          GetButtonTransition(event.button)};
+      if (transition != MouseButtonTransitionState::kNone) {
+        mouse_input_queue.Emplace(time,
+                                  MakeMouseInput(transition, 0.0F, 0L, 0L));
+      }
+      break;
+    }
+
+    case SDL_EVENT_MOUSE_WHEEL: {
+      // Positive is away from user as in raw input.
+      const float direction{
+          event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -1.0F : 1.0F};
+
+      if (std::abs(event.wheel.y) > 0.0F) {
+        mouse_input_queue.Emplace(
+            time, MakeMouseInput(MouseButtonTransitionState::kVerticalWheel,
+                                 event.wheel.y * direction, 0L, 0L));
+      }
+      if (std::abs(event.wheel.x) > 0.0F) {
+        mouse_input_queue.Emplace(
+            time, MakeMouseInput(MouseButtonTransitionState::kHorizontalWheel,
+                                 event.wheel.x * direction, 0L, 0L));
+      }
+      break;
+    }
+
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP: {
+      const auto keyboard_input = MakeKeyboardInput(event.key);
+      if (keyboard_input.has_value()) {
+        keyboard_input_queue.Emplace(time, *keyboard_input);
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
 /**
  * @brief Run app message loop.
+ * @param world_simulation World simulation.
+ * @param mouse_input_queue Mouse input queue world simulation reads.
+ * @param keyboard_input_queue Keyboard input queue world simulation reads.
  * @return App exit code.
  */
-[[nodiscard]] int DispatchMessages() noexcept {
+[[nodiscard]] int DispatchMessages(
+    wb::kernel::WorldSimulation& world_simulation,
+    wb::kernel::input::InputQueue<wb::hal::hid::MouseInput>& mouse_input_queue,
+    wb::kernel::input::InputQueue<wb::hal::hid::KeyboardInput>&
+        keyboard_input_queue) noexcept {
   SDL_Event event;
   bool is_done{false};
+  auto loop_iteration_start_time = wb::base::HighResolutionClock::now();
 
   while (!is_done) {
+    // Step is not running, so queues can be fed.
     while (::SDL_PollEvent(&event) == 1) {
       switch (event.type) {
         case SDL_EVENT_QUIT:
@@ -46,10 +289,18 @@ namespace {
           break;
 
         default:
+          FeedInput(event, mouse_input_queue, keyboard_input_queue);
           continue;
       }
     }
 
+    const auto now_time = wb::base::HighResolutionClock::now();
+    const auto delta_time = now_time - loop_iteration_start_time;
+
+    loop_iteration_start_time = now_time;
+
+    world_simulation.Step(delta_time);
+
     // TODO(dimhotepus): Do smth when no events.
     using namespace std::chrono_literals;
     std::this_thread::sleep_for(5ms);
@@ -180,7 +431,17 @@ extern "C" [[nodiscard]] WB_WHITEBOX_KERNEL_API int KernelMain(
     // cursor.
     wait_cursor_while_app_starts.reset();
 
-    return DispatchMessages();
+    using namespace wb::hal::hid;
+
+    // Message loop feeds SDL input into queues.
+    input::InputQueue<MouseInput> mouse_input_queue;
+    input::InputQueue<KeyboardInput> keyboard_input_queue;
+
+    WorldSimulation world_simulation{mouse_input_queue, keyboard_input_queue,
+                                     command_line_flags.frame_pipeline_depth};
+
+    return DispatchMessages(world_simulation, mouse_input_queue,
+                            keyboard_input_queue);
   }
 
   const auto error = window_result.error();
@@ -6,28 +6,372 @@
 
 #include "kernel/main_simulate_step.h"
 
+#include <algorithm>
+#include <chrono>
+#include <numbers>
+
+#include "base/deps/g3log/g3log.h"
+#include "base/deps/marl/scheduler.h"
+#include "base/deps/marl/waitgroup.h"
+#include "base/intl/lookup_with_fallback.h"
+#include "base/memory/frame_arena.h"
+#include "base/memory/heap_stats.h"
+#include "base/memory/low_memory.h"
+#include "base/task_lanes.h"
+
+namespace {
+
+/**
+ * @brief Resources accessed by simulation step jobs.
+ */
+enum class StepResource : wb::kernel::jobs::JobResource {
+  kMouseInput,
+  kKeyboardInput,
+  kCommands,
+  kWorld,
+  kFrameState
+};
+
+/**
+ * @brief Makes job resources.
+ * @param resources Step resources.
+ * @return Job resources.
+ */
+template <typename... Resources>
+[[nodiscard]] constexpr auto MakeResources(Resources... resources) noexcept {
+  return std::array<wb::kernel::jobs::JobResource, sizeof...(Resources)>{
+      wb::base::underlying_cast(resources)...};
+}
+
+/**
+ * @brief Entity position.
+ */
+struct Position {
+  float x, y;
+};
+
+/**
+ * @brief Entity velocity, units per second.
+ */
+struct Velocity {
+  float dx, dy;
+};
+
+/**
+ * @brief Entity look orientation, radians.
+ */
+struct Orientation {
+  float yaw, pitch;
+};
+
+/**
+ * @brief Player speed, units per second.
+ */
+constexpr float kPlayerSpeed{4.0F};
+
+/**
+ * @brief Player look radians per mouse count.
+ */
+constexpr float kLookSensitivity{0.0025F};
+
+/**
+ * @brief Move keys.
+ */
+enum class MoveKey : std::uint8_t {
+  kForward = 1U << 0U,
+  kBackward = 1U << 1U,
+  kLeft = 1U << 2U,
+  kRight = 1U << 3U
+};
+
+/**
+ * @brief Gets move key by keyboard make code.  WASD and arrows.
+ * @param make_code Make code.
+ * @return Move key mask or 0 if not move key.
+ */
+[[nodiscard]] constexpr std::uint8_t GetMoveKey(
+    unsigned short make_code) noexcept {
+  using wb::base::underlying_cast;
+
+  switch (make_code) {
+    case 0x11U:  // W
+    case 0x48U:  // Up
+      return underlying_cast(MoveKey::kForward);
+    case 0x1FU:  // S
+    case 0x50U:  // Down
+      return underlying_cast(MoveKey::kBackward);
+    case 0x1EU:  // A
+    case 0x4BU:  // Left
+      return underlying_cast(MoveKey::kLeft);
+    case 0x20U:  // D
+    case 0x4DU:  // Right
+      return underlying_cast(MoveKey::kRight);
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Gets move axis from held move keys.
+ * @param held_move_keys Held move keys mask.
+ * @param positive Positive direction key.
+ * @param negative Negative direction key.
+ * @return Move axis, [-1, 1].
+ */
+[[nodiscard]] constexpr float GetMoveAxis(std::uint8_t held_move_keys,
+                                          MoveKey positive,
+                                          MoveKey negative) noexcept {
+  using wb::base::underlying_cast;
+
+  return ((held_move_keys & underlying_cast(positive)) != 0 ? 1.0F : 0.0F) -
+         ((held_move_keys & underlying_cast(negative)) != 0 ? 1.0F : 0.0F);
+}
+
+/**
+ * @brief Step time after which critical path is logged.
+ */
+constexpr std::chrono::milliseconds kSlowStepTime{50};
+
+/**
+ * @brief Logs critical path of slow step.
+ * @param graph_name Job graph name.
+ * @param trace Job graph trace.
+ */
+void LogCriticalPath(std::string_view graph_name,
+                     const wb::kernel::jobs::JobGraphTrace& trace) noexcept {
+  using namespace std::chrono;
+
+  G3LOG(WARNING) << "World simulation step " << graph_name << " took "
+                 << duration_cast<microseconds>(trace.total_time).count()
+                 << "us, critical path:";
+
+  for (const auto& job : trace.critical_path) {
+    G3LOG(WARNING) << "  " << job.name << ": waited "
+                   << duration_cast<microseconds>(job.wait_time).count()
+                   << "us, ran "
+                   << duration_cast<microseconds>(job.run_time).count()
+                   << "us.";
+  }
+}
+
+}  // namespace
+
 namespace wb::kernel {
 
-void SimulateWorldStep(
-    base::HighResolutionClockDuration time_delta,
+WorldSimulation::WorldSimulation(
     input::InputQueue<hal::hid::MouseInput>& mouse_input_queue,
-    input::InputQueue<hal::hid::KeyboardInput>& keyboard_input_queue) noexcept {
-  (void)time_delta;
+    input::InputQueue<hal::hid::KeyboardInput>& keyboard_input_queue,
+    std::uint8_t pipeline_depth) noexcept
+    : mouse_input_queue_{mouse_input_queue},
+      keyboard_input_queue_{keyboard_input_queue},
+      mouse_inputs_{},
+      keyboard_inputs_{},
+      commands_{},
+      world_{},
+      player_{world_.CreateEntity(Position{0.0F, 0.0F},
+                                  Velocity{0.0F, 0.0F},
+                                  Orientation{0.0F, 0.0F})},
+      simulate_graph_{},
+      output_graph_{},
+      frame_states_{},
+      time_delta_{},
+      steps_count_{0},
+      write_index_{0},
+      output_index_{0},
+      pipeline_depth_{std::clamp(pipeline_depth, kMinPipelineDepth,
+                                 kMaxPipelineDepth)},
+      held_move_keys_{0},
+      pad_{} {
+  G3DCHECK(pipeline_depth == pipeline_depth_)
+      << "Frame pipeline depth " << static_cast<unsigned>(pipeline_depth)
+      << " is out of range.";
+  G3CHECK(player_.IsValid()) << "Unable to create player, out of world memory.";
+
+  using R = StepResource;
 
   // Get input from HID, network, AI.
+  simulate_graph_.AddJob("Gather mouse input", {},
+                         MakeResources(R::kMouseInput), [this]() noexcept {
+                           mouse_inputs_.clear();
+
+                           auto input = mouse_input_queue_.Pop();
+                           while (input.has_value()) {
+                             mouse_inputs_.emplace_back(*input);
+                             input = mouse_input_queue_.Pop();
+                           }
+                         });
+  simulate_graph_.AddJob("Gather keyboard input", {},
+                         MakeResources(R::kKeyboardInput), [this]() noexcept {
+                           keyboard_inputs_.clear();
+
+                           auto input = keyboard_input_queue_.Pop();
+                           while (input.has_value()) {
+                             keyboard_inputs_.emplace_back(*input);
+                             input = keyboard_input_queue_.Pop();
+                           }
+                         });
+
   // Convert input to world / physics commands.
+  simulate_graph_.AddJob(
+      "Convert input to commands",
+      MakeResources(R::kMouseInput, R::kKeyboardInput),
+      MakeResources(R::kCommands), [this]() noexcept {
+        using namespace wb::hal::hid;
+
+        for (const auto& input : keyboard_inputs_) {
+          const std::uint8_t key{GetMoveKey(input.data.make_code)};
+          if ((input.data.key_flags & KeyboardKeyFlags::kDown) ==
+              KeyboardKeyFlags::kDown) {
+            held_move_keys_ |= key;
+          } else {
+            held_move_keys_ &= static_cast<std::uint8_t>(~key);
+          }
+        }
+
+        commands_.move_x =
+            GetMoveAxis(held_move_keys_, MoveKey::kRight, MoveKey::kLeft);
+        commands_.move_y =
+            GetMoveAxis(held_move_keys_, MoveKey::kForward, MoveKey::kBackward);
+
+        commands_.look_yaw = 0.0F;
+        commands_.look_pitch = 0.0F;
+        for (const auto& input : mouse_inputs_) {
+          if ((input.data.mouse_state & MouseStateFlags::kMoveRelative) ==
+              MouseStateFlags::kMoveRelative) {
+            commands_.look_yaw += static_cast<float>(input.data.last_x);
+            commands_.look_pitch += static_cast<float>(input.data.last_y);
+          }
+        }
+      });
+
   // Apply commands to physics world (simulate).
+  simulate_graph_.AddJob(
+      "Simulate world", MakeResources(R::kCommands), MakeResources(R::kWorld),
+      [this]() noexcept {
+        using namespace wb::kernel::world;
+
+        // Player control system.
+        Velocity* velocity{world_.GetComponent<Velocity>(player_)};
+        velocity->dx = commands_.move_x * kPlayerSpeed;
+        velocity->dy = commands_.move_y * kPlayerSpeed;
+
+        Orientation* orientation{world_.GetComponent<Orientation>(player_)};
+        orientation->yaw += commands_.look_yaw * kLookSensitivity;
+        orientation->pitch =
+            std::clamp(orientation->pitch +
+                           commands_.look_pitch * kLookSensitivity,
+                       -std::numbers::pi_v<float> / 2.0F,
+                       std::numbers::pi_v<float> / 2.0F);
+
+        // Movement system.
+        const float time_delta{
+            std::chrono::duration<float>(time_delta_).count()};
+        world_.ParallelForEachChunk<Position, Velocity>(
+            [time_delta](const ChunkView<Position, Velocity>& chunk) noexcept {
+              const auto positions = chunk.Get<Position>();
+              const auto velocities = chunk.Get<Velocity>();
+
+              for (std::size_t i{0}; i < chunk.GetSize(); ++i) {
+                positions[i].x += velocities[i].dx * time_delta;
+                positions[i].y += velocities[i].dy * time_delta;
+              }
+            },
+            // Inside step, so chunks list lives in frame memory.
+            base::memory::GetThreadFrameMemoryResource());
+      });
+
+  // Snapshot what outputs need, so they don't touch world.
+  simulate_graph_.AddJob(
+      "Write frame state", MakeResources(R::kWorld),
+      MakeResources(R::kFrameState), [this]() noexcept {
+        const FrameState& previous{frame_states_[write_index_ ^ 1U]};
+        FrameState& frame{frame_states_[write_index_]};
+
+        frame.step_index = steps_count_;
+        frame.time_delta = time_delta_;
+        frame.simulated_time = previous.simulated_time + time_delta_;
+        frame.entities_count = world_.GetEntitiesCount();
+
+        const auto* position = world_.GetComponent<Position>(player_);
+        frame.player_x = position->x;
+        frame.player_y = position->y;
+      });
+
+  simulate_graph_.Build();
+
   // Render simulation results (audio, video, force feedback, network, etc.)
-  
-  // TODO(dimhotepus): Main loop content here.  For now just drain queues.
-  auto mouse_input = mouse_input_queue.Pop();
-  while (mouse_input.has_value()) {
-    mouse_input = mouse_input_queue.Pop();
+  // Outputs only read frame state, so run in parallel.  Kernel has no
+  // renderer, mixer or network yet, so jobs only mark where they run.
+  for (const char* output : {"Render video", "Render audio", "Send network"}) {
+    output_graph_.AddJob(output, MakeResources(R::kFrameState), {},
+                         [this]() noexcept {
+                           const FrameState& frame{
+                               frame_states_[output_index_]};
+                           G3DCHECK(frame.step_index + 1 >= steps_count_);
+                         });
   }
 
-  auto keyboard_input = keyboard_input_queue.Pop();
-  while (keyboard_input.has_value()) {
-    keyboard_input = keyboard_input_queue.Pop();
+  output_graph_.Build();
+}
+
+WorldSimulation::~WorldSimulation() noexcept {
+  const auto stats = base::memory::GetThreadFrameArenasStats();
+
+  G3LOG(INFO) << "World simulation frame arenas high-water mark "
+              << stats.high_water_mark << " of " << stats.capacity
+              << " bytes, " << stats.overflow_count << " overflows ("
+              << stats.overflow_bytes << " bytes).";
+}
+
+void WorldSimulation::Step(
+    base::HighResolutionClockDuration time_delta) noexcept {
+  time_delta_ = time_delta;
+
+  // No jobs run between steps, so release frame memory of step before
+  // previous one.  Previous step memory stays valid for pipelined outputs.
+  base::memory::BeginFrameOnThreadFrameArenas();
+  // Out of memory spike may be over, so be ready for the next one.
+  base::memory::RestoreEmergencyMemoryReserve();
+  // Leaks and fragmentation show up hours into session, so watch heap.
+  base::memory::SampleHeapStatsIfDue();
+  // Retired catalogs live one more full frame, so strings of previous frame
+  // stay valid while catalogs are swapped.
+  base::intl::HotReloadCatalogsIfDue();
+
+  const auto start_time = base::HighResolutionClock::now();
+
+  if (pipeline_depth_ == 1 || !::marl::Scheduler::get()) {
+    simulate_graph_.Execute();
+
+    output_index_ = write_index_;
+    output_graph_.Execute();
+  } else {
+    // Output previous frame while simulating this one.  First step has
+    // nothing to output yet.
+    const bool has_output{steps_count_ > 0};
+    ::marl::WaitGroup output_done{has_output ? 1U : 0U};
+
+    if (has_output) {
+      output_index_ = write_index_ ^ 1U;
+
+      base::ScheduleTask(base::TaskPriority::kFrameCritical,
+                         [this, output_done]() noexcept {
+                           output_graph_.Execute();
+                           output_done.done();
+                         });
+    }
+
+    simulate_graph_.Execute();
+    output_done.wait();
+  }
+
+  write_index_ ^= 1U;
+  ++steps_count_;
+
+  if (base::HighResolutionClock::now() - start_time >= kSlowStepTime)
+      [[unlikely]] {
+    LogCriticalPath("simulate", simulate_graph_.GetTrace());
+    LogCriticalPath("output", output_graph_.GetTrace());
   }
 }
 
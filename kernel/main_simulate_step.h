@@ -7,25 +7,191 @@
 #ifndef WB_KERNEL_MAIN_SIMULATE_STEP_H_
 #define WB_KERNEL_MAIN_SIMULATE_STEP_H_
 
+#include <array>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
+#include "base/high_resolution_clock.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
 #include "hal/drivers/hid/keyboard_input.h"
 #include "hal/drivers/hid/mouse_input.h"
+#include "kernel/input/input_event.h"
 #include "kernel/input/input_queue.h"
+#include "kernel/jobs/job_graph.h"
+#include "kernel/world/world.h"
 
 namespace wb::kernel {
 
 /**
- * @brief Run step world simulation.
- * @param time_delta How much time elapsed since last run?
- * @param mouse_input_queue Mouse input queue.
- * @param keyboard_input_queue Keyboard input queue.
+ * @brief Snapshot of simulated frame consumed by outputs.  Outputs never touch
+ * the world, so next frame can be simulated while they run.
  */
-void SimulateWorldStep(
-    base::HighResolutionClockDuration time_delta,
-    input::InputQueue<hal::hid::MouseInput>& mouse_input_queue,
-    input::InputQueue<hal::hid::KeyboardInput>&
-        keyboard_input_queue) noexcept;
+struct FrameState {
+  /**
+   * @brief Simulation step index.
+   */
+  std::uint64_t step_index;
+  /**
+   * @brief Time elapsed since previous step.
+   */
+  base::HighResolutionClockDuration time_delta;
+  /**
+   * @brief Total simulated time.
+   */
+  base::HighResolutionClockDuration simulated_time;
+  /**
+   * @brief Alive entities count.
+   */
+  std::size_t entities_count;
+  /**
+   * @brief Player position along x axis.
+   */
+  float player_x;
+  /**
+   * @brief Player position along y axis.
+   */
+  float player_y;
+};
+
+/**
+ * @brief World commands converted from step input.
+ */
+struct WorldCommands {
+  /**
+   * @brief Player move direction along x axis, [-1, 1].
+   */
+  float move_x;
+  /**
+   * @brief Player move direction along y axis, [-1, 1].
+   */
+  float move_y;
+  /**
+   * @brief Player look yaw change in mouse counts.
+   */
+  float look_yaw;
+  /**
+   * @brief Player look pitch change in mouse counts.
+   */
+  float look_pitch;
+};
+
+/**
+ * @brief World simulation.  Step phases (gather input, convert input to
+ * commands, simulate, output) are jobs of frame job graphs built once, so
+ * independent jobs of a step run in parallel on marl workers.
+ *
+ * Simulation writes frame state into one buffer while outputs read the
+ * previous one.  With pipeline depth 2 output of frame N runs concurrently
+ * with simulation of frame N+1, so step takes max(simulate, output) instead
+ * of simulate + output at the cost of one frame output latency.
+ *
+ * Jobs can allocate step scratch from base::memory thread frame arenas.  They
+ * are reset on step start, so memory stays valid for outputs of next step.
+ */
+class WorldSimulation {
+ public:
+  /**
+   * @brief Min frame pipeline depth.
+   */
+  static constexpr std::uint8_t kMinPipelineDepth{1};
+  /**
+   * @brief Max frame pipeline depth.
+   */
+  static constexpr std::uint8_t kMaxPipelineDepth{2};
+
+  /**
+   * @brief Creates world simulation and builds its job graphs.
+   * @param mouse_input_queue Mouse input queue.
+   * @param keyboard_input_queue Keyboard input queue.
+   * @param pipeline_depth Frame pipeline depth, [kMinPipelineDepth,
+   * kMaxPipelineDepth].
+   */
+  WorldSimulation(
+      input::InputQueue<hal::hid::MouseInput> &mouse_input_queue,
+      input::InputQueue<hal::hid::KeyboardInput> &keyboard_input_queue,
+      std::uint8_t pipeline_depth) noexcept;
+  ~WorldSimulation() noexcept;
+
+  WB_NO_COPY_MOVE_CTOR_AND_ASSIGNMENT(WorldSimulation);
+
+  /**
+   * @brief Run step world simulation.  Blocks till step is done.  Input
+   * queues should not be touched by others during step.
+   * @param time_delta How much time elapsed since last run?
+   */
+  void Step(base::HighResolutionClockDuration time_delta) noexcept;
+
+ private:
+  /**
+   * @brief Mouse input queue.
+   */
+  input::InputQueue<hal::hid::MouseInput> &mouse_input_queue_;
+  /**
+   * @brief Keyboard input queue.
+   */
+  input::InputQueue<hal::hid::KeyboardInput> &keyboard_input_queue_;
+  /**
+   * @brief Mouse input of current step.
+   */
+  std::vector<input::InputEvent<hal::hid::MouseInput>> mouse_inputs_;
+  /**
+   * @brief Keyboard input of current step.
+   */
+  std::vector<input::InputEvent<hal::hid::KeyboardInput>> keyboard_inputs_;
+  /**
+   * @brief Commands of current step.
+   */
+  WorldCommands commands_;
+  /**
+   * @brief Simulated world.
+   */
+  world::World world_;
+  /**
+   * @brief Entity controlled by input.
+   */
+  world::EntityHandle player_;
+  /**
+   * @brief Simulate job graph: input, commands, world.  Writes frame state.
+   */
+  jobs::JobGraph simulate_graph_;
+  /**
+   * @brief Output job graph: video, audio, network.  Reads frame state.
+   */
+  jobs::JobGraph output_graph_;
+  /**
+   * @brief Double buffered frame states.
+   */
+  std::array<FrameState, 2> frame_states_;
+  /**
+   * @brief Time elapsed since last step.
+   */
+  base::HighResolutionClockDuration time_delta_;
+  /**
+   * @brief Steps count.
+   */
+  std::uint64_t steps_count_;
+  /**
+   * @brief Frame state simulation writes.
+   */
+  std::size_t write_index_;
+  /**
+   * @brief Frame state outputs read.
+   */
+  std::size_t output_index_;
+  /**
+   * @brief Frame pipeline depth.
+   */
+  std::uint8_t pipeline_depth_;
+  /**
+   * @brief Held move keys mask, kept between steps.
+   */
+  std::uint8_t held_move_keys_;
+
+  WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 6> pad_;
+};
 
 }  // namespace wb::kernel
 
@@ -51,15 +51,12 @@ namespace {
 /**
  * @brief Run app message loop.
  * @param main_window_name Main window name.
- * @param mouse_input_queue Mouse input queue.
- * @param keyboard_input_queue Keyboard input queue.
+ * @param world_simulation World simulation.
  * @return App exit code.
  */
 [[nodiscard]] int DispatchMessages(
     _In_ std::string_view main_window_name,
-    wb::kernel::input::InputQueue<wb::hal::hid::MouseInput>& mouse_input_queue,
-    wb::kernel::input::InputQueue<wb::hal::hid::KeyboardInput>&
-        keyboard_input_queue) noexcept {
+    wb::kernel::WorldSimulation& world_simulation) noexcept {
   int exit_code{0};
   bool is_done{false};
   const auto handle_quit_message = [&](const MSG& msg) noexcept {
@@ -95,8 +92,7 @@ namespace {
 
     loop_iteration_start_time = now_time;
 
-    wb::kernel::SimulateWorldStep(delta_time, mouse_input_queue,
-                                  keyboard_input_queue);
+    world_simulation.Step(delta_time);
   }
 
   G3LOG_IF(WARNING, exit_code != 0)
@@ -154,8 +150,10 @@ extern "C" [[nodiscard]] WB_WHITEBOX_KERNEL_API int KernelMain(
     // Send WM_PAINT directly to draw first time.
     window->Update();
 
-    return DispatchMessages(window_definition.name, mouse_input_queue,
-                            keyboard_input_queue);
+    WorldSimulation world_simulation{mouse_input_queue, keyboard_input_queue,
+                                     command_line_flags.frame_pipeline_depth};
+
+    return DispatchMessages(window_definition.name, world_simulation);
   }
 
   return wb::ui::FatalDialog(
@@ -0,0 +1,203 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox archetype: entities with the same set of components, stored as
+// structure of arrays in fixed size chunks.
+
+#include "kernel/world/archetype.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+
+#include "base/deps/g3log/g3log.h"
+
+namespace {
+
+/**
+ * @brief Aligns |offset| up to |alignment|.
+ * @param offset Offset.
+ * @param alignment Power of two alignment.
+ * @return Aligned offset.
+ */
+[[nodiscard]] constexpr std::size_t AlignUp(std::size_t offset,
+                                            std::size_t alignment) noexcept {
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Calls |fn| for each component id in |mask|, in id order.
+ * @param mask Components mask.
+ * @param fn Function.
+ */
+template <typename Fn>
+void ForEachComponent(wb::kernel::world::ComponentMask mask, Fn &&fn) noexcept {
+  for (; mask != 0; mask &= mask - 1) {
+    fn(static_cast<wb::kernel::world::ComponentId>(std::countr_zero(mask)));
+  }
+}
+
+/**
+ * @brief Computes chunk layout for |capacity| rows.
+ * @param mask Components mask.
+ * @param capacity Rows per chunk.
+ * @param column_offsets Column offsets, filled for components in |mask|.
+ * @return Bytes used by chunk.
+ */
+[[nodiscard]] std::size_t LayoutChunk(
+    wb::kernel::world::ComponentMask mask, std::size_t capacity,
+    std::array<std::uint16_t, wb::kernel::world::kMaxComponents>
+        &column_offsets) noexcept {
+  using namespace wb::kernel::world;
+
+  std::size_t offset{sizeof(EntityHandle) * capacity};
+
+  ForEachComponent(mask, [&](ComponentId id) {
+    const ComponentInfo info{GetComponentInfo(id)};
+
+    offset = AlignUp(offset, info.alignment);
+    column_offsets[id] =
+        static_cast<std::uint16_t>(std::min(offset, kChunkBytes));
+    offset += std::size_t{info.size} * capacity;
+  });
+
+  return offset;
+}
+
+}  // namespace
+
+namespace wb::kernel::world {
+
+Archetype::Archetype(ComponentMask mask) noexcept
+    : mask_{mask}, chunk_capacity_{0}, size_{0}, chunks_{} {
+  column_offsets_.fill(kNoColumn);
+  component_sizes_.fill(0);
+
+  std::size_t row_bytes{sizeof(EntityHandle)};
+  ForEachComponent(mask_, [&](ComponentId id) {
+    const ComponentInfo info{GetComponentInfo(id)};
+
+    component_sizes_[id] = static_cast<std::uint16_t>(info.size);
+    row_bytes += info.size;
+  });
+
+  // Start from estimate without alignment gaps, then shrink till fits.
+  std::size_t capacity{kChunkBytes / row_bytes};
+  while (capacity > 0 &&
+         LayoutChunk(mask_, capacity, column_offsets_) > kChunkBytes) {
+    --capacity;
+  }
+
+  G3CHECK(capacity > 0) << "Archetype 0x" << std::hex << mask_
+                        << " row does not fit into " << std::dec
+                        << kChunkBytes << " bytes chunk.";
+
+  chunk_capacity_ = static_cast<std::uint32_t>(capacity);
+}
+
+Archetype::Archetype(Archetype &&) noexcept = default;
+Archetype &Archetype::operator=(Archetype &&) noexcept = default;
+
+Archetype::~Archetype() noexcept = default;
+
+[[nodiscard]] std::uint32_t Archetype::GetChunkSize(
+    std::size_t chunk) const noexcept {
+  G3DCHECK(chunk < GetChunksCount());
+
+  const std::size_t first_row{chunk * chunk_capacity_};
+  return static_cast<std::uint32_t>(
+      std::min(std::size_t{chunk_capacity_}, size_ - first_row));
+}
+
+[[nodiscard]] EntityHandle *Archetype::GetEntities(std::size_t chunk) noexcept {
+  G3DCHECK(chunk < chunks_.size());
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<EntityHandle *>(chunks_[chunk]->bytes.data());
+}
+
+[[nodiscard]] std::byte *Archetype::GetColumn(std::size_t chunk,
+                                              ComponentId id) noexcept {
+  G3DCHECK(chunk < chunks_.size());
+  G3DCHECK(id < kMaxComponents);
+
+  const std::uint16_t offset{column_offsets_[id]};
+  return offset != kNoColumn ? chunks_[chunk]->bytes.data() + offset
+                             : nullptr;
+}
+
+[[nodiscard]] std::byte *Archetype::GetComponent(std::uint32_t row,
+                                                 ComponentId id) noexcept {
+  G3DCHECK(row < size_);
+
+  std::byte *column{GetColumn(row / chunk_capacity_, id)};
+  return column ? column + std::size_t{component_sizes_[id]} *
+                               (row % chunk_capacity_)
+                : nullptr;
+}
+
+[[nodiscard]] std::optional<std::uint32_t> Archetype::PushRow(
+    EntityHandle entity) noexcept {
+  const std::uint32_t row{size_};
+  const std::size_t chunk{row / chunk_capacity_};
+  const std::uint32_t index{row % chunk_capacity_};
+
+  if (chunk == chunks_.size()) {
+    // World heap throws when world memory budget is exhausted.
+    base::un<ChunkStorage> storage{new (std::nothrow) ChunkStorage};
+    if (!storage) [[unlikely]] {
+      return std::nullopt;
+    }
+
+    chunks_.emplace_back(std::move(storage));
+  }
+
+  ++size_;
+
+  GetEntities(chunk)[index] = entity;
+
+  ForEachComponent(mask_, [&](ComponentId id) {
+    std::memset(GetComponent(row, id), 0, component_sizes_[id]);
+  });
+
+  return row;
+}
+
+[[nodiscard]] EntityHandle Archetype::RemoveRow(std::uint32_t row) noexcept {
+  G3DCHECK(row < size_);
+
+  const std::uint32_t last_row{size_ - 1};
+  EntityHandle moved;
+
+  if (row != last_row) {
+    ForEachComponent(mask_, [&](ComponentId id) {
+      std::memcpy(GetComponent(row, id), GetComponent(last_row, id),
+                  component_sizes_[id]);
+    });
+
+    moved = GetEntities(last_row / chunk_capacity_)[last_row %
+                                                     chunk_capacity_];
+    GetEntities(row / chunk_capacity_)[row % chunk_capacity_] = moved;
+  }
+
+  --size_;
+
+  // Keep one spare chunk.
+  if (chunks_.size() > GetChunksCount() + 1) {
+    chunks_.pop_back();
+  }
+
+  return moved;
+}
+
+void Archetype::CopyRow(std::uint32_t row, Archetype &to,
+                        std::uint32_t to_row) noexcept {
+  ForEachComponent(mask_ & to.mask_, [&](ComponentId id) {
+    std::memcpy(to.GetComponent(to_row, id), GetComponent(row, id),
+                component_sizes_[id]);
+  });
+}
+
+}  // namespace wb::kernel::world
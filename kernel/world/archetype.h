@@ -0,0 +1,228 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox archetype: entities with the same set of components, stored as
+// structure of arrays in fixed size chunks.
+
+#ifndef WB_KERNEL_WORLD_ARCHETYPE_H_
+#define WB_KERNEL_WORLD_ARCHETYPE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <vector>
+
+#include "base/macroses.h"
+#include "base/memory/subsystem_heap.h"
+#include "build/compiler_config.h"
+#include "kernel/config.h"
+#include "kernel/world/component.h"
+#include "kernel/world/entity_handle.h"
+
+namespace wb::kernel::world {
+
+/**
+ * @brief Chunk size in bytes.  Small enough to stay in L1 / L2 while job
+ * processes it, large enough to amortize per chunk overhead.
+ */
+inline constexpr std::size_t kChunkBytes{16 * 1024};
+
+/**
+ * @brief Chunk storage, cache line aligned.
+ */
+struct alignas(64) ChunkStorage {
+  /**
+   * @brief Allocates chunk from world heap, so world memory is accounted and
+   * can be released at once.
+   */
+  [[nodiscard]] static void *operator new(std::size_t size,
+                                          std::align_val_t alignment) {
+    return base::memory::GetSubsystemHeap(base::memory::Subsystem::kWorld)
+        .allocate(size, base::underlying_cast(alignment));
+  }
+
+  /**
+   * @brief Allocates chunk from world heap.
+   * @return Chunk or nullptr when out of memory or world memory budget.
+   */
+  [[nodiscard]] static void *operator new(std::size_t size,
+                                          std::align_val_t alignment,
+                                          const std::nothrow_t &) noexcept {
+    try {
+      return operator new(size, alignment);
+    } catch (const std::bad_alloc &) {
+      return nullptr;
+    }
+  }
+
+  /**
+   * @brief Deallocates chunk to world heap.
+   */
+  static void operator delete(void *memory, std::size_t size,
+                              std::align_val_t alignment) noexcept {
+    base::memory::GetSubsystemHeap(base::memory::Subsystem::kWorld)
+        .deallocate(memory, size, base::underlying_cast(alignment));
+  }
+
+  /**
+   * @brief Deallocates chunk to world heap when nothrow new failed.
+   */
+  static void operator delete(void *memory, std::align_val_t alignment,
+                              const std::nothrow_t &) noexcept {
+    operator delete(memory, sizeof(ChunkStorage), alignment);
+  }
+
+  /**
+   * @brief Columns: entity handles, then each component array.
+   */
+  std::array<std::byte, kChunkBytes> bytes;
+};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Entities with the same set of components.  Each chunk stores
+   * entity handles column followed by column per component, so systems
+   * iterate components linearly.  Rows are packed: all chunks except the last
+   * are full, removal moves the last row into the hole.
+   */
+  class WB_WHITEBOX_KERNEL_API Archetype {
+   public:
+    /**
+     * @brief Creates archetype for component set.
+     * @param mask Components mask.
+     */
+    explicit Archetype(ComponentMask mask) noexcept;
+
+    Archetype(Archetype &&) noexcept;
+    Archetype &operator=(Archetype &&) noexcept;
+
+    ~Archetype() noexcept;
+
+    WB_NO_COPY_CTOR_AND_ASSIGNMENT(Archetype);
+
+    /**
+     * @brief Components mask.
+     */
+    [[nodiscard]] ComponentMask GetMask() const noexcept { return mask_; }
+
+    /**
+     * @brief Entities count.
+     */
+    [[nodiscard]] std::uint32_t GetSize() const noexcept { return size_; }
+
+    /**
+     * @brief Max entities count per chunk.
+     */
+    [[nodiscard]] std::uint32_t GetChunkCapacity() const noexcept {
+      return chunk_capacity_;
+    }
+
+    /**
+     * @brief Count of chunks with entities.
+     */
+    [[nodiscard]] std::size_t GetChunksCount() const noexcept {
+      return (std::size_t{size_} + chunk_capacity_ - 1) / chunk_capacity_;
+    }
+
+    /**
+     * @brief Entities count in chunk.
+     * @param chunk Chunk index.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE std::uint32_t GetChunkSize(
+        std::size_t chunk) const noexcept;
+
+    /**
+     * @brief Entity handles column of chunk.
+     * @param chunk Chunk index.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE EntityHandle *GetEntities(
+        std::size_t chunk) noexcept;
+
+    /**
+     * @brief Component column of chunk.
+     * @param chunk Chunk index.
+     * @param id Component id.
+     * @return Column or nullptr if archetype has no such component.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE std::byte *GetColumn(std::size_t chunk,
+                                       ComponentId id) noexcept;
+
+    /**
+     * @brief Component of entity.
+     * @param row Entity row.
+     * @param id Component id.
+     * @return Component or nullptr if archetype has no such component.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE std::byte *GetComponent(std::uint32_t row,
+                                          ComponentId id) noexcept;
+
+    /**
+     * @brief Appends entity with zeroed components.
+     * @param entity Entity.
+     * @return Entity row or std::nullopt when chunk can't be allocated, ex.
+     * world memory budget is exhausted.
+     */
+    [[nodiscard]] std::optional<std::uint32_t> PushRow(
+        EntityHandle entity) noexcept;
+
+    /**
+     * @brief Removes entity by moving the last row into its place.
+     * @param row Entity row.
+     * @return Entity moved into |row| or null handle if |row| was the last.
+     */
+    [[nodiscard]] EntityHandle RemoveRow(std::uint32_t row) noexcept;
+
+    /**
+     * @brief Copies components present in both archetypes.
+     * @param row Source row.
+     * @param to Target archetype.
+     * @param to_row Target row.
+     */
+    void CopyRow(std::uint32_t row, Archetype &to,
+                 std::uint32_t to_row) noexcept;
+
+   private:
+    /**
+     * @brief Marks absent column.
+     */
+    static constexpr std::uint16_t kNoColumn{0xFFFF};
+
+    /**
+     * @brief Components mask.
+     */
+    ComponentMask mask_;
+    /**
+     * @brief Max entities count per chunk.
+     */
+    std::uint32_t chunk_capacity_;
+    /**
+     * @brief Entities count.
+     */
+    std::uint32_t size_;
+    /**
+     * @brief Column offsets in chunk by component id.
+     */
+    std::array<std::uint16_t, kMaxComponents> column_offsets_;
+    /**
+     * @brief Component sizes by component id.
+     */
+    std::array<std::uint16_t, kMaxComponents> component_sizes_;
+    /**
+     * @brief Chunks.  Keeps at most one empty chunk to not thrash allocator
+     * when entities are added / removed at chunk boundary.
+     */
+    std::vector<base::un<ChunkStorage>> chunks_;
+  };
+
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+}  // namespace wb::kernel::world
+
+#endif  // !WB_KERNEL_WORLD_ARCHETYPE_H_
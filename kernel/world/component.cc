@@ -0,0 +1,84 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox entity component type registry.
+
+#include "kernel/world/component.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include "base/deps/abseil/base/thread_annotations.h"
+#include "base/deps/abseil/synchronization/mutex.h"
+#include "base/deps/g3log/g3log.h"
+
+namespace {
+
+/**
+ * @brief Serializes component registration.
+ */
+ABSL_CONST_INIT absl::Mutex components_mutex{absl::kConstInit};
+
+/**
+ * @brief Next free component id.
+ */
+std::atomic<wb::kernel::world::ComponentId> next_component_id{0};
+
+/**
+ * @brief Component type hashes by id.
+ */
+std::array<std::uint64_t, wb::kernel::world::kMaxComponents> component_hashes
+    ABSL_GUARDED_BY(components_mutex);
+
+/**
+ * @brief Component layouts by id.  Slot is written before id is published
+ * via function local static of GetComponentId, so reads need no locks.
+ */
+std::array<wb::kernel::world::ComponentInfo,
+           wb::kernel::world::kMaxComponents>
+    component_infos;
+
+}  // namespace
+
+namespace wb::kernel::world {
+
+namespace internal {
+
+[[nodiscard]] WB_WHITEBOX_KERNEL_API ComponentId
+RegisterComponent(std::uint64_t type_hash, ComponentInfo info) noexcept {
+  absl::MutexLock lock{&components_mutex};
+
+  const ComponentId count{next_component_id.load(std::memory_order_relaxed)};
+  const auto hashes_end = component_hashes.begin() + count;
+
+  // Other module already registered it.
+  const auto it = std::find(component_hashes.begin(), hashes_end, type_hash);
+  if (it != hashes_end) {
+    const auto id = static_cast<ComponentId>(it - component_hashes.begin());
+    G3CHECK(component_infos[id].size == info.size &&
+            component_infos[id].alignment == info.alignment)
+        << "Component type hash collision, id " << id;
+    return id;
+  }
+
+  G3CHECK(count < kMaxComponents)
+      << "Too many component types, max is " << kMaxComponents;
+
+  component_hashes[count] = type_hash;
+  component_infos[count] = info;
+  next_component_id.store(count + 1, std::memory_order_relaxed);
+  return count;
+}
+
+}  // namespace internal
+
+[[nodiscard]] WB_WHITEBOX_KERNEL_API ComponentInfo
+GetComponentInfo(ComponentId id) noexcept {
+  G3DCHECK(id < next_component_id.load(std::memory_order_relaxed));
+
+  return component_infos[id];
+}
+
+}  // namespace wb::kernel::world
@@ -0,0 +1,137 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox entity component type registry.
+
+#ifndef WB_KERNEL_WORLD_COMPONENT_H_
+#define WB_KERNEL_WORLD_COMPONENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "build/build_config.h"
+#include "kernel/config.h"
+
+namespace wb::kernel::world {
+
+/**
+ * @brief Component type id, [0, kMaxComponents).
+ */
+using ComponentId = std::uint32_t;
+
+/**
+ * @brief Set of component ids, bit per id.
+ */
+using ComponentMask = std::uint64_t;
+
+/**
+ * @brief Max count of component types.
+ */
+inline constexpr std::size_t kMaxComponents{sizeof(ComponentMask) * 8};
+
+/**
+ * @brief Components are plain data, moved between chunks by memcpy.
+ */
+template <typename T>
+concept Component =
+    std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T> &&
+    std::is_default_constructible_v<T> &&
+    std::is_same_v<T, std::remove_cvref_t<T>> && alignof(T) <= 64;
+
+/**
+ * @brief Component type layout.
+ */
+struct ComponentInfo {
+  /**
+   * @brief sizeof component.
+   */
+  std::uint32_t size;
+  /**
+   * @brief alignof component.
+   */
+  std::uint32_t alignment;
+};
+
+namespace internal {
+
+/**
+ * @brief Gets signature of function instantiated for |T|, which contains |T|
+ * name.  The same in all modules built by the same compiler.
+ * @tparam T Type.
+ * @return Function signature.
+ */
+template <typename T>
+[[nodiscard]] consteval std::string_view GetTypeSignature() noexcept {
+#ifdef WB_COMPILER_MSVC
+  return __FUNCSIG__;
+#else
+  return __PRETTY_FUNCTION__;
+#endif
+}
+
+/**
+ * @brief Computes stable type hash (FNV-1a over type signature).
+ * @tparam T Type.
+ * @return Type hash.
+ */
+template <typename T>
+[[nodiscard]] consteval std::uint64_t GetTypeHash() noexcept {
+  std::uint64_t hash{0xCBF2'9CE4'8422'2325ULL};
+  for (const char ch : GetTypeSignature<T>()) {
+    hash ^= static_cast<unsigned char>(ch);
+    hash *= 0x0000'0100'0000'01B3ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Registers component type or gets id of already registered one.
+ * @param type_hash Stable component type hash.
+ * @param info Component layout.
+ * @return Component id.
+ */
+[[nodiscard]] WB_WHITEBOX_KERNEL_API ComponentId
+RegisterComponent(std::uint64_t type_hash, ComponentInfo info) noexcept;
+
+}  // namespace internal
+
+/**
+ * @brief Gets registered component layout.
+ * @param id Component id.
+ * @return Component layout.
+ */
+[[nodiscard]] WB_WHITEBOX_KERNEL_API WB_ATTRIBUTE_PURE ComponentInfo
+GetComponentInfo(ComponentId id) noexcept;
+
+/**
+ * @brief Gets component id for T, registers T on first call.  Thread-safe.
+ * Each module (shared library) may have own copy of function local static,
+ * so ids are registered by stable type hash in kernel and are the same in all
+ * modules.
+ * @tparam T Component.
+ * @return Component id.
+ */
+template <Component T>
+[[nodiscard]] ComponentId GetComponentId() noexcept {
+  static const ComponentId id{internal::RegisterComponent(
+      internal::GetTypeHash<T>(), {static_cast<std::uint32_t>(sizeof(T)),
+                                   static_cast<std::uint32_t>(alignof(T))})};
+  return id;
+}
+
+/**
+ * @brief Makes mask of components.
+ * @tparam Ts Components.
+ * @return Components mask.
+ */
+template <Component... Ts>
+[[nodiscard]] ComponentMask MakeComponentMask() noexcept {
+  return (ComponentMask{0} | ... | (ComponentMask{1} << GetComponentId<Ts>()));
+}
+
+}  // namespace wb::kernel::world
+
+#endif  // !WB_KERNEL_WORLD_COMPONENT_H_
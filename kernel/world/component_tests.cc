@@ -0,0 +1,62 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox entity component type registry.
+
+#include "component.h"
+//
+#include "base/deps/googletest/gtest/gtest.h"
+
+namespace {
+
+struct Health {
+  int value;
+};
+
+struct alignas(16) Transform {
+  float position[3];
+  float scale;
+};
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ComponentTest, GetComponentId) {
+  using namespace wb::kernel::world;
+
+  const ComponentId health_id{GetComponentId<Health>()};
+  const ComponentId transform_id{GetComponentId<Transform>()};
+
+  EXPECT_NE(health_id, transform_id);
+  EXPECT_EQ(health_id, GetComponentId<Health>());
+  EXPECT_GT(kMaxComponents, health_id);
+  EXPECT_GT(kMaxComponents, transform_id);
+
+  EXPECT_EQ(sizeof(Health), GetComponentInfo(health_id).size);
+  EXPECT_EQ(alignof(Health), GetComponentInfo(health_id).alignment);
+  EXPECT_EQ(sizeof(Transform), GetComponentInfo(transform_id).size);
+  EXPECT_EQ(16U, GetComponentInfo(transform_id).alignment);
+
+  EXPECT_EQ(
+      (ComponentMask{1} << health_id) | (ComponentMask{1} << transform_id),
+      (MakeComponentMask<Health, Transform>()));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(ComponentTest, SameIdInAllModules) {
+  using namespace wb::kernel::world;
+
+  static_assert(internal::GetTypeHash<Health>() !=
+                internal::GetTypeHash<Transform>());
+  static_assert(internal::GetTypeHash<Health>() ==
+                internal::GetTypeHash<Health>());
+
+  const ComponentId id{GetComponentId<Health>()};
+
+  // Other module has own function local static, so registers type again.
+  EXPECT_EQ(id, internal::RegisterComponent(
+                    internal::GetTypeHash<Health>(),
+                    {static_cast<std::uint32_t>(sizeof(Health)),
+                     static_cast<std::uint32_t>(alignof(Health))}));
+}
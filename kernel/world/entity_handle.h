@@ -0,0 +1,75 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox generational entity handle.
+
+#ifndef WB_KERNEL_WORLD_ENTITY_HANDLE_H_
+#define WB_KERNEL_WORLD_ENTITY_HANDLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace wb::kernel::world {
+
+/**
+ * @brief Generational handle to entity.  Index addresses slot, generation is
+ * bumped each time slot is freed, so handles to destroyed entities never
+ * resolve to entities reusing the same slot (like Source's CBaseHandle, but
+ * with full 32 bits for both parts).
+ *
+ * Zero generation is never issued, so default constructed handle is null.
+ */
+struct EntityHandle {
+  /**
+   * @brief Slot index.
+   */
+  std::uint32_t index{0};
+  /**
+   * @brief Slot generation.
+   */
+  std::uint32_t generation{0};
+
+  /**
+   * @brief Is handle not null?  Does not mean entity is alive.
+   */
+  [[nodiscard]] constexpr bool IsValid() const noexcept {
+    return generation != 0;
+  }
+
+  /**
+   * @brief Packs handle into 64 bits, ex. for serialization or hashing.
+   */
+  [[nodiscard]] constexpr std::uint64_t ToBits() const noexcept {
+    return (std::uint64_t{generation} << 32U) | index;
+  }
+
+  /**
+   * @brief Unpacks handle from 64 bits.
+   * @param bits Bits from ToBits.
+   */
+  [[nodiscard]] static constexpr EntityHandle FromBits(
+      std::uint64_t bits) noexcept {
+    return {static_cast<std::uint32_t>(bits & 0xFFFFFFFFU),
+            static_cast<std::uint32_t>(bits >> 32U)};
+  }
+
+  [[nodiscard]] friend constexpr bool operator==(EntityHandle,
+                                                 EntityHandle) noexcept =
+      default;
+};
+
+static_assert(sizeof(EntityHandle) == 8);
+
+}  // namespace wb::kernel::world
+
+template <>
+struct std::hash<wb::kernel::world::EntityHandle> {
+  [[nodiscard]] std::size_t operator()(
+      wb::kernel::world::EntityHandle handle) const noexcept {
+    return std::hash<std::uint64_t>{}(handle.ToBits());
+  }
+};
+
+#endif  // !WB_KERNEL_WORLD_ENTITY_HANDLE_H_
@@ -0,0 +1,283 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox generational slot map.
+
+#ifndef WB_KERNEL_WORLD_SLOT_MAP_H_
+#define WB_KERNEL_WORLD_SLOT_MAP_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "base/deps/g3log/g3log.h"
+#include "base/macroses.h"
+#include "build/compiler_config.h"
+#include "kernel/world/entity_handle.h"
+
+namespace wb::kernel::world {
+
+/**
+ * @brief Generational slot map.  Values are stored densely in insertion
+ * order (until erase), so iteration touches only live values in contiguous
+ * memory.  Sparse slots map handle index to dense position, so insert, erase
+ * and lookup are O(1).  Erase moves last value into erased position.
+ *
+ * Slot generation is odd while slot is alive and even while it is free, so
+ * stale or forged handles never resolve.  Slot which generation wraps is
+ * retired forever instead of being reused.
+ *
+ * Const member functions can be called concurrently, ex. from marl jobs
+ * splitting GetValues() into ranges.  Mutations require exclusive access.
+ * @tparam T Value.
+ */
+template <typename T>
+class SlotMap {
+ public:
+  /**
+   * @brief Creates empty slot map.
+   */
+  SlotMap() noexcept
+      : slots_{}, values_{}, handles_{}, free_head_{kNoSlot}, pad_{} {}
+
+  SlotMap(SlotMap &&) noexcept = default;
+  SlotMap &operator=(SlotMap &&) noexcept = default;
+
+  WB_NO_COPY_CTOR_AND_ASSIGNMENT(SlotMap);
+
+  /**
+   * @brief Reserves storage for |capacity| values.
+   * @param capacity Values capacity.
+   */
+  void Reserve(std::size_t capacity) noexcept {
+    slots_.reserve(capacity);
+    values_.reserve(capacity);
+    handles_.reserve(capacity);
+  }
+
+  /**
+   * @brief Constructs value in place.
+   * @tparam Args Value constructor arguments.
+   * @param args Value constructor arguments.
+   * @return Handle of the value.
+   */
+  template <typename... Args>
+  EntityHandle Emplace(Args &&...args) noexcept {
+    const auto dense_index = static_cast<std::uint32_t>(values_.size());
+    std::uint32_t index;
+
+    if (free_head_ != kNoSlot) {
+      index = free_head_;
+
+      Slot &slot{slots_[index]};
+      free_head_ = slot.dense_index;
+      slot.dense_index = dense_index;
+      // Even -> odd, alive again.
+      ++slot.generation;
+    } else {
+      G3CHECK(slots_.size() < kNoSlot) << "Slot map has no free slots.";
+
+      index = static_cast<std::uint32_t>(slots_.size());
+      slots_.push_back({dense_index, 1U});
+    }
+
+    values_.emplace_back(std::forward<Args>(args)...);
+
+    const EntityHandle handle{index, slots_[index].generation};
+    handles_.push_back(handle);
+    return handle;
+  }
+
+  /**
+   * @brief Erases value by handle.
+   * @param handle Handle.
+   * @return true if value was alive and erased, false otherwise.
+   */
+  bool Erase(EntityHandle handle) noexcept {
+    if (!Contains(handle)) return false;
+
+    Slot &slot{slots_[handle.index]};
+    const std::uint32_t dense_index{slot.dense_index};
+    const std::size_t last_index{values_.size() - 1};
+
+    if (dense_index != last_index) {
+      values_[dense_index] = std::move(values_.back());
+      handles_[dense_index] = handles_.back();
+      slots_[handles_[dense_index].index].dense_index = dense_index;
+    }
+
+    values_.pop_back();
+    handles_.pop_back();
+
+    // Odd -> even, free.
+    ++slot.generation;
+    FreeSlot(handle.index);
+
+    return true;
+  }
+
+  /**
+   * @brief Erases all values.  All issued handles become stale.
+   */
+  void Clear() noexcept {
+    for (const EntityHandle handle : handles_) {
+      ++slots_[handle.index].generation;
+      FreeSlot(handle.index);
+    }
+
+    values_.clear();
+    handles_.clear();
+  }
+
+  /**
+   * @brief Is value with |handle| alive?
+   * @param handle Handle.
+   * @return true if alive, false otherwise.
+   */
+  [[nodiscard]] WB_ATTRIBUTE_PURE bool Contains(
+      EntityHandle handle) const noexcept {
+    return (handle.generation & 1U) != 0 && handle.index < slots_.size() &&
+           slots_[handle.index].generation == handle.generation;
+  }
+
+  /**
+   * @brief Finds value by handle.
+   * @param handle Handle.
+   * @return Value or nullptr if handle is stale.
+   */
+  [[nodiscard]] WB_ATTRIBUTE_PURE T *Find(EntityHandle handle) noexcept {
+    return Contains(handle) ? &values_[slots_[handle.index].dense_index]
+                            : nullptr;
+  }
+
+  /**
+   * @brief Finds value by handle.
+   * @param handle Handle.
+   * @return Value or nullptr if handle is stale.
+   */
+  [[nodiscard]] WB_ATTRIBUTE_PURE const T *Find(
+      EntityHandle handle) const noexcept {
+    return Contains(handle) ? &values_[slots_[handle.index].dense_index]
+                            : nullptr;
+  }
+
+  /**
+   * @brief Gets alive value by handle.
+   * @param handle Handle of alive value.
+   * @return Value.
+   */
+  [[nodiscard]] T &Get(EntityHandle handle) noexcept {
+    G3DCHECK(Contains(handle)) << "Handle is stale.";
+    return values_[slots_[handle.index].dense_index];
+  }
+
+  /**
+   * @brief Alive values count.
+   */
+  [[nodiscard]] std::size_t GetSize() const noexcept { return values_.size(); }
+
+  /**
+   * @brief Has no alive values?
+   */
+  [[nodiscard]] bool IsEmpty() const noexcept { return values_.empty(); }
+
+  /**
+   * @brief Alive values, dense.  Order changes on erase.
+   */
+  [[nodiscard]] std::span<T> GetValues() noexcept { return values_; }
+
+  /**
+   * @brief Alive values, dense.  Order changes on erase.
+   */
+  [[nodiscard]] std::span<const T> GetValues() const noexcept {
+    return values_;
+  }
+
+  /**
+   * @brief Handles of alive values, parallel to GetValues().
+   */
+  [[nodiscard]] std::span<const EntityHandle> GetHandles() const noexcept {
+    return handles_;
+  }
+
+  /**
+   * @brief Sets generation of free slot, so generation wraparound can be
+   * tested without 2^31 slot reuses.  Tests only.
+   * @param index Free slot index.
+   * @param generation Even generation.
+   */
+  void SetFreeSlotGenerationForTesting(std::uint32_t index,
+                                       std::uint32_t generation) noexcept {
+    G3CHECK(index < slots_.size() && (slots_[index].generation & 1U) == 0 &&
+            (generation & 1U) == 0)
+        << "Slot should be free and generation even.";
+
+    slots_[index].generation = generation;
+  }
+
+ private:
+  /**
+   * @brief Marks end of free list.
+   */
+  static constexpr std::uint32_t kNoSlot{
+      std::numeric_limits<std::uint32_t>::max()};
+
+  /**
+   * @brief Sparse slot.
+   */
+  struct Slot {
+    /**
+     * @brief Dense index when alive, next free slot index when free.
+     */
+    std::uint32_t dense_index;
+    /**
+     * @brief Odd when alive, even when free.
+     */
+    std::uint32_t generation;
+  };
+
+  /**
+   * @brief Sparse slots.
+   */
+  std::vector<Slot> slots_;
+  /**
+   * @brief Dense values.
+   */
+  std::vector<T> values_;
+  /**
+   * @brief Dense handles, parallel to values.
+   */
+  std::vector<EntityHandle> handles_;
+  /**
+   * @brief First free slot index or kNoSlot.
+   */
+  std::uint32_t free_head_;
+
+  WB_ATTRIBUTE_UNUSED_FIELD std::array<std::byte, 4> pad_;
+
+  /**
+   * @brief Pushes just freed slot to free list unless its generation wrapped.
+   * @param index Slot index.
+   */
+  void FreeSlot(std::uint32_t index) noexcept {
+    Slot &slot{slots_[index]};
+
+    // Generation wrapped, retire slot so old handles can't become valid.
+    if (slot.generation == 0) [[unlikely]] {
+      slot.dense_index = kNoSlot;
+      return;
+    }
+
+    slot.dense_index = free_head_;
+    free_head_ = index;
+  }
+};
+
+}  // namespace wb::kernel::world
+
+#endif  // !WB_KERNEL_WORLD_SLOT_MAP_H_
@@ -0,0 +1,200 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox generational slot map.
+
+#include "slot_map.h"
+//
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(EntityHandleTest, NullAndBits) {
+  using namespace wb::kernel::world;
+
+  constexpr EntityHandle kNull;
+  static_assert(!kNull.IsValid());
+
+  constexpr EntityHandle kHandle{7U, 3U};
+  static_assert(kHandle.IsValid());
+  static_assert(0x0000'0003'0000'0007ULL == kHandle.ToBits());
+  static_assert(kHandle == EntityHandle::FromBits(kHandle.ToBits()));
+
+  EXPECT_NE(std::hash<EntityHandle>{}(kHandle),
+            std::hash<EntityHandle>{}(EntityHandle{3U, 7U}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SlotMapTest, EmplaceFindErase) {
+  using namespace wb::kernel::world;
+
+  SlotMap<std::string> map;
+
+  EXPECT_TRUE(map.IsEmpty());
+  EXPECT_FALSE(map.Contains(EntityHandle{}));
+
+  const EntityHandle a{map.Emplace("a")};
+  const EntityHandle b{map.Emplace(1U, 'b')};
+
+  EXPECT_TRUE(a.IsValid());
+  EXPECT_TRUE(b.IsValid());
+  EXPECT_NE(a, b);
+  EXPECT_EQ(2U, map.GetSize());
+
+  ASSERT_NE(nullptr, map.Find(a));
+  EXPECT_EQ("a", *map.Find(a));
+  EXPECT_EQ("b", map.Get(b));
+
+  EXPECT_TRUE(map.Erase(a));
+  EXPECT_FALSE(map.Erase(a)) << "Double erase.";
+  EXPECT_FALSE(map.Contains(a));
+  EXPECT_EQ(nullptr, map.Find(a));
+  EXPECT_EQ(1U, map.GetSize());
+  EXPECT_EQ("b", map.Get(b));
+
+  // Forged handles never resolve.
+  EXPECT_FALSE(map.Contains(EntityHandle{b.index, b.generation + 2U}));
+  EXPECT_FALSE(map.Contains(EntityHandle{b.index + 100U, b.generation}));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SlotMapTest, StaleHandleAfterEraseAndReinsert) {
+  using namespace wb::kernel::world;
+
+  SlotMap<int> map;
+
+  const EntityHandle old_handle{map.Emplace(1)};
+  ASSERT_TRUE(map.Erase(old_handle));
+
+  // Slot is reused, but with new generation.
+  const EntityHandle new_handle{map.Emplace(2)};
+  EXPECT_EQ(old_handle.index, new_handle.index);
+  EXPECT_NE(old_handle.generation, new_handle.generation);
+
+  EXPECT_FALSE(map.Contains(old_handle));
+  EXPECT_EQ(nullptr, map.Find(old_handle));
+  EXPECT_FALSE(map.Erase(old_handle));
+
+  EXPECT_TRUE(map.Contains(new_handle));
+  EXPECT_EQ(2, map.Get(new_handle));
+  EXPECT_EQ(1U, map.GetSize());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SlotMapTest, EraseKeepsValuesDense) {
+  using namespace wb::kernel::world;
+
+  SlotMap<int> map;
+
+  std::vector<EntityHandle> handles;
+  for (int i{0}; i < 5; ++i) {
+    handles.push_back(map.Emplace(i));
+  }
+
+  // Last value moves into erased position.
+  ASSERT_TRUE(map.Erase(handles[1]));
+
+  EXPECT_EQ((std::vector<int>{0, 4, 2, 3}),
+            std::vector<int>(map.GetValues().begin(), map.GetValues().end()));
+  EXPECT_EQ((std::vector<EntityHandle>{handles[0], handles[4], handles[2],
+                                       handles[3]}),
+            std::vector<EntityHandle>(map.GetHandles().begin(),
+                                      map.GetHandles().end()));
+
+  // Moved value is still found by its handle.
+  EXPECT_EQ(4, map.Get(handles[4]));
+
+  // Erase last does not move anything.
+  ASSERT_TRUE(map.Erase(handles[3]));
+  EXPECT_EQ((std::vector<int>{0, 4, 2}),
+            std::vector<int>(map.GetValues().begin(), map.GetValues().end()));
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SlotMapTest, FreeListOrder) {
+  using namespace wb::kernel::world;
+
+  SlotMap<int> map;
+
+  const EntityHandle a{map.Emplace(0)};
+  const EntityHandle b{map.Emplace(1)};
+  const EntityHandle c{map.Emplace(2)};
+
+  ASSERT_TRUE(map.Erase(a));
+  ASSERT_TRUE(map.Erase(c));
+  ASSERT_TRUE(map.Erase(b));
+
+  // Last freed slot is reused first, so hot slots stay in cache.
+  EXPECT_EQ(b.index, map.Emplace(3).index);
+  EXPECT_EQ(c.index, map.Emplace(4).index);
+  EXPECT_EQ(a.index, map.Emplace(5).index);
+  // Free list is empty, so new slot.
+  EXPECT_EQ(3U, map.Emplace(6).index);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SlotMapTest, GenerationWraparoundRetiresSlot) {
+  using namespace wb::kernel::world;
+
+  SlotMap<int> map;
+
+  const EntityHandle first{map.Emplace(0)};
+  ASSERT_TRUE(map.Erase(first));
+
+  // Skip 2^31 slot reuses.
+  map.SetFreeSlotGenerationForTesting(first.index, 0xFFFF'FFFEU);
+
+  const EntityHandle last{map.Emplace(1)};
+  EXPECT_EQ(first.index, last.index);
+  EXPECT_EQ(0xFFFF'FFFFU, last.generation);
+  EXPECT_TRUE(map.Contains(last));
+
+  // Generation wraps to 0, so slot is retired instead of being freed.
+  ASSERT_TRUE(map.Erase(last));
+  EXPECT_FALSE(map.Contains(last));
+  EXPECT_FALSE(map.Contains(first));
+  EXPECT_FALSE(map.Contains(EntityHandle{first.index, 0U}));
+  EXPECT_FALSE(map.Contains(EntityHandle{first.index, 1U}));
+
+  // Retired slot is never reused.
+  const EntityHandle next{map.Emplace(2)};
+  EXPECT_NE(first.index, next.index);
+  EXPECT_EQ(1U, next.generation);
+  EXPECT_FALSE(map.Contains(first));
+
+  ASSERT_TRUE(map.Erase(next));
+  EXPECT_EQ(next.index, map.Emplace(3).index)
+      << "Retired slot should not be in free list.";
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(SlotMapTest, ClearMakesHandlesStale) {
+  using namespace wb::kernel::world;
+
+  SlotMap<int> map;
+
+  std::vector<EntityHandle> handles;
+  for (int i{0}; i < 4; ++i) {
+    handles.push_back(map.Emplace(i));
+  }
+
+  map.Clear();
+
+  EXPECT_TRUE(map.IsEmpty());
+  for (const EntityHandle handle : handles) {
+    EXPECT_FALSE(map.Contains(handle));
+  }
+
+  // All slots are reused, without new ones.
+  std::unordered_set<EntityHandle> new_handles;
+  for (int i{0}; i < 4; ++i) {
+    const EntityHandle handle{map.Emplace(i)};
+
+    EXPECT_GT(4U, handle.index);
+    EXPECT_TRUE(new_handles.insert(handle).second);
+  }
+}
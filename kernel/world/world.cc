@@ -0,0 +1,115 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox world: entities and their components grouped by archetype.
+
+#include "kernel/world/world.h"
+
+#include "base/deps/g3log/g3log.h"
+
+namespace wb::kernel::world {
+
+World::World() noexcept
+    : entities_{}, archetypes_{}, archetype_indices_{} {}
+
+World::World(World &&) noexcept = default;
+World &World::operator=(World &&) noexcept = default;
+
+World::~World() noexcept = default;
+
+bool World::DestroyEntity(EntityHandle entity) noexcept {
+  const EntityLocation *location{entities_.Find(entity)};
+  if (!location) return false;
+
+  const EntityHandle moved{
+      archetypes_[location->archetype].RemoveRow(location->row)};
+  if (moved.IsValid()) entities_.Get(moved).row = location->row;
+
+  return entities_.Erase(entity);
+}
+
+[[nodiscard]] ComponentMask World::GetComponentMask(
+    EntityHandle entity) const noexcept {
+  const EntityLocation *location{entities_.Find(entity)};
+  return location ? archetypes_[location->archetype].GetMask() : 0;
+}
+
+[[nodiscard]] EntityHandle World::CreateEntity(ComponentMask mask) noexcept {
+  const std::uint32_t archetype{GetOrCreateArchetype(mask)};
+  const EntityHandle entity{entities_.Emplace(EntityLocation{archetype, 0})};
+
+  const std::optional<std::uint32_t> row{
+      archetypes_[archetype].PushRow(entity)};
+  if (!row) [[unlikely]] {
+    G3LOG(WARNING) << "Unable to create entity, out of world memory.";
+    entities_.Erase(entity);
+    return {};
+  }
+
+  entities_.Get(entity).row = *row;
+  return entity;
+}
+
+[[nodiscard]] std::byte *World::GetComponent(EntityHandle entity,
+                                             ComponentId id) noexcept {
+  const EntityLocation *location{entities_.Find(entity)};
+  return location
+             ? archetypes_[location->archetype].GetComponent(location->row, id)
+             : nullptr;
+}
+
+[[nodiscard]] std::uint32_t World::GetOrCreateArchetype(
+    ComponentMask mask) noexcept {
+  const auto [it, is_inserted] = archetype_indices_.try_emplace(
+      mask, static_cast<std::uint32_t>(archetypes_.size()));
+  if (is_inserted) archetypes_.emplace_back(mask);
+
+  return it->second;
+}
+
+bool World::MoveEntity(EntityHandle entity, ComponentMask mask) noexcept {
+  EntityLocation &location{entities_.Get(entity)};
+
+  // May reallocate archetypes, so get them after.
+  const std::uint32_t to_index{GetOrCreateArchetype(mask)};
+  if (to_index == location.archetype) return true;
+
+  Archetype &from{archetypes_[location.archetype]};
+  Archetype &to{archetypes_[to_index]};
+
+  const std::optional<std::uint32_t> pushed_row{to.PushRow(entity)};
+  if (!pushed_row) [[unlikely]] {
+    G3LOG(WARNING) << "Unable to move entity to other archetype, out of world "
+                      "memory.";
+    return false;
+  }
+
+  const std::uint32_t to_row{*pushed_row};
+  from.CopyRow(location.row, to, to_row);
+
+  const EntityHandle moved{from.RemoveRow(location.row)};
+  if (moved.IsValid()) entities_.Get(moved).row = location.row;
+
+  location = {to_index, to_row};
+  return true;
+}
+
+[[nodiscard]] std::pmr::vector<World::ChunkRef> World::GetChunks(
+    ComponentMask mask, std::pmr::memory_resource *memory) const noexcept {
+  std::pmr::vector<ChunkRef> chunks{memory};
+
+  for (std::size_t i{0}; i < archetypes_.size(); ++i) {
+    const Archetype &archetype{archetypes_[i]};
+    if ((archetype.GetMask() & mask) != mask) continue;
+
+    for (std::size_t chunk{0}; chunk < archetype.GetChunksCount(); ++chunk) {
+      chunks.push_back({static_cast<std::uint32_t>(i),
+                        static_cast<std::uint32_t>(chunk)});
+    }
+  }
+
+  return chunks;
+}
+
+}  // namespace wb::kernel::world
@@ -0,0 +1,356 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox world: entities and their components grouped by archetype.
+
+#ifndef WB_KERNEL_WORLD_WORLD_H_
+#define WB_KERNEL_WORLD_WORLD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "base/macroses.h"
+#include "base/parallel/parallel.h"
+#include "build/compiler_config.h"
+#include "kernel/config.h"
+#include "kernel/world/archetype.h"
+#include "kernel/world/component.h"
+#include "kernel/world/entity_handle.h"
+#include "kernel/world/slot_map.h"
+
+namespace wb::kernel::world {
+
+/**
+ * @brief Where entity components live.
+ */
+struct EntityLocation {
+  /**
+   * @brief Archetype index.
+   */
+  std::uint32_t archetype;
+  /**
+   * @brief Row in archetype.
+   */
+  std::uint32_t row;
+};
+
+/**
+ * @brief View of components |Ts| in single chunk.
+ * @tparam Ts Components.
+ */
+template <Component... Ts>
+class ChunkView {
+ public:
+  /**
+   * @brief Creates chunk view.
+   * @param archetype Archetype with all |Ts|.
+   * @param chunk Chunk index.
+   */
+  ChunkView(Archetype &archetype, std::size_t chunk) noexcept
+      : entities_{archetype.GetEntities(chunk),
+                  archetype.GetChunkSize(chunk)},
+        columns_{static_cast<Ts *>(static_cast<void *>(
+            archetype.GetColumn(chunk, GetComponentId<Ts>())))...} {}
+
+  /**
+   * @brief Entities count in chunk.
+   */
+  [[nodiscard]] std::size_t GetSize() const noexcept {
+    return entities_.size();
+  }
+
+  /**
+   * @brief Entities in chunk.
+   */
+  [[nodiscard]] std::span<const EntityHandle> GetEntities() const noexcept {
+    return entities_;
+  }
+
+  /**
+   * @brief Components column.
+   * @tparam T Component.
+   */
+  template <typename T>
+    requires(std::is_same_v<T, Ts> || ...)
+  [[nodiscard]] std::span<T> Get() const noexcept {
+    return {std::get<T *>(columns_), entities_.size()};
+  }
+
+ private:
+  /**
+   * @brief Entities in chunk.
+   */
+  std::span<const EntityHandle> entities_;
+  /**
+   * @brief Component columns.
+   */
+  std::tuple<Ts *...> columns_;
+};
+
+WB_MSVC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Private member is not accessible to the DLL's client, including inline
+  // functions.
+  WB_MSVC_DISABLE_WARNING(4251)
+
+  /**
+   * @brief Entity component store.  Entities with the same component set
+   * share archetype, so queries iterate matching chunks linearly.
+   *
+   * Structural changes (create / destroy entities, add / remove components)
+   * require exclusive access.  Chunk iteration only touches component data,
+   * so ParallelForEachChunk may mutate components from many jobs at once.
+   */
+  class WB_WHITEBOX_KERNEL_API World {
+   public:
+    /**
+     * @brief Creates empty world.
+     */
+    World() noexcept;
+
+    World(World &&) noexcept;
+    World &operator=(World &&) noexcept;
+
+    ~World() noexcept;
+
+    WB_NO_COPY_CTOR_AND_ASSIGNMENT(World);
+
+    /**
+     * @brief Creates entity with components.
+     * @tparam Ts Distinct components.
+     * @param components Components.
+     * @return Entity or invalid handle when out of world memory.
+     */
+    template <Component... Ts>
+    EntityHandle CreateEntity(const Ts &...components) noexcept {
+      const EntityHandle entity{CreateEntity(MakeComponentMask<Ts...>())};
+      if (!entity.IsValid()) [[unlikely]] {
+        return entity;
+      }
+
+      ((*GetComponent<Ts>(entity) = components), ...);
+      return entity;
+    }
+
+    /**
+     * @brief Destroys entity.
+     * @param entity Entity.
+     * @return true if entity was alive, false otherwise.
+     */
+    bool DestroyEntity(EntityHandle entity) noexcept;
+
+    /**
+     * @brief Is entity alive?
+     * @param entity Entity.
+     */
+    [[nodiscard]] bool IsAlive(EntityHandle entity) const noexcept {
+      return entities_.Contains(entity);
+    }
+
+    /**
+     * @brief Alive entities count.
+     */
+    [[nodiscard]] std::size_t GetEntitiesCount() const noexcept {
+      return entities_.GetSize();
+    }
+
+    /**
+     * @brief Archetypes count.
+     */
+    [[nodiscard]] std::size_t GetArchetypesCount() const noexcept {
+      return archetypes_.size();
+    }
+
+    /**
+     * @brief Gets entity components mask.
+     * @param entity Entity.
+     * @return Components mask or 0 if entity is not alive.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE ComponentMask GetComponentMask(
+        EntityHandle entity) const noexcept;
+
+    /**
+     * @brief Gets entity component.
+     * @tparam T Component.
+     * @param entity Entity.
+     * @return Component or nullptr if entity is not alive or has no T.
+     */
+    template <Component T>
+    [[nodiscard]] T *GetComponent(EntityHandle entity) noexcept {
+      return static_cast<T *>(
+          static_cast<void *>(GetComponent(entity, GetComponentId<T>())));
+    }
+
+    /**
+     * @brief Adds or replaces entity component.  Moves entity to other
+     * archetype when added.
+     * @tparam T Component.
+     * @param entity Entity.
+     * @param component Component.
+     * @return Component or nullptr if entity is not alive or out of world
+     * memory.  Entity is kept as is in the latter case.
+     */
+    template <Component T>
+    T *AddComponent(EntityHandle entity, const T &component) noexcept {
+      if (!IsAlive(entity)) return nullptr;
+
+      const ComponentMask mask{GetComponentMask(entity)};
+      const ComponentMask added{MakeComponentMask<T>()};
+      if ((mask & added) == 0 && !MoveEntity(entity, mask | added)) {
+        return nullptr;
+      }
+
+      T *result{GetComponent<T>(entity)};
+      *result = component;
+      return result;
+    }
+
+    /**
+     * @brief Removes entity component.  Moves entity to other archetype.
+     * @tparam T Component.
+     * @param entity Entity.
+     * @return true if component was removed, false if entity has no component
+     * or out of world memory.
+     */
+    template <Component T>
+    bool RemoveComponent(EntityHandle entity) noexcept {
+      const ComponentMask mask{GetComponentMask(entity)};
+      const ComponentMask removed{MakeComponentMask<T>()};
+      if ((mask & removed) == 0) return false;
+
+      return MoveEntity(entity, mask & ~removed);
+    }
+
+    /**
+     * @brief Calls |fn| with ChunkView<Ts...> for each chunk with all |Ts|.
+     * @tparam Ts Components.
+     * @param fn Function.
+     */
+    template <Component... Ts, typename Fn>
+    void ForEachChunk(Fn &&fn) noexcept {
+      const ComponentMask mask{MakeComponentMask<Ts...>()};
+
+      for (auto &archetype : archetypes_) {
+        if ((archetype.GetMask() & mask) != mask) continue;
+
+        for (std::size_t chunk{0}; chunk < archetype.GetChunksCount();
+             ++chunk) {
+          fn(ChunkView<Ts...>{archetype, chunk});
+        }
+      }
+    }
+
+    /**
+     * @brief Calls |fn| with ChunkView<Ts...> for each chunk with all |Ts| on
+     * marl, chunks per task adapt to measured per chunk cost.  Blocks till all
+     * chunks are processed.  Runs serially when there are few cheap chunks or
+     * no marl scheduler is bound to the thread.  Chunks run as frame critical
+     * tasks, as world is updated by simulation step.
+     * @tparam Ts Components.
+     * @param fn Thread-safe function.
+     * @param memory Memory for chunks list, ex. thread frame one when called
+     * inside frame.
+     */
+    template <Component... Ts, typename Fn>
+    void ParallelForEachChunk(
+        Fn &&fn,
+        std::pmr::memory_resource *memory =
+            std::pmr::get_default_resource()) noexcept {
+      // Each query adapts to own per chunk cost.
+      static base::parallel::GrainSize grain_size;
+
+      const std::pmr::vector<ChunkRef> chunks{
+          GetChunks(MakeComponentMask<Ts...>(), memory)};
+
+      base::parallel::ParallelFor(
+          chunks,
+          [&](const ChunkRef chunk) {
+            fn(ChunkView<Ts...>{archetypes_[chunk.archetype], chunk.chunk});
+          },
+          grain_size, base::TaskPriority::kFrameCritical);
+    }
+
+   private:
+    /**
+     * @brief Chunk of archetype.
+     */
+    struct ChunkRef {
+      /**
+       * @brief Archetype index.
+       */
+      std::uint32_t archetype;
+      /**
+       * @brief Chunk index.
+       */
+      std::uint32_t chunk;
+    };
+
+    /**
+     * @brief Entity locations.
+     */
+    SlotMap<EntityLocation> entities_;
+    /**
+     * @brief Archetypes.
+     */
+    std::vector<Archetype> archetypes_;
+    /**
+     * @brief Archetype index by components mask.
+     */
+    std::unordered_map<ComponentMask, std::uint32_t> archetype_indices_;
+
+    /**
+     * @brief Creates entity with zeroed components.
+     * @param mask Components mask.
+     * @return Entity or invalid handle when out of world memory.
+     */
+    [[nodiscard]] EntityHandle CreateEntity(ComponentMask mask) noexcept;
+
+    /**
+     * @brief Gets entity component.
+     * @param entity Entity.
+     * @param id Component id.
+     * @return Component or nullptr if entity is not alive or has no |id|.
+     */
+    [[nodiscard]] WB_ATTRIBUTE_PURE std::byte *GetComponent(
+        EntityHandle entity, ComponentId id) noexcept;
+
+    /**
+     * @brief Gets or creates archetype for components.
+     * @param mask Components mask.
+     * @return Archetype index.
+     */
+    [[nodiscard]] std::uint32_t GetOrCreateArchetype(
+        ComponentMask mask) noexcept;
+
+    /**
+     * @brief Moves alive entity to archetype with |mask|, keeps common
+     * components.
+     * @param entity Entity.
+     * @param mask New components mask.
+     * @return true if moved, false when out of world memory.  Entity is kept
+     * as is in the latter case.
+     */
+    [[nodiscard]] bool MoveEntity(EntityHandle entity,
+                                  ComponentMask mask) noexcept;
+
+    /**
+     * @brief Gets chunks of archetypes with all components in |mask|.
+     * @param mask Components mask.
+     * @param memory Memory for chunks list.
+     * @return Chunks.
+     */
+    [[nodiscard]] std::pmr::vector<ChunkRef> GetChunks(
+        ComponentMask mask, std::pmr::memory_resource *memory) const noexcept;
+  };
+
+WB_MSVC_END_WARNING_OVERRIDE_SCOPE()
+
+}  // namespace wb::kernel::world
+
+#endif  // !WB_KERNEL_WORLD_WORLD_H_
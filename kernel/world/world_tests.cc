@@ -0,0 +1,234 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Whitebox world: entities and their components grouped by archetype.
+
+#include "world.h"
+//
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "base/deps/googletest/gtest/gtest.h"
+#include "base/memory/memory_budget.h"
+
+namespace {
+
+struct Position {
+  int x, y;
+};
+
+struct Velocity {
+  int dx, dy;
+};
+
+}  // namespace
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(WorldTest, CreateAndGetComponents) {
+  using namespace wb::kernel::world;
+
+  World world;
+
+  const EntityHandle entity{world.CreateEntity(Position{1, 2}, Velocity{3, 4})};
+
+  EXPECT_TRUE(world.IsAlive(entity));
+  EXPECT_EQ(1U, world.GetEntitiesCount());
+  EXPECT_EQ((MakeComponentMask<Position, Velocity>()),
+            world.GetComponentMask(entity));
+
+  const Position *position{world.GetComponent<Position>(entity)};
+  ASSERT_NE(nullptr, position);
+  EXPECT_EQ(1, position->x);
+  EXPECT_EQ(2, position->y);
+
+  const Velocity *velocity{world.GetComponent<Velocity>(entity)};
+  ASSERT_NE(nullptr, velocity);
+  EXPECT_EQ(3, velocity->dx);
+  EXPECT_EQ(4, velocity->dy);
+
+  const EntityHandle positioned{world.CreateEntity(Position{5, 6})};
+  EXPECT_EQ(nullptr, world.GetComponent<Velocity>(positioned));
+  EXPECT_EQ(2U, world.GetArchetypesCount());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(WorldTest, DestroySwapRemovesRow) {
+  using namespace wb::kernel::world;
+
+  World world;
+
+  std::vector<EntityHandle> entities;
+  for (int i{0}; i < 4; ++i) {
+    entities.push_back(world.CreateEntity(Position{i, -i}));
+  }
+
+  // Last entity moves into destroyed entity row, its location is updated.
+  EXPECT_TRUE(world.DestroyEntity(entities[0]));
+  EXPECT_FALSE(world.DestroyEntity(entities[0]));
+
+  EXPECT_FALSE(world.IsAlive(entities[0]));
+  EXPECT_EQ(nullptr, world.GetComponent<Position>(entities[0]));
+  EXPECT_EQ(0U, world.GetComponentMask(entities[0]));
+  EXPECT_EQ(3U, world.GetEntitiesCount());
+
+  for (int i{1}; i < 4; ++i) {
+    const Position *position{
+        world.GetComponent<Position>(entities[static_cast<std::size_t>(i)])};
+    ASSERT_NE(nullptr, position) << i;
+    EXPECT_EQ(i, position->x);
+    EXPECT_EQ(-i, position->y);
+  }
+
+  // Slot is reused, but stale handle still resolves to nothing.
+  const EntityHandle reused{world.CreateEntity(Position{42, 42})};
+  EXPECT_EQ(entities[0].index, reused.index);
+  EXPECT_EQ(nullptr, world.GetComponent<Position>(entities[0]));
+  EXPECT_EQ(42, world.GetComponent<Position>(reused)->x);
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(WorldTest, AddRemoveComponentMovesArchetype) {
+  using namespace wb::kernel::world;
+
+  World world;
+
+  const EntityHandle first{world.CreateEntity(Position{1, 1})};
+  const EntityHandle second{world.CreateEntity(Position{2, 2})};
+  const EntityHandle third{world.CreateEntity(Position{3, 3})};
+
+  // First moves to other archetype, third takes its row.
+  Velocity *velocity{world.AddComponent(first, Velocity{10, 10})};
+  ASSERT_NE(nullptr, velocity);
+  EXPECT_EQ(10, velocity->dx);
+  EXPECT_EQ(2U, world.GetArchetypesCount());
+  EXPECT_EQ((MakeComponentMask<Position, Velocity>()),
+            world.GetComponentMask(first));
+
+  EXPECT_EQ(1, world.GetComponent<Position>(first)->x)
+      << "Common components are kept on move.";
+  EXPECT_EQ(2, world.GetComponent<Position>(second)->x);
+  EXPECT_EQ(3, world.GetComponent<Position>(third)->x);
+
+  // Replace existing component, no move.
+  EXPECT_EQ(20, world.AddComponent(first, Velocity{20, 20})->dx);
+  EXPECT_EQ(2U, world.GetArchetypesCount());
+
+  EXPECT_TRUE(world.RemoveComponent<Position>(first));
+  EXPECT_FALSE(world.RemoveComponent<Position>(first));
+  EXPECT_EQ(MakeComponentMask<Velocity>(), world.GetComponentMask(first));
+  EXPECT_EQ(nullptr, world.GetComponent<Position>(first));
+  EXPECT_EQ(20, world.GetComponent<Velocity>(first)->dx);
+
+  // Move back into archetype where entity was.
+  EXPECT_EQ(4, world.AddComponent(third, Velocity{4, 4})->dx);
+  EXPECT_EQ(3, world.GetComponent<Position>(third)->x);
+  EXPECT_EQ(2, world.GetComponent<Position>(second)->x);
+
+  EXPECT_EQ(nullptr, world.AddComponent(EntityHandle{}, Velocity{}));
+  EXPECT_EQ(3U, world.GetEntitiesCount());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(WorldTest, ForEachChunk) {
+  using namespace wb::kernel::world;
+
+  World world;
+
+  // Enough entities to span several chunks.
+  constexpr int kEntitiesCount{5000};
+  for (int i{0}; i < kEntitiesCount; ++i) {
+    if (i % 2 == 0) {
+      world.CreateEntity(Position{i, 0}, Velocity{1, 2});
+    } else {
+      world.CreateEntity(Position{i, 0});
+    }
+  }
+
+  std::size_t moving_count{0};
+  world.ForEachChunk<Position, Velocity>(
+      [&](const ChunkView<Position, Velocity> &chunk) {
+        const auto positions = chunk.Get<Position>();
+        const auto velocities = chunk.Get<Velocity>();
+
+        for (std::size_t i{0}; i < chunk.GetSize(); ++i) {
+          positions[i].y += velocities[i].dy;
+        }
+
+        moving_count += chunk.GetSize();
+      });
+  EXPECT_EQ(static_cast<std::size_t>(kEntitiesCount / 2), moving_count);
+
+  // No scheduler bound, so runs serially.
+  std::atomic_size_t positioned_count{0};
+  std::atomic_int moved_y_sum{0};
+  world.ParallelForEachChunk<Position>([&](const ChunkView<Position> &chunk) {
+    int y_sum{0};
+    for (const Position &position : chunk.Get<Position>()) {
+      y_sum += position.y;
+    }
+
+    moved_y_sum.fetch_add(y_sum);
+    positioned_count.fetch_add(chunk.GetSize());
+  });
+  EXPECT_EQ(static_cast<std::size_t>(kEntitiesCount), positioned_count.load());
+  EXPECT_EQ(kEntitiesCount, moved_y_sum.load());
+
+  // Chunks list in caller memory.
+  std::pmr::monotonic_buffer_resource chunks_memory;
+  std::atomic_size_t moving_chunk_entities_count{0};
+  world.ParallelForEachChunk<Velocity>(
+      [&](const ChunkView<Velocity> &chunk) {
+        moving_chunk_entities_count.fetch_add(chunk.GetSize());
+      },
+      &chunks_memory);
+  EXPECT_EQ(static_cast<std::size_t>(kEntitiesCount / 2),
+            moving_chunk_entities_count.load());
+}
+
+// NOLINTNEXTLINE(cert-err58-cpp,cppcoreguidelines-avoid-non-const-global-variables,cppcoreguidelines-owning-memory)
+GTEST_TEST(WorldTest, CreateEntitiesPastMemoryBudget) {
+  using namespace wb::base::memory;
+  using namespace wb::kernel::world;
+
+  World world;
+
+  const EntityHandle positioned{world.CreateEntity(Position{1, 2})};
+  ASSERT_TRUE(positioned.IsValid());
+
+  MemoryBudgetTracker &tracker{GetMemoryBudgetTracker()};
+  const std::size_t current_bytes{
+      tracker.GetUsage(MemoryCategory::kWorld).current_bytes};
+
+  // Budget can't fit more chunks than thread budget credit.
+  tracker.SetBudget(MemoryCategory::kWorld,
+                    {.soft_limit = 0, .hard_limit = current_bytes});
+
+  std::size_t created_count{1};
+  bool is_out_of_budget{false};
+  for (std::size_t i{0}; i < 1'000'000; ++i) {
+    const EntityHandle entity{world.CreateEntity(Velocity{1, 2})};
+    if (!entity.IsValid()) {
+      is_out_of_budget = true;
+      break;
+    }
+
+    ++created_count;
+  }
+
+  EXPECT_TRUE(is_out_of_budget);
+  EXPECT_EQ(created_count, world.GetEntitiesCount());
+
+  // Entity is kept as is when can't be moved to new archetype.
+  EXPECT_EQ(nullptr, world.AddComponent(positioned, Velocity{3, 4}));
+  EXPECT_TRUE(world.IsAlive(positioned));
+  EXPECT_EQ(MakeComponentMask<Position>(), world.GetComponentMask(positioned));
+  EXPECT_EQ(1, world.GetComponent<Position>(positioned)->x);
+
+  tracker.SetBudget(MemoryCategory::kWorld, {.soft_limit = 0, .hard_limit = 0});
+
+  EXPECT_TRUE(world.CreateEntity(Velocity{1, 2}).IsValid());
+  EXPECT_NE(nullptr, world.AddComponent(positioned, Velocity{3, 4}));
+}
@@ -0,0 +1,281 @@
+// Copyright (c) 2023 The WhiteBox Authors.  All rights reserved.
+// Use of this source code is governed by a 3-Clause BSD license that can be
+// found in the LICENSE file.
+//
+// Message catalog compiler.  Compiles gettext PO file into memory mappable
+// binary message catalog.
+//
+// Usage: message-catalog-compiler [--rtl] <input.po> <output.wbmc>
+//
+// Only msgid / msgstr pairs are supported.  msgid is English (United States)
+// source message, which I18nStringViewHash is message id.  Untranslated
+// (empty msgstr) and fuzzy messages are skipped, so lookup falls back.
+//
+// Output catalog is replaced atomically, so running game can hot-reload it.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/deps/fmt/core.h"
+#include "base/deps/g3log/scoped_g3log_initializer.h"
+#include "base/intl/binary_message_catalog.h"
+#include "base/intl/l18n.h"
+#include "build/compiler_config.h"
+#include "build/static_settings_config.h"
+
+namespace {
+
+WB_GCC_BEGIN_WARNING_OVERRIDE_SCOPE()
+  // Local parse struct, padding is ok.
+  WB_GCC_DISABLE_PADDED_WARNING()
+
+  /**
+   * @brief PO file message.
+   */
+  struct PoMessage {
+    /**
+     * @brief Source message.
+     */
+    std::string id;
+    /**
+     * @brief Translated message.
+     */
+    std::string text;
+    /**
+     * @brief Is message marked as fuzzy?
+     */
+    bool is_fuzzy;
+  };
+
+WB_GCC_END_WARNING_OVERRIDE_SCOPE()
+
+/**
+ * @brief Unquotes PO string literal |quoted| and appends it to |out|.
+ * @param quoted Quoted string, like "Hello, \"{0}\"!\n".
+ * @param out String to append to.
+ * @return true on success, false if |quoted| is not valid string literal.
+ */
+[[nodiscard]] bool AppendUnquoted(std::string_view quoted,
+                                  std::string& out) noexcept {
+  if (quoted.size() < 2 || quoted.front() != '"' || quoted.back() != '"')
+      [[unlikely]] {
+    return false;
+  }
+
+  quoted = quoted.substr(1, quoted.size() - 2);
+
+  for (std::size_t i{0}; i < quoted.size(); ++i) {
+    if (quoted[i] != '\\') {
+      out.push_back(quoted[i]);
+      continue;
+    }
+
+    if (++i == quoted.size()) [[unlikely]] {
+      return false;
+    }
+
+    switch (quoted[i]) {
+      case 'n':
+        out.push_back('\n');
+        break;
+      case 't':
+        out.push_back('\t');
+        break;
+      case 'r':
+        out.push_back('\r');
+        break;
+      case '"':
+      case '\\':
+        out.push_back(quoted[i]);
+        break;
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Trims whitespaces from both ends of |line|.
+ * @param line Line.
+ * @return Trimmed line.
+ */
+[[nodiscard]] std::string_view Trim(std::string_view line) noexcept {
+  constexpr std::string_view kWhitespaces{" \t\r"};
+
+  const std::size_t begin{line.find_first_not_of(kWhitespaces)};
+  if (begin == std::string_view::npos) return {};
+
+  return line.substr(begin, line.find_last_not_of(kWhitespaces) - begin + 1);
+}
+
+/**
+ * @brief Parses PO file.
+ * @param po_path PO file path.
+ * @return PO messages or nullopt on parse error.
+ */
+[[nodiscard]] std::optional<std::vector<PoMessage>> ParsePoFile(
+    const char* po_path) noexcept {
+  std::ifstream po_file{po_path};
+  if (!po_file) [[unlikely]] {
+    fmt::print(stderr, "Unable to open PO file '{0}'.\n", po_path);
+    return std::nullopt;
+  }
+
+  std::vector<PoMessage> messages;
+  PoMessage message{{}, {}, false};
+  // Where continuation string literals go.
+  std::string* current{nullptr};
+  bool is_next_fuzzy{false};
+
+  const auto flush_message = [&]() {
+    if (current != nullptr) {
+      messages.push_back(std::move(message));
+    }
+
+    message = PoMessage{{}, {}, is_next_fuzzy};
+    is_next_fuzzy = false;
+    current = nullptr;
+  };
+
+  std::string raw_line;
+  std::size_t line_no{0};
+
+  while (std::getline(po_file, raw_line)) {
+    ++line_no;
+
+    const std::string_view line{Trim(raw_line)};
+    if (line.empty()) continue;
+
+    if (line.starts_with("#,")) {
+      is_next_fuzzy = is_next_fuzzy || line.find("fuzzy") != line.npos;
+      continue;
+    }
+
+    if (line.starts_with('#')) continue;
+
+    std::string_view literal;
+
+    if (line.starts_with("msgid ")) {
+      flush_message();
+      current = &message.id;
+      literal = Trim(line.substr(6));
+    } else if (line.starts_with("msgstr ")) {
+      current = &message.text;
+      literal = Trim(line.substr(7));
+    } else if (line.starts_with('"')) {
+      literal = line;
+    } else {
+      fmt::print(stderr,
+                 "{0}({1}): unsupported PO keyword, only msgid / msgstr are "
+                 "supported.\n",
+                 po_path, line_no);
+      return std::nullopt;
+    }
+
+    if (current == nullptr || !AppendUnquoted(literal, *current))
+        [[unlikely]] {
+      fmt::print(stderr, "{0}({1}): invalid string literal.\n", po_path,
+                 line_no);
+      return std::nullopt;
+    }
+  }
+
+  flush_message();
+
+  return messages;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  using namespace wb::base::intl;
+
+  // Catalog writer reports details via g3log, so initialize it first.
+  const wb::base::deps::g3log::ScopedG3LogInitializer scoped_g3log_initializer{
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      argv[0], wb::build::settings::kPathToMainLogFile};
+
+  std::vector<std::string_view> args{argv + 1, argv + argc};
+  StringLayout string_layout{StringLayout::LeftToRight};
+
+  if (!args.empty() && args.front() == "--rtl") {
+    string_layout = StringLayout::RightToLeft;
+    args.erase(args.begin());
+  }
+
+  if (args.size() != 2) {
+    fmt::print(stderr,
+               "Usage: message-catalog-compiler [--rtl] <input.po> "
+               "<output{0}>\n",
+               kBinaryMessageCatalogExtension);
+    return 1;
+  }
+
+  const char* po_path{argv[argc - 2]};
+  const char* catalog_path{argv[argc - 1]};
+
+  const auto po_messages = ParsePoFile(po_path);
+  if (!po_messages) return 1;
+
+  std::vector<MessageCatalogEntry> messages;
+  messages.reserve(po_messages->size());
+
+  for (const PoMessage& po_message : *po_messages) {
+    // Header entry has empty msgid, untranslated / fuzzy ones should fall back.
+    if (po_message.id.empty() || po_message.text.empty() ||
+        po_message.is_fuzzy) {
+      continue;
+    }
+
+    messages.push_back(MessageCatalogEntry{
+        I18nStringViewHash{}(po_message.id), po_message.text});
+  }
+
+  const auto catalog = WriteBinaryMessageCatalog(messages, string_layout);
+  if (!catalog) {
+    fmt::print(stderr,
+               "Unable to build message catalog from '{0}', see log for "
+               "details.\n",
+               po_path);
+    return 1;
+  }
+
+  // Catalog may be memory mapped by running game, so never rewrite it in place,
+  // write new one and atomically replace old one instead.
+  const std::filesystem::path catalog_file_path{catalog_path};
+  std::filesystem::path temp_catalog_file_path{catalog_file_path};
+  temp_catalog_file_path += ".tmp";
+
+  {
+    std::ofstream catalog_file{temp_catalog_file_path,
+                               std::ios::binary | std::ios::trunc};
+    catalog_file.write(reinterpret_cast<const char*>(catalog->data()),
+                       static_cast<std::streamsize>(catalog->size()));
+    catalog_file.close();
+
+    if (!catalog_file) {
+      fmt::print(stderr, "Unable to write message catalog '{0}'.\n",
+                 temp_catalog_file_path.string());
+      return 1;
+    }
+  }
+
+  std::error_code rc;
+  std::filesystem::rename(temp_catalog_file_path, catalog_file_path, rc);
+  if (rc) {
+    fmt::print(stderr, "Unable to replace message catalog '{0}': {1}.\n",
+               catalog_path, rc.message());
+    return 1;
+  }
+
+  fmt::print("Compiled {0} messages from '{1}' into '{2}' ({3} bytes).\n",
+             messages.size(), po_path, catalog_path, catalog->size());
+  return 0;
+}
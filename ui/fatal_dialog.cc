@@ -52,10 +52,10 @@ namespace {
 namespace wb::ui {
 
 [[nodiscard]] WB_WHITEBOX_UI_API WB_ATTRIBUTE_COLD int FatalDialog(
-    const std::string& title, std::optional<std::error_code> rc,
-    const std::string& main_instruction_message,
+    std::string_view title, std::optional<std::error_code> rc,
+    std::string_view main_instruction_message,
     const FatalDialogContext& context,
-    const std::string& content_message) noexcept {
+    std::string_view content_message) noexcept {
   try {
 #ifdef WB_OS_POSIX
     std::string error_message{main_instruction_message};
@@ -81,9 +81,12 @@ namespace wb::ui {
         context.text_layout == base::intl::StringLayout::LeftToRight
             ? sdl::MessageBoxFlags::LeftToRight
             : sdl::MessageBoxFlags::RightToLeft};
+    // SDL expects null-terminated title.
+    const std::string message_box_title{title};
     [[maybe_unused]] const auto error =
         sdl::ShowSimpleMessageBox(flags | sdl::MessageBoxFlags::Error,
-                                  title.c_str(), error_message.c_str());
+                                  message_box_title.c_str(),
+                                  error_message.c_str());
     // Well, dialog may not be shown (too low RAM, etc.).  So just ignore result
     // in Release.
     G3DCHECK(error.is_succeeded()) << "Fatal dialog can't be shown: " << error;
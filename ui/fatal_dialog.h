@@ -9,6 +9,7 @@
 
 #include <cstddef>
 #include <optional>
+#include <string_view>
 #include <system_error>
 
 #include "base/intl/lookup_with_fallback.h"
@@ -72,10 +73,10 @@ struct FatalDialogContext {
  * @return Error code |rc| or -1 if no |rc|.
  */
 [[nodiscard]] WB_WHITEBOX_UI_API WB_ATTRIBUTE_COLD int FatalDialog(
-    const std::string& title, std::optional<std::error_code> rc,
-    const std::string& main_instruction_message,
+    std::string_view title, std::optional<std::error_code> rc,
+    std::string_view main_instruction_message,
     const FatalDialogContext& context,
-    const std::string& content_message) noexcept;
+    std::string_view content_message) noexcept;
 
 }  // namespace wb::ui
 
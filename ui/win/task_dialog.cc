@@ -195,7 +195,8 @@ WB_WHITEBOX_UI_API base::std2::result<DialogBoxButton> ShowDialogBox(
   const std::wstring content{std2::UTF8ToWide(settings.content)};
 
   const auto no_collapse_settings =
-      DialogBoxCollapseSettings{std::string{}, std::string{}, std::string{}};
+      DialogBoxCollapseSettings{std::string_view{}, std::string_view{},
+                                std::string_view{}};
   const auto& collapse_settings = settings.collapse_settings.has_value()
                                       ? settings.collapse_settings.value()
                                       : no_collapse_settings;
@@ -12,6 +12,7 @@
 #include <cstddef>  // std::byte
 #include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 
 #include "base/macroses.h"
@@ -103,9 +104,9 @@ enum class DialogBoxButton {
  */
 struct DialogBoxCollapseSettings {
   DialogBoxCollapseSettings(
-      const std::string &expanded_control_text_,
-      const std::string &collapsed_control_text_,
-      const std::string &expand_collapse_content_) noexcept
+      std::string_view expanded_control_text_,
+      std::string_view collapsed_control_text_,
+      std::string_view expand_collapse_content_) noexcept
       : expanded_control_text{expanded_control_text_},
         collapsed_control_text{collapsed_control_text_},
         expand_collapse_content{expand_collapse_content_} {}
@@ -113,15 +114,15 @@ struct DialogBoxCollapseSettings {
   /**
    * @brief Expanded toggle control text.
    */
-  const std::string &expanded_control_text;
+  const std::string_view expanded_control_text;
   /**
    * @brief Collapsed toggle control text.
    */
-  const std::string &collapsed_control_text;
+  const std::string_view collapsed_control_text;
   /**
    * @brief Expand control content when toggle expanded.
    */
-  const std::string &expand_collapse_content;
+  const std::string_view expand_collapse_content;
 
   DialogBoxCollapseSettings(DialogBoxCollapseSettings &s) noexcept = default;
   DialogBoxCollapseSettings(DialogBoxCollapseSettings &&s) noexcept = default;
@@ -147,13 +148,12 @@ struct DialogBoxSettings {
    * @param is_cancellable_ Is cancel button available?
    * @return nothing.
    */
-  DialogBoxSettings(_In_opt_ HWND parent_window_, const std::string &title_,
-                    const std::string &main_instruction_,
+  DialogBoxSettings(_In_opt_ HWND parent_window_, std::string_view title_,
+                    std::string_view main_instruction_,
                     std::optional<DialogBoxCollapseSettings> collapse_settings_,
-                    const std::string &content_,
-                    const std::string &footer_text_, DialogBoxButton buttons_,
-                    int main_icon_id_, int small_icon_id_,
-                    bool rtl_layout_) noexcept
+                    std::string_view content_, std::string_view footer_text_,
+                    DialogBoxButton buttons_, int main_icon_id_,
+                    int small_icon_id_, bool rtl_layout_) noexcept
       : parent_window{parent_window_},
         title{title_},
         main_instruction{main_instruction_},
@@ -172,11 +172,11 @@ struct DialogBoxSettings {
   /**
    * @brief Title.
    */
-  const std::string &title;
+  const std::string_view title;
   /**
    * @brief Main instruction.
    */
-  const std::string &main_instruction;
+  const std::string_view main_instruction;
   /**
    * @brief Collapse control settings.
    */
@@ -184,11 +184,11 @@ struct DialogBoxSettings {
   /**
    * @brief Content.
    */
-  const std::string &content;
+  const std::string_view content;
   /**
    * @brief Footer text.
    */
-  const std::string &footer_text;
+  const std::string_view footer_text;
   /**
    * @brief Buttons.
    */